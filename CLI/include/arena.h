@@ -0,0 +1,91 @@
+/**
+ * @file arena.h
+ * @author Enrique Rodrigues (a28602@alunos.ipca.pt)
+ * @brief Header file for the bump allocator used while parsing commands.
+ *
+ * An arena hands out memory from large blocks by advancing an offset. Nothing
+ * is freed on its own: resetArena() releases everything at once, so parsing a
+ * command costs a few pointer bumps instead of one malloc() per argument.
+ *
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+/**
+ * @brief Structure that holds one block of an arena.
+ */
+typedef struct ArenaBlock {
+  struct ArenaBlock *previous;  // block filled before this one, or NULL
+  size_t capacity;              // bytes available after the header
+  size_t used;                  // bytes already handed out
+} ArenaBlock;
+
+/**
+ * @brief Structure that holds the state of an arena.
+ */
+typedef struct Arena {
+  ArenaBlock *block;  // block allocations are taken from, or NULL
+  void *last;         // most recent allocation, which can grow in place
+} Arena;
+
+/**
+ * @brief Initializes an empty arena.
+ *
+ * @param arena The arena to initialize.
+ */
+void initArena(Arena *arena);
+
+/**
+ * @brief Allocates memory from an arena.
+ *
+ * The memory is aligned for any type and stays valid until the arena is
+ * reset.
+ *
+ * @param arena The arena.
+ * @param size The number of bytes to allocate.
+ * @return void* The allocated memory, or NULL on memory allocation failure.
+ */
+void *arenaAlloc(Arena *arena, size_t size);
+
+/**
+ * @brief Changes the size of memory allocated from an arena.
+ *
+ * The most recent allocation grows or shrinks in place when its block has
+ * room. Any other allocation is copied to new memory.
+ *
+ * @param arena The arena.
+ * @param memory The memory to resize, returned by arenaAlloc().
+ * @param old_size The current size of `memory`.
+ * @param new_size The new size.
+ * @return void* The resized memory, or NULL on memory allocation failure, in
+ * which case `memory` is left unchanged.
+ */
+void *arenaResize(Arena *arena, void *memory, size_t old_size,
+                  size_t new_size);
+
+/**
+ * @brief Releases every allocation of an arena.
+ *
+ * The largest block is kept for the next allocations, so an arena that is
+ * reset after each command stops calling malloc() once it is warm.
+ *
+ * @param arena The arena.
+ */
+void resetArena(Arena *arena);
+
+/**
+ * @brief Releases the memory of an arena.
+ *
+ * @param arena The arena.
+ */
+void freeArena(Arena *arena);
+
+#endif /* ARENA_H */
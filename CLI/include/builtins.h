@@ -0,0 +1,67 @@
+/**
+ * @file builtins.h
+ * @author Enrique Rodrigues (a28602@alunos.ipca.pt)
+ * @brief Header file for the commands built into the interpreter.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef BUILTINS_H
+#define BUILTINS_H
+
+/**
+ * @brief Signature of a builtin command.
+ *
+ * Builtins receive the same arguments a program would receive in `main` and
+ * return the exit status of the command.
+ */
+typedef int (*BuiltinFunction)(int argc, char *argv[]);
+
+/**
+ * @brief Structure that associates a builtin name with its implementation.
+ */
+typedef struct Builtin {
+  const char *name;          // name typed by the user
+  BuiltinFunction function;  // implementation of the builtin
+} Builtin;
+
+/**
+ * @brief Signature of the entry point of a bundled command.
+ *
+ * Bundled commands are the programs in the `commands` folder. Their entry
+ * points are linked into the interpreter so they can run in-process.
+ */
+typedef int (*BundledFunction)(const int argc, const char *argv[]);
+
+/**
+ * @brief Structure that associates a bundled command with its entry point.
+ */
+typedef struct BundledCommand {
+  const char *name;          // name of the command
+  BundledFunction function;  // entry point of the command
+} BundledCommand;
+
+/**
+ * @brief Finds the builtin with the given name.
+ *
+ * @param name The command name.
+ * @return const Builtin* The builtin, or NULL if `name` is not a builtin.
+ */
+const Builtin *findBuiltin(const char *name);
+
+/**
+ * @brief Finds the bundled command with the given name.
+ *
+ * Returns NULL when the `externo` option is enabled, so that bundled commands
+ * are looked up in the PATH and executed as separate programs.
+ *
+ * @param name The command name.
+ * @return const BundledCommand* The bundled command, or NULL if `name` must
+ * be executed as an external program.
+ */
+const BundledCommand *findBundledCommand(const char *name);
+
+#endif /* BUILTINS_H */
@@ -0,0 +1,104 @@
+/**
+ * @file command_cache.h
+ * @author Enrique Rodrigues (a28602@alunos.ipca.pt)
+ * @brief Header file for the resolved command path cache.
+ *
+ * The interpreter remembers where each command name was found so that a
+ * repeated command does not need to rescan the PATH directories. The cache
+ * behaves like the `hash` table of bash: entries are keyed by command name and
+ * keep the resolved path, the directory it was found in and a hit counter.
+ *
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef COMMAND_CACHE_H
+#define COMMAND_CACHE_H
+
+#include <stdbool.h>
+#include <sys/stat.h>
+#include <time.h>
+
+/**
+ * @brief Structure that holds a cached command resolution.
+ *
+ * The structure includes the following fields:
+ * - `name`: The command name as typed by the user.
+ * - `path`: The full path the command resolved to.
+ * - `dir`: The search directory the command was found in.
+ * - `dir_mtime`: Modification time of `dir` when the entry was stored.
+ * - `cwd_dev`, `cwd_ino`, `cwd_mtime`: Identity and modification time of the
+ *   current directory when the entry was stored, since a command in the
+ *   current directory takes precedence over the PATH.
+ * - `hits`: Number of times the entry was used.
+ * - `next`: Next entry in the same hash bucket.
+ */
+typedef struct CacheEntry {
+  char *name;                 // command name
+  char *path;                 // resolved path of the command
+  char *dir;                  // directory the command was found in
+  struct timespec dir_mtime;  // mtime of `dir` when the entry was stored
+  dev_t cwd_dev;              // device of the current directory
+  ino_t cwd_ino;              // inode of the current directory
+  struct timespec cwd_mtime;  // mtime of the current directory
+  unsigned long hits;         // number of times the entry was used
+  struct CacheEntry *next;    // next entry in the bucket chain
+} CacheEntry;
+
+/**
+ * @brief Checks the cache against the current value of PATH.
+ *
+ * If the PATH environment variable changed since the cache was filled, every
+ * entry is discarded and the new value is remembered.
+ */
+void syncCommandCache(void);
+
+/**
+ * @brief Looks up a command name in the cache.
+ *
+ * @param name The command name.
+ * @return CacheEntry* The cached entry, or NULL if the name is not cached.
+ */
+CacheEntry *lookupCachedCommand(const char *name);
+
+/**
+ * @brief Stores the resolution of a command name in the cache.
+ *
+ * An existing entry for the same name is replaced.
+ *
+ * @param name The command name.
+ * @param path The full path the command resolved to.
+ * @param dir The directory the command was found in.
+ * @param dir_mtime The modification time of `dir`.
+ * @param cwd_stat The status of the current directory, taken before the
+ * command was searched for.
+ * @return true if the entry was stored, false on memory allocation failure.
+ */
+bool storeCachedCommand(const char *name, const char *path, const char *dir,
+                        const struct timespec *dir_mtime,
+                        const struct stat *cwd_stat);
+
+/**
+ * @brief Removes a command name from the cache.
+ *
+ * @param name The command name.
+ * @return true if an entry was removed, false if the name was not cached.
+ */
+bool removeCachedCommand(const char *name);
+
+/**
+ * @brief Removes every entry from the cache.
+ */
+void clearCommandCache(void);
+
+/**
+ * @brief Prints the cached commands and their hit counts to stdout.
+ *
+ * The output follows the format of the bash `hash` builtin.
+ */
+void printCommandCache(void);
+
+#endif /* COMMAND_CACHE_H */
@@ -0,0 +1,84 @@
+/**
+ * @file commands.h
+ * @author Enrique Rodrigues (a28602@alunos.ipca.pt)
+ * @brief Header file for the entry points of the bundled commands.
+ *
+ * Every program in the `commands` folder implements its logic in a function
+ * named after the command. The standalone programs call that function from
+ * `main`, and the interpreter links the same functions to run the commands
+ * in-process, without creating a new process.
+ *
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef COMMANDS_H
+#define COMMANDS_H
+
+/**
+ * @brief Appends the content of one file to another.
+ *
+ * @param argc The number of command-line arguments.
+ * @param argv An array of strings containing the command-line arguments.
+ * @return int The exit status of the command.
+ */
+int acrescenta_main(const int argc, const char *argv[]);
+
+/**
+ * @brief Deletes a file from the filesystem.
+ *
+ * @param argc The number of command-line arguments.
+ * @param argv An array of strings containing the command-line arguments.
+ * @return int The exit status of the command.
+ */
+int apaga_main(const int argc, const char *argv[]);
+
+/**
+ * @brief Counts the number of lines in a file.
+ *
+ * @param argc The number of command-line arguments.
+ * @param argv An array of strings containing the command-line arguments.
+ * @return int The exit status of the command.
+ */
+int conta_main(const int argc, const char *argv[]);
+
+/**
+ * @brief Creates a copy of the specified file.
+ *
+ * @param argc The number of command-line arguments.
+ * @param argv An array of strings containing the command-line arguments.
+ * @return int The exit status of the command.
+ */
+int copia_main(const int argc, const char *argv[]);
+
+/**
+ * @brief Displays information about a file.
+ *
+ * @param argc The number of command-line arguments.
+ * @param argv An array of strings containing the command-line arguments.
+ * @return int The exit status of the command.
+ */
+int informa_main(const int argc, const char *argv[]);
+
+/**
+ * @brief Lists the contents of a directory.
+ *
+ * @param argc The number of command-line arguments.
+ * @param argv An array of strings containing the command-line arguments.
+ * @return int The exit status of the command.
+ */
+int lista_main(const int argc, const char *argv[]);
+
+/**
+ * @brief Displays the contents of a file to stdout.
+ *
+ * @param argc The number of command-line arguments.
+ * @param argv An array of strings containing the command-line arguments.
+ * @return int The exit status of the command.
+ */
+int mostra_main(const int argc, const char *argv[]);
+
+#endif /* COMMANDS_H */
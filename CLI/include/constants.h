@@ -30,10 +30,26 @@
 #define PROGRAM_NAME "interpretador"  // program name
 #define VERSION "0.2"                 // current version number
 #define EXIT_CMD "termina"            // command to exit CLI
-#define MAX_ARGS 64                   // maximum number of arguments
+#define TIME_CMD "tempo"              // prefix that measures a command
+#define SCHEDULE_CMD "escalona"       // prefix that schedules a command
+#define MAX_PIPELINE_STAGES 64        // maximum number of pipeline stages
+
+/* OPERATORS */
+#define PIPE_OPERATOR "|"        // separates the stages of a pipeline
+#define BACKGROUND_OPERATOR "&"  // runs a command line as a background job
+#define LIST_SEPARATOR ";"       // separates commands on the same line
+
+/* REDIRECTIONS */
+#define INPUT_REDIRECT "<"           // reads stdin from a file
+#define OUTPUT_REDIRECT ">"          // writes stdout to a file
+#define APPEND_REDIRECT ">>"         // appends stdout to a file
+#define ERROR_REDIRECT "2>"          // writes stderr to a file
+#define ERROR_APPEND_REDIRECT "2>>"  // appends stderr to a file
 
 /* BUFFERS */
-#define BUFFER_SIZE_BYTES 4096  // max buffer size
+#define BUFFER_SIZE_BYTES 4096                 // max buffer size
+#define PIPE_BUFFER_SIZE_BYTES (1024 * 1024)  // capacity of pipeline pipes
+#define LINE_BUFFER_SIZE_BYTES (64 * 1024)    // initial input buffer size
 
 /* FILE INFORMATION */
 #define FILE_INFO_STR_SIZE 50  // size of strings in `FileInfo` structure
@@ -2,26 +2,244 @@
  * @file execute.h
  * @author Enrique Rodrigues (a28602@alunos.ipca.pt)
  * @brief Header file for functions that execute files.
- * @version 0.1
+ * @version 0.2
  * @date 2024-04-21
  *
  * @copyright Copyright (c) 2024
  *
+ * @section Modifications
+ * - 2026-10-16: Added selectable spawn backends and exit status reporting.
+ *   Enrique George Rodrigues (a28602@alunos.ipca.pt)
+ * - 2026-10-16: Added in-process execution of the bundled commands.
+ *   Enrique George Rodrigues (a28602@alunos.ipca.pt)
+ * - 2026-10-16: Commands can be launched without waiting and with their
+ *               standard streams connected to other descriptors.
+ *   Enrique George Rodrigues (a28602@alunos.ipca.pt)
+ * - 2026-10-16: Added exitStatusFromWait().
+ *   Enrique George Rodrigues (a28602@alunos.ipca.pt)
+ * - 2026-10-16: The newline after each command can be disabled.
+ *   Enrique George Rodrigues (a28602@alunos.ipca.pt)
+ * - 2026-10-16: Added launchBuiltin().
+ *   Enrique George Rodrigues (a28602@alunos.ipca.pt)
+ * - 2026-10-16: waitCommand() collects the resource usage of the command.
+ *   Enrique George Rodrigues (a28602@alunos.ipca.pt)
+ * - 2026-10-16: waitCommand() records the command in the execution trace.
+ *   Enrique George Rodrigues (a28602@alunos.ipca.pt)
+ * - 2026-10-16: Added the zigoto backend.
+ *   Enrique George Rodrigues (a28602@alunos.ipca.pt)
+ * - 2026-10-16: executeCommand() and executeBundledCommand() take the streams
+ *               of the command, for redirections.
+ *   Enrique George Rodrigues (a28602@alunos.ipca.pt)
+ * - 2026-10-16: Added reportExitStatus().
+ *   Enrique George Rodrigues (a28602@alunos.ipca.pt)
+ * - 2026-10-16: forkInProcessChild() is public, for the server mode.
+ *   Enrique George Rodrigues (a28602@alunos.ipca.pt)
  */
 
 #ifndef EXECUTE_H
 #define EXECUTE_H
 
+#include <stdbool.h>
+#include <sys/types.h>
+
+#include "builtins.h"
+
+/**
+ * @brief Backends available to launch commands.
+ *
+ * - `SPAWN_BACKEND_SPAWN`: posix_spawn(), which the C library implements with
+ *      a vfork-style clone that does not copy the interpreter's page tables.
+ * - `SPAWN_BACKEND_FORK`: fork() followed by execve().
+ * - `SPAWN_BACKEND_ZYGOTE`: a helper from a pool of pre-forked processes,
+ *      which only has to execute the program.
+ */
+typedef enum SpawnBackend {
+  SPAWN_BACKEND_SPAWN,  // posix_spawn()
+  SPAWN_BACKEND_FORK,   // fork() + execve()
+  SPAWN_BACKEND_ZYGOTE  // pre-forked helper + execve()
+} SpawnBackend;
+
+/**
+ * @brief Structure that holds the standard streams of a command.
+ *
+ * Each field is the descriptor that becomes stdin, stdout or stderr of the
+ * command. Descriptors equal to the stream number are inherited unchanged.
+ */
+typedef struct CommandIO {
+  int in_fd;   // descriptor used as stdin
+  int out_fd;  // descriptor used as stdout
+  int err_fd;  // descriptor used as stderr
+} CommandIO;
+
+/* Descriptors of a command that inherits the interpreter's streams. */
+extern const CommandIO DEFAULT_COMMAND_IO;
+
+/**
+ * @brief Selects the backend used to launch commands.
+ *
+ * @param backend The backend to use from now on.
+ */
+void setSpawnBackend(SpawnBackend backend);
+
+/**
+ * @brief Returns the backend used to launch commands.
+ *
+ * @return SpawnBackend The current backend.
+ */
+SpawnBackend getSpawnBackend(void);
+
+/**
+ * @brief Selects whether a newline is printed after each command.
+ *
+ * The newline separates the output of a command from the next prompt. It is
+ * disabled in script mode, where no prompt is shown.
+ *
+ * @param enabled true to print the newline, false otherwise.
+ */
+void setInteractiveOutput(bool enabled);
+
+/**
+ * @brief Ends the output of a command.
+ *
+ * Prints the newline that separates the output of a command from the next
+ * prompt, when running interactively.
+ */
+void finishCommandOutput(void);
+
+/**
+ * @brief Returns the name of a backend.
+ *
+ * @param backend The backend.
+ * @return const char* The name used to select the backend.
+ */
+const char *spawnBackendName(SpawnBackend backend);
+
+/**
+ * @brief Finds the backend with the given name.
+ *
+ * @param name The name of the backend.
+ * @param backend Where to store the backend.
+ * @return true if `name` names a backend, false otherwise.
+ */
+bool parseSpawnBackend(const char *name, SpawnBackend *backend);
+
+/**
+ * @brief Launches a command without waiting for it.
+ *
+ * @param command_path The path to the command to be executed.
+ * @param args An array of strings containing the arguments for the command.
+ * @param io The descriptors the command uses as its standard streams.
+ * @return pid_t The pid of the command, or -1 on failure.
+ */
+pid_t launchCommand(const char *command_path, char *args[],
+                    const CommandIO *io);
+
+/**
+ * @brief Creates a child copy of the interpreter to run a command in-process.
+ *
+ * In the child, the standard streams are connected and every other
+ * descriptor is closed, so that pipes see end-of-file as soon as their
+ * writers finish.
+ *
+ * @param io The descriptors the child uses as its standard streams.
+ * @return pid_t 0 in the child, the pid of the child in the parent, or -1 on
+ * failure.
+ */
+pid_t forkInProcessChild(const CommandIO *io);
+
+/**
+ * @brief Launches a bundled command in a child process without waiting.
+ *
+ * The child is a copy of the interpreter that calls the entry point of the
+ * command directly, so the program is not executed nor dynamically linked
+ * again. Descriptors other than the standard streams are closed in the child
+ * so that pipes see end-of-file as soon as their writers finish.
+ *
+ * @param command The bundled command to run.
+ * @param arg_count The number of arguments in `args`.
+ * @param args An array of strings containing the arguments for the command.
+ * @param io The descriptors the command uses as its standard streams.
+ * @return pid_t The pid of the child, or -1 on failure.
+ */
+pid_t launchBundledCommand(const BundledCommand *command, int arg_count,
+                           char *args[], const CommandIO *io);
+
+/**
+ * @brief Launches a builtin in a child process without waiting.
+ *
+ * Used when a builtin is part of a pipeline or of a background job. The
+ * builtin runs in a copy of the interpreter, so changes it makes to the
+ * interpreter state are not kept.
+ *
+ * @param builtin The builtin to run.
+ * @param arg_count The number of arguments in `args`.
+ * @param args An array of strings containing the arguments for the builtin.
+ * @param io The descriptors the builtin uses as its standard streams.
+ * @return pid_t The pid of the child, or -1 on failure.
+ */
+pid_t launchBuiltin(const Builtin *builtin, int arg_count, char *args[],
+                    const CommandIO *io);
+
+/**
+ * @brief Reports a non-zero exit status on stderr.
+ *
+ * @param status The exit status of a command.
+ */
+void reportExitStatus(int status);
+
+/**
+ * @brief Converts a status returned by waitpid() into an exit status.
+ *
+ * @param wait_status The status returned by waitpid().
+ * @return int The exit status of the process, or 128 plus the signal number
+ * if the process was killed by a signal.
+ */
+int exitStatusFromWait(int wait_status);
+
+/**
+ * @brief Waits for a command and reports how it terminated.
+ *
+ * The resources used by the command are added to the active usage meters
+ * and to the execution trace.
+ *
+ * @param pid The pid of the command.
+ * @return int The exit status of the command, or 128 plus the signal number
+ * if the command was killed by a signal.
+ */
+int waitCommand(pid_t pid);
+
 /**
  * @brief Executes a command with the given arguments.
  *
- * This function creates a child process using fork() and executes the specified
- * command with the provided arguments using execvp(). If the fork or execvp
- * operation fails, an error message is printed, and the function returns.
+ * This function launches the command at `command_path` with the selected
+ * backend and waits for it to finish. The path is executed as given, without
+ * searching the PATH again.
  *
  * @param command_path The path to the command to be executed.
  * @param args An array of strings containing the arguments for the command.
+ * @param io The descriptors the command uses as its standard streams.
+ * @return int The exit status of the command, or 128 plus the signal number
+ * if the command was killed by a signal.
+ */
+int executeCommand(const char *command_path, char *args[],
+                   const CommandIO *io);
+
+/**
+ * @brief Executes a bundled command inside the interpreter.
+ *
+ * The command runs in the interpreter process, so no process is created.
+ * While it runs, the streams of the interpreter are connected to those in
+ * `io`, so the command writes straight to a redirected file. Buffered output
+ * is flushed around the call to keep it ordered with the output of other
+ * commands.
+ *
+ * @param command The bundled command to execute.
+ * @param arg_count The number of arguments in `args`.
+ * @param args An array of strings containing the arguments for the command.
+ * @param io The descriptors the command uses as its standard streams.
+ * @return int The exit status of the command.
  */
-void executeCommand(const char *command_path, char *args[]);
+int executeBundledCommand(const BundledCommand *command, int arg_count,
+                          char *args[], const CommandIO *io);
 
 #endif /* EXECUTE_H */
@@ -27,9 +27,15 @@ bool isExecutableFile(const char *path);
 /**
  * @brief Finds the full path of a command in the PATH environment variable.
  *
- * This function searches for the specified command in the directories listed
- * in the PATH environment variable. If the command is found, its full path is
- * copied to the provided buffer.
+ * This function searches for the specified command in the current directory
+ * and then in the directories listed in the PATH environment variable. If the
+ * command is found, its full path is copied to the provided buffer.
+ *
+ * Resolutions are kept in the command cache, so a repeated command is resolved
+ * without any access() call. Cached entries are dropped when PATH changes,
+ * when the directory they were found in is modified, or when the current
+ * directory is another one or was modified, since a command added there
+ * takes precedence.
  *
  * @param command The name of the command to search for.
  * @param command_path A buffer to store the full path of the command.
@@ -37,4 +43,16 @@ bool isExecutableFile(const char *path);
  */
 bool findCommandInPath(const char *command, char *command_path);
 
+/**
+ * @brief Resolves the path of the program a command name refers to.
+ *
+ * A name containing a slash is a path to the program itself and is used as
+ * given. Any other name is searched with findCommandInPath().
+ *
+ * @param command The name of the command.
+ * @param command_path A buffer to store the path of the program.
+ * @return true if the command was resolved, false otherwise.
+ */
+bool resolveCommand(const char *command, char *command_path);
+
 #endif /* FIND_H */
@@ -7,23 +7,52 @@
  *
  * @copyright Copyright (c) 2024
  *
+ * @section Modifications
+ * - 2026-10-16: parseInput() was replaced by parseCommand(), which allocates
+ *               the arguments from an arena, and isOperator().
+ *   Enrique George Rodrigues (a28602@alunos.ipca.pt)
+ * - 2026-10-16: Added the redirection operators.
+ *   Enrique George Rodrigues (a28602@alunos.ipca.pt)
  */
 
 #ifndef INPUT_PARSER_H
 #define INPUT_PARSER_H
 
+#include <stdbool.h>
+
+#include "arena.h"
+
 /**
- * @brief Parses an input string into arguments.
+ * @brief Parses the next command of a line into arguments.
+ *
+ * Arguments are separated by spaces or tabs. Single quotes keep their content
+ * as it is, double quotes expand variables, and a backslash outside quotes
+ * escapes the next character. `$NAME` and `${NAME}` are replaced by the value
+ * of the environment variable, and arguments with wildcards outside quotes
+ * are replaced by the files they match. The pipe, background and redirection
+ * operators are returned as separate arguments, which isOperator()
+ * recognizes, and the list separator ends the command.
+ *
+ * The arguments and their array are allocated from the arena and stay valid
+ * until it is reset. There is no limit on their number.
  *
- * This function tokenizes the input string by spaces and stores the tokens
- * in the provided array of strings (`args`). The maximum number of arguments
- * that can be stored in the `args` array is specified by `max_args`.
+ * @param arena The arena the arguments are allocated from.
+ * @param input Pointer to the rest of the line. It is moved past the command
+ * and its separator, and set to NULL at the end of the line.
+ * @param args Receives the arguments, terminated by NULL.
+ * @return int The number of arguments, or -1 on syntax error or memory
+ * allocation failure.
+ */
+int parseCommand(Arena *arena, const char **input, char ***args);
+
+/**
+ * @brief Checks if an argument returned by parseCommand() is an operator.
  *
- * @param input The input string to be parsed.
- * @param args An array of strings to store the parsed arguments.
- * @param max_args The maximum number of arguments that can be stored.
- * @return int The number of arguments parsed and stored in the `args` array.
+ * @param arg The argument.
+ * @param operator The operator, such as PIPE_OPERATOR.
+ * @return true if the argument is that operator and was not quoted, false
+ * otherwise.
  */
-int parseInput(char *input, char *args[], int max_args);
+bool isOperator(const char *arg, const char *operator);
 
 #endif /* INPUT_PARSER_H */
@@ -0,0 +1,147 @@
+/**
+ * @file jobs.h
+ * @author Enrique Rodrigues (a28602@alunos.ipca.pt)
+ * @brief Header file for the table of background jobs.
+ *
+ * Commands started with `&` become jobs. The interpreter keeps SIGCHLD
+ * blocked and receives it through a signalfd, so finished jobs are reaped as
+ * soon as they exit while the prompt keeps accepting commands.
+ *
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2024
+ *
+ * @section Modifications
+ * - 2026-10-16: Added the resource usage of each job.
+ *   Enrique George Rodrigues (a28602@alunos.ipca.pt)
+ * - 2026-10-16: Jobs can record the CPUs they ran on.
+ *   Enrique George Rodrigues (a28602@alunos.ipca.pt)
+ */
+
+#ifndef JOBS_H
+#define JOBS_H
+
+#include <stdbool.h>
+#include <sys/types.h>
+#include <time.h>
+
+#include "schedule.h"
+#include "usage.h"
+
+/**
+ * @brief States of a background job.
+ */
+typedef enum JobState {
+  JOB_RUNNING,  // at least one process of the job is running
+  JOB_DONE      // every process of the job has terminated
+} JobState;
+
+/**
+ * @brief Structure that holds a background job.
+ *
+ * The structure includes the following fields:
+ * - `id`: The number used to refer to the job in the builtins.
+ * - `command_line`: The command line that started the job.
+ * - `pids`: The processes of the job, one per pipeline stage.
+ * - `pid_count`: The number of entries in `pids`.
+ * - `running`: The number of processes that have not terminated yet.
+ * - `start_time`: When the job was started, as a Unix timestamp.
+ * - `start`: When the job was started, on the monotonic clock.
+ * - `end`: When the last process terminated, on the monotonic clock.
+ * - `state`: Whether the job is running or done.
+ * - `status`: The exit status of the last process of the job.
+ * - `usage`: The resources used by the processes that terminated.
+ * - `report_cpus`: Whether the CPUs of the processes are recorded.
+ * - `allowed_cpus`: The CPUs the processes were allowed to run on.
+ * - `used_cpus`: The CPUs the processes ran on last.
+ */
+typedef struct Job {
+  int id;                 // job number
+  char *command_line;     // command line that started the job
+  pid_t *pids;            // processes of the job, -1 once reaped
+  int pid_count;          // number of processes of the job
+  int running;            // number of processes still running
+  time_t start_time;      // wall clock start time
+  struct timespec start;  // monotonic start time
+  struct timespec end;    // monotonic end time
+  JobState state;         // state of the job
+  int status;             // exit status of the last process
+  CommandUsage usage;     // resources used by the job
+  bool report_cpus;       // whether the CPUs of the job are recorded
+  CpuList allowed_cpus;   // CPUs the processes were allowed to run on
+  CpuList used_cpus;      // CPUs the processes ran on last
+} Job;
+
+/**
+ * @brief Prepares the interpreter to reap background jobs.
+ *
+ * Blocks SIGCHLD and creates the signalfd that reports it. Commands are
+ * started with an empty signal mask, so they are not affected by this.
+ *
+ * @return true on success, false if the signalfd could not be created.
+ */
+bool initJobControl(void);
+
+/**
+ * @brief Returns the descriptor that becomes readable when a child exits.
+ *
+ * @return int The signalfd descriptor, or -1 if job control is unavailable.
+ */
+int jobSignalFd(void);
+
+/**
+ * @brief Adds a job to the table.
+ *
+ * @param command_line The command line that started the job.
+ * @param pids The processes of the job. Entries equal to -1 are ignored.
+ * @param pid_count The number of entries in `pids`.
+ * @param report_cpus Whether to record the CPUs the processes ran on and
+ * print them when the job is reported.
+ * @return int The number of the job, or -1 on failure.
+ */
+int addJob(const char *command_line, const pid_t pids[], int pid_count,
+           bool report_cpus);
+
+/**
+ * @brief Reaps the processes of background jobs that have terminated.
+ *
+ * Drains the signalfd and collects every finished job process without
+ * blocking. Other children of the interpreter are not touched.
+ */
+void reapJobs(void);
+
+/**
+ * @brief Prints and removes the jobs that are done.
+ *
+ * @return true if at least one job was reported, false otherwise.
+ */
+bool reportFinishedJobs(void);
+
+/**
+ * @brief Prints every job in the table to stdout.
+ */
+void printJobs(void);
+
+/**
+ * @brief Waits for a job to finish and removes it from the table.
+ *
+ * A job that records its CPUs is printed once it finishes, to report them.
+ *
+ * @param id The number of the job, or -1 for the most recent job.
+ * @param show Whether to print the command line of the job before waiting.
+ * @return int The exit status of the job, or -1 if there is no such job.
+ */
+int waitJob(int id, bool show);
+
+/**
+ * @brief Waits for every job to finish and empties the table.
+ *
+ * Jobs that record their CPUs are printed once they finish, to report them.
+ *
+ * @return int The exit status of the last job waited for, or 0 if there
+ * were no jobs.
+ */
+int waitAllJobs(void);
+
+#endif /* JOBS_H */
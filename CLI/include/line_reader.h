@@ -0,0 +1,77 @@
+/**
+ * @file line_reader.h
+ * @author Enrique Rodrigues (a28602@alunos.ipca.pt)
+ * @brief Header file for the buffered line reader.
+ *
+ * The line reader splits the input of the interpreter into lines. Input is
+ * read in large blocks into a ring buffer, so a single read() can deliver
+ * any number of commands, and the buffer grows when a line does not fit.
+ *
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef LINE_READER_H
+#define LINE_READER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * @brief Structure that holds the state of a line reader.
+ *
+ * The buffered data starts at `head` and is `length` bytes long, wrapping
+ * around the end of `buffer`.
+ */
+typedef struct LineReader {
+  int fd;           // descriptor the input is read from
+  char *buffer;     // ring buffer
+  size_t capacity;  // size of `buffer`
+  size_t head;      // position of the first buffered byte
+  size_t length;    // number of buffered bytes
+  size_t consumed;  // bytes of the last returned line still in the buffer
+  bool eof;         // whether the end of the input was reached
+} LineReader;
+
+/**
+ * @brief Initializes a line reader.
+ *
+ * @param reader The reader to initialize.
+ * @param fd The descriptor to read from.
+ * @return true on success, false on memory allocation failure.
+ */
+bool initLineReader(LineReader *reader, int fd);
+
+/**
+ * @brief Releases the memory of a line reader.
+ *
+ * @param reader The reader.
+ */
+void freeLineReader(LineReader *reader);
+
+/**
+ * @brief Checks if a complete line is already buffered.
+ *
+ * When this returns true, readLine() returns without reading more input.
+ *
+ * @param reader The reader.
+ * @return true if readLine() would not block, false otherwise.
+ */
+bool hasBufferedLine(LineReader *reader);
+
+/**
+ * @brief Reads the next line.
+ *
+ * The returned line is null-terminated, without the newline character, and
+ * stays valid until the next call.
+ *
+ * @param reader The reader.
+ * @param line Where to store the pointer to the line.
+ * @return int 1 if a line was read, 0 at the end of the input or -1 on error.
+ */
+int readLine(LineReader *reader, char **line);
+
+#endif /* LINE_READER_H */
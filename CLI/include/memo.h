@@ -0,0 +1,82 @@
+/**
+ * @file memo.h
+ * @author Enrique Rodrigues (a28602@alunos.ipca.pt)
+ * @brief Header file for the cache of results of pure commands.
+ *
+ * A command is pure when its output only depends on its arguments and on
+ * the files they name, like `conta` and `lista`. When the cache
+ * is enabled with `opcao memo on`, the output and exit status of a pure
+ * command are kept, keyed by its arguments and by the device, inode, size,
+ * modification time and change time of every file it names. Running the
+ * same command on unchanged files writes the kept output without running
+ * anything.
+ *
+ * Results are evicted, least recently used first, when the cache grows over
+ * its byte budget. They can be saved to a file on exit and mapped back into
+ * memory by the next session.
+ *
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef MEMO_H
+#define MEMO_H
+
+#include <stdbool.h>
+
+#include "builtins.h"
+#include "execute.h"
+
+/**
+ * @brief Enables or disables the cache.
+ *
+ * @param enabled true to cache the results of pure commands, false
+ * otherwise.
+ */
+void setMemoEnabled(bool enabled);
+
+/**
+ * @brief Returns whether the cache is enabled.
+ *
+ * @return true if the results of pure commands are cached, false otherwise.
+ */
+bool isMemoEnabled(void);
+
+/**
+ * @brief Runs a command through the cache.
+ *
+ * When the cache holds the result of the command, its output is written to
+ * the streams in `io`. Otherwise the command runs with its output captured,
+ * which is then written to the streams in `io` and kept. Nothing is done
+ * when the cache is disabled, the command is not pure, or its result cannot
+ * be cached, such as when it reads stdin.
+ *
+ * @param bundled The bundled command to run, or NULL to run `command_path`.
+ * @param command_path The path of the program to run, if `bundled` is NULL.
+ * @param args The arguments of the command, terminated by NULL.
+ * @param arg_count The number of arguments in `args`.
+ * @param io The descriptors the command uses as its standard streams.
+ * @param status Receives the exit status of the command.
+ * @return true if the command was run through the cache, false if the caller
+ * must run it.
+ */
+bool runMemoized(const BundledCommand *bundled, const char *command_path,
+                 char *args[], int arg_count, const CommandIO *io,
+                 int *status);
+
+/**
+ * @brief Implements the `memo` builtin.
+ *
+ * Shows the statistics of the cache, clears it, changes its byte budget,
+ * selects the file it is saved to, or marks commands as pure.
+ *
+ * @param argc The number of arguments.
+ * @param argv The arguments, starting with the builtin name.
+ * @return int Returns 0 on success or 1 on invalid usage.
+ */
+int memoBuiltin(int argc, char *argv[]);
+
+#endif /* MEMO_H */
@@ -0,0 +1,39 @@
+/**
+ * @file parallel.h
+ * @author Enrique Rodrigues (a28602@alunos.ipca.pt)
+ * @brief Header file for the `paralelo` builtin.
+ *
+ * `paralelo` runs the same command once per input, with up to N commands
+ * running at the same time:
+ *
+ * @code
+ * paralelo [-j N] [-k] command [args...] ::: input...
+ * lista-de-ficheiros | paralelo [-j N] [-k] command [args...]
+ * @endcode
+ *
+ * Each `{}` in the arguments is replaced by the input. When no argument
+ * contains `{}` the input is appended as the last argument. Inputs are read
+ * from stdin, one per line, when `:::` is not given.
+ *
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+/**
+ * @brief Implements the `paralelo` builtin.
+ *
+ * @param argc The number of arguments.
+ * @param argv The arguments, starting with the builtin name.
+ * @return int 0 if every command succeeded, otherwise the number of failed
+ * commands up to 100, or 101 if more than 100 failed. Returns 255 on invalid
+ * usage.
+ */
+int parallelBuiltin(int argc, char *argv[]);
+
+#endif /* PARALLEL_H */
@@ -0,0 +1,58 @@
+/**
+ * @file pipeline.h
+ * @author Enrique Rodrigues (a28602@alunos.ipca.pt)
+ * @brief Header file for functions that execute pipelines.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include <stdbool.h>
+#include <sys/types.h>
+
+/**
+ * @brief Checks if the arguments of a command line form a pipeline.
+ *
+ * @param args An array of strings containing the parsed arguments.
+ * @param arg_count The number of arguments in `args`.
+ * @return true if the arguments contain the pipe operator, false otherwise.
+ */
+bool isPipeline(char *args[], int arg_count);
+
+/**
+ * @brief Launches a pipeline of commands without waiting for it.
+ *
+ * The arguments are split into stages at each pipe operator. Every stage is
+ * started at once, with the stdout of each stage connected to the stdin of
+ * the next one through a pipe, unless the stage redirects that stream to a
+ * file. Builtins and bundled commands run in a child copy of the interpreter
+ * instead of being executed as separate programs.
+ *
+ * @param args An array of strings containing the parsed arguments. The pipe
+ * operators are replaced by NULL to terminate the argument list of each stage.
+ * @param arg_count The number of arguments in `args`.
+ * @param pids Array that receives the pid of each stage, or -1 for stages
+ * that could not be launched. Must hold MAX_PIPELINE_STAGES entries.
+ * @return int The number of stages, or -1 on syntax error.
+ */
+int launchPipeline(char *args[], int arg_count, pid_t pids[]);
+
+/**
+ * @brief Executes a pipeline of commands.
+ *
+ * Launches the pipeline with launchPipeline() and then waits for all stages
+ * together.
+ *
+ * @param args An array of strings containing the parsed arguments. The pipe
+ * operators are replaced by NULL to terminate the argument list of each stage.
+ * @param arg_count The number of arguments in `args`.
+ * @return int The exit status of the last stage.
+ */
+int executePipeline(char *args[], int arg_count);
+
+#endif /* PIPELINE_H */
@@ -0,0 +1,69 @@
+/**
+ * @file redirect.h
+ * @author Enrique Rodrigues (a28602@alunos.ipca.pt)
+ * @brief Header file for the redirection of the standard streams.
+ *
+ * `<`, `>`, `>>`, `2>` and `2>>` connect a standard stream of a command to a
+ * file. The interpreter opens the file and the command receives the
+ * descriptor as its stream: programs get it through the spawn file actions,
+ * and commands that run inside the interpreter write to it directly while
+ * they run.
+ *
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef REDIRECT_H
+#define REDIRECT_H
+
+#include <stdbool.h>
+
+#include "execute.h"
+
+/**
+ * @brief Opens the files of the redirections of a command.
+ *
+ * The redirection operators and their files are removed from `args`, and the
+ * descriptors of the files replace the streams in `io`. The files are opened
+ * close-on-exec, so commands only inherit the copies made for their streams.
+ *
+ * @param args The arguments of the command, terminated by NULL.
+ * @param arg_count The number of arguments in `args`.
+ * @param io The streams of the command, updated with the files.
+ * @return int The number of arguments left, or -1 on error, in which case
+ * `io` is unchanged and no file is left open.
+ */
+int applyRedirections(char *args[], int arg_count, CommandIO *io);
+
+/**
+ * @brief Closes the files opened by applyRedirections().
+ *
+ * @param io The streams returned by applyRedirections().
+ * @param original The streams before the redirections were applied.
+ */
+void closeRedirections(const CommandIO *io, const CommandIO *original);
+
+/**
+ * @brief Connects the standard streams of the interpreter to other files.
+ *
+ * Used around commands that run inside the interpreter. Buffered output is
+ * flushed first, and the original streams are kept in `saved_fds`.
+ *
+ * @param io The descriptors to use as stdin, stdout and stderr.
+ * @param saved_fds Receives copies of the original streams, or -1 for streams
+ * that are not changed.
+ * @return true on success, false on error, in which case nothing is changed.
+ */
+bool redirectInterpreter(const CommandIO *io, int saved_fds[3]);
+
+/**
+ * @brief Restores the streams changed by redirectInterpreter().
+ *
+ * @param saved_fds The copies of the original streams.
+ */
+void restoreInterpreter(const int saved_fds[3]);
+
+#endif /* REDIRECT_H */
@@ -0,0 +1,64 @@
+/**
+ * @file run.h
+ * @author Enrique Rodrigues (a28602@alunos.ipca.pt)
+ * @brief Header file for the function that runs parsed command lines.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef RUN_H
+#define RUN_H
+
+#include <sys/types.h>
+
+#include "arena.h"
+#include "execute.h"
+
+/**
+ * @brief Launches a single command without waiting for it.
+ *
+ * Builtins and bundled commands run in a child copy of the interpreter. Any
+ * other command is resolved through the command cache and executed.
+ *
+ * @param args The arguments of the command, terminated by NULL.
+ * @param arg_count The number of arguments in `args`.
+ * @param io The descriptors the command uses as its standard streams.
+ * @return pid_t The pid of the command, or -1 if it could not be launched.
+ */
+pid_t launchArguments(char *args[], int arg_count, const CommandIO *io);
+
+/**
+ * @brief Runs a parsed command line.
+ *
+ * Command lines ending with the background operator become background jobs.
+ * Any other command line runs in the foreground and its resource usage is
+ * measured: it is added to the session summary and, when enabled with
+ * `opcao tempo on`, printed after the command.
+ *
+ * @param args An array of strings containing the parsed arguments, terminated
+ * by NULL. The array may be modified.
+ * @param arg_count The number of arguments in `args`.
+ * @return int The exit status of the command line.
+ */
+int runCommandLine(char *args[], int arg_count);
+
+/**
+ * @brief Parses and runs every command of a line.
+ *
+ * Commands on the same line are separated by the list separator and run one
+ * after the other. The arguments of each command are allocated from `arena`,
+ * which is reset once the command finished. A syntax error stops the rest of
+ * the line. The exit command prints the session summary and terminates the
+ * interpreter.
+ *
+ * @param arena The arena the arguments are allocated from.
+ * @param line The line to run.
+ * @param status The exit status of the previous command, updated with the
+ * status of each command that runs.
+ */
+void runLine(Arena *arena, const char *line, int *status);
+
+#endif /* RUN_H */
@@ -0,0 +1,153 @@
+/**
+ * @file schedule.h
+ * @author Enrique Rodrigues (a28602@alunos.ipca.pt)
+ * @brief Header file for the CPU and I/O scheduling of commands.
+ *
+ * The `escalona` builtin runs a command line with a scheduling policy: the
+ * CPUs its processes may run on, their nice value, their I/O priority class
+ * and the cgroup v2 group they are placed in:
+ *
+ * @code
+ * escalona [-c cpus] [-n nice] [-i class[:level]] [-g cgroup] command...
+ * escalona -j [-c cpus] [-n nice] [-i class[:level]] [-g cgroup]
+ * @endcode
+ *
+ * With `-j` the policy becomes the default for every background job. The
+ * policy is applied by each process of the command between fork() and
+ * execve(), so the interpreter itself keeps running where it was.
+ *
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef SCHEDULE_H
+#define SCHEDULE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <sys/types.h>
+
+#include "constants.h"
+
+/* Largest number of CPUs a policy can name. */
+#define SCHEDULE_MAX_CPUS 1024
+
+/* Number of words in the bitmap of a `CpuList`. */
+#define CPU_LIST_WORDS (SCHEDULE_MAX_CPUS / (8 * sizeof(unsigned long)))
+
+/**
+ * @brief Structure that holds a set of CPUs, one bit per CPU.
+ */
+typedef struct CpuList {
+  unsigned long bits[CPU_LIST_WORDS];  // bit N is set when CPU N is included
+} CpuList;
+
+/**
+ * @brief Structure that holds the scheduling policy of a command.
+ *
+ * Each part of the policy is only applied when its `set_` field is true, or
+ * for the cgroup, when `cgroup` is not empty.
+ */
+typedef struct SchedulePolicy {
+  bool set_cpus;                         // whether `cpus` is applied
+  CpuList cpus;                          // CPUs the command may run on
+  bool set_nice;                         // whether `nice` is applied
+  int nice;                              // nice value, from -20 to 19
+  bool set_io;                           // whether the I/O priority is applied
+  int io_class;                          // I/O scheduling class
+  int io_level;                          // priority within the class, 0 to 7
+  char cgroup[BUFFER_SIZE_BYTES];        // directory of the cgroup
+} SchedulePolicy;
+
+/**
+ * @brief Implements the `escalona` builtin.
+ *
+ * Runs a command line with a scheduling policy, sets the policy of the
+ * background jobs with `-j`, or shows it when called without arguments.
+ *
+ * @param argc The number of arguments.
+ * @param argv The arguments, starting with the builtin name.
+ * @return int The exit status of the command line, or 1 on invalid usage.
+ */
+int scheduleBuiltin(int argc, char *argv[]);
+
+/**
+ * @brief Parses the options of a scheduling policy.
+ *
+ * Options change the fields of `policy` they name and leave the others as
+ * they are, so a policy can refine another one. Errors are printed on
+ * stderr.
+ *
+ * @param argc The number of arguments.
+ * @param argv The arguments, starting with the builtin name.
+ * @param policy The policy the options are applied to.
+ * @return int The index of the first argument that is not an option, or -1
+ * if an option is invalid.
+ */
+int parseScheduleOptions(int argc, char *argv[], SchedulePolicy *policy);
+
+/**
+ * @brief Returns the policy applied to the commands being launched.
+ *
+ * @return const SchedulePolicy* The policy set by `escalona` while it runs a
+ * command line, or NULL if there is none.
+ */
+const SchedulePolicy *getActiveSchedule(void);
+
+/**
+ * @brief Sets the policy applied to the commands being launched.
+ *
+ * @param policy The policy, or NULL to launch commands without one. It must
+ * remain valid until it is replaced.
+ * @return const SchedulePolicy* The policy that was active before.
+ */
+const SchedulePolicy *setActiveSchedule(const SchedulePolicy *policy);
+
+/**
+ * @brief Returns the default policy of background jobs.
+ *
+ * @return const SchedulePolicy* The policy set with `escalona -j`, or NULL if
+ * there is none.
+ */
+const SchedulePolicy *getJobSchedule(void);
+
+/**
+ * @brief Applies a scheduling policy to the calling process.
+ *
+ * Called by the child process of a command, before the command runs. Errors
+ * are printed on stderr.
+ *
+ * @param policy The policy to apply.
+ * @return true on success, false if a part of the policy could not be
+ * applied.
+ */
+bool applySchedule(const SchedulePolicy *policy);
+
+/**
+ * @brief Records the CPUs of a process that has terminated.
+ *
+ * Must be called before the process is reaped. The kernel keeps the CPUs a
+ * process may run on and the CPU it ran on last, which are added to
+ * `allowed` and `used`.
+ *
+ * @param pid The pid of the process.
+ * @param allowed The CPUs the process was allowed to run on.
+ * @param used The CPUs the process ran on.
+ * @return true on success, false if the process could not be inspected.
+ */
+bool recordProcessCpus(pid_t pid, CpuList *allowed, CpuList *used);
+
+/**
+ * @brief Formats a set of CPUs as a list such as `0-3,6`.
+ *
+ * @param cpus The set of CPUs.
+ * @param buffer The buffer that receives the list.
+ * @param size The size of `buffer`.
+ * @return size_t The number of CPUs in the set.
+ */
+size_t formatCpuList(const CpuList *cpus, char *buffer, size_t size);
+
+#endif /* SCHEDULE_H */
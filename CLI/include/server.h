@@ -0,0 +1,41 @@
+/**
+ * @file server.h
+ * @author Enrique Rodrigues (a28602@alunos.ipca.pt)
+ * @brief Header file for the server mode of the interpreter.
+ *
+ * With `--serve path` the interpreter listens on a Unix socket instead of
+ * reading commands from a terminal or script. Each client sends command
+ * lines, which run one after the other in the order they were sent, while
+ * the lines of different clients run at the same time, up to a limit.
+ *
+ * Every line runs in a child copy of the server, whose stdout and stderr are
+ * the client socket, so output reaches the client as it is written. Once the
+ * line finishes, the server sends a NUL byte followed by its exit status and
+ * a newline. A single epoll loop accepts clients, reads their lines and
+ * learns when each line finishes through a pidfd.
+ *
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef SERVER_H
+#define SERVER_H
+
+/**
+ * @brief Serves command lines to the clients of a Unix socket.
+ *
+ * Returns when the server receives SIGINT or SIGTERM, after removing the
+ * socket.
+ *
+ * @param socket_path The path of the socket. A socket left there by a server
+ * that is no longer running is replaced.
+ * @param max_children The most lines running at once, or 0 for one per
+ * online CPU.
+ * @return int 0 if the server stopped on a signal, or 1 on error.
+ */
+int runServer(const char *socket_path, int max_children);
+
+#endif /* SERVER_H */
@@ -0,0 +1,125 @@
+/**
+ * @file trace.h
+ * @author Enrique Rodrigues (a28602@alunos.ipca.pt)
+ * @brief Header file for the execution trace of the interpreter.
+ *
+ * When enabled with `--trace file` or the `INTERPRETADOR_TRACE` environment
+ * variable, the interpreter appends one JSON object per line to the file for
+ * every command it runs:
+ *
+ * @code
+ * {"time":1760620000.123456,"version":"0.2","pid":4242,"kind":"program",
+ *  "argv":["ls","-l"],"path":"/usr/bin/ls","backend":"spawn",
+ *  "lookup_us":3.1,"spawn_us":412.0,"run_us":1830.5,"status":0,"signal":0,
+ *  "user_us":900,"sys_us":700,"max_rss_kb":3584,"minor_faults":120,
+ *  "major_faults":0,"voluntary_switches":1,"involuntary_switches":0}
+ * @endcode
+ *
+ * (shown on several lines here, written on a single line). `kind` is
+ * `program`, `bundled` or `builtin`. `spawn_us` is the time from the start of
+ * the launch until the program was executed, and `run_us` the time from the
+ * launch until the process was reaped.
+ *
+ * Records are written into a memory buffer and a writer thread moves them to
+ * the file, so the interpreter does not wait for the disk.
+ *
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdbool.h>
+#include <sys/resource.h>
+#include <sys/types.h>
+#include <time.h>
+
+#include "usage.h"
+
+/* Environment variable that names the trace file. */
+#define TRACE_ENV_VAR "INTERPRETADOR_TRACE"
+
+/* Kinds of traced commands. */
+#define TRACE_KIND_PROGRAM "program"  // program executed from a file
+#define TRACE_KIND_BUNDLED "bundled"  // bundled command run by the interpreter
+#define TRACE_KIND_BUILTIN "builtin"  // builtin of the interpreter
+
+/**
+ * @brief Starts writing the execution trace to a file.
+ *
+ * Records are appended to the file. The trace is flushed and closed when the
+ * interpreter exits.
+ *
+ * @param path The path of the trace file.
+ * @return true on success, false on error.
+ */
+bool openTrace(const char *path);
+
+/**
+ * @brief Writes the pending records and stops tracing.
+ */
+void closeTrace(void);
+
+/**
+ * @brief Checks if the execution trace is enabled.
+ *
+ * @return true if commands are being traced, false otherwise.
+ */
+bool isTracing(void);
+
+/**
+ * @brief Stops tracing in a child copy of the interpreter.
+ *
+ * The writer thread does not exist in a child created with fork(), so the
+ * child must not write records nor flush the trace when it exits.
+ */
+void disableTraceInChild(void);
+
+/**
+ * @brief Records the time spent finding the next command in the PATH.
+ *
+ * @param start When the search started, on the monotonic clock.
+ */
+void traceLookup(const struct timespec *start);
+
+/**
+ * @brief Records the launch of a process.
+ *
+ * The record is written when the process is reaped, by traceExit().
+ *
+ * @param pid The pid of the process.
+ * @param kind The kind of command.
+ * @param path The path of the executed program, or NULL.
+ * @param args The arguments of the command, terminated by NULL.
+ * @param start When the launch started, on the monotonic clock.
+ */
+void traceLaunch(pid_t pid, const char *kind, const char *path, char *args[],
+                 const struct timespec *start);
+
+/**
+ * @brief Writes the record of a process that was reaped.
+ *
+ * Processes that were not launched while tracing are ignored.
+ *
+ * @param pid The pid of the process.
+ * @param wait_status The status returned by wait4().
+ * @param rusage The resources used by the process.
+ */
+void traceExit(pid_t pid, int wait_status, const struct rusage *rusage);
+
+/**
+ * @brief Writes the record of a command that ran inside the interpreter.
+ *
+ * @param kind The kind of command.
+ * @param args The arguments of the command, terminated by NULL.
+ * @param status The exit status of the command.
+ * @param usage The resources used by the command.
+ */
+void traceInProcess(const char *kind, char *args[], int status,
+                    const CommandUsage *usage);
+
+#endif /* TRACE_H */
@@ -0,0 +1,146 @@
+/**
+ * @file usage.h
+ * @author Enrique Rodrigues (a28602@alunos.ipca.pt)
+ * @brief Header file for the resource accounting of commands.
+ *
+ * The interpreter measures every command it runs in the foreground: wall
+ * time, user and system CPU time, maximum resident set size, page faults and
+ * context switches. Processes contribute the usage returned by wait4() and
+ * commands running inside the interpreter contribute the difference of
+ * getrusage(). Measurements can be nested, so `tempo` works inside the
+ * always-on mode.
+ *
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef USAGE_H
+#define USAGE_H
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <sys/resource.h>
+#include <sys/time.h>
+#include <time.h>
+
+/**
+ * @brief Structure that holds the resources used by a command.
+ */
+typedef struct CommandUsage {
+  double wall_seconds;        // elapsed time
+  double user_seconds;        // CPU time in user mode
+  double system_seconds;      // CPU time in kernel mode
+  long max_rss_kb;            // largest resident set size, in kilobytes
+  long minor_faults;          // page faults served without I/O
+  long major_faults;          // page faults that required I/O
+  long voluntary_switches;    // context switches while waiting
+  long involuntary_switches;  // context switches by preemption
+} CommandUsage;
+
+/**
+ * @brief Structure that holds a measurement in progress.
+ *
+ * Meters form a stack, so that the processes waited for while a meter is
+ * active are counted by every enclosing meter.
+ */
+typedef struct UsageMeter {
+  struct timespec start;        // monotonic time at the start
+  struct rusage self_start;     // usage of the interpreter at the start
+  CommandUsage children;        // usage of the processes waited for
+  bool waited_children;         // whether any process was waited for
+  struct UsageMeter *previous;  // enclosing meter, or NULL
+} UsageMeter;
+
+/**
+ * @brief Starts measuring a command.
+ *
+ * @param meter The meter that holds the measurement.
+ */
+void beginUsage(UsageMeter *meter);
+
+/**
+ * @brief Finishes measuring a command.
+ *
+ * Must be called for the most recent meter started with beginUsage().
+ *
+ * @param meter The meter that holds the measurement.
+ * @param usage Receives the resources used since beginUsage().
+ */
+void endUsage(UsageMeter *meter, CommandUsage *usage);
+
+/**
+ * @brief Adds the usage of a process that was waited for.
+ *
+ * The usage is added to every active meter.
+ *
+ * @param rusage The usage returned by wait4().
+ */
+void addChildUsage(const struct rusage *rusage);
+
+/**
+ * @brief Converts the usage returned by the kernel.
+ *
+ * @param rusage The usage returned by getrusage() or wait4().
+ * @param wall_seconds The elapsed time.
+ * @param usage Receives the converted usage.
+ */
+void usageFromRusage(const struct rusage *rusage, double wall_seconds,
+                     CommandUsage *usage);
+
+/**
+ * @brief Adds one usage to another.
+ *
+ * Times and counters are added. The resident set size is the largest of
+ * both, since processes that ran one after the other do not add up.
+ *
+ * @param total The usage that is increased.
+ * @param usage The usage to add.
+ */
+void addUsage(CommandUsage *total, const CommandUsage *usage);
+
+/**
+ * @brief Prints a one-line summary of the resources used by a command.
+ *
+ * @param stream The stream to print to.
+ * @param usage The usage to print.
+ */
+void printUsage(FILE *stream, const CommandUsage *usage);
+
+/**
+ * @brief Adds the usage of a command to the session summary.
+ *
+ * Commands are grouped by name. The name of a pipeline is made of the names
+ * of its stages.
+ *
+ * @param command_line The command line that ran.
+ * @param usage The resources it used.
+ */
+void recordSessionUsage(const char *command_line, const CommandUsage *usage);
+
+/**
+ * @brief Prints the resources used by each command during the session.
+ *
+ * Commands are listed from the most to the least CPU time used.
+ *
+ * @param stream The stream to print to.
+ */
+void printSessionUsage(FILE *stream);
+
+/**
+ * @brief Selects whether a summary is printed after each command.
+ *
+ * @param enabled true to print the summary, false otherwise.
+ */
+void setUsageReporting(bool enabled);
+
+/**
+ * @brief Checks if a summary is printed after each command.
+ *
+ * @return true if the summary is printed, false otherwise.
+ */
+bool getUsageReporting(void);
+
+#endif /* USAGE_H */
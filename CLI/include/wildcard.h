@@ -0,0 +1,53 @@
+/**
+ * @file wildcard.h
+ * @author Enrique Rodrigues (a28602@alunos.ipca.pt)
+ * @brief Header file for the expansion of wildcard patterns into file names.
+ *
+ * Patterns support `*`, `?`, classes such as `[a-z]` or `[!0-9]`, and `**`
+ * as a whole path component, which matches any number of directories. A
+ * backslash makes the next character literal. Names starting with a dot are
+ * only matched by components that start with a dot.
+ *
+ * Each component is compiled once, and directories are read with
+ * getdents64(), whose entries carry the file type, so matching a directory
+ * does not stat() every entry.
+ *
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef WILDCARD_H
+#define WILDCARD_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "arena.h"
+
+/**
+ * @brief Expands a pattern into the paths that match it.
+ *
+ * The paths are sorted in byte order. A pattern ending with `/` only matches
+ * directories, and their paths end with `/`. Directories that cannot be read
+ * are skipped.
+ *
+ * @param arena The arena the paths and their array are allocated from.
+ * @param pattern The pattern.
+ * @param matches Receives the paths.
+ * @param match_count Receives the number of paths, 0 if nothing matched.
+ * @return true on success, false on memory allocation failure.
+ */
+bool expandWildcards(Arena *arena, const char *pattern, char ***matches,
+                     size_t *match_count);
+
+/**
+ * @brief Removes the backslashes that make characters of a pattern literal.
+ *
+ * @param pattern The pattern, modified in place.
+ */
+void unescapePattern(char *pattern);
+
+#endif /* WILDCARD_H */
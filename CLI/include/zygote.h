@@ -0,0 +1,67 @@
+/**
+ * @file zygote.h
+ * @author Enrique Rodrigues (a28602@alunos.ipca.pt)
+ * @brief Header file for the pool of pre-forked helper processes.
+ *
+ * With `opcao lancador zigoto` commands are not forked when they run.
+ * A small zygote process, forked once, keeps a pool of helper processes
+ * ready. Each helper is a copy of the zygote, like after fork(), and
+ * already has a clean signal mask and no descriptors other than its socket.
+ * It is created with `CLONE_PARENT`, so it is a child of the interpreter and
+ * is waited for like any other command.
+ *
+ * Ready helpers are queued on the control socket of the zygote. To launch a
+ * command, the interpreter takes the next helper and sends it the path and
+ * arguments, with the standard streams passed as `SCM_RIGHTS`. The helper
+ * executes the program, and the zygote creates a replacement in the
+ * background.
+ *
+ * Helpers inherit the environment and the working directory of the
+ * interpreter at the time the pool was started.
+ *
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef ZYGOTE_H
+#define ZYGOTE_H
+
+#include <stdbool.h>
+#include <sys/types.h>
+
+#include "execute.h"
+
+/**
+ * @brief Starts the zygote and fills the pool of helpers.
+ *
+ * Does nothing if the zygote is already running.
+ *
+ * @return true if the pool is available, false otherwise.
+ */
+bool startZygote(void);
+
+/**
+ * @brief Stops using the pool in a child copy of the interpreter.
+ *
+ * Helpers are children of the interpreter, so a copy of it could not wait
+ * for them. The copy launches commands with posix_spawn() instead.
+ */
+void disableZygoteInChild(void);
+
+/**
+ * @brief Launches a command in a helper from the pool.
+ *
+ * @param command_path The path to the command to be executed.
+ * @param args An array of strings containing the arguments for the command.
+ * @param io The descriptors the command uses as its standard streams.
+ * @param pid Receives the pid of the command.
+ * @return true if the command was handed to a helper, false if the pool is
+ * unavailable and the command must be launched some other way.
+ */
+bool spawnWithZygote(const char *command_path, char *args[],
+                     const CommandIO *io, pid_t *pid);
+
+#endif /* ZYGOTE_H */
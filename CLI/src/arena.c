@@ -0,0 +1,157 @@
+/**
+ * @file arena.c
+ * @author Enrique Rodrigues (a28602@alunos.ipca.pt)
+ * @brief Contains the bump allocator used while parsing commands.
+ * @version 0.1
+ * @date 2026-10-16
+ * @copyright Copyright (c) 2024
+ */
+#include "arena.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/* Alignment of every allocation, enough for any type. */
+#define ARENA_ALIGNMENT 16
+
+/* Size of the blocks, unless an allocation needs more. */
+#define ARENA_BLOCK_SIZE_BYTES (64 * 1024)
+
+/* Size of a block header, rounded up so the data after it is aligned. */
+#define ARENA_HEADER_SIZE                                          \
+  ((sizeof(ArenaBlock) + ARENA_ALIGNMENT - 1) & ~(size_t)(ARENA_ALIGNMENT - 1))
+
+/**
+ * @brief Rounds a size up to the alignment of the allocations.
+ *
+ * @param size The size.
+ * @return size_t The aligned size.
+ */
+static size_t alignSize(size_t size) {
+  return (size + ARENA_ALIGNMENT - 1) & ~(size_t)(ARENA_ALIGNMENT - 1);
+}
+
+/**
+ * @brief Returns the first byte of data of a block.
+ *
+ * @param block The block.
+ * @return char* The start of the data.
+ */
+static char *blockData(ArenaBlock *block) {
+  return (char *)block + ARENA_HEADER_SIZE;
+}
+
+/**
+ * @brief Initializes an empty arena.
+ *
+ * @param arena The arena to initialize.
+ */
+void initArena(Arena *arena) {
+  arena->block = NULL;
+  arena->last = NULL;
+}
+
+/**
+ * @brief Allocates memory from an arena.
+ *
+ * The memory is aligned for any type and stays valid until the arena is
+ * reset.
+ *
+ * @param arena The arena.
+ * @param size The number of bytes to allocate.
+ * @return void* The allocated memory, or NULL on memory allocation failure.
+ */
+void *arenaAlloc(Arena *arena, size_t size) {
+  size = alignSize(size);
+
+  ArenaBlock *block = arena->block;
+  if (block == NULL || block->capacity - block->used < size) {
+    size_t capacity =
+        (size > ARENA_BLOCK_SIZE_BYTES) ? size : ARENA_BLOCK_SIZE_BYTES;
+    block = malloc(ARENA_HEADER_SIZE + capacity);
+    if (block == NULL) {
+      return NULL;
+    }
+    block->previous = arena->block;
+    block->capacity = capacity;
+    block->used = 0;
+    arena->block = block;
+  }
+
+  void *memory = blockData(block) + block->used;
+  block->used += size;
+  arena->last = memory;
+  return memory;
+}
+
+/**
+ * @brief Changes the size of memory allocated from an arena.
+ *
+ * The most recent allocation grows or shrinks in place when its block has
+ * room. Any other allocation is copied to new memory.
+ *
+ * @param arena The arena.
+ * @param memory The memory to resize, returned by arenaAlloc().
+ * @param old_size The current size of `memory`.
+ * @param new_size The new size.
+ * @return void* The resized memory, or NULL on memory allocation failure, in
+ * which case `memory` is left unchanged.
+ */
+void *arenaResize(Arena *arena, void *memory, size_t old_size,
+                  size_t new_size) {
+  ArenaBlock *block = arena->block;
+  if (memory != NULL && memory == arena->last) {
+    size_t offset = (char *)memory - blockData(block);
+    if (alignSize(new_size) <= block->capacity - offset) {
+      block->used = offset + alignSize(new_size);
+      return memory;
+    }
+  }
+
+  void *new_memory = arenaAlloc(arena, new_size);
+  if (new_memory != NULL && memory != NULL) {
+    memcpy(new_memory, memory, (old_size < new_size) ? old_size : new_size);
+  }
+  return new_memory;
+}
+
+/**
+ * @brief Releases every allocation of an arena.
+ *
+ * The largest block is kept for the next allocations, so an arena that is
+ * reset after each command stops calling malloc() once it is warm.
+ *
+ * @param arena The arena.
+ */
+void resetArena(Arena *arena) {
+  ArenaBlock *largest = NULL;
+  ArenaBlock *block = arena->block;
+  while (block != NULL) {
+    ArenaBlock *previous = block->previous;
+    if (largest == NULL || block->capacity > largest->capacity) {
+      free(largest);
+      largest = block;
+    } else {
+      free(block);
+    }
+    block = previous;
+  }
+
+  if (largest != NULL) {
+    largest->previous = NULL;
+    largest->used = 0;
+  }
+  arena->block = largest;
+  arena->last = NULL;
+}
+
+/**
+ * @brief Releases the memory of an arena.
+ *
+ * @param arena The arena.
+ */
+void freeArena(Arena *arena) {
+  resetArena(arena);
+  free(arena->block);
+  arena->block = NULL;
+}
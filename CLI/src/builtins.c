@@ -0,0 +1,450 @@
+/**
+ * @file builtins.c
+ * @author Enrique Rodrigues (a28602@alunos.ipca.pt)
+ * @brief Contains the commands built into the interpreter.
+ * @version 0.1
+ * @date 2026-10-16
+ * @copyright Copyright (c) 2024
+ *
+ * @section Modifications
+ * - 2026-10-16: Added the paralelo builtin.
+ *   Enrique George Rodrigues (a28602@alunos.ipca.pt)
+ * - 2026-10-16: Added the tempo builtin and the tempo option.
+ *   Enrique George Rodrigues (a28602@alunos.ipca.pt)
+ * - 2026-10-16: opcao lancador accepts zigoto.
+ *   Enrique George Rodrigues (a28602@alunos.ipca.pt)
+ * - 2026-10-16: Added the escalona builtin.
+ *   Enrique George Rodrigues (a28602@alunos.ipca.pt)
+ * - 2026-10-16: Added the memo builtin and the memo option.
+ *   Enrique George Rodrigues (a28602@alunos.ipca.pt)
+ */
+#define _XOPEN_SOURCE 700
+
+#include "builtins.h"
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "command_cache.h"
+#include "commands.h"
+#include "constants.h"
+#include "execute.h"
+#include "find.h"
+#include "jobs.h"
+#include "memo.h"
+#include "parallel.h"
+#include "run.h"
+#include "schedule.h"
+#include "usage.h"
+#include "zygote.h"
+
+/* Help message of the `hash` builtin. */
+#define HASH_HELP_MESSAGE                                      \
+  "Usage: hash [-r] [-d name...] [name...]\n"                  \
+  "Displays or changes the table of resolved command paths.\n" \
+  "Options:\n"                                                 \
+  "  -r          Forget every resolved command.\n"             \
+  "  -d          Forget the given commands.\n"                 \
+  "  name        Resolve the given commands and remember them.\n"
+
+/* Whether bundled commands are executed as separate programs. */
+static bool force_external = false;
+
+/**
+ * @brief Implements the `hash` builtin.
+ *
+ * Without arguments it lists the cached commands. `-r` clears the cache, `-d`
+ * removes the named commands and any other name is resolved and cached.
+ *
+ * @param argc The number of arguments.
+ * @param argv The arguments, starting with the builtin name.
+ * @return int Returns 0 on success or 1 if a command could not be found.
+ */
+static int hashBuiltin(int argc, char *argv[]) {
+  if (argc == 1) {
+    syncCommandCache();
+    printCommandCache();
+    return EXIT_SUCCESS;
+  }
+
+  if (strcmp(argv[1], "--help") == 0) {
+    fputs(HASH_HELP_MESSAGE, stdout);
+    return EXIT_SUCCESS;
+  }
+
+  int status = EXIT_SUCCESS;
+  bool forget = false;
+  char command_path[BUFFER_SIZE_BYTES];
+
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "-r") == 0) {
+      clearCommandCache();
+    } else if (strcmp(argv[i], "-d") == 0) {
+      forget = true;
+    } else if (forget) {
+      if (!removeCachedCommand(argv[i])) {
+        fprintf(stderr, "hash: %s: not found\n", argv[i]);
+        status = EXIT_FAILURE;
+      }
+    } else if (!findCommandInPath(argv[i], command_path)) {
+      fprintf(stderr, "hash: %s: not found\n", argv[i]);
+      status = EXIT_FAILURE;
+    }
+  }
+
+  return status;
+}
+
+/**
+ * @brief Structure that describes an interpreter option.
+ *
+ * Options are changed at runtime with the `opcao` builtin. Each option has a
+ * function that returns its current value as a string and a function that
+ * parses and applies a new value.
+ */
+typedef struct Option {
+  const char *name;                // name of the option
+  const char *values;              // accepted values, for the help text
+  const char *(*get)(void);        // returns the current value
+  bool (*set)(const char *value);  // applies a new value
+} Option;
+
+/**
+ * @brief Returns the value of the `lancador` option.
+ *
+ * @return const char* The name of the current spawn backend.
+ */
+static const char *getLauncherOption(void) {
+  return spawnBackendName(getSpawnBackend());
+}
+
+/**
+ * @brief Sets the value of the `lancador` option.
+ *
+ * @param value The name of the spawn backend.
+ * @return true if the value is valid, false otherwise.
+ */
+static bool setLauncherOption(const char *value) {
+  SpawnBackend backend;
+  if (!parseSpawnBackend(value, &backend)) {
+    return false;
+  }
+  if (backend == SPAWN_BACKEND_ZYGOTE) {
+    startZygote();  // Fill the pool before the first command
+  }
+  setSpawnBackend(backend);
+  return true;
+}
+
+/**
+ * @brief Returns the value of the `externo` option.
+ *
+ * @return const char* "on" if bundled commands run as separate programs.
+ */
+static const char *getExternalOption(void) {
+  return force_external ? "on" : "off";
+}
+
+/**
+ * @brief Sets the value of the `externo` option.
+ *
+ * @param value "on" to run bundled commands as separate programs, "off" to
+ * run them inside the interpreter.
+ * @return true if the value is valid, false otherwise.
+ */
+static bool setExternalOption(const char *value) {
+  if (strcmp(value, "on") == 0) {
+    force_external = true;
+  } else if (strcmp(value, "off") == 0) {
+    force_external = false;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+/**
+ * @brief Returns the value of the `tempo` option.
+ *
+ * @return const char* "on" if a summary is printed after each command.
+ */
+static const char *getTimeOption(void) {
+  return getUsageReporting() ? "on" : "off";
+}
+
+/**
+ * @brief Sets the value of the `tempo` option.
+ *
+ * @param value "on" to print a summary of the resources used after each
+ * command, "off" otherwise.
+ * @return true if the value is valid, false otherwise.
+ */
+static bool setTimeOption(const char *value) {
+  if (strcmp(value, "on") == 0) {
+    setUsageReporting(true);
+  } else if (strcmp(value, "off") == 0) {
+    setUsageReporting(false);
+  } else {
+    return false;
+  }
+  return true;
+}
+
+/**
+ * @brief Returns the value of the `memo` option.
+ *
+ * @return const char* "on" if the results of pure commands are cached.
+ */
+static const char *getMemoOption(void) {
+  return isMemoEnabled() ? "on" : "off";
+}
+
+/**
+ * @brief Sets the value of the `memo` option.
+ *
+ * @param value "on" to cache the results of pure commands, "off" otherwise.
+ * @return true if the value is valid, false otherwise.
+ */
+static bool setMemoOption(const char *value) {
+  if (strcmp(value, "on") == 0) {
+    setMemoEnabled(true);
+  } else if (strcmp(value, "off") == 0) {
+    setMemoEnabled(false);
+  } else {
+    return false;
+  }
+  return true;
+}
+
+/* Table of the options known to the interpreter. */
+static const Option options[] = {
+    {"lancador", "spawn|fork|zigoto", getLauncherOption, setLauncherOption},
+    {"externo", "on|off", getExternalOption, setExternalOption},
+    {"tempo", "on|off", getTimeOption, setTimeOption},
+    {"memo", "on|off", getMemoOption, setMemoOption},
+};
+
+/* Number of entries in the options table. */
+#define OPTION_COUNT (sizeof(options) / sizeof(options[0]))
+
+/**
+ * @brief Implements the `opcao` builtin.
+ *
+ * Without arguments it lists every option and its value. With a name it shows
+ * the value of that option and with a name and a value it changes the option.
+ *
+ * @param argc The number of arguments.
+ * @param argv The arguments, starting with the builtin name.
+ * @return int Returns 0 on success or 1 on invalid usage.
+ */
+static int optionBuiltin(int argc, char *argv[]) {
+  if (argc == 1 || strcmp(argv[1], "--help") == 0) {
+    if (argc > 1) {
+      fputs("Usage: opcao [name [value]]\n", stdout);
+    }
+    for (size_t i = 0; i < OPTION_COUNT; i++) {
+      printf("%-12s %-16s (%s)\n", options[i].name, options[i].get(),
+             options[i].values);
+    }
+    return EXIT_SUCCESS;
+  }
+
+  for (size_t i = 0; i < OPTION_COUNT; i++) {
+    if (strcmp(options[i].name, argv[1]) != 0) {
+      continue;
+    }
+    if (argc == 2) {
+      puts(options[i].get());
+      return EXIT_SUCCESS;
+    }
+    if (!options[i].set(argv[2])) {
+      fprintf(stderr, "opcao: %s: invalid value '%s' (expected %s)\n",
+              argv[1], argv[2], options[i].values);
+      return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+  }
+
+  fprintf(stderr, "opcao: %s: unknown option\n", argv[1]);
+  return EXIT_FAILURE;
+}
+
+/**
+ * @brief Parses a job number given to a job builtin.
+ *
+ * Accepts both `N` and `%N`.
+ *
+ * @param arg The argument to parse.
+ * @param id Where to store the job number.
+ * @return true if `arg` is a valid job number, false otherwise.
+ */
+static bool parseJobId(const char *arg, int *id) {
+  if (*arg == '%') {
+    arg++;
+  }
+  char *end;
+  long value = strtol(arg, &end, 10);
+  if (*arg == '\0' || *end != '\0' || value <= 0) {
+    return false;
+  }
+  *id = (int)value;
+  return true;
+}
+
+/**
+ * @brief Implements the `jobs` builtin.
+ *
+ * Lists the background jobs with their number, state, start time, elapsed
+ * time and command line.
+ *
+ * @param argc The number of arguments.
+ * @param argv The arguments, starting with the builtin name.
+ * @return int Always returns 0.
+ */
+static int jobsBuiltin(int argc, char *argv[]) {
+  (void)argc;
+  (void)argv;
+  reapJobs();
+  printJobs();
+  return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Implements the `wait` builtin.
+ *
+ * Without arguments it waits for every background job. Otherwise it waits
+ * for the given jobs.
+ *
+ * @param argc The number of arguments.
+ * @param argv The arguments, starting with the builtin name.
+ * @return int The exit status of the last job waited for, or 127 if a job
+ * does not exist.
+ */
+static int waitBuiltin(int argc, char *argv[]) {
+  if (argc == 1) {
+    return waitAllJobs();
+  }
+
+  int status = EXIT_SUCCESS;
+  for (int i = 1; i < argc; i++) {
+    int id;
+    if (!parseJobId(argv[i], &id) || (status = waitJob(id, false)) == -1) {
+      fprintf(stderr, "wait: %s: no such job\n", argv[i]);
+      status = 127;
+    }
+  }
+  return status;
+}
+
+/**
+ * @brief Implements the `fg` builtin.
+ *
+ * Waits in the foreground for the given job, or for the most recent job when
+ * no job is given.
+ *
+ * @param argc The number of arguments.
+ * @param argv The arguments, starting with the builtin name.
+ * @return int The exit status of the job, or 1 if the job does not exist.
+ */
+static int fgBuiltin(int argc, char *argv[]) {
+  int id = -1;
+  if (argc > 1 && !parseJobId(argv[1], &id)) {
+    fprintf(stderr, "fg: %s: no such job\n", argv[1]);
+    return EXIT_FAILURE;
+  }
+
+  int status = waitJob(id, true);
+  if (status == -1) {
+    fprintf(stderr, "fg: %s: no such job\n", (argc > 1) ? argv[1] : "current");
+    return EXIT_FAILURE;
+  }
+  return status;
+}
+
+/**
+ * @brief Implements the `tempo` builtin.
+ *
+ * Runs a command line and prints the resources it used on stderr: elapsed
+ * time, user and system CPU time, maximum resident set size, minor/major page
+ * faults and voluntary/involuntary context switches.
+ *
+ * @param argc The number of arguments.
+ * @param argv The arguments, starting with the builtin name.
+ * @return int The exit status of the command line, or 1 on invalid usage.
+ */
+static int timeBuiltin(int argc, char *argv[]) {
+  if (argc < 2 || strcmp(argv[1], "--help") == 0) {
+    fputs("Usage: tempo command [args...]\n", (argc < 2) ? stderr : stdout);
+    return (argc < 2) ? EXIT_FAILURE : EXIT_SUCCESS;
+  }
+
+  UsageMeter meter;
+  beginUsage(&meter);
+  int status = runCommandLine(&argv[1], argc - 1);
+  CommandUsage usage;
+  endUsage(&meter, &usage);
+
+  printUsage(stderr, &usage);
+  return status;
+}
+
+/* Table of the builtins known to the interpreter. */
+static const Builtin builtins[] = {
+    {"escalona", scheduleBuiltin},
+    {"fg", fgBuiltin},
+    {"hash", hashBuiltin},
+    {"jobs", jobsBuiltin},
+    {"memo", memoBuiltin},
+    {"opcao", optionBuiltin},
+    {"paralelo", parallelBuiltin},
+    {"tempo", timeBuiltin},
+    {"wait", waitBuiltin},
+};
+
+/**
+ * @brief Finds the builtin with the given name.
+ *
+ * @param name The command name.
+ * @return const Builtin* The builtin, or NULL if `name` is not a builtin.
+ */
+const Builtin *findBuiltin(const char *name) {
+  for (size_t i = 0; i < sizeof(builtins) / sizeof(builtins[0]); i++) {
+    if (strcmp(builtins[i].name, name) == 0) {
+      return &builtins[i];
+    }
+  }
+  return NULL;
+}
+
+/* Table of the bundled commands linked into the interpreter. */
+static const BundledCommand bundled_commands[] = {
+    {"acrescenta", acrescenta_main}, {"apaga", apaga_main},
+    {"conta", conta_main},           {"copia", copia_main},
+    {"informa", informa_main},       {"lista", lista_main},
+    {"mostra", mostra_main},
+};
+
+/**
+ * @brief Finds the bundled command with the given name.
+ *
+ * Returns NULL when the `externo` option is enabled, so that bundled commands
+ * are looked up in the PATH and executed as separate programs.
+ *
+ * @param name The command name.
+ * @return const BundledCommand* The bundled command, or NULL if `name` must
+ * be executed as an external program.
+ */
+const BundledCommand *findBundledCommand(const char *name) {
+  if (force_external) {
+    return NULL;
+  }
+  for (size_t i = 0;
+       i < sizeof(bundled_commands) / sizeof(bundled_commands[0]); i++) {
+    if (strcmp(bundled_commands[i].name, name) == 0) {
+      return &bundled_commands[i];
+    }
+  }
+  return NULL;
+}
@@ -0,0 +1,231 @@
+/**
+ * @file command_cache.c
+ * @author Enrique Rodrigues (a28602@alunos.ipca.pt)
+ * @brief Contains the hash table that caches resolved command paths.
+ * @version 0.1
+ * @date 2026-10-16
+ * @copyright Copyright (c) 2024
+ */
+#define _XOPEN_SOURCE 700
+
+#include "command_cache.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* Number of buckets the table starts with (must be a power of two). */
+#define INITIAL_BUCKETS 64
+
+/* Hash table state. */
+static CacheEntry **buckets = NULL;  // bucket array
+static size_t bucket_count = 0;      // number of buckets
+static size_t entry_count = 0;       // number of stored entries
+static char *cached_path = NULL;     // value of PATH the entries belong to
+
+/**
+ * @brief Computes the FNV-1a hash of a string.
+ *
+ * @param str The string to hash.
+ * @return uint32_t The hash value.
+ */
+static uint32_t hashString(const char *str) {
+  uint32_t hash = 2166136261u;
+  while (*str != '\0') {
+    hash ^= (unsigned char)*str++;
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+/**
+ * @brief Frees an entry and the strings it owns.
+ *
+ * @param entry The entry to free.
+ */
+static void freeEntry(CacheEntry *entry) {
+  free(entry->name);
+  free(entry->path);
+  free(entry->dir);
+  free(entry);
+}
+
+/**
+ * @brief Doubles the number of buckets and rehashes every entry.
+ *
+ * If the new bucket array cannot be allocated the table keeps its current
+ * size, which only makes the chains longer.
+ */
+static void growTable(void) {
+  size_t new_count = bucket_count ? bucket_count * 2 : INITIAL_BUCKETS;
+  CacheEntry **new_buckets = calloc(new_count, sizeof(CacheEntry *));
+  if (new_buckets == NULL) {
+    return;
+  }
+
+  for (size_t i = 0; i < bucket_count; i++) {
+    CacheEntry *entry = buckets[i];
+    while (entry != NULL) {
+      CacheEntry *next = entry->next;
+      size_t index = hashString(entry->name) & (new_count - 1);
+      entry->next = new_buckets[index];
+      new_buckets[index] = entry;
+      entry = next;
+    }
+  }
+
+  free(buckets);
+  buckets = new_buckets;
+  bucket_count = new_count;
+}
+
+/**
+ * @brief Checks the cache against the current value of PATH.
+ *
+ * If the PATH environment variable changed since the cache was filled, every
+ * entry is discarded and the new value is remembered.
+ */
+void syncCommandCache(void) {
+  const char *path = getenv("PATH");
+  if (path == NULL) {
+    path = "";
+  }
+
+  if (cached_path != NULL && strcmp(cached_path, path) == 0) {
+    return;
+  }
+
+  clearCommandCache();
+  free(cached_path);
+  cached_path = strdup(path);
+}
+
+/**
+ * @brief Looks up a command name in the cache.
+ *
+ * @param name The command name.
+ * @return CacheEntry* The cached entry, or NULL if the name is not cached.
+ */
+CacheEntry *lookupCachedCommand(const char *name) {
+  if (bucket_count == 0) {
+    return NULL;
+  }
+
+  CacheEntry *entry = buckets[hashString(name) & (bucket_count - 1)];
+  while (entry != NULL && strcmp(entry->name, name) != 0) {
+    entry = entry->next;
+  }
+  return entry;
+}
+
+/**
+ * @brief Stores the resolution of a command name in the cache.
+ *
+ * An existing entry for the same name is replaced.
+ *
+ * @param name The command name.
+ * @param path The full path the command resolved to.
+ * @param dir The directory the command was found in.
+ * @param dir_mtime The modification time of `dir`.
+ * @param cwd_stat The status of the current directory, taken before the
+ * command was searched for.
+ * @return true if the entry was stored, false on memory allocation failure.
+ */
+bool storeCachedCommand(const char *name, const char *path, const char *dir,
+                        const struct timespec *dir_mtime,
+                        const struct stat *cwd_stat) {
+  removeCachedCommand(name);
+
+  // Keep the load factor under 3/4
+  if ((entry_count + 1) * 4 > bucket_count * 3) {
+    growTable();
+    if (bucket_count == 0) {
+      return false;
+    }
+  }
+
+  CacheEntry *entry = calloc(1, sizeof(CacheEntry));
+  if (entry == NULL) {
+    return false;
+  }
+  entry->name = strdup(name);
+  entry->path = strdup(path);
+  entry->dir = strdup(dir);
+  if (entry->name == NULL || entry->path == NULL || entry->dir == NULL) {
+    freeEntry(entry);
+    return false;
+  }
+  entry->dir_mtime = *dir_mtime;
+  entry->cwd_dev = cwd_stat->st_dev;
+  entry->cwd_ino = cwd_stat->st_ino;
+  entry->cwd_mtime = cwd_stat->st_mtim;
+
+  size_t index = hashString(name) & (bucket_count - 1);
+  entry->next = buckets[index];
+  buckets[index] = entry;
+  entry_count++;
+  return true;
+}
+
+/**
+ * @brief Removes a command name from the cache.
+ *
+ * @param name The command name.
+ * @return true if an entry was removed, false if the name was not cached.
+ */
+bool removeCachedCommand(const char *name) {
+  if (bucket_count == 0) {
+    return false;
+  }
+
+  CacheEntry **link = &buckets[hashString(name) & (bucket_count - 1)];
+  while (*link != NULL) {
+    if (strcmp((*link)->name, name) == 0) {
+      CacheEntry *entry = *link;
+      *link = entry->next;
+      freeEntry(entry);
+      entry_count--;
+      return true;
+    }
+    link = &(*link)->next;
+  }
+  return false;
+}
+
+/**
+ * @brief Removes every entry from the cache.
+ */
+void clearCommandCache(void) {
+  for (size_t i = 0; i < bucket_count; i++) {
+    CacheEntry *entry = buckets[i];
+    while (entry != NULL) {
+      CacheEntry *next = entry->next;
+      freeEntry(entry);
+      entry = next;
+    }
+    buckets[i] = NULL;
+  }
+  entry_count = 0;
+}
+
+/**
+ * @brief Prints the cached commands and their hit counts to stdout.
+ *
+ * The output follows the format of the bash `hash` builtin.
+ */
+void printCommandCache(void) {
+  if (entry_count == 0) {
+    puts("hash: hash table empty");
+    return;
+  }
+
+  puts("hits\tcommand");
+  for (size_t i = 0; i < bucket_count; i++) {
+    for (CacheEntry *entry = buckets[i]; entry != NULL; entry = entry->next) {
+      printf("%4lu\t%s\n", entry->hits, entry->path);
+    }
+  }
+}
@@ -2,40 +2,493 @@
  * @file execute.c
  * @author Enrique Rodrigues (a28602@alunos.ipca.pt)
  * @brief Contains functions for executing external commands.
- * @version 0.1
+ * @version 0.2
  * @date 2024-04-21
  * @copyright Copyright (c) 2024
+ *
+ * @section Modifications
+ * - 2026-10-16: Commands are launched with posix_spawn() by default, with
+ *               fork() kept as a runtime selectable fallback. The exit status
+ *               of the command is now reported.
+ *   Enrique George Rodrigues (a28602@alunos.ipca.pt)
+ * - 2026-10-16: Added in-process execution of the bundled commands.
+ *   Enrique George Rodrigues (a28602@alunos.ipca.pt)
+ * - 2026-10-16: Commands can be launched without waiting and with their
+ *               standard streams connected to other descriptors.
+ *   Enrique George Rodrigues (a28602@alunos.ipca.pt)
+ * - 2026-10-16: Commands start with an empty signal mask, since the
+ *               interpreter blocks SIGCHLD to reap background jobs.
+ *   Enrique George Rodrigues (a28602@alunos.ipca.pt)
+ * - 2026-10-16: The newline after each command can be disabled.
+ *   Enrique George Rodrigues (a28602@alunos.ipca.pt)
+ * - 2026-10-16: Builtins can run in a child process.
+ *   Enrique George Rodrigues (a28602@alunos.ipca.pt)
+ * - 2026-10-16: waitCommand() collects the resource usage of the command with
+ *               wait4().
+ *   Enrique George Rodrigues (a28602@alunos.ipca.pt)
+ * - 2026-10-16: Launches and exits of commands are recorded in the execution
+ *               trace.
+ *   Enrique George Rodrigues (a28602@alunos.ipca.pt)
+ * - 2026-10-16: Added the zigoto backend, which hands commands to pre-forked
+ *               helpers.
+ *   Enrique George Rodrigues (a28602@alunos.ipca.pt)
+ * - 2026-10-16: executeCommand() and executeBundledCommand() take the streams
+ *               of the command, for redirections.
+ *   Enrique George Rodrigues (a28602@alunos.ipca.pt)
+ * - 2026-10-16: Commands run by escalona are launched with fork() and get its
+ *               scheduling policy before they start.
+ *   Enrique George Rodrigues (a28602@alunos.ipca.pt)
+ * - 2026-10-16: reportExitStatus() is public, for the result cache.
+ *   Enrique George Rodrigues (a28602@alunos.ipca.pt)
+ * - 2026-10-16: forkInProcessChild() is public, for the server mode.
+ *   Enrique George Rodrigues (a28602@alunos.ipca.pt)
  */
+#define _GNU_SOURCE
+
+#include "execute.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <spawn.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
 #include <sys/types.h>
 #include <sys/wait.h>
+#include <time.h>
 #include <unistd.h>
 
+#include "builtins.h"
+#include "redirect.h"
+#include "schedule.h"
+#include "trace.h"
+#include "usage.h"
+#include "zygote.h"
+
+/* Environment passed to the commands. */
+extern char **environ;
+
+/* Backend used to launch commands. */
+static SpawnBackend spawn_backend = SPAWN_BACKEND_SPAWN;
+
+/* Whether a newline is printed after the output of each command. */
+static bool interactive_output = true;
+
+/* Names of the backends, indexed by `SpawnBackend`. */
+static const char *const backend_names[] = {"spawn", "fork", "zigoto"};
+
 /**
- * @brief Executes a command with the given arguments.
+ * @brief Selects the backend used to launch commands.
  *
- * This function creates a child process using fork() and executes the specified
- * command with the provided arguments using execvp(). If the fork or execvp
- * operation fails, an error message is printed, and the function returns.
+ * @param backend The backend to use from now on.
+ */
+void setSpawnBackend(SpawnBackend backend) { spawn_backend = backend; }
+
+/**
+ * @brief Returns the backend used to launch commands.
+ *
+ * @return SpawnBackend The current backend.
+ */
+SpawnBackend getSpawnBackend(void) { return spawn_backend; }
+
+/**
+ * @brief Selects whether a newline is printed after each command.
+ *
+ * The newline separates the output of a command from the next prompt. It is
+ * disabled in script mode, where no prompt is shown.
+ *
+ * @param enabled true to print the newline, false otherwise.
+ */
+void setInteractiveOutput(bool enabled) { interactive_output = enabled; }
+
+/**
+ * @brief Ends the output of a command.
+ *
+ * Prints the newline that separates the output of a command from the next
+ * prompt, when running interactively.
+ */
+void finishCommandOutput(void) {
+  if (interactive_output) {
+    fputs("\n", stdout);  // Put newline
+  }
+}
+
+/**
+ * @brief Returns the name of a backend.
+ *
+ * @param backend The backend.
+ * @return const char* The name used to select the backend.
+ */
+const char *spawnBackendName(SpawnBackend backend) {
+  return backend_names[backend];
+}
+
+/**
+ * @brief Finds the backend with the given name.
+ *
+ * @param name The name of the backend.
+ * @param backend Where to store the backend.
+ * @return true if `name` names a backend, false otherwise.
+ */
+bool parseSpawnBackend(const char *name, SpawnBackend *backend) {
+  for (size_t i = 0; i < sizeof(backend_names) / sizeof(backend_names[0]);
+       i++) {
+    if (strcmp(backend_names[i], name) == 0) {
+      *backend = (SpawnBackend)i;
+      return true;
+    }
+  }
+  return false;
+}
+
+/* Descriptors of a command that inherits the interpreter's streams. */
+const CommandIO DEFAULT_COMMAND_IO = {STDIN_FILENO, STDOUT_FILENO,
+                                      STDERR_FILENO};
+
+/**
+ * @brief Prepares a child process to execute or run a command.
+ *
+ * Clears the signal mask inherited from the interpreter and connects the
+ * standard streams of the process.
+ *
+ * @param io The descriptors to use as stdin, stdout and stderr.
+ * @return true on success, false if a descriptor could not be duplicated.
+ */
+static bool prepareChild(const CommandIO *io) {
+  sigset_t empty_mask;
+  sigemptyset(&empty_mask);
+  sigprocmask(SIG_SETMASK, &empty_mask, NULL);
+
+  const int fds[] = {io->in_fd, io->out_fd, io->err_fd};
+  for (int target = 0; target < 3; target++) {
+    if (fds[target] != target && dup2(fds[target], target) == -1) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * @brief Launches a command with posix_spawn().
+ *
+ * The C library implements posix_spawn() with a vfork-style clone that shares
+ * the address space of the interpreter, so no page tables are copied no
+ * matter how much memory the interpreter uses.
+ *
+ * @param command_path The path to the command to be executed.
+ * @param args An array of strings containing the arguments for the command.
+ * @param io The descriptors the command uses as its standard streams.
+ * @return pid_t The pid of the command, or -1 on failure.
+ */
+static pid_t spawnWithPosixSpawn(const char *command_path, char *args[],
+                                 const CommandIO *io) {
+  posix_spawnattr_t attributes;
+  posix_spawnattr_init(&attributes);
+  sigset_t empty_mask;
+  sigemptyset(&empty_mask);
+  posix_spawnattr_setsigmask(&attributes, &empty_mask);
+  posix_spawnattr_setflags(&attributes, POSIX_SPAWN_SETSIGMASK);
+
+  posix_spawn_file_actions_t actions;
+  posix_spawn_file_actions_init(&actions);
+  const int fds[] = {io->in_fd, io->out_fd, io->err_fd};
+  for (int target = 0; target < 3; target++) {
+    if (fds[target] != target) {
+      posix_spawn_file_actions_adddup2(&actions, fds[target], target);
+    }
+  }
+
+  pid_t pid;
+  int error =
+      posix_spawn(&pid, command_path, &actions, &attributes, args, environ);
+  posix_spawn_file_actions_destroy(&actions);
+  posix_spawnattr_destroy(&attributes);
+  if (error != 0) {
+    fprintf(stderr, "Error executing command: %s\n", strerror(error));
+    return -1;
+  }
+  return pid;
+}
+
+/**
+ * @brief Launches a command with fork() and execve().
  *
  * @param command_path The path to the command to be executed.
  * @param args An array of strings containing the arguments for the command.
+ * @param io The descriptors the command uses as its standard streams.
+ * @return pid_t The pid of the command, or -1 on failure.
  */
-void executeCommand(const char *command_path, char *args[]) {
+static pid_t spawnWithFork(const char *command_path, char *args[],
+                           const CommandIO *io) {
+  // While tracing, the end of this pipe tells when the program was executed
+  int exec_pipe[2] = {-1, -1};
+  if (isTracing() && pipe2(exec_pipe, O_CLOEXEC) == -1) {
+    exec_pipe[0] = exec_pipe[1] = -1;
+  }
+
   pid_t pid = fork();
   if (pid < 0) {
-    fputs("Error executing program.", stderr);
-    return;
+    perror("Error executing program");
+    if (exec_pipe[0] != -1) {
+      close(exec_pipe[0]);
+      close(exec_pipe[1]);
+    }
+    return -1;
   }
   if (pid == 0) {
     // Child process
-    execvp(command_path, args);
+    if (prepareChild(io)) {
+      const SchedulePolicy *policy = getActiveSchedule();
+      if (policy != NULL && !applySchedule(policy)) {
+        _exit(EXIT_FAILURE);
+      }
+      execve(command_path, args, environ);
+    }
     perror("Error executing command");
-    exit(EXIT_FAILURE);
+    _exit(EXIT_FAILURE);
+  }
+
+  if (exec_pipe[0] != -1) {
+    // The write end is closed by execve() or when the child exits
+    close(exec_pipe[1]);
+    char byte;
+    while (read(exec_pipe[0], &byte, 1) == -1 && errno == EINTR) {
+    }
+    close(exec_pipe[0]);
+  }
+  return pid;
+}
+
+/**
+ * @brief Launches a command without waiting for it.
+ *
+ * @param command_path The path to the command to be executed.
+ * @param args An array of strings containing the arguments for the command.
+ * @param io The descriptors the command uses as its standard streams.
+ * @return pid_t The pid of the command, or -1 on failure.
+ */
+pid_t launchCommand(const char *command_path, char *args[],
+                    const CommandIO *io) {
+  // Flush pending output so it is not duplicated or reordered by the child
+  fflush(stdout);
+
+  struct timespec start;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  pid_t pid;
+  // Neither posix_spawn() nor the helpers can change the CPUs, priorities or
+  // cgroup of the command, so commands run by `escalona` are forked
+  if (spawn_backend == SPAWN_BACKEND_FORK || getActiveSchedule() != NULL) {
+    pid = spawnWithFork(command_path, args, io);
+  } else if (spawn_backend != SPAWN_BACKEND_ZYGOTE ||
+             !spawnWithZygote(command_path, args, io, &pid)) {
+    // posix_spawn() also covers commands the helper pool cannot take
+    pid = spawnWithPosixSpawn(command_path, args, io);
+  }
+  traceLaunch(pid, TRACE_KIND_PROGRAM, command_path, args, &start);
+  return pid;
+}
+
+/**
+ * @brief Creates a child copy of the interpreter to run a command in-process.
+ *
+ * In the child, the standard streams are connected and every other
+ * descriptor is closed, so that pipes see end-of-file as soon as their
+ * writers finish.
+ *
+ * @param io The descriptors the child uses as its standard streams.
+ * @return pid_t 0 in the child, the pid of the child in the parent, or -1 on
+ * failure.
+ */
+pid_t forkInProcessChild(const CommandIO *io) {
+  fflush(stdout);
+  fflush(stderr);
+
+  pid_t pid = fork();
+  if (pid < 0) {
+    perror("Error executing program");
+    return -1;
+  }
+  if (pid == 0) {
+    // Child process
+    disableTraceInChild();
+    disableZygoteInChild();
+    if (!prepareChild(io)) {
+      perror("Error executing command");
+      _exit(EXIT_FAILURE);
+    }
+    closefrom(STDERR_FILENO + 1);
+    const SchedulePolicy *policy = getActiveSchedule();
+    if (policy != NULL && !applySchedule(policy)) {
+      _exit(EXIT_FAILURE);
+    }
+  }
+  return pid;
+}
+
+/**
+ * @brief Launches a bundled command in a child process without waiting.
+ *
+ * The child is a copy of the interpreter that calls the entry point of the
+ * command directly, so the program is not executed nor dynamically linked
+ * again. Descriptors other than the standard streams are closed in the child
+ * so that pipes see end-of-file as soon as their writers finish.
+ *
+ * @param command The bundled command to run.
+ * @param arg_count The number of arguments in `args`.
+ * @param args An array of strings containing the arguments for the command.
+ * @param io The descriptors the command uses as its standard streams.
+ * @return pid_t The pid of the child, or -1 on failure.
+ */
+pid_t launchBundledCommand(const BundledCommand *command, int arg_count,
+                           char *args[], const CommandIO *io) {
+  struct timespec start;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  pid_t pid = forkInProcessChild(io);
+  if (pid == 0) {
+    int status = command->function(arg_count, (const char **)args);
+    fflush(stdout);
+    _exit(status);
+  }
+  traceLaunch(pid, TRACE_KIND_BUNDLED, NULL, args, &start);
+  return pid;
+}
+
+/**
+ * @brief Launches a builtin in a child process without waiting.
+ *
+ * Used when a builtin is part of a pipeline or of a background job. The
+ * builtin runs in a copy of the interpreter, so changes it makes to the
+ * interpreter state are not kept.
+ *
+ * @param builtin The builtin to run.
+ * @param arg_count The number of arguments in `args`.
+ * @param args An array of strings containing the arguments for the builtin.
+ * @param io The descriptors the builtin uses as its standard streams.
+ * @return pid_t The pid of the child, or -1 on failure.
+ */
+pid_t launchBuiltin(const Builtin *builtin, int arg_count, char *args[],
+                    const CommandIO *io) {
+  struct timespec start;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  pid_t pid = forkInProcessChild(io);
+  if (pid == 0) {
+    int status = builtin->function(arg_count, args);
+    fflush(stdout);
+    _exit(status);
+  }
+  traceLaunch(pid, TRACE_KIND_BUILTIN, NULL, args, &start);
+  return pid;
+}
+
+/**
+ * @brief Reports a non-zero exit status on stderr.
+ *
+ * @param status The exit status of a command.
+ */
+void reportExitStatus(int status) {
+  if (status != EXIT_SUCCESS) {
+    fprintf(stderr, "Command exited with status %d\n", status);
+  }
+}
+
+/**
+ * @brief Converts a status returned by waitpid() into an exit status.
+ *
+ * @param wait_status The status returned by waitpid().
+ * @return int The exit status of the process, or 128 plus the signal number
+ * if the process was killed by a signal.
+ */
+int exitStatusFromWait(int wait_status) {
+  if (WIFSIGNALED(wait_status)) {
+    return 128 + WTERMSIG(wait_status);
+  }
+  return WEXITSTATUS(wait_status);
+}
+
+/**
+ * @brief Waits for a command and reports how it terminated.
+ *
+ * The resources used by the command are added to the active usage meters
+ * and to the execution trace.
+ *
+ * @param pid The pid of the command.
+ * @return int The exit status of the command, or 128 plus the signal number
+ * if the command was killed by a signal.
+ */
+int waitCommand(pid_t pid) {
+  int wait_status;
+  struct rusage usage;
+  while (wait4(pid, &wait_status, 0, &usage) == -1) {
+    if (errno != EINTR) {
+      perror("Error waiting for command");
+      return EXIT_FAILURE;
+    }
+  }
+  addChildUsage(&usage);
+  traceExit(pid, wait_status, &usage);
+
+  if (WIFSIGNALED(wait_status)) {
+    int signal_number = WTERMSIG(wait_status);
+    fprintf(stderr, "Command terminated by signal %d (%s)\n", signal_number,
+            strsignal(signal_number));
   } else {
-    // Parent process
-    wait(NULL);           // Wait for the child process to finish
-    fputs("\n", stdout);  // Put newline
+    reportExitStatus(WEXITSTATUS(wait_status));
+  }
+  return exitStatusFromWait(wait_status);
+}
+
+/**
+ * @brief Executes a command with the given arguments.
+ *
+ * This function launches the command at `command_path` with the selected
+ * backend and waits for it to finish. The path is executed as given, without
+ * searching the PATH again.
+ *
+ * @param command_path The path to the command to be executed.
+ * @param args An array of strings containing the arguments for the command.
+ * @param io The descriptors the command uses as its standard streams.
+ * @return int The exit status of the command, or 128 plus the signal number
+ * if the command was killed by a signal.
+ */
+int executeCommand(const char *command_path, char *args[],
+                   const CommandIO *io) {
+  pid_t pid = launchCommand(command_path, args, io);
+  if (pid < 0) {
+    return EXIT_FAILURE;
+  }
+
+  int status = waitCommand(pid);  // Wait for the child process to finish
+  finishCommandOutput();
+  return status;
+}
+
+/**
+ * @brief Executes a bundled command inside the interpreter.
+ *
+ * The command runs in the interpreter process, so no process is created.
+ * While it runs, the streams of the interpreter are connected to those in
+ * `io`, so the command writes straight to a redirected file. Buffered output
+ * is flushed around the call to keep it ordered with the output of other
+ * commands.
+ *
+ * @param command The bundled command to execute.
+ * @param arg_count The number of arguments in `args`.
+ * @param args An array of strings containing the arguments for the command.
+ * @param io The descriptors the command uses as its standard streams.
+ * @return int The exit status of the command.
+ */
+int executeBundledCommand(const BundledCommand *command, int arg_count,
+                          char *args[], const CommandIO *io) {
+  int saved_fds[3];
+  if (!redirectInterpreter(io, saved_fds)) {
+    return EXIT_FAILURE;
   }
+  int status = command->function(arg_count, (const char **)args);
+  restoreInterpreter(saved_fds);
+
+  reportExitStatus(status);
+  finishCommandOutput();
+  return status;
 }
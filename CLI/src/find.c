@@ -2,9 +2,19 @@
  * @file find.c
  * @author Enrique Rodrigues (a28602@alunos.ipca.pt)
  * @brief Contains functions for finding executable files in the PATH.
- * @version 0.1
+ * @version 0.2
  * @date 2024-04-21
  * @copyright Copyright (c) 2024
+ *
+ * @section Modifications
+ * - 2026-10-16: Cached commands are checked against the current directory,
+ *               which takes precedence over the PATH.
+ *   Enrique George Rodrigues (a28602@alunos.ipca.pt)
+ * - 2026-10-16: Resolved commands are cached, so repeated commands do not
+ *               rescan the PATH.
+ *   Enrique George Rodrigues (a28602@alunos.ipca.pt)
+ * - 2026-10-16: Added resolveCommand().
+ *   Enrique George Rodrigues (a28602@alunos.ipca.pt)
  */
 #define _XOPEN_SOURCE 700
 #define _DEFAULT_SOURCE
@@ -14,10 +24,13 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/stat.h>
 #include <sys/types.h>
 #include <sys/wait.h>
 #include <unistd.h>
 
+#include "command_cache.h"
+
 /**
  * @brief Checks if a file is executable.
  *
@@ -28,33 +41,129 @@
  */
 bool isExecutableFile(const char *path) { return access(path, X_OK) == 0; }
 
+/**
+ * @brief Checks whether two modification times are the same.
+ *
+ * @param a The first time.
+ * @param b The second time.
+ * @return true if they are equal, false otherwise.
+ */
+static bool isSameTime(const struct timespec *a, const struct timespec *b) {
+  return a->tv_sec == b->tv_sec && a->tv_nsec == b->tv_nsec;
+}
+
+/**
+ * @brief Checks whether a cached entry is still valid.
+ *
+ * An entry stays valid while the directory it was found in has not been
+ * modified, since adding, removing or renaming an executable changes the
+ * modification time of its directory. The current directory is searched
+ * first, so the entry is also dropped when it is another directory or was
+ * modified. The check costs a stat() call besides the one of the current
+ * directory, and none for commands found in the current directory.
+ *
+ * @param entry The cached entry.
+ * @param cwd_stat The status of the current directory.
+ * @return true if the entry can be used, false if it must be resolved again.
+ */
+static bool isCacheEntryValid(const CacheEntry *entry,
+                              const struct stat *cwd_stat) {
+  if (cwd_stat->st_dev != entry->cwd_dev ||
+      cwd_stat->st_ino != entry->cwd_ino ||
+      !isSameTime(&cwd_stat->st_mtim, &entry->cwd_mtime)) {
+    return false;
+  }
+  if (strcmp(entry->dir, ".") == 0) {
+    return true;  // Already checked as the current directory
+  }
+  struct stat dir_stat;
+  if (stat(entry->dir, &dir_stat) == -1) {
+    return false;
+  }
+  return isSameTime(&dir_stat.st_mtim, &entry->dir_mtime);
+}
+
+/**
+ * @brief Searches a directory for a command and caches the result.
+ *
+ * @param dir The directory to search.
+ * @param command The name of the command to search for.
+ * @param command_path A buffer to store the full path of the command.
+ * @param cwd_stat The status of the current directory, or NULL to not cache
+ * the result.
+ * @return true if the command is found in `dir`, false otherwise.
+ */
+static bool searchDirectory(const char *dir, const char *command,
+                            char *command_path, const struct stat *cwd_stat) {
+  snprintf(command_path, BUFFER_SIZE_BYTES, "%s/%s", dir, command);
+  if (!isExecutableFile(command_path)) {
+    return false;
+  }
+
+  // Remember the directory state so later lookups can skip the search
+  struct stat dir_stat;
+  if (cwd_stat != NULL && stat(dir, &dir_stat) == 0) {
+    storeCachedCommand(command, command_path, dir, &dir_stat.st_mtim,
+                       cwd_stat);
+  }
+  return true;
+}
+
 /**
  * @brief Finds the full path of a command in the PATH environment variable.
  *
- * This function searches for the specified command in the directories listed
- * in the PATH environment variable. If the command is found, its full path is
- * copied to the provided buffer.
+ * This function searches for the specified command in the current directory
+ * and then in the directories listed in the PATH environment variable. If the
+ * command is found, its full path is copied to the provided buffer.
+ *
+ * Resolutions are kept in the command cache, so a repeated command is resolved
+ * without any access() call. Cached entries are dropped when PATH changes,
+ * when the directory they were found in is modified, or when the current
+ * directory is another one or was modified, since a command added there
+ * takes precedence.
  *
  * @param command The name of the command to search for.
  * @param command_path A buffer to store the full path of the command.
  * @return true if the command is found, false otherwise.
  */
 bool findCommandInPath(const char *command, char *command_path) {
+  // Drop every entry if PATH changed since the cache was filled
+  syncCommandCache();
+
+  // The current directory is taken before searching, so a change made to it
+  // during the search invalidates the entry
+  struct stat cwd_stat;
+  const struct stat *cwd = (stat(".", &cwd_stat) == 0) ? &cwd_stat : NULL;
+
+  CacheEntry *entry = lookupCachedCommand(command);
+  if (entry != NULL) {
+    if (cwd != NULL && isCacheEntryValid(entry, cwd)) {
+      entry->hits++;
+      snprintf(command_path, BUFFER_SIZE_BYTES, "%s", entry->path);
+      return true;
+    }
+    removeCachedCommand(command);
+  }
+
   // Check if the command is executable in the current directory
-  if (isExecutableFile(command)) {
-    strcpy(command_path, command);
+  if (searchDirectory(".", command, command_path, cwd)) {
     return true;
   }
 
   // Search for the command in the PATH
   char *path = getenv("PATH");
+  if (path == NULL) {
+    return false;
+  }
   char *path_copy = strdup(path);
+  if (path_copy == NULL) {
+    return false;
+  }
   char *rest = path_copy;  // Pointer to keep track of the remaining string
 
   char *dir = strsep(&rest, ":");
   while (dir != NULL) {
-    snprintf(command_path, BUFFER_SIZE_BYTES, "%s/%s", dir, command);
-    if (isExecutableFile(command_path)) {
+    if (*dir != '\0' && searchDirectory(dir, command, command_path, cwd)) {
       free(path_copy);
       return true;
     }
@@ -64,3 +173,21 @@ bool findCommandInPath(const char *command, char *command_path) {
   free(path_copy);
   return false;
 }
+
+/**
+ * @brief Resolves the path of the program a command name refers to.
+ *
+ * A name containing a slash is a path to the program itself and is used as
+ * given. Any other name is searched with findCommandInPath().
+ *
+ * @param command The name of the command.
+ * @param command_path A buffer to store the path of the program.
+ * @return true if the command was resolved, false otherwise.
+ */
+bool resolveCommand(const char *command, char *command_path) {
+  if (strchr(command, '/') != NULL) {
+    snprintf(command_path, BUFFER_SIZE_BYTES, "%s", command);
+    return true;
+  }
+  return findCommandInPath(command, command_path);
+}
@@ -5,42 +5,478 @@
  * @version 0.1
  * @date 2024-04-21
  * @copyright Copyright (c) 2024
+ *
+ * @section Modifications
+ * - 2026-10-16: Replaced the space splitter with a lexer that handles quotes,
+ *               escapes, tabs and variables, with no limit on the number of
+ *               arguments. Arguments are allocated from an arena.
+ *   Enrique George Rodrigues (a28602@alunos.ipca.pt)
+ * - 2026-10-16: Arguments with wildcards outside quotes are expanded into file
+ *               names.
+ *   Enrique George Rodrigues (a28602@alunos.ipca.pt)
+ * - 2026-10-16: Added the redirection operators.
+ *   Enrique George Rodrigues (a28602@alunos.ipca.pt)
  */
-#define _DEFAULT_SOURCE
+#define _XOPEN_SOURCE 700
+
+#include "input_parser.h"
 
+#include <stdbool.h>
+#include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+#include "arena.h"
+#include "constants.h"
+#include "wildcard.h"
+
+/* Initial capacities, both grow by doubling. */
+#define INITIAL_ARG_CAPACITY 16   // arguments of a command
+#define INITIAL_WORD_CAPACITY 64  // bytes of an argument
+
+extern char **environ;
+
+/*
+ * Operators are returned as pointers to these strings, so an argument that was
+ * quoted, such as "|", is never taken for an operator.
+ */
+static char pipe_token[] = PIPE_OPERATOR;
+static char background_token[] = BACKGROUND_OPERATOR;
+static char input_token[] = INPUT_REDIRECT;
+static char output_token[] = OUTPUT_REDIRECT;
+static char append_token[] = APPEND_REDIRECT;
+static char error_token[] = ERROR_REDIRECT;
+static char error_append_token[] = ERROR_APPEND_REDIRECT;
+
+/* Every operator token, for isOperator(). */
+static char *const operator_tokens[] = {
+    pipe_token,   background_token, input_token,       output_token,
+    append_token, error_token,      error_append_token};
+
 /**
- * @brief Parses an input string into arguments.
+ * @brief Structure that holds the state of the lexer for one command.
+ */
+typedef struct Lexer {
+  Arena *arena;          // arena the arguments are allocated from
+  const char *next;      // next character of the input
+  char **args;           // arguments found so far
+  int arg_count;         // number of arguments in `args`
+  int arg_capacity;      // capacity of `args`, without the final NULL
+  char *word;            // argument being read
+  size_t word_length;    // number of bytes in `word`
+  size_t word_capacity;  // capacity of `word`
+  bool wildcards;        // whether `word` has wildcards outside quotes
+  bool escaped;          // whether `word` has quoted wildcards, escaped
+} Lexer;
+
+/**
+ * @brief Checks if a character separates arguments.
+ *
+ * @param c The character.
+ * @return true for spaces, tabs and newlines, false otherwise.
+ */
+static bool isBlank(char c) {
+  return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+/**
+ * @brief Checks if a character can be part of a variable name.
  *
- * This function tokenizes the input string by spaces and stores the tokens
- * in the provided array of strings (`args`). The maximum number of arguments
- * that can be stored in the `args` array is specified by `max_args`.
+ * @param c The character.
+ * @param first Whether it is the first character of the name.
+ * @return true if the character is allowed, false otherwise.
+ */
+static bool isNameChar(char c, bool first) {
+  return c == '_' || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+         (!first && c >= '0' && c <= '9');
+}
+
+/**
+ * @brief Appends bytes to the argument being read.
  *
- * @param input The input string to be parsed.
- * @param args An array of strings to store the parsed arguments.
- * @param max_args The maximum number of arguments that can be stored.
- * @return int The number of arguments parsed and stored in the `args` array.
+ * @param lexer The lexer.
+ * @param text The bytes to append.
+ * @param length The number of bytes.
+ * @return true on success, false on memory allocation failure.
  */
-int parseInput(char *input, char *args[], int max_args) {
-  char *token;
-  int arg_count = 0;
-  char *rest = input;  // Pointer to keep track of the remaining string
+static bool appendToWord(Lexer *lexer, const char *text, size_t length) {
+  // Keep room for the null terminator
+  if (lexer->word_length + length >= lexer->word_capacity) {
+    size_t capacity = lexer->word_capacity;
+    while (lexer->word_length + length >= capacity) {
+      capacity *= 2;
+    }
+    char *word =
+        arenaResize(lexer->arena, lexer->word, lexer->word_capacity, capacity);
+    if (word == NULL) {
+      return false;
+    }
+    lexer->word = word;
+    lexer->word_capacity = capacity;
+  }
+
+  memcpy(lexer->word + lexer->word_length, text, length);
+  lexer->word_length += length;
+  return true;
+}
 
-  // Tokenize the input string by spaces using strsep()
-  while ((token = strsep(&rest, " ")) != NULL && arg_count < max_args) {
-    // Ignore empty tokens
-    if (*token == '\0') {
+/**
+ * @brief Appends bytes that came from quotes, escapes or variables.
+ *
+ * Wildcard characters and backslashes are escaped with a backslash, so they
+ * stay literal if the argument is expanded as a pattern. The backslashes are
+ * removed again when it is not.
+ *
+ * @param lexer The lexer.
+ * @param text The bytes to append.
+ * @param length The number of bytes.
+ * @return true on success, false on memory allocation failure.
+ */
+static bool appendLiteral(Lexer *lexer, const char *text, size_t length) {
+  size_t start = 0;
+  for (size_t i = 0; i < length; i++) {
+    if (strchr("*?[]\\", text[i]) == NULL || text[i] == '\0') {
       continue;
     }
-    // Store the token in the args array
-    args[arg_count++] = token;
+    if (!appendToWord(lexer, text + start, i - start) ||
+        !appendToWord(lexer, "\\", 1)) {
+      return false;
+    }
+    lexer->escaped = true;
+    start = i;
   }
+  return appendToWord(lexer, text + start, length - start);
+}
 
-  // Ensure the last element of args is NULL
-  args[arg_count] = NULL;
+/**
+ * @brief Appends an argument to the list of arguments.
+ *
+ * @param lexer The lexer.
+ * @param arg The argument.
+ * @return true on success, false on memory allocation failure.
+ */
+static bool appendArgument(Lexer *lexer, char *arg) {
+  if (lexer->arg_count == lexer->arg_capacity) {
+    int capacity = lexer->arg_capacity * 2;
+    char **args = arenaResize(lexer->arena, lexer->args,
+                              (lexer->arg_capacity + 1) * sizeof(char *),
+                              (capacity + 1) * sizeof(char *));
+    if (args == NULL) {
+      return false;
+    }
+    lexer->args = args;
+    lexer->arg_capacity = capacity;
+  }
+
+  lexer->args[lexer->arg_count++] = arg;
+  return true;
+}
+
+/**
+ * @brief Looks up the value of an environment variable.
+ *
+ * @param name The name of the variable, which does not need to be
+ * null-terminated.
+ * @param length The length of the name.
+ * @return const char* The value, or an empty string if it is not set.
+ */
+static const char *findVariable(const char *name, size_t length) {
+  for (char **entry = environ; *entry != NULL; entry++) {
+    if (strncmp(*entry, name, length) == 0 && (*entry)[length] == '=') {
+      return *entry + length + 1;
+    }
+  }
+  return "";
+}
+
+/**
+ * @brief Expands a variable at the start of the input.
+ *
+ * Handles `$NAME` and `${NAME}`. A `$` that does not start a variable is kept
+ * as it is.
+ *
+ * @param lexer The lexer, positioned on the `$`.
+ * @return true on success, false on memory allocation failure.
+ */
+static bool expandVariable(Lexer *lexer) {
+  const char *name = lexer->next + 1;
+  bool braces = (*name == '{');
+  if (braces) {
+    name++;
+  }
 
-  return arg_count;
+  size_t length = 0;
+  while (isNameChar(name[length], length == 0)) {
+    length++;
+  }
+  if (length == 0 || (braces && name[length] != '}')) {
+    lexer->next++;
+    return appendToWord(lexer, "$", 1);
+  }
+
+  lexer->next = name + length + (braces ? 1 : 0);
+  const char *value = findVariable(name, length);
+  return appendLiteral(lexer, value, strlen(value));
+}
+
+/**
+ * @brief Reads the part of an argument inside single quotes.
+ *
+ * @param lexer The lexer, positioned after the opening quote.
+ * @return int 1 on success, 0 if the quote is not closed or -1 on memory
+ * allocation failure.
+ */
+static int readSingleQuoted(Lexer *lexer) {
+  const char *end = strchr(lexer->next, '\'');
+  if (end == NULL) {
+    return 0;
+  }
+  if (!appendLiteral(lexer, lexer->next, end - lexer->next)) {
+    return -1;
+  }
+  lexer->next = end + 1;
+  return 1;
+}
+
+/**
+ * @brief Reads the part of an argument inside double quotes.
+ *
+ * Variables are expanded, and a backslash only escapes `$`, `"` and `\`.
+ *
+ * @param lexer The lexer, positioned after the opening quote.
+ * @return int 1 on success, 0 if the quote is not closed or -1 on memory
+ * allocation failure.
+ */
+static int readDoubleQuoted(Lexer *lexer) {
+  while (*lexer->next != '"') {
+    const char *start = lexer->next;
+    bool ok = true;
+
+    if (*start == '\0') {
+      return 0;
+    } else if (*start == '$') {
+      ok = expandVariable(lexer);
+    } else if (*start == '\\' && start[1] != '\0' &&
+               strchr("$\"\\", start[1]) != NULL) {
+      ok = appendLiteral(lexer, start + 1, 1);
+      lexer->next += 2;
+    } else {
+      // Copy the run of characters that need no processing at once
+      size_t length = strcspn(start, "\"$\\");
+      ok = appendLiteral(lexer, start, (length > 0) ? length : 1);
+      lexer->next += (length > 0) ? length : 1;
+    }
+
+    if (!ok) {
+      return -1;
+    }
+  }
+
+  lexer->next++;
+  return 1;
+}
+
+/**
+ * @brief Replaces the argument that was read by the files it matches.
+ *
+ * An argument that matches no file is kept, without its escapes.
+ *
+ * @param lexer The lexer.
+ * @return int 1 on success or -1 on memory allocation failure.
+ */
+static int expandWord(Lexer *lexer) {
+  char **matches;
+  size_t match_count;
+  if (!expandWildcards(lexer->arena, lexer->word, &matches, &match_count)) {
+    return -1;
+  }
+
+  if (match_count == 0) {
+    unescapePattern(lexer->word);
+    return appendArgument(lexer, lexer->word) ? 1 : -1;
+  }
+  for (size_t i = 0; i < match_count; i++) {
+    if (!appendArgument(lexer, matches[i])) {
+      return -1;
+    }
+  }
+  return 1;
+}
+
+/**
+ * @brief Reads one argument.
+ *
+ * The argument ends at a blank or an operator outside quotes. An argument
+ * made only of variables that are not set is dropped, like in the shell, and
+ * one with wildcards outside quotes is expanded into file names.
+ *
+ * @param lexer The lexer, positioned on the first character of the argument.
+ * @return int 1 on success, 0 on syntax error or -1 on memory allocation
+ * failure.
+ */
+static int readWord(Lexer *lexer) {
+  lexer->word_capacity = INITIAL_WORD_CAPACITY;
+  lexer->word = arenaAlloc(lexer->arena, lexer->word_capacity);
+  lexer->word_length = 0;
+  lexer->wildcards = false;
+  lexer->escaped = false;
+  if (lexer->word == NULL) {
+    return -1;
+  }
+
+  bool quoted = false;
+  while (1) {
+    const char *start = lexer->next;
+    int result = 1;
+
+    if (*start == '\0' || isBlank(*start) || strchr("|&;<>", *start) != NULL) {
+      break;
+    } else if (*start == '\'' || *start == '"') {
+      quoted = true;
+      lexer->next++;
+      result = (*start == '\'') ? readSingleQuoted(lexer)
+                                : readDoubleQuoted(lexer);
+      if (result == 0) {
+        fputs("Syntax error: unterminated quote\n", stderr);
+      }
+    } else if (*start == '\\' && start[1] != '\0') {
+      result = appendLiteral(lexer, start + 1, 1) ? 1 : -1;
+      lexer->next += 2;
+    } else if (*start == '$') {
+      result = expandVariable(lexer) ? 1 : -1;
+    } else if (*start == '*' || *start == '?' || *start == '[') {
+      lexer->wildcards = true;
+      result = appendToWord(lexer, start, 1) ? 1 : -1;
+      lexer->next++;
+    } else {
+      // Copy the run of characters that need no processing at once
+      size_t length = strcspn(start, " \t\n\r|&;<>'\"\\$*?[");
+      if (length == 0) {
+        length = 1;  // A backslash at the end of the line
+      }
+      result = appendToWord(lexer, start, length) ? 1 : -1;
+      lexer->next += length;
+    }
+
+    if (result != 1) {
+      return result;
+    }
+  }
+
+  if (lexer->word_length == 0 && !quoted) {
+    return 1;
+  }
+
+  // Give back the unused capacity, the word is the last allocation
+  lexer->word[lexer->word_length] = '\0';
+  arenaResize(lexer->arena, lexer->word, lexer->word_capacity,
+              lexer->word_length + 1);
+  if (lexer->wildcards) {
+    return expandWord(lexer);
+  }
+  if (lexer->escaped) {
+    unescapePattern(lexer->word);
+  }
+  return appendArgument(lexer, lexer->word) ? 1 : -1;
+}
+
+/**
+ * @brief Reads a redirection operator.
+ *
+ * @param lexer The lexer, positioned on the operator.
+ * @return char* The token of the operator.
+ */
+static char *readRedirection(Lexer *lexer) {
+  if (*lexer->next == '<') {
+    lexer->next++;
+    return input_token;
+  }
+
+  bool error = (*lexer->next == '2');
+  lexer->next += error ? 2 : 1;
+  bool append = (*lexer->next == '>');
+  lexer->next += append;
+  if (error) {
+    return append ? error_append_token : error_token;
+  }
+  return append ? append_token : output_token;
+}
+
+/**
+ * @brief Parses the next command of a line into arguments.
+ *
+ * Arguments are separated by spaces or tabs. Single quotes keep their content
+ * as it is, double quotes expand variables, and a backslash outside quotes
+ * escapes the next character. `$NAME` and `${NAME}` are replaced by the value
+ * of the environment variable, and arguments with wildcards outside quotes
+ * are replaced by the files they match. The pipe, background and redirection
+ * operators are returned as separate arguments, which isOperator()
+ * recognizes, and the list separator ends the command.
+ *
+ * The arguments and their array are allocated from the arena and stay valid
+ * until it is reset. There is no limit on their number.
+ *
+ * @param arena The arena the arguments are allocated from.
+ * @param input Pointer to the rest of the line. It is moved past the command
+ * and its separator, and set to NULL at the end of the line.
+ * @param args Receives the arguments, terminated by NULL.
+ * @return int The number of arguments, or -1 on syntax error or memory
+ * allocation failure.
+ */
+int parseCommand(Arena *arena, const char **input, char ***args) {
+  Lexer lexer = {arena, *input, NULL, 0, INITIAL_ARG_CAPACITY,
+                 NULL,  0,      0,    false, false};
+  lexer.args = arenaAlloc(arena, (INITIAL_ARG_CAPACITY + 1) * sizeof(char *));
+  if (lexer.args == NULL) {
+    fputs("Error: Memory allocation failed.\n", stderr);
+    return -1;
+  }
+
+  while (*lexer.next != '\0' && *lexer.next != LIST_SEPARATOR[0]) {
+    char c = *lexer.next;
+    int result = 1;
+
+    if (isBlank(c)) {
+      lexer.next++;
+    } else if (c == PIPE_OPERATOR[0] || c == BACKGROUND_OPERATOR[0]) {
+      char *token = (c == PIPE_OPERATOR[0]) ? pipe_token : background_token;
+      result = appendArgument(&lexer, token) ? 1 : -1;
+      lexer.next++;
+    } else if (c == '<' || c == '>' || (c == '2' && lexer.next[1] == '>')) {
+      result = appendArgument(&lexer, readRedirection(&lexer)) ? 1 : -1;
+    } else {
+      result = readWord(&lexer);
+    }
+
+    if (result == -1) {
+      fputs("Error: Memory allocation failed.\n", stderr);
+    }
+    if (result != 1) {
+      return -1;
+    }
+  }
+
+  *input = (*lexer.next != '\0') ? lexer.next + 1 : NULL;
+  lexer.args[lexer.arg_count] = NULL;
+  *args = lexer.args;
+  return lexer.arg_count;
+}
+
+/**
+ * @brief Checks if an argument returned by parseCommand() is an operator.
+ *
+ * @param arg The argument.
+ * @param operator The operator, such as PIPE_OPERATOR.
+ * @return true if the argument is that operator and was not quoted, false
+ * otherwise.
+ */
+bool isOperator(const char *arg, const char *operator) {
+  size_t count = sizeof(operator_tokens) / sizeof(operator_tokens[0]);
+  for (size_t i = 0; i < count; i++) {
+    if (arg == operator_tokens[i]) {
+      return strcmp(arg, operator) == 0;
+    }
+  }
+  return false;
 }
@@ -0,0 +1,397 @@
+/**
+ * @file jobs.c
+ * @author Enrique Rodrigues (a28602@alunos.ipca.pt)
+ * @brief Contains the table of background jobs.
+ * @version 0.1
+ * @date 2026-10-16
+ * @copyright Copyright (c) 2024
+ *
+ * @section Modifications
+ * - 2026-10-16: Jobs are reaped with wait4() and their resource usage is added
+ *               to the session summary.
+ *   Enrique George Rodrigues (a28602@alunos.ipca.pt)
+ * - 2026-10-16: Job processes are recorded in the execution trace.
+ *   Enrique George Rodrigues (a28602@alunos.ipca.pt)
+ * - 2026-10-16: Jobs started with a scheduling policy report the CPUs they ran
+ *               on.
+ *   Enrique George Rodrigues (a28602@alunos.ipca.pt)
+ */
+#define _GNU_SOURCE
+
+#include "jobs.h"
+
+#include <errno.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/signalfd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "constants.h"
+#include "execute.h"
+#include "schedule.h"
+#include "trace.h"
+#include "usage.h"
+
+/* Job table state. */
+static Job *jobs = NULL;      // jobs in the order they were started
+static int job_count = 0;     // number of jobs in the table
+static int job_capacity = 0;  // number of jobs the table can hold
+static int next_job_id = 1;   // number given to the next job
+static int signal_fd = -1;    // signalfd that reports SIGCHLD
+
+/**
+ * @brief Prepares the interpreter to reap background jobs.
+ *
+ * Blocks SIGCHLD and creates the signalfd that reports it. Commands are
+ * started with an empty signal mask, so they are not affected by this.
+ *
+ * @return true on success, false if the signalfd could not be created.
+ */
+bool initJobControl(void) {
+  sigset_t mask;
+  sigemptyset(&mask);
+  sigaddset(&mask, SIGCHLD);
+
+  if (sigprocmask(SIG_BLOCK, &mask, NULL) == -1) {
+    perror("Error blocking SIGCHLD");
+    return false;
+  }
+
+  signal_fd = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+  if (signal_fd == -1) {
+    perror("Error creating signalfd");
+    sigprocmask(SIG_UNBLOCK, &mask, NULL);
+    return false;
+  }
+  return true;
+}
+
+/**
+ * @brief Returns the descriptor that becomes readable when a child exits.
+ *
+ * @return int The signalfd descriptor, or -1 if job control is unavailable.
+ */
+int jobSignalFd(void) { return signal_fd; }
+
+/**
+ * @brief Adds a job to the table.
+ *
+ * @param command_line The command line that started the job.
+ * @param pids The processes of the job. Entries equal to -1 are ignored.
+ * @param pid_count The number of entries in `pids`.
+ * @param report_cpus Whether to record the CPUs the processes ran on and
+ * print them when the job is reported.
+ * @return int The number of the job, or -1 on failure.
+ */
+int addJob(const char *command_line, const pid_t pids[], int pid_count,
+           bool report_cpus) {
+  if (job_count == job_capacity) {
+    int new_capacity = job_capacity ? job_capacity * 2 : 8;
+    Job *new_jobs = realloc(jobs, new_capacity * sizeof(Job));
+    if (new_jobs == NULL) {
+      return -1;
+    }
+    jobs = new_jobs;
+    job_capacity = new_capacity;
+  }
+
+  Job *job = &jobs[job_count];
+  memset(job, 0, sizeof(Job));
+  job->command_line = strdup(command_line);
+  job->pids = malloc(pid_count * sizeof(pid_t));
+  if (job->command_line == NULL || job->pids == NULL) {
+    free(job->command_line);
+    free(job->pids);
+    return -1;
+  }
+
+  for (int i = 0; i < pid_count; i++) {
+    job->pids[i] = pids[i];
+    if (pids[i] != -1) {
+      job->running++;
+    }
+  }
+  job->pid_count = pid_count;
+  job->report_cpus = report_cpus;
+  job->id = next_job_id++;
+  job->start_time = time(NULL);
+  clock_gettime(CLOCK_MONOTONIC, &job->start);
+  job->state = (job->running > 0) ? JOB_RUNNING : JOB_DONE;
+  job->status = EXIT_FAILURE;
+  job->end = job->start;
+  job_count++;
+
+  return job->id;
+}
+
+/**
+ * @brief Computes the seconds elapsed between two monotonic times.
+ *
+ * @param start The start time.
+ * @param end The end time.
+ * @return double The elapsed seconds.
+ */
+static double elapsedSeconds(const struct timespec *start,
+                             const struct timespec *end) {
+  return (double)(end->tv_sec - start->tv_sec) +
+         (double)(end->tv_nsec - start->tv_nsec) / 1e9;
+}
+
+/**
+ * @brief Records the termination of a process of a job.
+ *
+ * @param job The job the process belongs to.
+ * @param index The index of the process in the job.
+ * @param wait_status The status returned by wait4().
+ * @param rusage The resources used by the process.
+ */
+static void markProcessDone(Job *job, int index, int wait_status,
+                            const struct rusage *rusage) {
+  // The status of a pipeline is the status of its last stage
+  if (index == job->pid_count - 1) {
+    job->status = exitStatusFromWait(wait_status);
+  }
+  traceExit(job->pids[index], wait_status, rusage);
+  job->pids[index] = -1;
+  job->running--;
+
+  CommandUsage usage;
+  usageFromRusage(rusage, 0, &usage);
+  addUsage(&job->usage, &usage);
+
+  if (job->running == 0) {
+    job->state = JOB_DONE;
+    clock_gettime(CLOCK_MONOTONIC, &job->end);
+    job->usage.wall_seconds = elapsedSeconds(&job->start, &job->end);
+    recordSessionUsage(job->command_line, &job->usage);
+  }
+}
+
+/**
+ * @brief Records the CPUs of a process of a job once it has terminated.
+ *
+ * The process is left unreaped, so that the kernel still has its CPUs.
+ *
+ * @param job The job the process belongs to.
+ * @param index The index of the process in the job.
+ * @param block Whether to wait for the process to terminate.
+ * @return true if the process has terminated, false otherwise.
+ */
+static bool recordJobCpus(Job *job, int index, bool block) {
+  siginfo_t info;
+  info.si_pid = 0;
+  int options = WEXITED | WNOWAIT | (block ? 0 : WNOHANG);
+  while (waitid(P_PID, job->pids[index], &info, options) == -1) {
+    if (errno != EINTR) {
+      return true;  // Let wait4() report the error
+    }
+  }
+  if (info.si_pid != job->pids[index]) {
+    return false;
+  }
+  recordProcessCpus(job->pids[index], &job->allowed_cpus, &job->used_cpus);
+  return true;
+}
+
+/**
+ * @brief Reaps the processes of background jobs that have terminated.
+ *
+ * Drains the signalfd and collects every finished job process without
+ * blocking. Other children of the interpreter are not touched.
+ */
+void reapJobs(void) {
+  // Several exits may be merged into a single pending signal
+  struct signalfd_siginfo info;
+  while (signal_fd != -1 && read(signal_fd, &info, sizeof(info)) > 0) {
+  }
+
+  for (int i = 0; i < job_count; i++) {
+    Job *job = &jobs[i];
+    for (int p = 0; p < job->pid_count && job->running > 0; p++) {
+      int wait_status;
+      struct rusage rusage;
+      if (job->pids[p] == -1 ||
+          (job->report_cpus && !recordJobCpus(job, p, false))) {
+        continue;
+      }
+      if (wait4(job->pids[p], &wait_status, WNOHANG, &rusage) ==
+          job->pids[p]) {
+        markProcessDone(job, p, wait_status, &rusage);
+      }
+    }
+  }
+}
+
+/**
+ * @brief Prints a job in the format used by the job builtins.
+ *
+ * @param job The job to print.
+ */
+static void printJob(const Job *job) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  const struct timespec *end = (job->state == JOB_DONE) ? &job->end : &now;
+
+  char started[16];
+  strftime(started, sizeof(started), "%H:%M:%S", localtime(&job->start_time));
+
+  char state[32];
+  if (job->state == JOB_RUNNING) {
+    snprintf(state, sizeof(state), "Running");
+  } else if (job->status == EXIT_SUCCESS) {
+    snprintf(state, sizeof(state), "Done");
+  } else {
+    snprintf(state, sizeof(state), "Exit %d", job->status);
+  }
+
+  printf("[%d]  %-10s %s %8.2fs  %s", job->id, state, started,
+         elapsedSeconds(&job->start, end), job->command_line);
+
+  // The kernel only keeps the CPU each process ran on last
+  char used[BUFFER_SIZE_BYTES];
+  char allowed[BUFFER_SIZE_BYTES];
+  size_t used_count = 0;
+  if (job->report_cpus && job->state == JOB_DONE) {
+    used_count = formatCpuList(&job->used_cpus, used, sizeof(used));
+    formatCpuList(&job->allowed_cpus, allowed, sizeof(allowed));
+  }
+  if (used_count > 0) {
+    printf("  (ran on CPU%s %s, allowed %s)", (used_count > 1) ? "s" : "",
+           used, allowed);
+  }
+  putchar('\n');
+}
+
+/**
+ * @brief Removes the job at the given index from the table.
+ *
+ * @param index The index of the job.
+ */
+static void removeJob(int index) {
+  free(jobs[index].command_line);
+  free(jobs[index].pids);
+  memmove(&jobs[index], &jobs[index + 1],
+          (job_count - index - 1) * sizeof(Job));
+  job_count--;
+
+  if (job_count == 0) {
+    next_job_id = 1;
+  }
+}
+
+/**
+ * @brief Prints and removes the jobs that are done.
+ *
+ * @return true if at least one job was reported, false otherwise.
+ */
+bool reportFinishedJobs(void) {
+  bool reported = false;
+  for (int i = 0; i < job_count;) {
+    if (jobs[i].state == JOB_DONE) {
+      printJob(&jobs[i]);
+      removeJob(i);
+      reported = true;
+    } else {
+      i++;
+    }
+  }
+  fflush(stdout);
+  return reported;
+}
+
+/**
+ * @brief Prints every job in the table to stdout.
+ */
+void printJobs(void) {
+  for (int i = 0; i < job_count; i++) {
+    printJob(&jobs[i]);
+  }
+}
+
+/**
+ * @brief Blocks until every process of a job has terminated.
+ *
+ * @param job The job to wait for.
+ */
+static void waitJobProcesses(Job *job) {
+  for (int p = 0; p < job->pid_count; p++) {
+    int wait_status;
+    struct rusage rusage;
+    if (job->pids[p] == -1) {
+      continue;
+    }
+    if (job->report_cpus) {
+      recordJobCpus(job, p, true);
+    }
+    while (wait4(job->pids[p], &wait_status, 0, &rusage) == -1) {
+      if (errno != EINTR) {
+        wait_status = EXIT_FAILURE << 8;
+        memset(&rusage, 0, sizeof(rusage));
+        break;
+      }
+    }
+    markProcessDone(job, p, wait_status, &rusage);
+  }
+}
+
+/**
+ * @brief Waits for a job to finish and removes it from the table.
+ *
+ * A job that records its CPUs is printed once it finishes, to report them.
+ *
+ * @param id The number of the job, or -1 for the most recent job.
+ * @param show Whether to print the command line of the job before waiting.
+ * @return int The exit status of the job, or -1 if there is no such job.
+ */
+int waitJob(int id, bool show) {
+  int index = (id == -1) ? job_count - 1 : -1;
+  for (int i = 0; i < job_count && index == -1; i++) {
+    if (jobs[i].id == id) {
+      index = i;
+    }
+  }
+  if (index < 0) {
+    return -1;
+  }
+
+  if (show) {
+    puts(jobs[index].command_line);
+    fflush(stdout);
+  }
+
+  waitJobProcesses(&jobs[index]);
+  if (jobs[index].report_cpus) {
+    printJob(&jobs[index]);
+  }
+  int status = jobs[index].status;
+  removeJob(index);
+  return status;
+}
+
+/**
+ * @brief Waits for every job to finish and empties the table.
+ *
+ * Jobs that record their CPUs are printed once they finish, to report them.
+ *
+ * @return int The exit status of the last job waited for, or 0 if there
+ * were no jobs.
+ */
+int waitAllJobs(void) {
+  int status = EXIT_SUCCESS;
+  while (job_count > 0) {
+    waitJobProcesses(&jobs[0]);
+    if (jobs[0].report_cpus) {
+      printJob(&jobs[0]);
+    }
+    status = jobs[0].status;
+    removeJob(0);
+  }
+  return status;
+}
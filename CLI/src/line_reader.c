@@ -0,0 +1,219 @@
+/**
+ * @file line_reader.c
+ * @author Enrique Rodrigues (a28602@alunos.ipca.pt)
+ * @brief Contains the buffered line reader used by the interpreter.
+ * @version 0.1
+ * @date 2026-10-16
+ * @copyright Copyright (c) 2024
+ */
+#define _XOPEN_SOURCE 700
+
+#include "line_reader.h"
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include "constants.h"
+
+/**
+ * @brief Initializes a line reader.
+ *
+ * @param reader The reader to initialize.
+ * @param fd The descriptor to read from.
+ * @return true on success, false on memory allocation failure.
+ */
+bool initLineReader(LineReader *reader, int fd) {
+  memset(reader, 0, sizeof(LineReader));
+  reader->fd = fd;
+  reader->capacity = LINE_BUFFER_SIZE_BYTES;
+  reader->buffer = malloc(reader->capacity);
+  return reader->buffer != NULL;
+}
+
+/**
+ * @brief Releases the memory of a line reader.
+ *
+ * @param reader The reader.
+ */
+void freeLineReader(LineReader *reader) {
+  free(reader->buffer);
+  reader->buffer = NULL;
+}
+
+/**
+ * @brief Drops the line returned by the previous call to readLine().
+ *
+ * @param reader The reader.
+ */
+static void consumeLine(LineReader *reader) {
+  reader->head = (reader->head + reader->consumed) % reader->capacity;
+  reader->length -= reader->consumed;
+  reader->consumed = 0;
+  if (reader->length == 0) {
+    reader->head = 0;  // Keep future reads contiguous
+  }
+}
+
+/**
+ * @brief Finds the end of the first buffered line.
+ *
+ * @param reader The reader.
+ * @return size_t The offset of the newline from `head`, or `length` if no
+ * complete line is buffered.
+ */
+static size_t findNewline(const LineReader *reader) {
+  size_t first_part = reader->capacity - reader->head;
+  if (first_part > reader->length) {
+    first_part = reader->length;
+  }
+
+  const char *start = reader->buffer + reader->head;
+  const char *newline = memchr(start, '\n', first_part);
+  if (newline != NULL) {
+    return newline - start;
+  }
+
+  // Search the part that wrapped around to the start of the buffer
+  newline = memchr(reader->buffer, '\n', reader->length - first_part);
+  if (newline != NULL) {
+    return first_part + (newline - reader->buffer);
+  }
+  return reader->length;
+}
+
+/**
+ * @brief Moves the buffered data to the start of the buffer.
+ *
+ * Used when a line wraps around the end of the ring buffer, so that it can be
+ * returned as a contiguous string.
+ *
+ * @param reader The reader.
+ * @return true on success, false on memory allocation failure.
+ */
+static bool linearize(LineReader *reader) {
+  if (reader->head + reader->length <= reader->capacity) {
+    memmove(reader->buffer, reader->buffer + reader->head, reader->length);
+  } else {
+    char *copy = malloc(reader->capacity);
+    if (copy == NULL) {
+      return false;
+    }
+    size_t first_part = reader->capacity - reader->head;
+    memcpy(copy, reader->buffer + reader->head, first_part);
+    memcpy(copy + first_part, reader->buffer, reader->length - first_part);
+    free(reader->buffer);
+    reader->buffer = copy;
+  }
+  reader->head = 0;
+  return true;
+}
+
+/**
+ * @brief Doubles the capacity of the buffer.
+ *
+ * @param reader The reader.
+ * @return true on success, false on memory allocation failure.
+ */
+static bool growBuffer(LineReader *reader) {
+  if (!linearize(reader)) {
+    return false;
+  }
+  char *buffer = realloc(reader->buffer, reader->capacity * 2);
+  if (buffer == NULL) {
+    return false;
+  }
+  reader->buffer = buffer;
+  reader->capacity *= 2;
+  return true;
+}
+
+/**
+ * @brief Reads more input into the free space of the buffer.
+ *
+ * @param reader The reader.
+ * @return ssize_t The number of bytes read, 0 at the end of the input or -1
+ * on error.
+ */
+static ssize_t fillBuffer(LineReader *reader) {
+  if (reader->length == reader->capacity && !growBuffer(reader)) {
+    errno = ENOMEM;
+    return -1;
+  }
+
+  size_t tail = (reader->head + reader->length) % reader->capacity;
+  size_t space = (tail >= reader->head || reader->length == 0)
+                     ? reader->capacity - tail
+                     : reader->head - tail;
+
+  ssize_t bytes_read;
+  do {
+    bytes_read = read(reader->fd, reader->buffer + tail, space);
+  } while (bytes_read == -1 && errno == EINTR);
+
+  if (bytes_read > 0) {
+    reader->length += bytes_read;
+  } else if (bytes_read == 0) {
+    reader->eof = true;
+  }
+  return bytes_read;
+}
+
+/**
+ * @brief Checks if a complete line is already buffered.
+ *
+ * When this returns true, readLine() returns without reading more input.
+ *
+ * @param reader The reader.
+ * @return true if readLine() would not block, false otherwise.
+ */
+bool hasBufferedLine(LineReader *reader) {
+  consumeLine(reader);
+  return reader->eof || findNewline(reader) < reader->length;
+}
+
+/**
+ * @brief Reads the next line.
+ *
+ * The returned line is null-terminated, without the newline character, and
+ * stays valid until the next call.
+ *
+ * @param reader The reader.
+ * @param line Where to store the pointer to the line.
+ * @return int 1 if a line was read, 0 at the end of the input or -1 on error.
+ */
+int readLine(LineReader *reader, char **line) {
+  consumeLine(reader);
+
+  size_t line_length;
+  while ((line_length = findNewline(reader)) == reader->length) {
+    if (reader->eof) {
+      if (reader->length == 0) {
+        return 0;
+      }
+      break;  // Last line without a newline
+    }
+    if (fillBuffer(reader) == -1) {
+      return -1;
+    }
+  }
+
+  // The line and its terminator must be contiguous
+  bool has_newline = line_length < reader->length;
+  size_t needed = line_length + 1;
+  if (!has_newline && reader->length == reader->capacity &&
+      !growBuffer(reader)) {
+    return -1;
+  }
+  if (reader->head + needed > reader->capacity && !linearize(reader)) {
+    return -1;
+  }
+
+  reader->buffer[reader->head + line_length] = '\0';
+  reader->consumed = has_newline ? needed : line_length;
+  *line = reader->buffer + reader->head;
+  return 1;
+}
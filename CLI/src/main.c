@@ -20,10 +20,40 @@
  *               in the users PATH variable.
  *   Enrique George Rodrigues (a28602@alunos.ipca.pt)
  *
+ * - 2026-10-16: Added builtin commands. Commands without a slash are resolved
+ *               through the command cache instead of being probed as files.
+ *   Enrique George Rodrigues (a28602@alunos.ipca.pt)
+ *
+ * - 2026-10-16: The bundled commands run in-process unless `opcao externo on`
+ *               is set.
+ *   Enrique George Rodrigues (a28602@alunos.ipca.pt)
+ *
+ * - 2026-10-16: Added pipelines.
+ *   Enrique George Rodrigues (a28602@alunos.ipca.pt)
+ *
+ * - 2026-10-16: Added background jobs. Command dispatch moved to run.c.
+ *   Enrique George Rodrigues (a28602@alunos.ipca.pt)
+ *
+ * - 2026-10-16: Added script mode, a buffered line reader and command lists
+ *               separated by `;`.
+ *   Enrique George Rodrigues (a28602@alunos.ipca.pt)
+ * - 2026-10-16: termina prints a summary of the resources used by each command.
+ *   Enrique George Rodrigues (a28602@alunos.ipca.pt)
+ * - 2026-10-16: Added --trace and the INTERPRETADOR_TRACE variable.
+ *   Enrique George Rodrigues (a28602@alunos.ipca.pt)
+ * - 2026-10-16: Commands are parsed by a lexer that handles quotes, escapes and
+ *               variables, into an arena that is reset after each command.
+ *   Enrique George Rodrigues (a28602@alunos.ipca.pt)
+ * - 2026-10-16: Added --serve and --max-children. runLine() moved to run.c.
+ *   Enrique George Rodrigues (a28602@alunos.ipca.pt)
  */
 #define _XOPEN_SOURCE 700
+#define _DEFAULT_SOURCE
 
 #include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -31,74 +61,176 @@
 #include <sys/wait.h>
 #include <unistd.h>
 
+#include "arena.h"
 #include "constants.h"
 #include "execute.h"
-#include "find.h"
-#include "input_parser.h"
-#include "utils.h"
+#include "jobs.h"
+#include "line_reader.h"
+#include "run.h"
+#include "server.h"
+#include "trace.h"
+
+/* Usage message of the interpreter. */
+#define USAGE_MESSAGE                                               \
+  "Usage: interpretador [-f script] [--trace file]\n"               \
+  "                     [--serve socket [--max-children n]]\n"      \
+  "Runs commands typed at the prompt, or in script mode\n"          \
+  "from a file or from stdin when it is not a terminal.\n"          \
+  "  -f script           Run the commands in the script.\n"         \
+  "  --trace file        Append a JSON line per command to the\n"   \
+  "                      file. Also enabled by the\n"               \
+  "                      " TRACE_ENV_VAR " variable.\n"             \
+  "  --serve socket      Run the lines sent by the clients of a\n"  \
+  "                      Unix socket, after the script, if any.\n"  \
+  "  --max-children n    Run up to n lines at once in server\n"     \
+  "                      mode. Defaults to one per CPU.\n"
 
 /**
- * @brief Main entry point of the program.
+ * @brief Waits until there is input to read.
  *
- * The main function serves as the entry point of the program. It executes the
- * command-line interface, allowing users to execute commands and programs.
+ * While waiting, background jobs that finish are reaped as soon as SIGCHLD
+ * arrives and reported, followed by a new prompt.
  *
- * @return int Returns 0 upon successful execution or 1 in the case of error.
+ * @return true if input is available, false on error.
  */
-int main() {
-  printf("%s version %s.\n\n", PROGRAM_NAME, VERSION);
-
-  char buffer[BUFFER_SIZE_BYTES];
-  ssize_t bytes_read;
-  char *args[MAX_ARGS + 1];
-  char command_path[BUFFER_SIZE_BYTES];
-  int arg_count;
+static bool waitForInput(void) {
+  struct pollfd fds[2] = {{STDIN_FILENO, POLLIN, 0},
+                          {jobSignalFd(), POLLIN, 0}};
+  nfds_t fd_count = (jobSignalFd() != -1) ? 2 : 1;
 
   while (1) {
-    // Print a prompt
-    printf("%% ");
-    fflush(stdout);  // Ensure the prompt is displayed
-
-    // Read user input
-    bytes_read = read(STDIN_FILENO, buffer, BUFFER_SIZE_BYTES - 1);
-    if (bytes_read < 0) {
+    if (poll(fds, fd_count, -1) == -1) {
+      if (errno == EINTR) {
+        continue;
+      }
       perror("Error");
-      return EXIT_FAILURE;
-    } else if (bytes_read == 0 || (bytes_read == 1 && buffer[0] == '\n')) {
-      // No input received, ignore and continue
-      continue;
+      return false;
     }
 
-    // Null-terminate the string
-    buffer[bytes_read - 1] = '\0';
+    if (fd_count == 2 && (fds[1].revents & POLLIN)) {
+      reapJobs();
+      if (reportFinishedJobs()) {
+        printf("%% ");
+        fflush(stdout);
+      }
+    }
+    if (fds[0].revents != 0) {
+      return true;
+    }
+  }
+}
 
-    // Check if user wants to end the program
-    if (shouldExit(buffer)) {
-      exit(EXIT_SUCCESS);
+/**
+ * @brief Main entry point of the program.
+ *
+ * The main function serves as the entry point of the program. It executes the
+ * command-line interface, allowing users to execute commands and programs.
+ *
+ * Commands are read from a script given with `-f`, or from stdin. When stdin
+ * is not a terminal the interpreter runs in script mode: no prompt or banner
+ * is printed and no newline is added after the output of each command.
+ * `--trace` writes the execution trace to a file. `--serve` runs the lines
+ * sent to a Unix socket once the script, if any, has run.
+ *
+ * @param argc The number of command-line arguments.
+ * @param argv An array of strings containing the command-line arguments.
+ * @return int Returns the exit status of the last command, or 1 in the case
+ * of error.
+ */
+int main(int argc, char *argv[]) {
+  const char *script_path = NULL;
+  const char *trace_path = getenv(TRACE_ENV_VAR);
+  const char *socket_path = NULL;
+  int max_children = 0;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "-f") == 0 && i + 1 < argc) {
+      script_path = argv[++i];
+    } else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+      trace_path = argv[++i];
+    } else if (strcmp(argv[i], "--serve") == 0 && i + 1 < argc) {
+      socket_path = argv[++i];
+    } else if (strcmp(argv[i], "--max-children") == 0 && i + 1 < argc &&
+               (max_children = atoi(argv[i + 1])) > 0) {
+      i++;
+    } else {
+      fputs(USAGE_MESSAGE, stderr);
+      return EXIT_FAILURE;
     }
+  }
 
-    // Parse the input
-    arg_count = parseInput(buffer, args, MAX_ARGS);
-    if (arg_count == 0) {
-      // No arguments found, continue to the next iteration
-      continue;
+  int input_fd = STDIN_FILENO;
+  if (script_path != NULL) {
+    input_fd = open(script_path, O_RDONLY | O_CLOEXEC);
+    if (input_fd == -1) {
+      perror(script_path);
+      return EXIT_FAILURE;
     }
+  }
 
-    // Find the command as an executable file
-    if (isExecutableFile(args[0])) {
-      // Execute the command with the provided arguments
-      executeCommand(args[0], args);
-    } else {
-      // Find the command in the PATH
-      if (!findCommandInPath(args[0], command_path)) {
-        fprintf(stderr, "%s: command not found\n", args[0]);
-        continue;
+  // Commands still run when the trace cannot be written
+  if (trace_path != NULL && *trace_path != '\0') {
+    openTrace(trace_path);
+  }
+
+  // In server mode only the script, if any, is read before serving
+  bool interactive = (input_fd == STDIN_FILENO) && isatty(STDIN_FILENO) &&
+                     socket_path == NULL;
+  setInteractiveOutput(interactive);
+  if (interactive) {
+    printf("%s version %s.\n\n", PROGRAM_NAME, VERSION);
+  }
+
+  LineReader reader;
+  if (!initLineReader(&reader, input_fd)) {
+    fputs("Error: Memory allocation failed.\n", stderr);
+    return EXIT_FAILURE;
+  }
+
+  // Reap background jobs through a signalfd
+  initJobControl();
+
+  Arena arena;
+  initArena(&arena);
+
+  int status = EXIT_SUCCESS;
+  char *line;
+  while (socket_path == NULL || script_path != NULL) {
+    reapJobs();
+
+    if (interactive) {
+      // Report background jobs that finished since the last prompt
+      reportFinishedJobs();
+
+      // Print a prompt
+      printf("%% ");
+      fflush(stdout);  // Ensure the prompt is displayed
+
+      if (!hasBufferedLine(&reader) && !waitForInput()) {
+        return EXIT_FAILURE;
       }
+    }
 
-      // Execute the command with the provided arguments
-      executeCommand(command_path, args);
+    // Read the next line of input
+    int result = readLine(&reader, &line);
+    if (result == -1) {
+      perror("Error");
+      return EXIT_FAILURE;
+    } else if (result == 0) {
+      // End of input
+      if (interactive) {
+        fputs("\n", stdout);
+      }
+      break;
     }
+
+    runLine(&arena, line, &status);
   }
 
-  return 0;
+  freeArena(&arena);
+  freeLineReader(&reader);
+  if (socket_path != NULL) {
+    // Lines run in copies of the interpreter left by the script
+    status = runServer(socket_path, max_children);
+  }
+  return status;
 }
@@ -0,0 +1,1023 @@
+/**
+ * @file memo.c
+ * @author Enrique Rodrigues (a28602@alunos.ipca.pt)
+ * @brief Contains the cache of results of pure commands and the `memo`
+ * builtin.
+ * @version 0.1
+ * @date 2026-10-16
+ * @copyright Copyright (c) 2024
+ */
+#define _GNU_SOURCE
+
+#include "memo.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/sendfile.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include "builtins.h"
+#include "constants.h"
+#include "execute.h"
+#include "redirect.h"
+#include "trace.h"
+#include "usage.h"
+
+/* Byte budget of the cache when none is given. */
+#define MEMO_DEFAULT_BUDGET (64 * 1024 * 1024)
+
+/* Initial number of buckets of the hash table. */
+#define MEMO_MIN_BUCKETS 64
+
+/* First bytes of a cache file, which also identify its format. */
+#define MEMO_FILE_MAGIC "IMEMO01"
+
+/* Exit statuses from this value up may come from a signal. */
+#define MEMO_SIGNAL_STATUS 128
+
+/* Help message explaining usage. */
+#define HELP_MESSAGE                                                        \
+  "Usage: memo [-r] [-m size] [-f file] [-p name...]\n"                     \
+  "Shows or changes the cache of results of pure commands, which is\n"      \
+  "enabled with 'opcao memo on'.\n"                                         \
+  "Options:\n"                                                              \
+  "  -r          Forget every result.\n"                                    \
+  "  -m size     Keep up to size bytes of results, such as 512K or 64M.\n"  \
+  "  -f file     Load the results saved in file and save them there on\n"   \
+  "              exit.\n"                                                   \
+  "  -p name     Mark the given commands as pure.\n"
+
+/**
+ * @brief Structure that holds a cached result.
+ *
+ * The key, stdout and stderr of the result are stored in `data`, or in a
+ * cache file mapped into memory when the result was loaded from one.
+ */
+typedef struct MemoEntry {
+  struct MemoEntry *bucket_next;  // next entry in the same bucket
+  struct MemoEntry *newer;        // next more recently used entry
+  struct MemoEntry *older;        // next less recently used entry
+  uint64_t hash;                  // hash of the key
+  size_t key_length;              // number of bytes in `key`
+  size_t out_length;              // number of bytes in `out`
+  size_t err_length;              // number of bytes in `err`
+  int status;                     // exit status of the command
+  const char *key;                // arguments and file identities
+  const char *out;                // output written to stdout
+  const char *err;                // output written to stderr
+  char data[];                    // key, stdout and stderr, if not mapped
+} MemoEntry;
+
+/**
+ * @brief Structure that holds the header of a result in a cache file.
+ *
+ * The key, stdout and stderr follow the header, and the next header starts
+ * at the next multiple of 8 bytes.
+ */
+typedef struct MemoRecord {
+  uint64_t key_length;  // number of bytes of the key
+  uint64_t out_length;  // number of bytes of stdout
+  uint64_t err_length;  // number of bytes of stderr
+  int64_t status;       // exit status of the command
+} MemoRecord;
+
+/**
+ * @brief Structure that holds the identity of a file named by a command.
+ */
+typedef struct MemoFileKey {
+  uint64_t argument;  // index of the argument that names the file
+  uint64_t device;    // device of the file
+  uint64_t inode;     // inode of the file
+  uint64_t size;      // size of the file in bytes
+  int64_t mtime_ns;   // modification time, in nanoseconds
+  int64_t ctime_ns;   // change time, in nanoseconds
+} MemoFileKey;
+
+/**
+ * @brief Structure that describes a pure command.
+ */
+typedef struct PureCommand {
+  const char *name;          // name of the command
+  const char *default_path;  // file read without arguments, NULL for stdin
+} PureCommand;
+
+/**
+ * @brief Structure that holds a cache file mapped into memory.
+ */
+typedef struct MemoMapping {
+  void *address;  // start of the mapping
+  size_t length;  // length of the mapping
+} MemoMapping;
+
+/* Bundled commands whose output only depends on the files they name. */
+static const PureCommand pure_commands[] = {
+    {"conta", NULL},
+    {"lista", "."},
+};
+
+/* Commands marked as pure with `memo -p`. */
+static char **marked_commands = NULL;  // names of the commands
+static int marked_count = 0;           // number of names
+
+/* Cache state. */
+static bool memo_enabled = false;       // whether results are cached
+static MemoEntry **buckets = NULL;      // hash table of the entries
+static size_t bucket_count = 0;         // number of buckets
+static size_t entry_count = 0;          // number of entries
+static MemoEntry *newest = NULL;        // most recently used entry
+static MemoEntry *oldest = NULL;        // least recently used entry
+static size_t memo_bytes = 0;           // bytes used by the entries
+static size_t memo_budget = MEMO_DEFAULT_BUDGET;  // most bytes to use
+
+/* Statistics reported by the `memo` builtin. */
+static unsigned long memo_hits = 0;       // results served from the cache
+static unsigned long memo_misses = 0;     // results not found in the cache
+static unsigned long memo_evictions = 0;  // results evicted by the budget
+static unsigned long memo_skipped = 0;    // pure commands not cacheable
+
+/* Key of the command being looked up. */
+static char *key_buffer = NULL;  // bytes of the key
+static size_t key_capacity = 0;  // size of `key_buffer`
+static size_t key_length = 0;    // number of bytes in the key
+
+/* Files the output of commands is captured in, or -1. */
+static int capture_fds[2] = {-1, -1};
+
+/* Cache files. */
+static char memo_path[BUFFER_SIZE_BYTES] = "";  // file saved on exit
+static pid_t memo_owner = -1;                   // process that saves it
+static MemoMapping *mappings = NULL;            // files loaded into memory
+static int mapping_count = 0;                   // number of mappings
+
+/**
+ * @brief Enables or disables the cache.
+ *
+ * @param enabled true to cache the results of pure commands, false
+ * otherwise.
+ */
+void setMemoEnabled(bool enabled) { memo_enabled = enabled; }
+
+/**
+ * @brief Returns whether the cache is enabled.
+ *
+ * @return true if the results of pure commands are cached, false otherwise.
+ */
+bool isMemoEnabled(void) { return memo_enabled; }
+
+/**
+ * @brief Finds the description of a pure command.
+ *
+ * @param name The name of the command.
+ * @param command Receives the description of the command.
+ * @return true if the command is pure, false otherwise.
+ */
+static bool findPureCommand(const char *name, PureCommand *command) {
+  for (size_t i = 0; i < sizeof(pure_commands) / sizeof(pure_commands[0]);
+       i++) {
+    if (strcmp(pure_commands[i].name, name) == 0) {
+      *command = pure_commands[i];
+      return true;
+    }
+  }
+  for (int i = 0; i < marked_count; i++) {
+    if (strcmp(marked_commands[i], name) == 0) {
+      command->name = marked_commands[i];
+      command->default_path = NULL;
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * @brief Appends bytes to the key being built.
+ *
+ * @param bytes The bytes to append.
+ * @param length The number of bytes.
+ * @return true on success, false on memory allocation failure.
+ */
+static bool appendKey(const void *bytes, size_t length) {
+  if (key_length + length > key_capacity) {
+    size_t new_capacity = key_capacity ? key_capacity : BUFFER_SIZE_BYTES;
+    while (new_capacity < key_length + length) {
+      new_capacity *= 2;
+    }
+    char *new_buffer = realloc(key_buffer, new_capacity);
+    if (new_buffer == NULL) {
+      return false;
+    }
+    key_buffer = new_buffer;
+    key_capacity = new_capacity;
+  }
+  memcpy(key_buffer + key_length, bytes, length);
+  key_length += length;
+  return true;
+}
+
+/**
+ * @brief Appends the identity of a file to the key being built.
+ *
+ * @param argument The index of the argument that names the file.
+ * @param path The path of the file.
+ * @return true on success, false if the file does not exist or on memory
+ * allocation failure.
+ */
+static bool appendFileKey(int argument, const char *path) {
+  struct stat file_stat;
+  if (stat(path, &file_stat) == -1) {
+    return false;
+  }
+
+  MemoFileKey file;
+  memset(&file, 0, sizeof(file));
+  file.argument = (uint64_t)argument;
+  file.device = (uint64_t)file_stat.st_dev;
+  file.inode = (uint64_t)file_stat.st_ino;
+  file.size = (uint64_t)file_stat.st_size;
+  file.mtime_ns = (int64_t)file_stat.st_mtim.tv_sec * 1000000000 +
+                  file_stat.st_mtim.tv_nsec;
+  file.ctime_ns = (int64_t)file_stat.st_ctim.tv_sec * 1000000000 +
+                  file_stat.st_ctim.tv_nsec;
+  return appendKey(&file, sizeof(file));
+}
+
+/**
+ * @brief Builds the key of a command in `key_buffer`.
+ *
+ * The key holds the command and its arguments, followed by the identity of
+ * every file they name. Arguments starting with `-` are options and may not
+ * name files. Any other argument must name an existing file, since a missing
+ * file could be created without changing the key.
+ *
+ * @param name The name or path of the command.
+ * @param command The description of the command.
+ * @param args The arguments of the command.
+ * @param arg_count The number of arguments in `args`.
+ * @return true if the result of the command can be cached, false otherwise.
+ */
+static bool buildKey(const char *name, const PureCommand *command,
+                     char *args[], int arg_count) {
+  key_length = 0;
+  if (!appendKey(name, strlen(name) + 1)) {
+    return false;
+  }
+  for (int i = 1; i < arg_count; i++) {
+    if (!appendKey(args[i], strlen(args[i]) + 1)) {
+      return false;
+    }
+  }
+
+  bool named_file = false;
+  for (int i = 1; i < arg_count; i++) {
+    if (strcmp(args[i], "-") == 0) {
+      return false;  // Reads stdin
+    }
+    if (args[i][0] == '-') {
+      appendFileKey(i, args[i]);
+    } else if (!appendFileKey(i, args[i])) {
+      return false;
+    } else {
+      named_file = true;
+    }
+  }
+
+  // Without a file the command reads stdin or its default file
+  if (!named_file) {
+    return command->default_path != NULL &&
+           appendFileKey(0, command->default_path);
+  }
+  return true;
+}
+
+/**
+ * @brief Computes the FNV-1a hash of a key.
+ *
+ * @param key The key.
+ * @param length The number of bytes in the key.
+ * @return uint64_t The hash.
+ */
+static uint64_t hashKey(const char *key, size_t length) {
+  uint64_t hash = 14695981039346656037ULL;
+  for (size_t i = 0; i < length; i++) {
+    hash ^= (unsigned char)key[i];
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+/**
+ * @brief Finds the entry with the given key.
+ *
+ * @param key The key.
+ * @param length The number of bytes in the key.
+ * @param hash The hash of the key.
+ * @return MemoEntry* The entry, or NULL if the key is not cached.
+ */
+static MemoEntry *findEntry(const char *key, size_t length, uint64_t hash) {
+  if (bucket_count == 0) {
+    return NULL;
+  }
+  for (MemoEntry *entry = buckets[hash % bucket_count]; entry != NULL;
+       entry = entry->bucket_next) {
+    if (entry->hash == hash && entry->key_length == length &&
+        memcmp(entry->key, key, length) == 0) {
+      return entry;
+    }
+  }
+  return NULL;
+}
+
+/**
+ * @brief Returns the number of bytes an entry counts against the budget.
+ *
+ * @param entry The entry.
+ * @return size_t The number of bytes.
+ */
+static size_t entrySize(const MemoEntry *entry) {
+  return sizeof(MemoEntry) + entry->key_length + entry->out_length +
+         entry->err_length;
+}
+
+/**
+ * @brief Removes an entry from the list of recently used entries.
+ *
+ * @param entry The entry.
+ */
+static void unlinkRecent(MemoEntry *entry) {
+  if (entry->newer != NULL) {
+    entry->newer->older = entry->older;
+  } else {
+    newest = entry->older;
+  }
+  if (entry->older != NULL) {
+    entry->older->newer = entry->newer;
+  } else {
+    oldest = entry->newer;
+  }
+  entry->newer = entry->older = NULL;
+}
+
+/**
+ * @brief Makes an entry the most recently used one.
+ *
+ * @param entry The entry, not in the list.
+ */
+static void linkNewest(MemoEntry *entry) {
+  entry->older = newest;
+  entry->newer = NULL;
+  if (newest != NULL) {
+    newest->newer = entry;
+  } else {
+    oldest = entry;
+  }
+  newest = entry;
+}
+
+/**
+ * @brief Removes an entry from the cache and frees it.
+ *
+ * @param entry The entry.
+ */
+static void removeEntry(MemoEntry *entry) {
+  MemoEntry **link = &buckets[entry->hash % bucket_count];
+  while (*link != entry) {
+    link = &(*link)->bucket_next;
+  }
+  *link = entry->bucket_next;
+  unlinkRecent(entry);
+  memo_bytes -= entrySize(entry);
+  entry_count--;
+  free(entry);
+}
+
+/**
+ * @brief Evicts the least recently used entries until the cache fits its
+ * budget.
+ */
+static void evictToBudget(void) {
+  while (oldest != NULL && memo_bytes > memo_budget) {
+    removeEntry(oldest);
+    memo_evictions++;
+  }
+}
+
+/**
+ * @brief Doubles the number of buckets when the table is full.
+ *
+ * @return true on success, false on memory allocation failure.
+ */
+static bool growBuckets(void) {
+  if (entry_count < bucket_count) {
+    return true;
+  }
+  size_t new_count = bucket_count ? bucket_count * 2 : MEMO_MIN_BUCKETS;
+  MemoEntry **new_buckets = calloc(new_count, sizeof(MemoEntry *));
+  if (new_buckets == NULL) {
+    return false;
+  }
+  for (size_t i = 0; i < bucket_count; i++) {
+    MemoEntry *entry = buckets[i];
+    while (entry != NULL) {
+      MemoEntry *next = entry->bucket_next;
+      entry->bucket_next = new_buckets[entry->hash % new_count];
+      new_buckets[entry->hash % new_count] = entry;
+      entry = next;
+    }
+  }
+  free(buckets);
+  buckets = new_buckets;
+  bucket_count = new_count;
+  return true;
+}
+
+/**
+ * @brief Adds an entry to the cache as the most recently used one.
+ *
+ * @param entry The entry, whose key is not cached.
+ * @return true on success, false on memory allocation failure.
+ */
+static bool insertEntry(MemoEntry *entry) {
+  if (!growBuckets()) {
+    return false;
+  }
+  size_t bucket = entry->hash % bucket_count;
+  entry->bucket_next = buckets[bucket];
+  buckets[bucket] = entry;
+  linkNewest(entry);
+  memo_bytes += entrySize(entry);
+  entry_count++;
+  return true;
+}
+
+/**
+ * @brief Forgets every cached result and unmaps the cache files.
+ */
+static void clearMemo(void) {
+  while (oldest != NULL) {
+    removeEntry(oldest);
+  }
+  for (int i = 0; i < mapping_count; i++) {
+    munmap(mappings[i].address, mappings[i].length);
+  }
+  mapping_count = 0;
+}
+
+/**
+ * @brief Writes a buffer to a descriptor, retrying partial writes.
+ *
+ * @param fd The descriptor.
+ * @param buffer The bytes to write.
+ * @param length The number of bytes.
+ * @return true on success, false on error.
+ */
+static bool writeAll(int fd, const char *buffer, size_t length) {
+  while (length > 0) {
+    ssize_t written = write(fd, buffer, length);
+    if (written == -1) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+    buffer += written;
+    length -= written;
+  }
+  return true;
+}
+
+/**
+ * @brief Copies captured output to a descriptor.
+ *
+ * @param capture_fd The file holding the output.
+ * @param fd The descriptor to copy the output to.
+ * @param length The number of bytes of output.
+ * @return true on success, false on error.
+ */
+static bool copyCapture(int capture_fd, int fd, size_t length) {
+  off_t offset = 0;
+  while ((size_t)offset < length) {
+    ssize_t copied = sendfile(fd, capture_fd, &offset, length - offset);
+    if (copied == -1 && errno == EINTR) {
+      continue;
+    }
+    if (copied <= 0) {
+      break;
+    }
+  }
+
+  // Fall back to reading and writing when sendfile() cannot write to `fd`
+  char buffer[BUFFER_SIZE_BYTES];
+  while ((size_t)offset < length) {
+    ssize_t bytes = pread(capture_fd, buffer, sizeof(buffer), offset);
+    if (bytes <= 0 || !writeAll(fd, buffer, bytes)) {
+      return false;
+    }
+    offset += bytes;
+  }
+  return true;
+}
+
+/**
+ * @brief Empties the files the output of commands is captured in.
+ *
+ * The files are created on first use, in memory.
+ *
+ * @return true on success, false if they could not be created.
+ */
+static bool resetCapture(void) {
+  const char *names[] = {"memo-stdout", "memo-stderr"};
+  for (int i = 0; i < 2; i++) {
+    if (capture_fds[i] == -1) {
+      capture_fds[i] = memfd_create(names[i], MFD_CLOEXEC);
+      if (capture_fds[i] == -1) {
+        return false;
+      }
+    }
+    if (ftruncate(capture_fds[i], 0) == -1 ||
+        lseek(capture_fds[i], 0, SEEK_SET) == -1) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * @brief Returns the number of bytes captured in a file.
+ *
+ * @param fd The file.
+ * @return size_t The size of the file.
+ */
+static size_t captureLength(int fd) {
+  struct stat file_stat;
+  return (fstat(fd, &file_stat) == 0) ? (size_t)file_stat.st_size : 0;
+}
+
+/**
+ * @brief Creates an entry from the captured output of a command.
+ *
+ * @param status The exit status of the command.
+ * @param out_length The number of bytes captured from stdout.
+ * @param err_length The number of bytes captured from stderr.
+ * @return MemoEntry* The entry, or NULL on failure.
+ */
+static MemoEntry *createEntry(int status, size_t out_length,
+                              size_t err_length) {
+  MemoEntry *entry =
+      malloc(sizeof(MemoEntry) + key_length + out_length + err_length);
+  if (entry == NULL) {
+    return NULL;
+  }
+  memset(entry, 0, sizeof(MemoEntry));
+  entry->hash = hashKey(key_buffer, key_length);
+  entry->key_length = key_length;
+  entry->out_length = out_length;
+  entry->err_length = err_length;
+  entry->status = status;
+  entry->key = entry->data;
+  entry->out = entry->data + key_length;
+  entry->err = entry->out + out_length;
+  memcpy(entry->data, key_buffer, key_length);
+
+  if ((out_length > 0 && pread(capture_fds[0], entry->data + key_length,
+                               out_length, 0) != (ssize_t)out_length) ||
+      (err_length > 0 &&
+       pread(capture_fds[1], entry->data + key_length + out_length,
+             err_length, 0) != (ssize_t)err_length)) {
+    free(entry);
+    return NULL;
+  }
+  return entry;
+}
+
+/**
+ * @brief Runs a command with its output captured.
+ *
+ * @param bundled The bundled command to run, or NULL to run `command_path`.
+ * @param command_path The path of the program to run, if `bundled` is NULL.
+ * @param args The arguments of the command, terminated by NULL.
+ * @param arg_count The number of arguments in `args`.
+ * @param capture The streams of the command.
+ * @return int The exit status of the command.
+ */
+static int runCaptured(const BundledCommand *bundled, const char *command_path,
+                       char *args[], int arg_count,
+                       const CommandIO *capture) {
+  if (bundled == NULL) {
+    pid_t pid = launchCommand(command_path, args, capture);
+    return (pid < 0) ? EXIT_FAILURE : waitCommand(pid);
+  }
+
+  UsageMeter meter;
+  if (isTracing()) {
+    beginUsage(&meter);
+  }
+
+  int status = EXIT_FAILURE;
+  int saved_fds[3];
+  if (redirectInterpreter(capture, saved_fds)) {
+    status = bundled->function(arg_count, (const char **)args);
+    restoreInterpreter(saved_fds);
+  }
+  reportExitStatus(status);
+
+  if (isTracing()) {
+    CommandUsage usage;
+    endUsage(&meter, &usage);
+    traceInProcess(TRACE_KIND_BUNDLED, args, status, &usage);
+  }
+  return status;
+}
+
+/**
+ * @brief Runs a command through the cache.
+ *
+ * When the cache holds the result of the command, its output is written to
+ * the streams in `io`. Otherwise the command runs with its output captured,
+ * which is then written to the streams in `io` and kept. Nothing is done
+ * when the cache is disabled, the command is not pure, or its result cannot
+ * be cached, such as when it reads stdin.
+ *
+ * @param bundled The bundled command to run, or NULL to run `command_path`.
+ * @param command_path The path of the program to run, if `bundled` is NULL.
+ * @param args The arguments of the command, terminated by NULL.
+ * @param arg_count The number of arguments in `args`.
+ * @param io The descriptors the command uses as its standard streams.
+ * @param status Receives the exit status of the command.
+ * @return true if the command was run through the cache, false if the caller
+ * must run it.
+ */
+bool runMemoized(const BundledCommand *bundled, const char *command_path,
+                 char *args[], int arg_count, const CommandIO *io,
+                 int *status) {
+  PureCommand command;
+  if (!memo_enabled || !findPureCommand(args[0], &command)) {
+    return false;
+  }
+  const char *name = (bundled != NULL) ? bundled->name : command_path;
+  if (!buildKey(name, &command, args, arg_count)) {
+    memo_skipped++;
+    return false;
+  }
+
+  fflush(stdout);
+  fflush(stderr);
+  uint64_t hash = hashKey(key_buffer, key_length);
+  MemoEntry *entry = findEntry(key_buffer, key_length, hash);
+  if (entry != NULL) {
+    // Serve the result without running anything
+    memo_hits++;
+    unlinkRecent(entry);
+    linkNewest(entry);
+    writeAll(io->out_fd, entry->out, entry->out_length);
+    writeAll(io->err_fd, entry->err, entry->err_length);
+    reportExitStatus(entry->status);
+    finishCommandOutput();
+    *status = entry->status;
+    return true;
+  }
+
+  if (!resetCapture()) {
+    memo_skipped++;
+    return false;
+  }
+  memo_misses++;
+  CommandIO capture = {io->in_fd, capture_fds[0], capture_fds[1]};
+  *status = runCaptured(bundled, command_path, args, arg_count, &capture);
+  size_t out_length = captureLength(capture_fds[0]);
+  size_t err_length = captureLength(capture_fds[1]);
+
+  // Results of commands killed by a signal depend on more than their files
+  size_t size = sizeof(MemoEntry) + key_length + out_length + err_length;
+  entry = (*status < MEMO_SIGNAL_STATUS && size <= memo_budget)
+              ? createEntry(*status, out_length, err_length)
+              : NULL;
+  if (entry != NULL && insertEntry(entry)) {
+    evictToBudget();
+    writeAll(io->out_fd, entry->out, entry->out_length);
+    writeAll(io->err_fd, entry->err, entry->err_length);
+  } else {
+    free(entry);
+    copyCapture(capture_fds[0], io->out_fd, out_length);
+    copyCapture(capture_fds[1], io->err_fd, err_length);
+  }
+  finishCommandOutput();
+  return true;
+}
+
+/**
+ * @brief Rounds a length up to the alignment of records in a cache file.
+ *
+ * @param length The length.
+ * @return size_t The rounded length.
+ */
+static size_t alignRecord(size_t length) { return (length + 7) & ~(size_t)7; }
+
+/**
+ * @brief Saves the cached results to the cache file.
+ *
+ * The results are written to a temporary file, in order from the least to
+ * the most recently used, which then replaces the cache file. Only the
+ * interpreter saves the file, not its child processes.
+ */
+static void saveMemoFile(void) {
+  if (memo_path[0] == '\0' || getpid() != memo_owner) {
+    return;
+  }
+
+  size_t length = alignRecord(sizeof(MEMO_FILE_MAGIC)) + sizeof(uint64_t);
+  for (MemoEntry *entry = oldest; entry != NULL; entry = entry->newer) {
+    length += alignRecord(sizeof(MemoRecord) + entry->key_length +
+                          entry->out_length + entry->err_length);
+  }
+
+  char temporary_path[BUFFER_SIZE_BYTES + 16];
+  snprintf(temporary_path, sizeof(temporary_path), "%s.%ld", memo_path,
+           (long)getpid());
+  int fd = open(temporary_path, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+  if (fd == -1) {
+    perror(temporary_path);
+    return;
+  }
+  char *file = MAP_FAILED;
+  if (ftruncate(fd, length) == 0) {
+    file = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  }
+  if (file == MAP_FAILED) {
+    perror(temporary_path);
+    close(fd);
+    unlink(temporary_path);
+    return;
+  }
+
+  memcpy(file, MEMO_FILE_MAGIC, sizeof(MEMO_FILE_MAGIC));
+  size_t offset = alignRecord(sizeof(MEMO_FILE_MAGIC));
+  uint64_t count = entry_count;
+  memcpy(file + offset, &count, sizeof(count));
+  offset += sizeof(count);
+
+  for (MemoEntry *entry = oldest; entry != NULL; entry = entry->newer) {
+    MemoRecord record = {entry->key_length, entry->out_length,
+                         entry->err_length, entry->status};
+    char *position = file + offset;
+    memcpy(position, &record, sizeof(record));
+    position += sizeof(record);
+    memcpy(position, entry->key, entry->key_length);
+    position += entry->key_length;
+    memcpy(position, entry->out, entry->out_length);
+    position += entry->out_length;
+    memcpy(position, entry->err, entry->err_length);
+    offset += alignRecord(sizeof(record) + entry->key_length +
+                          entry->out_length + entry->err_length);
+  }
+
+  munmap(file, length);
+  close(fd);
+  if (rename(temporary_path, memo_path) == -1) {
+    perror(memo_path);
+    unlink(temporary_path);
+  }
+}
+
+/**
+ * @brief Loads the results saved in a cache file.
+ *
+ * The file is mapped into memory and the results point into the mapping, so
+ * loading does not copy their output. Results already cached are kept.
+ *
+ * @param path The path of the cache file.
+ * @return true on success or if the file does not exist, false if the file
+ * cannot be read or is not a cache file.
+ */
+static bool loadMemoFile(const char *path) {
+  int fd = open(path, O_RDONLY | O_CLOEXEC);
+  if (fd == -1) {
+    if (errno == ENOENT) {
+      return true;
+    }
+    perror(path);
+    return false;
+  }
+
+  struct stat file_stat;
+  size_t header_length = alignRecord(sizeof(MEMO_FILE_MAGIC)) +
+                         sizeof(uint64_t);
+  char *file = MAP_FAILED;
+  if (fstat(fd, &file_stat) == 0 &&
+      (size_t)file_stat.st_size >= header_length) {
+    file = mmap(NULL, file_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  }
+  close(fd);
+  if (file == MAP_FAILED ||
+      memcmp(file, MEMO_FILE_MAGIC, sizeof(MEMO_FILE_MAGIC)) != 0) {
+    if (file != MAP_FAILED) {
+      munmap(file, file_stat.st_size);
+    }
+    fprintf(stderr, "memo: %s: not a cache file\n", path);
+    return false;
+  }
+
+  MemoMapping *new_mappings =
+      realloc(mappings, (mapping_count + 1) * sizeof(MemoMapping));
+  if (new_mappings == NULL) {
+    munmap(file, file_stat.st_size);
+    fputs("Error: Memory allocation failed.\n", stderr);
+    return false;
+  }
+  mappings = new_mappings;
+  mappings[mapping_count].address = file;
+  mappings[mapping_count].length = file_stat.st_size;
+  mapping_count++;
+
+  size_t length = file_stat.st_size;
+  size_t offset = header_length;
+  uint64_t count;
+  memcpy(&count, file + alignRecord(sizeof(MEMO_FILE_MAGIC)), sizeof(count));
+  for (uint64_t i = 0; i < count; i++) {
+    // The padding of the last record can end past a truncated file
+    if (offset > length || length - offset < sizeof(MemoRecord)) {
+      fprintf(stderr, "memo: %s: truncated cache file\n", path);
+      break;
+    }
+    MemoRecord record;
+    memcpy(&record, file + offset, sizeof(record));
+    size_t available = length - offset - sizeof(record);
+    if (record.key_length > available ||
+        record.out_length > available - record.key_length ||
+        record.err_length >
+            available - record.key_length - record.out_length) {
+      fprintf(stderr, "memo: %s: truncated cache file\n", path);
+      break;
+    }
+
+    const char *key = file + offset + sizeof(record);
+    uint64_t hash = hashKey(key, record.key_length);
+    MemoEntry *entry = NULL;
+    if (findEntry(key, record.key_length, hash) == NULL) {
+      entry = malloc(sizeof(MemoEntry));
+    }
+    if (entry != NULL) {
+      memset(entry, 0, sizeof(MemoEntry));
+      entry->hash = hash;
+      entry->key_length = record.key_length;
+      entry->out_length = record.out_length;
+      entry->err_length = record.err_length;
+      entry->status = (int)record.status;
+      entry->key = key;
+      entry->out = key + record.key_length;
+      entry->err = entry->out + record.out_length;
+      if (!insertEntry(entry)) {
+        free(entry);
+      }
+    }
+    offset += alignRecord(sizeof(record) + record.key_length +
+                          record.out_length + record.err_length);
+  }
+  evictToBudget();
+  return true;
+}
+
+/**
+ * @brief Parses a size in bytes, with an optional K, M or G suffix.
+ *
+ * @param text The size.
+ * @param size Receives the number of bytes.
+ * @return true if the size is valid, false otherwise.
+ */
+static bool parseByteSize(const char *text, size_t *size) {
+  char *end;
+  unsigned long long value = strtoull(text, &end, 10);
+  if (end == text || *text == '-') {
+    return false;
+  }
+  const char *suffixes = "KMG";
+  const char *suffix = (*end != '\0') ? strchr(suffixes, *end) : NULL;
+  if (suffix != NULL) {
+    for (const char *unit = suffixes; unit <= suffix; unit++) {
+      value *= 1024;
+    }
+    end++;
+  }
+  if (*end != '\0') {
+    return false;
+  }
+  *size = (size_t)value;
+  return true;
+}
+
+/**
+ * @brief Marks a command as pure.
+ *
+ * @param name The name of the command.
+ * @return true on success, false on memory allocation failure.
+ */
+static bool markPureCommand(const char *name) {
+  PureCommand command;
+  if (findPureCommand(name, &command)) {
+    return true;
+  }
+  char **new_commands =
+      realloc(marked_commands, (marked_count + 1) * sizeof(char *));
+  if (new_commands == NULL) {
+    return false;
+  }
+  marked_commands = new_commands;
+  marked_commands[marked_count] = strdup(name);
+  if (marked_commands[marked_count] == NULL) {
+    return false;
+  }
+  marked_count++;
+  return true;
+}
+
+/**
+ * @brief Prints the state and statistics of the cache.
+ */
+static void printMemoStatistics(void) {
+  printf("%-12s %s\n", "enabled", memo_enabled ? "on" : "off");
+  printf("%-12s %zu\n", "results", entry_count);
+  printf("%-12s %zu / %zu\n", "bytes", memo_bytes, memo_budget);
+  printf("%-12s %lu\n", "hits", memo_hits);
+  printf("%-12s %lu\n", "misses", memo_misses);
+  printf("%-12s %lu\n", "evictions", memo_evictions);
+  printf("%-12s %lu\n", "skipped", memo_skipped);
+  printf("%-12s %s\n", "file", (memo_path[0] != '\0') ? memo_path : "-");
+
+  printf("%-12s", "pure");
+  for (size_t i = 0; i < sizeof(pure_commands) / sizeof(pure_commands[0]);
+       i++) {
+    printf(" %s", pure_commands[i].name);
+  }
+  for (int i = 0; i < marked_count; i++) {
+    printf(" %s", marked_commands[i]);
+  }
+  putchar('\n');
+}
+
+/**
+ * @brief Implements the `memo` builtin.
+ *
+ * Shows the statistics of the cache, clears it, changes its byte budget,
+ * selects the file it is saved to, or marks commands as pure.
+ *
+ * @param argc The number of arguments.
+ * @param argv The arguments, starting with the builtin name.
+ * @return int Returns 0 on success or 1 on invalid usage.
+ */
+int memoBuiltin(int argc, char *argv[]) {
+  if (argc == 1) {
+    printMemoStatistics();
+    return EXIT_SUCCESS;
+  }
+
+  if (strcmp(argv[1], "--help") == 0) {
+    fputs(HELP_MESSAGE, stdout);
+    return EXIT_SUCCESS;
+  }
+
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "-r") == 0) {
+      clearMemo();
+    } else if (strcmp(argv[i], "-m") == 0 && i + 1 < argc) {
+      if (!parseByteSize(argv[++i], &memo_budget)) {
+        fprintf(stderr, "memo: %s: invalid size\n", argv[i]);
+        return EXIT_FAILURE;
+      }
+      evictToBudget();
+    } else if (strcmp(argv[i], "-f") == 0 && i + 1 < argc) {
+      i++;
+      if ((size_t)snprintf(memo_path, sizeof(memo_path), "%s", argv[i]) >=
+          sizeof(memo_path)) {
+        fprintf(stderr, "memo: %s: path too long\n", argv[i]);
+        memo_path[0] = '\0';
+        return EXIT_FAILURE;
+      }
+      if (!loadMemoFile(memo_path)) {
+        memo_path[0] = '\0';
+        return EXIT_FAILURE;
+      }
+      if (memo_owner == -1) {
+        atexit(saveMemoFile);
+      }
+      memo_owner = getpid();
+    } else if (strcmp(argv[i], "-p") == 0 && i + 1 < argc) {
+      while (i + 1 < argc) {
+        if (!markPureCommand(argv[++i])) {
+          fputs("Error: Memory allocation failed.\n", stderr);
+          return EXIT_FAILURE;
+        }
+      }
+    } else {
+      fputs("Usage: memo [-r] [-m size] [-f file] [-p name...]\n", stderr);
+      return EXIT_FAILURE;
+    }
+  }
+  return EXIT_SUCCESS;
+}
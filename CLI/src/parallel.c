@@ -0,0 +1,592 @@
+/**
+ * @file parallel.c
+ * @author Enrique Rodrigues (a28602@alunos.ipca.pt)
+ * @brief Contains the `paralelo` builtin, which runs a command over many
+ * inputs with a bounded number of concurrent workers.
+ * @version 0.1
+ * @date 2026-10-16
+ * @copyright Copyright (c) 2024
+ *
+ * @section Modifications
+ * - 2026-10-16: The resource usage of each command is collected with wait4().
+ *   Enrique George Rodrigues (a28602@alunos.ipca.pt)
+ * - 2026-10-16: Commands are recorded in the execution trace.
+ *   Enrique George Rodrigues (a28602@alunos.ipca.pt)
+ */
+#define _GNU_SOURCE
+
+#include "parallel.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/signalfd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "constants.h"
+#include "execute.h"
+#include "line_reader.h"
+#include "run.h"
+#include "trace.h"
+#include "usage.h"
+
+/* Separates the command from its inputs. */
+#define INPUT_SEPARATOR ":::"
+
+/* Replaced by the input in the arguments of the command. */
+#define INPUT_PLACEHOLDER "{}"
+
+/* Exit status for invalid usage. */
+#define USAGE_ERROR_STATUS 255
+
+/* Largest number of failed commands reported in the exit status. */
+#define MAX_FAILURE_STATUS 101
+
+/* Help message explaining usage. */
+#define HELP_MESSAGE                                                       \
+  "Usage: paralelo [-j N] [-k] command [args...] [::: input...]\n"         \
+  "Runs a command once per input, with up to N commands at once.\n"        \
+  "Each {} in the arguments is replaced by the input. Without {}, the\n"   \
+  "input is added as the last argument. Without :::, inputs are read\n"    \
+  "from stdin, one per line.\n"                                            \
+  "Options:\n"                                                             \
+  "  -j N        Run up to N commands at once (default: online CPUs).\n"   \
+  "  -k          Keep the output in input order, buffering each command.\n"
+
+/**
+ * @brief Structure that holds one invocation of the command.
+ */
+typedef struct ParallelJob {
+  char **args;             // arguments of the command, terminated by NULL
+  int arg_count;           // number of arguments
+  pid_t pid;               // pid of the command, or -1
+  int out_fd;              // read end of the output pipe, or -1
+  char *output;            // buffered output (only with -k)
+  size_t output_length;    // number of bytes in `output`
+  size_t output_capacity;  // size of `output`
+  int status;              // exit status of the command
+  bool started;            // whether the command was started
+  bool reaped;             // whether the command terminated
+} ParallelJob;
+
+/**
+ * @brief Structure that holds the state of a `paralelo` invocation.
+ */
+typedef struct ParallelRun {
+  char **command;     // arguments of the command, with placeholders
+  int command_count;  // number of arguments of the command
+  char **inputs;      // inputs, one per command
+  int input_count;    // number of inputs
+  ParallelJob *jobs;  // one job per input
+  int max_jobs;       // maximum number of commands running at once
+  bool keep_order;    // whether to buffer the output in input order
+  int signal_fd;      // signalfd that reports SIGCHLD, or -1
+} ParallelRun;
+
+/**
+ * @brief Appends an input to a growable array of strings.
+ *
+ * @param inputs The array of inputs.
+ * @param count The number of inputs in the array.
+ * @param capacity The capacity of the array.
+ * @param input The input to append. It is copied.
+ * @return true on success, false on memory allocation failure.
+ */
+static bool appendInput(char ***inputs, int *count, int *capacity,
+                        const char *input) {
+  if (*count == *capacity) {
+    int new_capacity = *capacity ? *capacity * 2 : 64;
+    char **new_inputs = realloc(*inputs, new_capacity * sizeof(char *));
+    if (new_inputs == NULL) {
+      return false;
+    }
+    *inputs = new_inputs;
+    *capacity = new_capacity;
+  }
+  (*inputs)[*count] = strdup(input);
+  if ((*inputs)[*count] == NULL) {
+    return false;
+  }
+  (*count)++;
+  return true;
+}
+
+/**
+ * @brief Reads the inputs from stdin, one per line.
+ *
+ * Empty lines are ignored.
+ *
+ * @param run The invocation that receives the inputs.
+ * @return true on success, false on error.
+ */
+static bool readInputsFromStdin(ParallelRun *run) {
+  LineReader reader;
+  if (!initLineReader(&reader, STDIN_FILENO)) {
+    return false;
+  }
+
+  int capacity = 0;
+  char *line;
+  int result;
+  while ((result = readLine(&reader, &line)) == 1) {
+    if (*line != '\0' &&
+        !appendInput(&run->inputs, &run->input_count, &capacity, line)) {
+      result = -1;
+      break;
+    }
+  }
+
+  freeLineReader(&reader);
+  return result == 0;
+}
+
+/**
+ * @brief Replaces every placeholder in an argument by the input.
+ *
+ * @param arg The argument, possibly containing placeholders.
+ * @param input The input.
+ * @return char* The new argument, or NULL on memory allocation failure.
+ */
+static char *substituteInput(const char *arg, const char *input) {
+  size_t placeholder_length = strlen(INPUT_PLACEHOLDER);
+  size_t input_length = strlen(input);
+
+  size_t count = 0;
+  for (const char *p = arg; (p = strstr(p, INPUT_PLACEHOLDER)) != NULL;
+       p += placeholder_length) {
+    count++;
+  }
+
+  size_t length = strlen(arg) + count * input_length;
+  char *result = malloc(length + 1);
+  if (result == NULL) {
+    return NULL;
+  }
+
+  char *out = result;
+  const char *p = arg;
+  const char *match;
+  while ((match = strstr(p, INPUT_PLACEHOLDER)) != NULL) {
+    memcpy(out, p, match - p);
+    out += match - p;
+    memcpy(out, input, input_length);
+    out += input_length;
+    p = match + placeholder_length;
+  }
+  strcpy(out, p);
+  return result;
+}
+
+/**
+ * @brief Builds the arguments of the command for one input.
+ *
+ * @param run The invocation.
+ * @param job The job that receives the arguments.
+ * @param input The input of the job.
+ * @return true on success, false on memory allocation failure.
+ */
+static bool buildArguments(const ParallelRun *run, ParallelJob *job,
+                           const char *input) {
+  bool has_placeholder = false;
+  for (int i = 0; i < run->command_count; i++) {
+    if (strstr(run->command[i], INPUT_PLACEHOLDER) != NULL) {
+      has_placeholder = true;
+    }
+  }
+
+  job->arg_count = run->command_count + (has_placeholder ? 0 : 1);
+  job->args = calloc(job->arg_count + 1, sizeof(char *));
+  if (job->args == NULL) {
+    return false;
+  }
+
+  for (int i = 0; i < run->command_count; i++) {
+    job->args[i] = substituteInput(run->command[i], input);
+    if (job->args[i] == NULL) {
+      return false;
+    }
+  }
+  if (!has_placeholder) {
+    job->args[run->command_count] = strdup(input);
+    if (job->args[run->command_count] == NULL) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * @brief Starts the command of a job.
+ *
+ * @param run The invocation.
+ * @param index The index of the job.
+ */
+static void startJob(ParallelRun *run, int index) {
+  ParallelJob *job = &run->jobs[index];
+  job->started = true;
+  job->pid = -1;
+  job->out_fd = -1;
+  job->status = EXIT_FAILURE;
+
+  if (!buildArguments(run, job, run->inputs[index])) {
+    fputs("paralelo: Memory allocation failed.\n", stderr);
+    job->reaped = true;
+    return;
+  }
+
+  // Capture the output in a pipe when it must be printed in order
+  CommandIO io = DEFAULT_COMMAND_IO;
+  int pipe_fds[2] = {-1, -1};
+  if (run->keep_order) {
+    if (pipe2(pipe_fds, O_CLOEXEC) == -1) {
+      perror("paralelo: Error creating pipe");
+      job->reaped = true;
+      return;
+    }
+    io.out_fd = pipe_fds[1];
+  }
+
+  job->pid = launchArguments(job->args, job->arg_count, &io);
+  if (pipe_fds[1] != -1) {
+    close(pipe_fds[1]);
+  }
+  job->out_fd = pipe_fds[0];
+
+  if (job->pid == -1) {
+    job->reaped = true;
+    job->status = 127;
+  }
+}
+
+/**
+ * @brief Checks if a job has terminated and its output was fully read.
+ *
+ * @param job The job.
+ * @return true if the job is complete, false otherwise.
+ */
+static bool isJobComplete(const ParallelJob *job) {
+  return job->started && job->reaped && job->out_fd == -1;
+}
+
+/**
+ * @brief Reads the output available in the pipe of a job.
+ *
+ * @param job The job.
+ */
+static void readJobOutput(ParallelJob *job) {
+  if (job->output_capacity - job->output_length < BUFFER_SIZE_BYTES) {
+    size_t new_capacity = job->output_capacity * 2 + BUFFER_SIZE_BYTES;
+    char *output = realloc(job->output, new_capacity);
+    if (output == NULL) {
+      close(job->out_fd);  // Drop the rest of the output
+      job->out_fd = -1;
+      return;
+    }
+    job->output = output;
+    job->output_capacity = new_capacity;
+  }
+
+  ssize_t bytes_read = read(job->out_fd, job->output + job->output_length,
+                            job->output_capacity - job->output_length);
+  if (bytes_read > 0) {
+    job->output_length += bytes_read;
+  } else if (bytes_read == 0 || errno != EINTR) {
+    close(job->out_fd);
+    job->out_fd = -1;
+  }
+}
+
+/**
+ * @brief Reaps the jobs whose command terminated, without blocking.
+ *
+ * The resources used by each command are added to the active usage meters
+ * and to the execution trace.
+ *
+ * @param run The invocation.
+ * @param first The index of the first job that may be running.
+ * @param end The index after the last started job.
+ */
+static void reapParallelJobs(ParallelRun *run, int first, int end) {
+  for (int i = first; i < end; i++) {
+    ParallelJob *job = &run->jobs[i];
+    int wait_status;
+    struct rusage usage;
+    if (!job->reaped &&
+        wait4(job->pid, &wait_status, WNOHANG, &usage) == job->pid) {
+      addChildUsage(&usage);
+      traceExit(job->pid, wait_status, &usage);
+      job->status = exitStatusFromWait(wait_status);
+      job->reaped = true;
+    }
+  }
+}
+
+/**
+ * @brief Waits until a command terminates or produces output.
+ *
+ * @param run The invocation.
+ * @param first The index of the first job that may be running.
+ * @param end The index after the last started job.
+ */
+static void waitForJobs(ParallelRun *run, int first, int end) {
+  struct pollfd fds[end - first + 1];
+  int fd_count = 0;
+
+  if (run->signal_fd != -1) {
+    fds[fd_count++] = (struct pollfd){run->signal_fd, POLLIN, 0};
+  }
+  for (int i = first; i < end; i++) {
+    if (run->jobs[i].out_fd != -1) {
+      fds[fd_count++] = (struct pollfd){run->jobs[i].out_fd, POLLIN, 0};
+    }
+  }
+
+  // Without a signalfd, exits are noticed by polling every few milliseconds
+  int timeout = (run->signal_fd != -1) ? -1 : 10;
+  if (poll(fds, fd_count, timeout) == -1) {
+    return;
+  }
+
+  if (run->signal_fd != -1 && (fds[0].revents & POLLIN)) {
+    struct signalfd_siginfo info;
+    while (read(run->signal_fd, &info, sizeof(info)) > 0) {
+    }
+  }
+  for (int i = first; i < end; i++) {
+    ParallelJob *job = &run->jobs[i];
+    for (int f = 0; f < fd_count && job->out_fd != -1; f++) {
+      if (fds[f].fd == job->out_fd && fds[f].revents != 0) {
+        readJobOutput(job);
+      }
+    }
+  }
+}
+
+/**
+ * @brief Reports and releases a complete job.
+ *
+ * @param job The job.
+ * @return true if the command succeeded, false otherwise.
+ */
+static bool finishJob(ParallelJob *job) {
+  if (job->output_length > 0) {
+    fflush(stdout);
+    size_t written = 0;
+    while (written < job->output_length) {
+      ssize_t result = write(STDOUT_FILENO, job->output + written,
+                             job->output_length - written);
+      if (result <= 0) {
+        break;
+      }
+      written += result;
+    }
+  }
+  free(job->output);
+  job->output = NULL;
+
+  if (job->status != EXIT_SUCCESS && job->args != NULL) {
+    fprintf(stderr, "paralelo: %s", job->args[0]);
+    for (int i = 1; i < job->arg_count; i++) {
+      fprintf(stderr, " %s", job->args[i]);
+    }
+    fprintf(stderr, ": exit status %d\n", job->status);
+  }
+
+  if (job->args != NULL) {
+    for (int i = 0; i < job->arg_count; i++) {
+      free(job->args[i]);
+    }
+    free(job->args);
+    job->args = NULL;
+  }
+  return job->status == EXIT_SUCCESS;
+}
+
+/**
+ * @brief Runs the command for every input with the worker pool.
+ *
+ * Keeps up to `max_jobs` commands running. Jobs are finished in input order,
+ * so with `-k` the buffered output of each command is printed in order.
+ *
+ * @param run The invocation.
+ * @return int The number of commands that failed.
+ */
+static int runJobs(ParallelRun *run) {
+  int failed = 0;
+  int next_start = 0;   // next job to start
+  int next_finish = 0;  // next job to report, in input order
+  int running = 0;      // number of jobs started but not reaped
+
+  while (next_finish < run->input_count) {
+    // Keep every worker busy
+    while (running < run->max_jobs && next_start < run->input_count) {
+      startJob(run, next_start);
+      running += !run->jobs[next_start++].reaped;
+    }
+
+    // Report the complete jobs in input order
+    while (next_finish < next_start &&
+           isJobComplete(&run->jobs[next_finish])) {
+      if (!finishJob(&run->jobs[next_finish])) {
+        failed++;
+      }
+      next_finish++;
+    }
+
+    if (next_finish == run->input_count) {
+      break;
+    }
+
+    // Reap without blocking, and wait only when no command terminated
+    int reaped = 0;
+    for (int i = next_finish; i < next_start; i++) {
+      reaped -= run->jobs[i].reaped;
+    }
+    reapParallelJobs(run, next_finish, next_start);
+    for (int i = next_finish; i < next_start; i++) {
+      reaped += run->jobs[i].reaped;
+    }
+    running -= reaped;
+
+    if (reaped == 0) {
+      waitForJobs(run, next_finish, next_start);
+    }
+  }
+
+  return failed;
+}
+
+/**
+ * @brief Parses the options and the command of `paralelo`.
+ *
+ * @param run The invocation that receives the options.
+ * @param argc The number of arguments.
+ * @param argv The arguments, starting with the builtin name.
+ * @return int The index of the first argument after the command, or -1 on
+ * invalid usage.
+ */
+static int parseOptions(ParallelRun *run, int argc, char *argv[]) {
+  int i = 1;
+  for (; i < argc && argv[i][0] == '-'; i++) {
+    if (strcmp(argv[i], "-k") == 0) {
+      run->keep_order = true;
+    } else if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+      char *end;
+      long value = strtol(argv[++i], &end, 10);
+      if (*end != '\0' || value <= 0) {
+        return -1;
+      }
+      run->max_jobs = (int)value;
+    } else {
+      return -1;
+    }
+  }
+
+  run->command = &argv[i];
+  for (; i < argc && strcmp(argv[i], INPUT_SEPARATOR) != 0; i++) {
+    run->command_count++;
+  }
+  return (run->command_count > 0) ? i : -1;
+}
+
+/**
+ * @brief Creates a signalfd that reports SIGCHLD for this invocation.
+ *
+ * `paralelo` may run inside the interpreter or in a child copy of it (in a
+ * pipeline or in the background), so it blocks SIGCHLD on its own.
+ *
+ * @param old_mask Receives the signal mask to restore afterwards.
+ * @return int The signalfd, or -1 if it could not be created.
+ */
+static int createChildSignalFd(sigset_t *old_mask) {
+  sigset_t mask;
+  sigemptyset(&mask);
+  sigaddset(&mask, SIGCHLD);
+  sigprocmask(SIG_BLOCK, &mask, old_mask);
+  return signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+}
+
+/**
+ * @brief Implements the `paralelo` builtin.
+ *
+ * @param argc The number of arguments.
+ * @param argv The arguments, starting with the builtin name.
+ * @return int 0 if every command succeeded, otherwise the number of failed
+ * commands up to 100, or 101 if more than 100 failed. Returns 255 on invalid
+ * usage.
+ */
+int parallelBuiltin(int argc, char *argv[]) {
+  if (argc > 1 && strcmp(argv[1], "--help") == 0) {
+    fputs(HELP_MESSAGE, stdout);
+    return EXIT_SUCCESS;
+  }
+
+  ParallelRun run;
+  memset(&run, 0, sizeof(run));
+  long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+  run.max_jobs = (cpus > 0) ? (int)cpus : 1;
+
+  int next = parseOptions(&run, argc, argv);
+  if (next == -1) {
+    fputs("Error: Incorrect usage.\n", stderr);
+    fputs(HELP_MESSAGE, stderr);
+    return USAGE_ERROR_STATUS;
+  }
+
+  // Collect the inputs from the command line or from stdin
+  bool inputs_ok = true;
+  if (next < argc) {
+    int capacity = 0;
+    for (int i = next + 1; i < argc && inputs_ok; i++) {
+      inputs_ok = appendInput(&run.inputs, &run.input_count, &capacity,
+                              argv[i]);
+    }
+  } else {
+    inputs_ok = readInputsFromStdin(&run);
+  }
+
+  // The number of failed commands can be any value, so input errors are
+  // kept apart from it
+  int failed = 0;
+  bool usage_error = false;
+  run.jobs = calloc(run.input_count ? run.input_count : 1, sizeof(ParallelJob));
+  if (!inputs_ok || run.jobs == NULL) {
+    fputs("paralelo: Unable to read the inputs.\n", stderr);
+    usage_error = true;
+  } else if (run.input_count > 0) {
+    sigset_t old_mask;
+    run.signal_fd = createChildSignalFd(&old_mask);
+
+    fflush(stdout);
+    failed = runJobs(&run);
+
+    if (run.signal_fd != -1) {
+      close(run.signal_fd);
+    }
+    sigprocmask(SIG_SETMASK, &old_mask, NULL);
+
+    if (failed > 0) {
+      fprintf(stderr, "paralelo: %d of %d commands failed\n", failed,
+              run.input_count);
+    }
+  }
+
+  for (int i = 0; i < run.input_count; i++) {
+    free(run.inputs[i]);
+  }
+  free(run.inputs);
+  free(run.jobs);
+
+  if (usage_error) {
+    return USAGE_ERROR_STATUS;
+  }
+  return (failed < MAX_FAILURE_STATUS) ? failed : MAX_FAILURE_STATUS;
+}
@@ -0,0 +1,210 @@
+/**
+ * @file pipeline.c
+ * @author Enrique Rodrigues (a28602@alunos.ipca.pt)
+ * @brief Contains functions for executing pipelines of commands.
+ * @version 0.1
+ * @date 2026-10-16
+ * @copyright Copyright (c) 2024
+ *
+ * @section Modifications
+ * - 2026-10-16: Builtins can be pipeline stages.
+ *   Enrique George Rodrigues (a28602@alunos.ipca.pt)
+ * - 2026-10-16: Operators are recognized with isOperator(), and pipelines are
+ *               limited to MAX_PIPELINE_STAGES stages.
+ *   Enrique George Rodrigues (a28602@alunos.ipca.pt)
+ * - 2026-10-16: Applies the redirections of each stage.
+ *   Enrique George Rodrigues (a28602@alunos.ipca.pt)
+ */
+#define _GNU_SOURCE
+
+#include "pipeline.h"
+
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include "constants.h"
+#include "execute.h"
+#include "input_parser.h"
+#include "redirect.h"
+#include "run.h"
+
+/**
+ * @brief Structure that holds one stage of a pipeline.
+ */
+typedef struct PipelineStage {
+  char **args;    // arguments of the stage, terminated by NULL
+  int arg_count;  // number of arguments of the stage
+  pid_t pid;      // pid of the process running the stage, or -1
+} PipelineStage;
+
+/**
+ * @brief Checks if the arguments of a command line form a pipeline.
+ *
+ * @param args An array of strings containing the parsed arguments.
+ * @param arg_count The number of arguments in `args`.
+ * @return true if the arguments contain the pipe operator, false otherwise.
+ */
+bool isPipeline(char *args[], int arg_count) {
+  for (int i = 0; i < arg_count; i++) {
+    if (isOperator(args[i], PIPE_OPERATOR)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * @brief Splits the arguments of a pipeline into stages.
+ *
+ * @param args The parsed arguments. Pipe operators are replaced by NULL.
+ * @param arg_count The number of arguments in `args`.
+ * @param stages Array that receives the stages. Must hold
+ * MAX_PIPELINE_STAGES entries.
+ * @return int The number of stages, or -1 if a stage is empty or there are
+ * too many stages.
+ */
+static int splitStages(char *args[], int arg_count, PipelineStage stages[]) {
+  int stage_count = 0;
+  int start = 0;
+
+  for (int i = 0; i <= arg_count; i++) {
+    if (i < arg_count && !isOperator(args[i], PIPE_OPERATOR)) {
+      continue;
+    }
+    if (i == start) {
+      fputs("Syntax error: empty command in pipeline\n", stderr);
+      return -1;  // Empty stage, e.g. "a | | b" or "| a"
+    }
+    if (stage_count == MAX_PIPELINE_STAGES) {
+      fprintf(stderr, "Syntax error: more than %d commands in pipeline\n",
+              MAX_PIPELINE_STAGES);
+      return -1;
+    }
+    args[i] = NULL;
+    stages[stage_count].args = &args[start];
+    stages[stage_count].arg_count = i - start;
+    stages[stage_count].pid = -1;
+    stage_count++;
+    start = i + 1;
+  }
+
+  return stage_count;
+}
+
+/**
+ * @brief Creates the pipe that connects two stages.
+ *
+ * The pipe is created close-on-exec, so only the stages that receive it as a
+ * standard stream keep it open, and its capacity is raised so producers and
+ * consumers can move large blocks between context switches. A pipe that
+ * cannot be enlarged keeps its default capacity.
+ *
+ * @param pipe_fds Array that receives the read and write ends of the pipe.
+ * @return true on success, false if the pipe could not be created.
+ */
+static bool createStagePipe(int pipe_fds[2]) {
+  if (pipe2(pipe_fds, O_CLOEXEC) == -1) {
+    perror("Error creating pipe");
+    return false;
+  }
+  fcntl(pipe_fds[1], F_SETPIPE_SZ, PIPE_BUFFER_SIZE_BYTES);
+  return true;
+}
+
+/**
+ * @brief Launches a pipeline of commands without waiting for it.
+ *
+ * The arguments are split into stages at each pipe operator. Every stage is
+ * started at once, with the stdout of each stage connected to the stdin of
+ * the next one through a pipe, unless the stage redirects that stream to a
+ * file. Builtins and bundled commands run in a child copy of the interpreter
+ * instead of being executed as separate programs.
+ *
+ * @param args An array of strings containing the parsed arguments. The pipe
+ * operators are replaced by NULL to terminate the argument list of each stage.
+ * @param arg_count The number of arguments in `args`.
+ * @param pids Array that receives the pid of each stage, or -1 for stages
+ * that could not be launched. Must hold MAX_PIPELINE_STAGES entries.
+ * @return int The number of stages, or -1 on syntax error.
+ */
+int launchPipeline(char *args[], int arg_count, pid_t pids[]) {
+  PipelineStage stages[MAX_PIPELINE_STAGES];
+  int stage_count = splitStages(args, arg_count, stages);
+  if (stage_count == -1) {
+    return -1;
+  }
+
+  // Launch every stage, connecting each one to the next through a pipe
+  int in_fd = STDIN_FILENO;
+  for (int i = 0; i < stage_count; i++) {
+    CommandIO io = DEFAULT_COMMAND_IO;
+    int pipe_fds[2] = {-1, -1};
+
+    io.in_fd = in_fd;
+    if (i < stage_count - 1) {
+      if (!createStagePipe(pipe_fds)) {
+        break;
+      }
+      io.out_fd = pipe_fds[1];
+    }
+
+    // Redirections of a stage replace its pipes
+    CommandIO stage_io = io;
+    int arg_count = applyRedirections(stages[i].args, stages[i].arg_count,
+                                      &stage_io);
+    if (arg_count > 0) {
+      stages[i].pid = launchArguments(stages[i].args, arg_count, &stage_io);
+    }
+    closeRedirections(&stage_io, &io);
+
+    // The parent keeps only the read end the next stage needs
+    if (in_fd != STDIN_FILENO) {
+      close(in_fd);
+    }
+    if (pipe_fds[1] != -1) {
+      close(pipe_fds[1]);
+    }
+    in_fd = pipe_fds[0];
+  }
+  if (in_fd != STDIN_FILENO && in_fd != -1) {
+    close(in_fd);
+  }
+
+  for (int i = 0; i < stage_count; i++) {
+    pids[i] = stages[i].pid;
+  }
+  return stage_count;
+}
+
+/**
+ * @brief Executes a pipeline of commands.
+ *
+ * Launches the pipeline with launchPipeline() and then waits for all stages
+ * together.
+ *
+ * @param args An array of strings containing the parsed arguments. The pipe
+ * operators are replaced by NULL to terminate the argument list of each stage.
+ * @param arg_count The number of arguments in `args`.
+ * @return int The exit status of the last stage.
+ */
+int executePipeline(char *args[], int arg_count) {
+  pid_t pids[MAX_PIPELINE_STAGES];
+  int stage_count = launchPipeline(args, arg_count, pids);
+  if (stage_count == -1) {
+    return EXIT_FAILURE;
+  }
+
+  // Wait for all stages, the pipeline status is the one of the last stage
+  int status = EXIT_FAILURE;
+  for (int i = 0; i < stage_count; i++) {
+    status = (pids[i] != -1) ? waitCommand(pids[i]) : EXIT_FAILURE;
+  }
+
+  finishCommandOutput();
+  return status;
+}
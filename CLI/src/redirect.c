@@ -0,0 +1,198 @@
+/**
+ * @file redirect.c
+ * @author Enrique Rodrigues (a28602@alunos.ipca.pt)
+ * @brief Contains the redirection of the standard streams.
+ * @version 0.1
+ * @date 2026-10-16
+ * @copyright Copyright (c) 2024
+ */
+#define _XOPEN_SOURCE 700
+
+#include "redirect.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "constants.h"
+#include "execute.h"
+#include "input_parser.h"
+
+/* Permissions of the files created by redirections, before the umask. */
+#define REDIRECT_FILE_MODE 0666
+
+/* Lowest descriptor used to keep the streams of the interpreter. */
+#define SAVED_FD_MIN 10
+
+/**
+ * @brief Structure that describes a redirection operator.
+ */
+typedef struct Redirection {
+  const char *operator;  // operator, as returned by the lexer
+  int stream;            // standard stream it redirects
+  int flags;             // flags used to open the file
+} Redirection;
+
+/* Redirection operators. */
+static const Redirection REDIRECTIONS[] = {
+    {INPUT_REDIRECT, STDIN_FILENO, O_RDONLY},
+    {OUTPUT_REDIRECT, STDOUT_FILENO, O_WRONLY | O_CREAT | O_TRUNC},
+    {APPEND_REDIRECT, STDOUT_FILENO, O_WRONLY | O_CREAT | O_APPEND},
+    {ERROR_REDIRECT, STDERR_FILENO, O_WRONLY | O_CREAT | O_TRUNC},
+    {ERROR_APPEND_REDIRECT, STDERR_FILENO, O_WRONLY | O_CREAT | O_APPEND}};
+
+/**
+ * @brief Finds the redirection an argument is the operator of.
+ *
+ * @param arg The argument.
+ * @return const Redirection* The redirection, or NULL if the argument is not
+ * a redirection operator.
+ */
+static const Redirection *findRedirection(const char *arg) {
+  size_t count = sizeof(REDIRECTIONS) / sizeof(REDIRECTIONS[0]);
+  for (size_t i = 0; i < count; i++) {
+    if (isOperator(arg, REDIRECTIONS[i].operator)) {
+      return &REDIRECTIONS[i];
+    }
+  }
+  return NULL;
+}
+
+/**
+ * @brief Returns the field of a CommandIO that holds a stream.
+ *
+ * @param io The streams.
+ * @param stream The stream number.
+ * @return int* The field.
+ */
+static int *streamField(CommandIO *io, int stream) {
+  if (stream == STDIN_FILENO) {
+    return &io->in_fd;
+  }
+  return (stream == STDOUT_FILENO) ? &io->out_fd : &io->err_fd;
+}
+
+/**
+ * @brief Opens the files of the redirections of a command.
+ *
+ * The redirection operators and their files are removed from `args`, and the
+ * descriptors of the files replace the streams in `io`. The files are opened
+ * close-on-exec, so commands only inherit the copies made for their streams.
+ *
+ * @param args The arguments of the command, terminated by NULL.
+ * @param arg_count The number of arguments in `args`.
+ * @param io The streams of the command, updated with the files.
+ * @return int The number of arguments left, or -1 on error, in which case
+ * `io` is unchanged and no file is left open.
+ */
+int applyRedirections(char *args[], int arg_count, CommandIO *io) {
+  CommandIO original = *io;
+  int kept = 0;
+
+  for (int i = 0; i < arg_count; i++) {
+    const Redirection *redirection = findRedirection(args[i]);
+    if (redirection == NULL) {
+      args[kept++] = args[i];
+      continue;
+    }
+
+    const char *path = (i + 1 < arg_count) ? args[++i] : NULL;
+    int fd = -1;
+    if (path == NULL || findRedirection(path) != NULL ||
+        isOperator(path, BACKGROUND_OPERATOR) ||
+        isOperator(path, PIPE_OPERATOR)) {
+      fprintf(stderr, "Syntax error: missing file after '%s'\n",
+              redirection->operator);
+    } else if ((fd = open(path, redirection->flags | O_CLOEXEC,
+                          REDIRECT_FILE_MODE)) == -1) {
+      fprintf(stderr, "%s: %s\n", path, strerror(errno));
+    }
+    if (fd == -1) {
+      closeRedirections(io, &original);
+      *io = original;
+      return -1;
+    }
+
+    // A later redirection of the same stream replaces an earlier one
+    int *field = streamField(io, redirection->stream);
+    if (*field != *streamField(&original, redirection->stream)) {
+      close(*field);
+    }
+    *field = fd;
+  }
+
+  args[kept] = NULL;
+  return kept;
+}
+
+/**
+ * @brief Closes the files opened by applyRedirections().
+ *
+ * @param io The streams returned by applyRedirections().
+ * @param original The streams before the redirections were applied.
+ */
+void closeRedirections(const CommandIO *io, const CommandIO *original) {
+  if (io->in_fd != original->in_fd) {
+    close(io->in_fd);
+  }
+  if (io->out_fd != original->out_fd) {
+    close(io->out_fd);
+  }
+  if (io->err_fd != original->err_fd) {
+    close(io->err_fd);
+  }
+}
+
+/**
+ * @brief Connects the standard streams of the interpreter to other files.
+ *
+ * Used around commands that run inside the interpreter. Buffered output is
+ * flushed first, and the original streams are kept in `saved_fds`.
+ *
+ * @param io The descriptors to use as stdin, stdout and stderr.
+ * @param saved_fds Receives copies of the original streams, or -1 for streams
+ * that are not changed.
+ * @return true on success, false on error, in which case nothing is changed.
+ */
+bool redirectInterpreter(const CommandIO *io, int saved_fds[3]) {
+  fflush(stdout);
+  fflush(stderr);
+
+  const int fds[] = {io->in_fd, io->out_fd, io->err_fd};
+  for (int target = 0; target < 3; target++) {
+    saved_fds[target] = -1;
+  }
+  for (int target = 0; target < 3; target++) {
+    if (fds[target] == target) {
+      continue;
+    }
+
+    saved_fds[target] = fcntl(target, F_DUPFD_CLOEXEC, SAVED_FD_MIN);
+    if (saved_fds[target] == -1 || dup2(fds[target], target) == -1) {
+      perror("Error");
+      restoreInterpreter(saved_fds);
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * @brief Restores the streams changed by redirectInterpreter().
+ *
+ * @param saved_fds The copies of the original streams.
+ */
+void restoreInterpreter(const int saved_fds[3]) {
+  fflush(stdout);
+  fflush(stderr);
+
+  for (int target = 0; target < 3; target++) {
+    if (saved_fds[target] != -1) {
+      dup2(saved_fds[target], target);
+      close(saved_fds[target]);
+    }
+  }
+}
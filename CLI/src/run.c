@@ -0,0 +1,436 @@
+/**
+ * @file run.c
+ * @author Enrique Rodrigues (a28602@alunos.ipca.pt)
+ * @brief Contains the function that runs parsed command lines.
+ * @version 0.1
+ * @date 2026-10-16
+ * @copyright Copyright (c) 2024
+ *
+ * @section Modifications
+ * - 2026-10-16: Builtins can run as background jobs. Added launchArguments().
+ *   Enrique George Rodrigues (a28602@alunos.ipca.pt)
+ * - 2026-10-16: The resource usage of foreground command lines is measured.
+ *   Enrique George Rodrigues (a28602@alunos.ipca.pt)
+ * - 2026-10-16: Commands are recorded in the execution trace, with the time
+ *               spent finding them in the PATH.
+ *   Enrique George Rodrigues (a28602@alunos.ipca.pt)
+ * - 2026-10-16: The background operator is recognized with isOperator().
+ *   Enrique George Rodrigues (a28602@alunos.ipca.pt)
+ * - 2026-10-16: Applies the redirections of commands that run in the
+ *               foreground.
+ *   Enrique George Rodrigues (a28602@alunos.ipca.pt)
+ * - 2026-10-16: Bundled commands and background jobs run with the scheduling
+ *               policy set by escalona.
+ *   Enrique George Rodrigues (a28602@alunos.ipca.pt)
+ * - 2026-10-16: Pure commands run through the result cache.
+ *   Enrique George Rodrigues (a28602@alunos.ipca.pt)
+ * - 2026-10-16: `mostra --segue` runs in a child process, which Ctrl-C stops
+ *               without stopping the interpreter.
+ *   Enrique George Rodrigues (a28602@alunos.ipca.pt)
+ * - 2026-10-16: runLine() moved here from main.c.
+ *   Enrique George Rodrigues (a28602@alunos.ipca.pt)
+ */
+#define _XOPEN_SOURCE 700
+
+#include "run.h"
+
+#include <signal.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <time.h>
+
+#include "arena.h"
+#include "builtins.h"
+#include "constants.h"
+#include "execute.h"
+#include "find.h"
+#include "input_parser.h"
+#include "jobs.h"
+#include "memo.h"
+#include "pipeline.h"
+#include "redirect.h"
+#include "schedule.h"
+#include "trace.h"
+#include "usage.h"
+#include "utils.h"
+
+/**
+ * @brief Joins arguments into a single command line separated by spaces.
+ *
+ * @param args The arguments to join.
+ * @param arg_count The number of arguments in `args`.
+ * @param buffer The buffer that receives the command line.
+ * @param size The size of `buffer`.
+ */
+static void joinArguments(char *args[], int arg_count, char *buffer,
+                          size_t size) {
+  size_t length = 0;
+  buffer[0] = '\0';
+  for (int i = 0; i < arg_count && length < size; i++) {
+    length += snprintf(buffer + length, size - length, "%s%s",
+                       (i > 0) ? " " : "", args[i]);
+  }
+}
+
+/**
+ * @brief Finds a command, timing the search for the execution trace.
+ *
+ * @param name The name of the command.
+ * @param command_path The buffer that receives the path of the command.
+ * @return true if the command was found, false otherwise.
+ */
+static bool findCommand(const char *name, char *command_path) {
+  if (!isTracing()) {
+    return resolveCommand(name, command_path);
+  }
+
+  struct timespec start;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  bool found = resolveCommand(name, command_path);
+  traceLookup(&start);
+  return found;
+}
+
+/**
+ * @brief Checks whether a bundled command runs until it is interrupted, like
+ * `mostra --segue`, and so must not run inside the interpreter.
+ *
+ * @param bundled The bundled command.
+ * @param args The arguments of the command, terminated by NULL.
+ * @return true if the command only ends when it is interrupted.
+ */
+static bool runsUntilInterrupted(const BundledCommand *bundled,
+                                 char *args[]) {
+  if (strcmp(bundled->name, "mostra") != 0) {
+    return false;
+  }
+  for (int i = 1; args[i] != NULL; i++) {
+    if (strcmp(args[i], "--segue") == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * @brief Runs a bundled command in a child process and waits for it.
+ *
+ * While a command that runs until it is interrupted is waited for, the
+ * interpreter ignores SIGINT, so Ctrl-C only stops the command.
+ *
+ * @param bundled The bundled command.
+ * @param args The arguments of the command, terminated by NULL.
+ * @param arg_count The number of arguments in `args`.
+ * @param io The descriptors the command uses as its standard streams.
+ * @return int The exit status of the command.
+ */
+static int runInChild(const BundledCommand *bundled, char *args[],
+                      int arg_count, const CommandIO *io) {
+  pid_t pid = launchBundledCommand(bundled, arg_count, args, io);
+  if (pid == -1) {
+    return EXIT_FAILURE;
+  }
+
+  // Ignore SIGINT only once the child exists, so it keeps the default action
+  bool interruptible = runsUntilInterrupted(bundled, args);
+  struct sigaction ignore, previous;
+  memset(&ignore, 0, sizeof(ignore));
+  ignore.sa_handler = SIG_IGN;
+  if (interruptible) {
+    sigaction(SIGINT, &ignore, &previous);
+  }
+  int status = waitCommand(pid);
+  if (interruptible) {
+    sigaction(SIGINT, &previous, NULL);
+  }
+  finishCommandOutput();
+  return status;
+}
+
+/**
+ * @brief Runs a builtin or a bundled command inside the interpreter.
+ *
+ * @param builtin The builtin to run, or NULL to run `bundled`.
+ * @param bundled The bundled command to run, if `builtin` is NULL.
+ * @param args The arguments of the command, terminated by NULL.
+ * @param arg_count The number of arguments in `args`.
+ * @param io The descriptors the command uses as its standard streams.
+ * @return int The exit status of the command.
+ */
+static int runInProcess(const Builtin *builtin, const BundledCommand *bundled,
+                        char *args[], int arg_count, const CommandIO *io) {
+  UsageMeter meter;
+  if (isTracing()) {
+    beginUsage(&meter);
+  }
+
+  int status;
+  int saved_fds[3];
+  if (builtin == NULL) {
+    status = executeBundledCommand(bundled, arg_count, args, io);
+  } else if (redirectInterpreter(io, saved_fds)) {
+    status = builtin->function(arg_count, args);
+    restoreInterpreter(saved_fds);
+  } else {
+    status = EXIT_FAILURE;
+  }
+
+  if (isTracing()) {
+    CommandUsage usage;
+    endUsage(&meter, &usage);
+    traceInProcess((builtin != NULL) ? TRACE_KIND_BUILTIN : TRACE_KIND_BUNDLED,
+                   args, status, &usage);
+  }
+  return status;
+}
+
+/**
+ * @brief Launches a single command without waiting for it.
+ *
+ * Builtins and bundled commands run in a child copy of the interpreter. Any
+ * other command is resolved through the command cache and executed.
+ *
+ * @param args The arguments of the command, terminated by NULL.
+ * @param arg_count The number of arguments in `args`.
+ * @param io The descriptors the command uses as its standard streams.
+ * @return pid_t The pid of the command, or -1 if it could not be launched.
+ */
+pid_t launchArguments(char *args[], int arg_count, const CommandIO *io) {
+  const Builtin *builtin = findBuiltin(args[0]);
+  if (builtin != NULL) {
+    return launchBuiltin(builtin, arg_count, args, io);
+  }
+
+  const BundledCommand *bundled = findBundledCommand(args[0]);
+  if (bundled != NULL) {
+    return launchBundledCommand(bundled, arg_count, args, io);
+  }
+
+  char command_path[BUFFER_SIZE_BYTES];
+  if (!findCommand(args[0], command_path)) {
+    fprintf(stderr, "%s: command not found\n", args[0]);
+    return -1;
+  }
+  return launchCommand(command_path, args, io);
+}
+
+/**
+ * @brief Starts a command line as a background job.
+ *
+ * The job runs with the policy set by `escalona -j`, if any. A leading
+ * `escalona` is applied by the interpreter, so that the processes of the job
+ * are those of the command line it runs, and the CPUs they ran on are
+ * reported when the job finishes.
+ *
+ * @param args The arguments of the command line, without the background
+ * operator.
+ * @param arg_count The number of arguments in `args`.
+ * @return int Returns 0 if the job was started or 1 otherwise.
+ */
+static int runInBackground(char *args[], int arg_count) {
+  char command_line[BUFFER_SIZE_BYTES];
+  joinArguments(args, arg_count, command_line, sizeof(command_line));
+
+  // Jobs get the default policy of background jobs, refined by a leading
+  // `escalona`, which is handled here so the job is the command it runs
+  SchedulePolicy policy;
+  memset(&policy, 0, sizeof(policy));
+  const SchedulePolicy *base = (getActiveSchedule() != NULL)
+                                   ? getActiveSchedule()
+                                   : getJobSchedule();
+  if (base != NULL) {
+    policy = *base;
+  }
+  bool scheduled = (base != NULL);
+  if (strcmp(args[0], SCHEDULE_CMD) == 0) {
+    int index = parseScheduleOptions(arg_count, args, &policy);
+    if (index == -1) {
+      return EXIT_FAILURE;
+    }
+    if (index == arg_count) {
+      fputs("Usage: escalona [options] command [args...]\n", stderr);
+      return EXIT_FAILURE;
+    }
+    args += index;
+    arg_count -= index;
+    scheduled = true;
+  }
+
+  pid_t pids[MAX_PIPELINE_STAGES];
+  const SchedulePolicy *previous =
+      setActiveSchedule(scheduled ? &policy : NULL);
+  int pid_count = launchPipeline(args, arg_count, pids);
+  setActiveSchedule(previous);
+  if (pid_count == -1 || pids[pid_count - 1] == -1) {
+    // Without its last stage nothing of the job would be waited for
+    for (int i = 0; i < pid_count; i++) {
+      if (pids[i] != -1) {
+        waitCommand(pids[i]);
+      }
+    }
+    return EXIT_FAILURE;
+  }
+
+  int id = addJob(command_line, pids, pid_count, scheduled);
+  if (id == -1) {
+    fputs("Error: Unable to register the background job.\n", stderr);
+    return EXIT_FAILURE;
+  }
+  printf("[%d] %ld\n", id, (long)pids[pid_count - 1]);
+  return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Runs a parsed command line in the foreground.
+ *
+ * Decides how the command line is executed: as a pipeline when it contains
+ * the pipe operator, as a builtin, as a bundled command running in-process or
+ * as an external program found in the PATH. Redirections are applied to the
+ * command, except after `tempo`, which leaves them to the command line it
+ * runs. Under `escalona`, bundled commands run in a child process, which the
+ * scheduling policy is applied to, and so do bundled commands that run until
+ * they are interrupted. Pure commands go through the result cache
+ * when it is enabled.
+ *
+ * @param args An array of strings containing the parsed arguments, terminated
+ * by NULL. The array may be modified.
+ * @param arg_count The number of arguments in `args`.
+ * @return int The exit status of the command line.
+ */
+static int runForeground(char *args[], int arg_count) {
+  bool timed = (strcmp(args[0], TIME_CMD) == 0);
+
+  // Run pipelines with all their stages at once, unless `tempo` measures the
+  // whole pipeline
+  if (isPipeline(args, arg_count) && !timed) {
+    return executePipeline(args, arg_count);
+  }
+
+  CommandIO io = DEFAULT_COMMAND_IO;
+  if (!timed) {
+    arg_count = applyRedirections(args, arg_count, &io);
+    if (arg_count <= 0) {
+      // A command made only of redirections just creates the files
+      closeRedirections(&io, &DEFAULT_COMMAND_IO);
+      return (arg_count == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+  }
+
+  // Run builtins and the bundled commands without creating a process, unless
+  // a scheduling policy needs a process to apply to or the command would
+  // never give the interpreter back
+  int status;
+  const Builtin *builtin = findBuiltin(args[0]);
+  const BundledCommand *bundled =
+      (builtin == NULL) ? findBundledCommand(args[0]) : NULL;
+  bool in_child = (bundled != NULL) && (getActiveSchedule() != NULL ||
+                                        runsUntilInterrupted(bundled, args));
+  char command_path[BUFFER_SIZE_BYTES];
+  if (builtin == NULL && bundled == NULL &&
+      !findCommand(args[0], command_path)) {
+    fprintf(stderr, "%s: command not found\n", args[0]);
+    status = 127;
+  } else if (builtin == NULL && getActiveSchedule() == NULL && !in_child &&
+             runMemoized(bundled, command_path, args, arg_count, &io,
+                         &status)) {
+    // The result was served from the cache, or run and cached
+  } else if (builtin != NULL || (bundled != NULL && !in_child)) {
+    status = runInProcess(builtin, bundled, args, arg_count, &io);
+  } else if (bundled != NULL) {
+    status = runInChild(bundled, args, arg_count, &io);
+  } else {
+    // Execute the command found in the current directory or in the PATH
+    status = executeCommand(command_path, args, &io);
+  }
+
+  closeRedirections(&io, &DEFAULT_COMMAND_IO);
+  return status;
+}
+
+/**
+ * @brief Runs a parsed command line.
+ *
+ * Command lines ending with the background operator become background jobs.
+ * Any other command line runs in the foreground and its resource usage is
+ * measured: it is added to the session summary and, when enabled with
+ * `opcao tempo on`, printed after the command.
+ *
+ * @param args An array of strings containing the parsed arguments, terminated
+ * by NULL. The array may be modified.
+ * @param arg_count The number of arguments in `args`.
+ * @return int The exit status of the command line.
+ */
+int runCommandLine(char *args[], int arg_count) {
+  // Start command lines ending with the background operator as jobs
+  if (isOperator(args[arg_count - 1], BACKGROUND_OPERATOR)) {
+    args[--arg_count] = NULL;
+    if (arg_count == 0) {
+      fputs("Syntax error: missing command before '&'\n", stderr);
+      return EXIT_FAILURE;
+    }
+    return runInBackground(args, arg_count);
+  }
+
+  // Keep the command line, since running a pipeline modifies `args`
+  char command_line[BUFFER_SIZE_BYTES];
+  joinArguments(args, arg_count, command_line, sizeof(command_line));
+  bool timed = (strcmp(args[0], TIME_CMD) == 0);
+
+  UsageMeter meter;
+  beginUsage(&meter);
+  int status = runForeground(args, arg_count);
+  CommandUsage usage;
+  endUsage(&meter, &usage);
+
+  // Command lines run by `tempo` are accounted for by the enclosing one
+  if (meter.previous == NULL) {
+    recordSessionUsage(command_line, &usage);
+    if (getUsageReporting() && !timed) {
+      printUsage(stderr, &usage);
+    }
+  }
+  return status;
+}
+
+/**
+ * @brief Parses and runs every command of a line.
+ *
+ * Commands on the same line are separated by the list separator and run one
+ * after the other. The arguments of each command are allocated from `arena`,
+ * which is reset once the command finished. A syntax error stops the rest of
+ * the line. The exit command prints the session summary and terminates the
+ * interpreter.
+ *
+ * @param arena The arena the arguments are allocated from.
+ * @param line The line to run.
+ * @param status The exit status of the previous command, updated with the
+ * status of each command that runs.
+ */
+void runLine(Arena *arena, const char *line, int *status) {
+  const char *rest = line;  // Pointer to keep track of the remaining commands
+
+  while (rest != NULL) {
+    // Parse the input
+    char **args;
+    int arg_count = parseCommand(arena, &rest, &args);
+    if (arg_count == -1) {
+      resetArena(arena);
+      *status = EXIT_FAILURE;
+      return;
+    }
+
+    if (arg_count > 0) {
+      // Check if user wants to end the program
+      if (shouldExit(args[0])) {
+        printSessionUsage(stderr);
+        exit(EXIT_SUCCESS);
+      }
+
+      *status = runCommandLine(args, arg_count);
+    }
+    resetArena(arena);
+  }
+}
@@ -0,0 +1,614 @@
+/**
+ * @file schedule.c
+ * @author Enrique Rodrigues (a28602@alunos.ipca.pt)
+ * @brief Contains the `escalona` builtin and the scheduling policies it
+ * applies to commands.
+ * @version 0.1
+ * @date 2026-10-16
+ * @copyright Copyright (c) 2024
+ */
+#define _GNU_SOURCE
+
+#include "schedule.h"
+
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include "constants.h"
+#include "run.h"
+
+/* Directory where relative cgroup names are looked up. */
+#define CGROUP_ROOT "/sys/fs/cgroup"
+
+/* Field of /proc/<pid>/stat with the CPU the process ran on last. */
+#define STAT_PROCESSOR_FIELD 39
+
+/* I/O priority values of ioprio_set(), from linux/ioprio.h. */
+#define IOPRIO_WHO_PROCESS 1
+#define IOPRIO_CLASS_SHIFT 13
+#define IOPRIO_DEFAULT_LEVEL 4
+
+/* Number of bits in a word of a `CpuList`. */
+#define CPU_WORD_BITS (8 * sizeof(unsigned long))
+
+/* Help message explaining usage. */
+#define HELP_MESSAGE                                                         \
+  "Usage: escalona [options] command [args...]\n"                            \
+  "       escalona -j [options]\n"                                           \
+  "Runs a command line with the given CPUs, nice value, I/O priority and\n"  \
+  "cgroup. With -j, sets the policy of every background job (no options\n"   \
+  "clear it). Without arguments, shows the policy of background jobs.\n"     \
+  "Options:\n"                                                               \
+  "  -c cpus      Run on the listed CPUs, such as 0-3,6.\n"                  \
+  "  -n nice      Run with the given nice value (-20 to 19).\n"              \
+  "  -i class     Use the I/O class idle, best-effort or realtime, with an\n" \
+  "               optional level from 0 to 7, such as best-effort:7.\n"      \
+  "  -g cgroup    Place the command in a cgroup v2 group, relative to\n"     \
+  "               " CGROUP_ROOT " unless the path is absolute.\n"
+
+/**
+ * @brief Structure that maps the name of an I/O class to its value.
+ */
+typedef struct IoClass {
+  const char *name;  // name used in the `-i` option
+  int value;         // class given to ioprio_set()
+} IoClass;
+
+/* I/O classes accepted by the `-i` option. */
+static const IoClass io_classes[] = {
+    {"realtime", 1},
+    {"best-effort", 2},
+    {"idle", 3},
+};
+
+/* Policies in use. */
+static const SchedulePolicy *active_schedule = NULL;  // set by `escalona`
+static SchedulePolicy job_schedule;                   // set by `escalona -j`
+static bool has_job_schedule = false;  // whether `job_schedule` is set
+
+/**
+ * @brief Adds a CPU to a set.
+ *
+ * @param cpus The set of CPUs.
+ * @param cpu The number of the CPU, lower than `SCHEDULE_MAX_CPUS`.
+ */
+static void addCpu(CpuList *cpus, int cpu) {
+  cpus->bits[cpu / CPU_WORD_BITS] |= 1UL << (cpu % CPU_WORD_BITS);
+}
+
+/**
+ * @brief Checks whether a CPU is in a set.
+ *
+ * @param cpus The set of CPUs.
+ * @param cpu The number of the CPU, lower than `SCHEDULE_MAX_CPUS`.
+ * @return true if the CPU is in the set, false otherwise.
+ */
+static bool hasCpu(const CpuList *cpus, int cpu) {
+  return (cpus->bits[cpu / CPU_WORD_BITS] >> (cpu % CPU_WORD_BITS)) & 1UL;
+}
+
+/**
+ * @brief Parses a list of CPUs such as `0-3,6`.
+ *
+ * @param text The list.
+ * @param cpus Receives the CPUs of the list.
+ * @return true if the list is valid, false otherwise.
+ */
+static bool parseCpuList(const char *text, CpuList *cpus) {
+  memset(cpus, 0, sizeof(*cpus));
+  const char *position = text;
+  do {
+    if (!isdigit((unsigned char)*position)) {
+      return false;
+    }
+    char *end;
+    long first = strtol(position, &end, 10);
+    long last = first;
+    if (*end == '-') {
+      position = end + 1;
+      if (!isdigit((unsigned char)*position)) {
+        return false;
+      }
+      last = strtol(position, &end, 10);
+    }
+    if (last < first || last >= SCHEDULE_MAX_CPUS) {
+      return false;
+    }
+    for (long cpu = first; cpu <= last; cpu++) {
+      addCpu(cpus, (int)cpu);
+    }
+    position = end;
+  } while (*position++ == ',');
+  return position[-1] == '\0';
+}
+
+/**
+ * @brief Formats a set of CPUs as a list such as `0-3,6`.
+ *
+ * @param cpus The set of CPUs.
+ * @param buffer The buffer that receives the list.
+ * @param size The size of `buffer`.
+ * @return size_t The number of CPUs in the set.
+ */
+size_t formatCpuList(const CpuList *cpus, char *buffer, size_t size) {
+  size_t count = 0;
+  size_t length = 0;
+  buffer[0] = '\0';
+  for (int cpu = 0; cpu < SCHEDULE_MAX_CPUS; cpu++) {
+    if (!hasCpu(cpus, cpu)) {
+      continue;
+    }
+    int last = cpu;
+    while (last + 1 < SCHEDULE_MAX_CPUS && hasCpu(cpus, last + 1)) {
+      last++;
+    }
+    if (length < size) {
+      length += snprintf(buffer + length, size - length,
+                         (last > cpu) ? "%s%d-%d" : "%s%d",
+                         (count > 0) ? "," : "", cpu, last);
+    }
+    count += last - cpu + 1;
+    cpu = last;
+  }
+  return count;
+}
+
+/**
+ * @brief Converts a set of CPUs to the type used by the kernel.
+ *
+ * @param cpus The set of CPUs.
+ * @param set Receives the same CPUs.
+ */
+static void toCpuSet(const CpuList *cpus, cpu_set_t *set) {
+  CPU_ZERO(set);
+  for (int cpu = 0; cpu < SCHEDULE_MAX_CPUS && cpu < CPU_SETSIZE; cpu++) {
+    if (hasCpu(cpus, cpu)) {
+      CPU_SET(cpu, set);
+    }
+  }
+}
+
+/**
+ * @brief Adds the CPUs of a set used by the kernel to a `CpuList`.
+ *
+ * @param set The CPUs to add.
+ * @param cpus The set that receives them.
+ */
+static void addCpuSet(const cpu_set_t *set, CpuList *cpus) {
+  for (int cpu = 0; cpu < SCHEDULE_MAX_CPUS && cpu < CPU_SETSIZE; cpu++) {
+    if (CPU_ISSET(cpu, set)) {
+      addCpu(cpus, cpu);
+    }
+  }
+}
+
+/**
+ * @brief Parses the value of the `-c` option.
+ *
+ * The list must name at least one CPU the interpreter may run on, since the
+ * commands cannot run anywhere else.
+ *
+ * @param value The list of CPUs.
+ * @param policy The policy that receives the CPUs.
+ * @return true if the value is valid, false otherwise.
+ */
+static bool parseCpuOption(const char *value, SchedulePolicy *policy) {
+  CpuList cpus;
+  if (!parseCpuList(value, &cpus)) {
+    fprintf(stderr, "escalona: %s: invalid list of CPUs\n", value);
+    return false;
+  }
+
+  cpu_set_t available;
+  CpuList usable;
+  memset(&usable, 0, sizeof(usable));
+  if (sched_getaffinity(0, sizeof(available), &available) == 0) {
+    addCpuSet(&available, &usable);
+    bool any = false;
+    for (size_t i = 0; i < CPU_LIST_WORDS; i++) {
+      any = any || (cpus.bits[i] & usable.bits[i]) != 0;
+    }
+    if (!any) {
+      char list[BUFFER_SIZE_BYTES];
+      formatCpuList(&usable, list, sizeof(list));
+      fprintf(stderr, "escalona: %s: no such CPU available (available: %s)\n",
+              value, list);
+      return false;
+    }
+  }
+
+  policy->cpus = cpus;
+  policy->set_cpus = true;
+  return true;
+}
+
+/**
+ * @brief Parses the value of the `-n` option.
+ *
+ * @param value The nice value.
+ * @param policy The policy that receives the value.
+ * @return true if the value is valid, false otherwise.
+ */
+static bool parseNiceOption(const char *value, SchedulePolicy *policy) {
+  char *end;
+  long nice = strtol(value, &end, 10);
+  if (*value == '\0' || *end != '\0' || nice < -20 || nice > 19) {
+    fprintf(stderr, "escalona: %s: invalid nice value (-20 to 19)\n", value);
+    return false;
+  }
+  policy->nice = (int)nice;
+  policy->set_nice = true;
+  return true;
+}
+
+/**
+ * @brief Parses the value of the `-i` option.
+ *
+ * @param value The I/O class, optionally followed by `:` and a level.
+ * @param policy The policy that receives the class and level.
+ * @return true if the value is valid, false otherwise.
+ */
+static bool parseIoOption(const char *value, SchedulePolicy *policy) {
+  size_t name_length = strcspn(value, ":");
+  int level = IOPRIO_DEFAULT_LEVEL;
+  if (value[name_length] == ':') {
+    const char *level_text = value + name_length + 1;
+    char *end;
+    long parsed = strtol(level_text, &end, 10);
+    if (!isdigit((unsigned char)*level_text) || *end != '\0' || parsed > 7) {
+      fprintf(stderr, "escalona: %s: invalid I/O level (0 to 7)\n", value);
+      return false;
+    }
+    level = (int)parsed;
+  }
+
+  for (size_t i = 0; i < sizeof(io_classes) / sizeof(io_classes[0]); i++) {
+    if (strlen(io_classes[i].name) == name_length &&
+        strncmp(io_classes[i].name, value, name_length) == 0) {
+      policy->io_class = io_classes[i].value;
+      policy->io_level = level;
+      policy->set_io = true;
+      return true;
+    }
+  }
+  fprintf(stderr,
+          "escalona: %s: invalid I/O class (idle, best-effort or realtime)\n",
+          value);
+  return false;
+}
+
+/**
+ * @brief Parses the value of the `-g` option.
+ *
+ * @param value The cgroup, as a path relative to the cgroup v2 mount point
+ * or as an absolute path.
+ * @param policy The policy that receives the cgroup.
+ * @return true if the cgroup exists and can be joined, false otherwise.
+ */
+static bool parseCgroupOption(const char *value, SchedulePolicy *policy) {
+  char procs[BUFFER_SIZE_BYTES];
+  int length = (*value == '/')
+                   ? snprintf(policy->cgroup, sizeof(policy->cgroup), "%s",
+                              value)
+                   : snprintf(policy->cgroup, sizeof(policy->cgroup),
+                              CGROUP_ROOT "/%s", value);
+  if (length < 0 || (size_t)length >= sizeof(policy->cgroup) ||
+      snprintf(procs, sizeof(procs), "%s/cgroup.procs", policy->cgroup) >=
+          (int)sizeof(procs)) {
+    fprintf(stderr, "escalona: %s: path too long\n", value);
+    policy->cgroup[0] = '\0';
+    return false;
+  }
+
+  if (access(procs, W_OK) == -1) {
+    fprintf(stderr, "escalona: %s: cannot join the cgroup: %s\n",
+            policy->cgroup, strerror(errno));
+    policy->cgroup[0] = '\0';
+    return false;
+  }
+  return true;
+}
+
+/**
+ * @brief Parses the options of a scheduling policy.
+ *
+ * Options change the fields of `policy` they name and leave the others as
+ * they are, so a policy can refine another one. Errors are printed on
+ * stderr.
+ *
+ * @param argc The number of arguments.
+ * @param argv The arguments, starting with the builtin name.
+ * @param policy The policy the options are applied to.
+ * @return int The index of the first argument that is not an option, or -1
+ * if an option is invalid.
+ */
+int parseScheduleOptions(int argc, char *argv[], SchedulePolicy *policy) {
+  int i = 1;
+  while (i < argc && argv[i][0] == '-' && argv[i][1] != '\0') {
+    if (strcmp(argv[i], "--") == 0) {
+      return i + 1;
+    }
+    if (i + 1 == argc) {
+      fprintf(stderr, "escalona: %s: missing value\n", argv[i]);
+      return -1;
+    }
+
+    const char *value = argv[i + 1];
+    bool valid;
+    if (strcmp(argv[i], "-c") == 0) {
+      valid = parseCpuOption(value, policy);
+    } else if (strcmp(argv[i], "-n") == 0) {
+      valid = parseNiceOption(value, policy);
+    } else if (strcmp(argv[i], "-i") == 0) {
+      valid = parseIoOption(value, policy);
+    } else if (strcmp(argv[i], "-g") == 0) {
+      valid = parseCgroupOption(value, policy);
+    } else {
+      fprintf(stderr, "escalona: %s: unknown option\n", argv[i]);
+      valid = false;
+    }
+    if (!valid) {
+      return -1;
+    }
+    i += 2;
+  }
+  return i;
+}
+
+/**
+ * @brief Checks whether a policy changes anything.
+ *
+ * @param policy The policy.
+ * @return true if at least one part of the policy is set, false otherwise.
+ */
+static bool isScheduleSet(const SchedulePolicy *policy) {
+  return policy->set_cpus || policy->set_nice || policy->set_io ||
+         policy->cgroup[0] != '\0';
+}
+
+/**
+ * @brief Prints a policy as the options that set it.
+ *
+ * @param policy The policy.
+ */
+static void printSchedule(const SchedulePolicy *policy) {
+  fputs("escalona -j", stdout);
+  if (policy->set_cpus) {
+    char list[BUFFER_SIZE_BYTES];
+    formatCpuList(&policy->cpus, list, sizeof(list));
+    printf(" -c %s", list);
+  }
+  if (policy->set_nice) {
+    printf(" -n %d", policy->nice);
+  }
+  if (policy->set_io) {
+    for (size_t i = 0; i < sizeof(io_classes) / sizeof(io_classes[0]); i++) {
+      if (io_classes[i].value == policy->io_class) {
+        printf(" -i %s:%d", io_classes[i].name, policy->io_level);
+      }
+    }
+  }
+  if (policy->cgroup[0] != '\0') {
+    printf(" -g %s", policy->cgroup);
+  }
+  putchar('\n');
+}
+
+/**
+ * @brief Implements the `escalona` builtin.
+ *
+ * Runs a command line with a scheduling policy, sets the policy of the
+ * background jobs with `-j`, or shows it when called without arguments.
+ *
+ * @param argc The number of arguments.
+ * @param argv The arguments, starting with the builtin name.
+ * @return int The exit status of the command line, or 1 on invalid usage.
+ */
+int scheduleBuiltin(int argc, char *argv[]) {
+  if (argc > 1 && strcmp(argv[1], "--help") == 0) {
+    fputs(HELP_MESSAGE, stdout);
+    return EXIT_SUCCESS;
+  }
+
+  if (argc == 1) {
+    if (has_job_schedule) {
+      printSchedule(&job_schedule);
+    }
+    return EXIT_SUCCESS;
+  }
+
+  SchedulePolicy policy;
+  memset(&policy, 0, sizeof(policy));
+
+  // Set the default policy of background jobs, replacing the previous one
+  if (strcmp(argv[1], "-j") == 0) {
+    int index = parseScheduleOptions(argc - 1, &argv[1], &policy);
+    if (index == -1) {
+      return EXIT_FAILURE;
+    }
+    if (index + 1 < argc) {
+      fputs("escalona: -j does not take a command\n", stderr);
+      return EXIT_FAILURE;
+    }
+    job_schedule = policy;
+    has_job_schedule = isScheduleSet(&policy);
+    return EXIT_SUCCESS;
+  }
+
+  // A nested `escalona` refines the policy of the enclosing one
+  if (active_schedule != NULL) {
+    policy = *active_schedule;
+  }
+  int index = parseScheduleOptions(argc, argv, &policy);
+  if (index == -1) {
+    return EXIT_FAILURE;
+  }
+  if (index == argc) {
+    fputs("Usage: escalona [options] command [args...]\n", stderr);
+    return EXIT_FAILURE;
+  }
+
+  const SchedulePolicy *previous = setActiveSchedule(&policy);
+  int status = runCommandLine(&argv[index], argc - index);
+  setActiveSchedule(previous);
+  return status;
+}
+
+/**
+ * @brief Returns the policy applied to the commands being launched.
+ *
+ * @return const SchedulePolicy* The policy set by `escalona` while it runs a
+ * command line, or NULL if there is none.
+ */
+const SchedulePolicy *getActiveSchedule(void) { return active_schedule; }
+
+/**
+ * @brief Sets the policy applied to the commands being launched.
+ *
+ * @param policy The policy, or NULL to launch commands without one. It must
+ * remain valid until it is replaced.
+ * @return const SchedulePolicy* The policy that was active before.
+ */
+const SchedulePolicy *setActiveSchedule(const SchedulePolicy *policy) {
+  const SchedulePolicy *previous = active_schedule;
+  active_schedule = policy;
+  return previous;
+}
+
+/**
+ * @brief Returns the default policy of background jobs.
+ *
+ * @return const SchedulePolicy* The policy set with `escalona -j`, or NULL if
+ * there is none.
+ */
+const SchedulePolicy *getJobSchedule(void) {
+  return has_job_schedule ? &job_schedule : NULL;
+}
+
+/**
+ * @brief Moves the calling process to a cgroup.
+ *
+ * @param cgroup The directory of the cgroup.
+ * @return true on success, false otherwise.
+ */
+static bool joinCgroup(const char *cgroup) {
+  char path[BUFFER_SIZE_BYTES];
+  snprintf(path, sizeof(path), "%s/cgroup.procs", cgroup);
+  int fd = open(path, O_WRONLY | O_CLOEXEC);
+  if (fd == -1) {
+    return false;
+  }
+  char pid[32];
+  int length = snprintf(pid, sizeof(pid), "%ld\n", (long)getpid());
+  bool joined = (write(fd, pid, length) == length);
+  close(fd);
+  return joined;
+}
+
+/**
+ * @brief Applies a scheduling policy to the calling process.
+ *
+ * Called by the child process of a command, before the command runs. Errors
+ * are printed on stderr.
+ *
+ * @param policy The policy to apply.
+ * @return true on success, false if a part of the policy could not be
+ * applied.
+ */
+bool applySchedule(const SchedulePolicy *policy) {
+  // The cgroup goes first, since its cpuset limits the CPUs that can be set
+  if (policy->cgroup[0] != '\0' && !joinCgroup(policy->cgroup)) {
+    fprintf(stderr, "Error joining cgroup %s: %s\n", policy->cgroup,
+            strerror(errno));
+    return false;
+  }
+
+  if (policy->set_cpus) {
+    cpu_set_t set;
+    toCpuSet(&policy->cpus, &set);
+    if (sched_setaffinity(0, sizeof(set), &set) == -1) {
+      perror("Error setting the CPU affinity");
+      return false;
+    }
+  }
+
+  if (policy->set_nice && setpriority(PRIO_PROCESS, 0, policy->nice) == -1) {
+    perror("Error setting the nice value");
+    return false;
+  }
+
+  if (policy->set_io &&
+      syscall(SYS_ioprio_set, IOPRIO_WHO_PROCESS, 0,
+              (policy->io_class << IOPRIO_CLASS_SHIFT) | policy->io_level) ==
+          -1) {
+    perror("Error setting the I/O priority");
+    return false;
+  }
+  return true;
+}
+
+/**
+ * @brief Reads the CPU a process ran on last.
+ *
+ * @param pid The pid of the process.
+ * @return int The number of the CPU, or -1 if it could not be read.
+ */
+static int readLastCpu(pid_t pid) {
+  char path[64];
+  snprintf(path, sizeof(path), "/proc/%ld/stat", (long)pid);
+  FILE *file = fopen(path, "re");
+  if (file == NULL) {
+    return -1;
+  }
+  char line[BUFFER_SIZE_BYTES];
+  bool read = (fgets(line, sizeof(line), file) != NULL);
+  fclose(file);
+  if (!read) {
+    return -1;
+  }
+
+  // The command name may contain spaces, so fields are counted after it,
+  // starting with the state, which is the third field
+  char *field = strrchr(line, ')');
+  for (int i = 3; i <= STAT_PROCESSOR_FIELD && field != NULL; i++) {
+    field = strchr(field + 1, ' ');
+  }
+  if (field == NULL) {
+    return -1;
+  }
+  long cpu = strtol(field + 1, NULL, 10);
+  return (cpu >= 0 && cpu < SCHEDULE_MAX_CPUS) ? (int)cpu : -1;
+}
+
+/**
+ * @brief Records the CPUs of a process that has terminated.
+ *
+ * Must be called before the process is reaped. The kernel keeps the CPUs a
+ * process may run on and the CPU it ran on last, which are added to
+ * `allowed` and `used`.
+ *
+ * @param pid The pid of the process.
+ * @param allowed The CPUs the process was allowed to run on.
+ * @param used The CPUs the process ran on.
+ * @return true on success, false if the process could not be inspected.
+ */
+bool recordProcessCpus(pid_t pid, CpuList *allowed, CpuList *used) {
+  cpu_set_t set;
+  int cpu = readLastCpu(pid);
+  if (cpu == -1 || sched_getaffinity(pid, sizeof(set), &set) == -1) {
+    return false;
+  }
+  addCpuSet(&set, allowed);
+  addCpu(used, cpu);
+  return true;
+}
@@ -0,0 +1,654 @@
+/**
+ * @file server.c
+ * @author Enrique Rodrigues (a28602@alunos.ipca.pt)
+ * @brief Contains the server mode, which runs the command lines of many
+ * clients of a Unix socket from a single epoll loop.
+ * @version 0.1
+ * @date 2026-10-16
+ * @copyright Copyright (c) 2024
+ */
+#define _GNU_SOURCE
+
+#include "server.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/signalfd.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/types.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "arena.h"
+#include "builtins.h"
+#include "constants.h"
+#include "execute.h"
+#include "find.h"
+#include "jobs.h"
+#include "run.h"
+
+/* Most events handled per call to epoll_wait(). */
+#define SERVER_EVENT_BATCH 64
+
+/* Most bytes of input kept for a client, which bounds the length of a line. */
+#define SERVER_MAX_INPUT (1024 * 1024)
+
+/* Characters that end the name of the first command of a line. */
+#define COMMAND_NAME_END " \t|;&<>'\"\\$*?["
+
+/**
+ * @brief Kinds of descriptors watched by the event loop.
+ */
+typedef enum EventKind {
+  EVENT_LISTEN,  // the listening socket has clients to accept
+  EVENT_SIGNAL,  // the signalfd has SIGINT or SIGTERM
+  EVENT_CLIENT,  // a client socket can be read or written
+  EVENT_CHILD    // the pidfd of a running line reports its exit
+} EventKind;
+
+/**
+ * @brief Structure registered with epoll for each watched descriptor.
+ */
+typedef struct EventSource {
+  EventKind kind;         // kind of descriptor
+  struct Client *client;  // client of the descriptor, if any
+} EventSource;
+
+/**
+ * @brief Structure that holds a connected client.
+ *
+ * The structure includes the following fields:
+ * - `socket_event`, `child_event`: The epoll sources of the socket and of
+ *   the pidfd of the running line.
+ * - `fd`: The client socket, or -1 once the client is gone.
+ * - `input`: The bytes received and not run yet.
+ * - `input_closed`: Whether the client finished sending.
+ * - `events`: The events the socket is registered for, 0 if none.
+ * - `pid`, `pidfd`: The process running a line of the client, or -1.
+ * - `reply`: The status of the last line, while it cannot be sent.
+ * - `waiting`, `next_waiting`: The position of the client in the queue of
+ *   lines waiting for a free child.
+ */
+typedef struct Client {
+  EventSource socket_event;     // epoll source of the socket
+  EventSource child_event;      // epoll source of the pidfd
+  int fd;                       // client socket, or -1
+  char *input;                  // received bytes not run yet
+  size_t input_length;          // number of bytes in `input`
+  size_t input_capacity;        // size of `input`
+  bool input_closed;            // whether the client finished sending
+  unsigned int events;          // events the socket is registered for
+  pid_t pid;                    // process running a line, or -1
+  int pidfd;                    // pidfd of `pid`, or -1
+  char reply[32];               // status not sent yet
+  size_t reply_length;          // number of bytes in `reply`
+  bool waiting;                 // whether the client is in the queue
+  struct Client *next_waiting;  // next client in the queue
+} Client;
+
+/* Server state. */
+static int epoll_fd = -1;           // descriptor of the event loop
+static int null_fd = -1;            // /dev/null, the stdin of every line
+static int running_children = 0;    // lines running now
+static int children_limit = 1;      // most lines running at once
+static Client *queue_head = NULL;   // first client waiting for a child
+static Client *queue_tail = NULL;   // last client waiting for a child
+static Client *closed_clients = NULL;  // clients to free after the events
+
+/**
+ * @brief Creates the listening socket.
+ *
+ * A socket file whose server is gone is replaced, but not one a server is
+ * still accepting connections on.
+ *
+ * @param path The path of the socket.
+ * @return int The listening socket, or -1 on error.
+ */
+static int openServerSocket(const char *path) {
+  struct sockaddr_un address;
+  memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  if (strlen(path) >= sizeof(address.sun_path)) {
+    fprintf(stderr, "Error: Socket path too long: %s\n", path);
+    return -1;
+  }
+  strcpy(address.sun_path, path);
+
+  int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (fd == -1) {
+    perror("Error creating socket");
+    return -1;
+  }
+
+  int result = bind(fd, (struct sockaddr *)&address, sizeof(address));
+  if (result == -1 && errno == EADDRINUSE) {
+    int probe = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    bool stale = (probe != -1 &&
+                  connect(probe, (struct sockaddr *)&address,
+                          sizeof(address)) == -1 &&
+                  errno == ECONNREFUSED);
+    if (probe != -1) {
+      close(probe);
+    }
+    if (!stale) {
+      fprintf(stderr, "Error: %s is in use by another server\n", path);
+      close(fd);
+      return -1;
+    }
+    unlink(path);
+    result = bind(fd, (struct sockaddr *)&address, sizeof(address));
+  }
+  if (result == -1 || listen(fd, SOMAXCONN) == -1) {
+    perror(path);
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+/**
+ * @brief Registers the events a client socket is waited for.
+ *
+ * The socket is read while the client sends and its input has room, and
+ * written while a status is pending. A socket without events is removed
+ * from the loop, so a client that hung up does not keep waking it.
+ *
+ * @param client The client.
+ */
+static void updateClientEvents(Client *client) {
+  unsigned int events = 0;
+  if (!client->input_closed && client->input_length < SERVER_MAX_INPUT) {
+    events |= EPOLLIN;
+  }
+  if (client->reply_length > 0) {
+    events |= EPOLLOUT;
+  }
+  if (events == client->events) {
+    return;
+  }
+
+  struct epoll_event event = {.events = events,
+                              .data.ptr = &client->socket_event};
+  if (events == 0) {
+    epoll_ctl(epoll_fd, EPOLL_CTL_DEL, client->fd, NULL);
+  } else if (client->events == 0) {
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, client->fd, &event);
+  } else {
+    epoll_ctl(epoll_fd, EPOLL_CTL_MOD, client->fd, &event);
+  }
+  client->events = events;
+}
+
+/**
+ * @brief Removes a client from the queue of lines waiting for a child.
+ *
+ * @param client The client.
+ */
+static void dequeueClient(Client *client) {
+  Client *previous = NULL;
+  for (Client *other = queue_head; other != client;
+       other = other->next_waiting) {
+    previous = other;
+  }
+  if (previous == NULL) {
+    queue_head = client->next_waiting;
+  } else {
+    previous->next_waiting = client->next_waiting;
+  }
+  if (queue_tail == client) {
+    queue_tail = previous;
+  }
+  client->waiting = false;
+  client->next_waiting = NULL;
+}
+
+/**
+ * @brief Disconnects a client.
+ *
+ * The client is freed once the line it is running, if any, finishes, and
+ * after the events of the current batch, which may still refer to it.
+ *
+ * @param client The client.
+ */
+static void closeClient(Client *client) {
+  if (client->fd != -1) {
+    if (client->events != 0) {
+      epoll_ctl(epoll_fd, EPOLL_CTL_DEL, client->fd, NULL);
+    }
+    close(client->fd);
+    client->fd = -1;
+  }
+  if (client->waiting) {
+    dequeueClient(client);
+  }
+  if (client->pid == -1) {
+    client->next_waiting = closed_clients;
+    closed_clients = client;
+  }
+}
+
+/**
+ * @brief Frees the clients closed while handling a batch of events.
+ */
+static void freeClosedClients(void) {
+  while (closed_clients != NULL) {
+    Client *client = closed_clients;
+    closed_clients = client->next_waiting;
+    free(client->input);
+    free(client);
+  }
+}
+
+/**
+ * @brief Finds the end of the next line of a client.
+ *
+ * @param client The client.
+ * @return char* The newline that ends the line, the end of the input when
+ * the client finished sending without a final newline, or NULL if no line
+ * is complete.
+ */
+static char *findLineEnd(Client *client) {
+  char *end = memchr(client->input, '\n', client->input_length);
+  if (end == NULL && client->input_closed && client->input_length > 0) {
+    end = client->input + client->input_length;
+  }
+  return end;
+}
+
+/**
+ * @brief Resolves the first command of a line in the server.
+ *
+ * The path is kept in the command cache of the server, which every later
+ * line inherits, so clients do not search the PATH again for each line.
+ *
+ * @param line The line.
+ */
+static void warmCommand(const char *line) {
+  line += strspn(line, " \t");
+  size_t length = strcspn(line, COMMAND_NAME_END);
+  if (length == 0 || length >= BUFFER_SIZE_BYTES ||
+      memchr(line, '/', length) != NULL) {
+    return;
+  }
+
+  char name[BUFFER_SIZE_BYTES];
+  memcpy(name, line, length);
+  name[length] = '\0';
+  char command_path[BUFFER_SIZE_BYTES];
+  if (findBuiltin(name) == NULL && findBundledCommand(name) == NULL) {
+    resolveCommand(name, command_path);
+  }
+}
+
+/**
+ * @brief Runs a line in a child copy of the server.
+ *
+ * Called in the child, which never returns. Background jobs started by the
+ * line are waited for, so their output is sent before the status.
+ *
+ * @param line The line.
+ */
+static void runClientLine(const char *line) {
+  Arena arena;
+  initArena(&arena);
+  int status = EXIT_SUCCESS;
+  runLine(&arena, line, &status);
+  waitAllJobs();
+  fflush(stdout);
+  _exit(status);
+}
+
+/**
+ * @brief Starts the next line of a client.
+ *
+ * @param client The client, which has a complete line and no line running.
+ */
+static void startLine(Client *client) {
+  char *end = findLineEnd(client);
+  size_t line_length = end - client->input;
+  if (end < client->input + client->input_length) {
+    *end = '\0';  // Replaces the newline
+  } else {
+    client->input[line_length] = '\0';  // The buffer always has room for it
+  }
+
+  warmCommand(client->input);
+  CommandIO io = {null_fd, client->fd, client->fd};
+  pid_t pid = forkInProcessChild(&io);
+  if (pid == 0) {
+    runClientLine(client->input);
+  }
+
+  // Drop the line, with its newline, from the input
+  size_t consumed = (line_length < client->input_length) ? line_length + 1
+                                                         : line_length;
+  client->input_length -= consumed;
+  memmove(client->input, client->input + consumed, client->input_length);
+
+  int status = EXIT_FAILURE;
+  if (pid != -1) {
+    client->pidfd = (int)syscall(SYS_pidfd_open, pid, 0);
+    struct epoll_event event = {.events = EPOLLIN,
+                                .data.ptr = &client->child_event};
+    if (client->pidfd != -1 &&
+        epoll_ctl(epoll_fd, EPOLL_CTL_ADD, client->pidfd, &event) == 0) {
+      client->pid = pid;
+      running_children++;
+      updateClientEvents(client);
+      return;
+    }
+
+    // Without a pidfd the line is waited for here
+    perror("Error watching command");
+    if (client->pidfd != -1) {
+      close(client->pidfd);
+      client->pidfd = -1;
+    }
+    int wait_status;
+    while (waitpid(pid, &wait_status, 0) == -1 && errno == EINTR) {
+    }
+    status = exitStatusFromWait(wait_status);
+  }
+
+  client->reply[0] = '\0';
+  client->reply_length =
+      1 + snprintf(client->reply + 1, sizeof(client->reply) - 1, "%d\n",
+                   status);
+  updateClientEvents(client);
+}
+
+/**
+ * @brief Starts waiting lines while there are free children.
+ */
+static void startWaitingLines(void) {
+  while (queue_head != NULL && running_children < children_limit) {
+    Client *client = queue_head;
+    queue_head = client->next_waiting;
+    if (queue_head == NULL) {
+      queue_tail = NULL;
+    }
+    client->waiting = false;
+    client->next_waiting = NULL;
+    startLine(client);
+  }
+}
+
+/**
+ * @brief Decides what a client does next.
+ *
+ * A client with a complete line and nothing running or pending joins the
+ * queue of lines waiting for a child. A client that finished sending and
+ * has nothing left to run is disconnected.
+ *
+ * @param client The client.
+ */
+static void scheduleClient(Client *client) {
+  if (client->pid != -1 || client->waiting || client->reply_length > 0) {
+    return;
+  }
+  if (findLineEnd(client) == NULL) {
+    if (client->input_closed) {
+      closeClient(client);
+    } else {
+      updateClientEvents(client);
+    }
+    return;
+  }
+
+  client->waiting = true;
+  if (queue_tail != NULL) {
+    queue_tail->next_waiting = client;
+  } else {
+    queue_head = client;
+  }
+  queue_tail = client;
+}
+
+/**
+ * @brief Sends the pending status of a client.
+ *
+ * @param client The client.
+ * @return true if the client is still connected, false if it was closed.
+ */
+static bool sendReply(Client *client) {
+  ssize_t sent = send(client->fd, client->reply, client->reply_length,
+                      MSG_DONTWAIT | MSG_NOSIGNAL);
+  if (sent == -1) {
+    if (errno == EAGAIN || errno == EINTR) {
+      updateClientEvents(client);
+      return true;
+    }
+    closeClient(client);
+    return false;
+  }
+  client->reply_length -= sent;
+  memmove(client->reply, client->reply + sent, client->reply_length);
+  updateClientEvents(client);
+  return true;
+}
+
+/**
+ * @brief Reads the lines a client sent.
+ *
+ * The socket is shared with the children that write the output, so it stays
+ * in blocking mode and is read with MSG_DONTWAIT.
+ *
+ * @param client The client.
+ * @return true if the client is still connected, false if it was closed.
+ */
+static bool readClient(Client *client) {
+  if (client->input_capacity - client->input_length < BUFFER_SIZE_BYTES) {
+    size_t new_capacity = client->input_capacity * 2 + BUFFER_SIZE_BYTES;
+    char *new_input = realloc(client->input, new_capacity);
+    if (new_input == NULL) {
+      fputs("Error: Memory allocation failed.\n", stderr);
+      closeClient(client);
+      return false;
+    }
+    client->input = new_input;
+    client->input_capacity = new_capacity;
+  }
+
+  // Keep a byte free to terminate a last line without a newline
+  ssize_t received =
+      recv(client->fd, client->input + client->input_length,
+           client->input_capacity - client->input_length - 1, MSG_DONTWAIT);
+  if (received == -1) {
+    if (errno == EAGAIN || errno == EINTR) {
+      return true;
+    }
+    closeClient(client);
+    return false;
+  }
+  if (received == 0) {
+    client->input_closed = true;
+  }
+  client->input_length += received;
+
+  if (client->input_length >= SERVER_MAX_INPUT &&
+      memchr(client->input, '\n', client->input_length) == NULL) {
+    const char message[] = "Error: Line too long.\n";
+    send(client->fd, message, sizeof(message) - 1,
+         MSG_DONTWAIT | MSG_NOSIGNAL);
+    closeClient(client);
+    return false;
+  }
+  updateClientEvents(client);
+  return true;
+}
+
+/**
+ * @brief Accepts every pending client.
+ *
+ * @param listen_fd The listening socket.
+ */
+static void acceptClients(int listen_fd) {
+  while (1) {
+    int fd = accept4(listen_fd, NULL, NULL, SOCK_CLOEXEC);
+    if (fd == -1) {
+      if (errno != EAGAIN && errno != EINTR && errno != ECONNABORTED) {
+        perror("Error accepting client");
+      }
+      if (errno != EINTR && errno != ECONNABORTED) {
+        return;
+      }
+      continue;
+    }
+
+    Client *client = calloc(1, sizeof(Client));
+    if (client == NULL) {
+      fputs("Error: Memory allocation failed.\n", stderr);
+      close(fd);
+      continue;
+    }
+    client->socket_event.kind = EVENT_CLIENT;
+    client->socket_event.client = client;
+    client->child_event.kind = EVENT_CHILD;
+    client->child_event.client = client;
+    client->fd = fd;
+    client->pid = -1;
+    client->pidfd = -1;
+    updateClientEvents(client);
+  }
+}
+
+/**
+ * @brief Collects a line that finished and queues its status.
+ *
+ * @param client The client that ran the line.
+ */
+static void finishLine(Client *client) {
+  int wait_status;
+  while (waitpid(client->pid, &wait_status, 0) == -1) {
+    if (errno != EINTR) {
+      wait_status = EXIT_FAILURE << 8;
+      break;
+    }
+  }
+  // A child forked meanwhile may still hold the pidfd, which keeps it in the
+  // event loop until removed
+  epoll_ctl(epoll_fd, EPOLL_CTL_DEL, client->pidfd, NULL);
+  close(client->pidfd);
+  client->pidfd = -1;
+  client->pid = -1;
+  running_children--;
+
+  if (client->fd == -1) {
+    closeClient(client);  // The client left while the line ran
+    return;
+  }
+  client->reply[0] = '\0';
+  client->reply_length =
+      1 + snprintf(client->reply + 1, sizeof(client->reply) - 1, "%d\n",
+                   exitStatusFromWait(wait_status));
+  if (sendReply(client)) {
+    scheduleClient(client);
+  }
+}
+
+/**
+ * @brief Handles an event of a client socket.
+ *
+ * @param client The client.
+ * @param events The events reported by epoll.
+ */
+static void handleClientEvent(Client *client, unsigned int events) {
+  if ((events & EPOLLOUT) && client->reply_length > 0 &&
+      (!sendReply(client) || client->reply_length > 0)) {
+    return;
+  }
+  if ((events & (EPOLLIN | EPOLLHUP | EPOLLERR)) && !client->input_closed &&
+      !readClient(client)) {
+    return;
+  }
+  scheduleClient(client);
+}
+
+/**
+ * @brief Serves command lines to the clients of a Unix socket.
+ *
+ * Returns when the server receives SIGINT or SIGTERM, after removing the
+ * socket.
+ *
+ * @param socket_path The path of the socket. A socket left there by a server
+ * that is no longer running is replaced.
+ * @param max_children The most lines running at once, or 0 for one per
+ * online CPU.
+ * @return int 0 if the server stopped on a signal, or 1 on error.
+ */
+int runServer(const char *socket_path, int max_children) {
+  long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+  children_limit = (max_children > 0) ? max_children : (cpus > 0) ? cpus : 1;
+
+  // Stop on SIGINT and SIGTERM from the event loop
+  sigset_t mask;
+  sigemptyset(&mask);
+  sigaddset(&mask, SIGINT);
+  sigaddset(&mask, SIGTERM);
+  sigprocmask(SIG_BLOCK, &mask, NULL);
+  int signal_fd = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+
+  null_fd = open("/dev/null", O_RDONLY | O_CLOEXEC);
+  epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+  if (signal_fd == -1 || null_fd == -1 || epoll_fd == -1) {
+    perror("Error");
+    return EXIT_FAILURE;
+  }
+  int listen_fd = openServerSocket(socket_path);
+  if (listen_fd == -1) {
+    return EXIT_FAILURE;
+  }
+
+  EventSource listen_event = {EVENT_LISTEN, NULL};
+  EventSource signal_event = {EVENT_SIGNAL, NULL};
+  struct epoll_event event = {.events = EPOLLIN, .data.ptr = &listen_event};
+  epoll_ctl(epoll_fd, EPOLL_CTL_ADD, listen_fd, &event);
+  event.data.ptr = &signal_event;
+  epoll_ctl(epoll_fd, EPOLL_CTL_ADD, signal_fd, &event);
+  fprintf(stderr, "%s: serving on %s, up to %d commands at once\n",
+          PROGRAM_NAME, socket_path, children_limit);
+
+  bool serving = true;
+  while (serving) {
+    struct epoll_event events[SERVER_EVENT_BATCH];
+    int count = epoll_wait(epoll_fd, events, SERVER_EVENT_BATCH, -1);
+    if (count == -1 && errno != EINTR) {
+      perror("Error");
+      break;
+    }
+
+    for (int i = 0; i < count; i++) {
+      EventSource *source = events[i].data.ptr;
+      if (source->kind == EVENT_LISTEN) {
+        acceptClients(listen_fd);
+      } else if (source->kind == EVENT_SIGNAL) {
+        serving = false;
+      } else if (source->kind == EVENT_CHILD) {
+        if (source->client->pid != -1) {
+          finishLine(source->client);
+        }
+      } else if (source->client->fd != -1) {
+        handleClientEvent(source->client, events[i].events);
+      }
+    }
+    startWaitingLines();
+    freeClosedClients();
+  }
+
+  // Lines still running finish on their own
+  unlink(socket_path);
+  close(listen_fd);
+  close(signal_fd);
+  close(epoll_fd);
+  close(null_fd);
+  sigprocmask(SIG_UNBLOCK, &mask, NULL);
+  return serving ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,499 @@
+/**
+ * @file trace.c
+ * @author Enrique Rodrigues (a28602@alunos.ipca.pt)
+ * @brief Contains the execution trace of the interpreter.
+ * @version 0.1
+ * @date 2026-10-16
+ * @copyright Copyright (c) 2024
+ */
+#define _XOPEN_SOURCE 700
+#define _DEFAULT_SOURCE
+
+#include "trace.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/time.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "constants.h"
+#include "execute.h"
+#include "usage.h"
+
+/* Size of each of the two record buffers. */
+#define TRACE_BUFFER_SIZE_BYTES (64 * 1024)
+
+/* Longest time a record waits in memory before it is written. */
+#define TRACE_FLUSH_INTERVAL_MS 500
+
+/**
+ * @brief Structure that holds a process launched while tracing.
+ */
+typedef struct TraceProcess {
+  pid_t pid;              // pid of the process
+  const char *kind;       // kind of command
+  char *path;             // path of the executed program, or NULL
+  char *argv_json;        // arguments, as a JSON array
+  double lookup_seconds;  // time spent finding the command in the PATH
+  double spawn_seconds;   // time until the program was executed
+  struct timespec start;  // monotonic time of the launch
+  struct timeval time;    // wall clock time of the launch
+} TraceProcess;
+
+/* Whether commands are being traced. */
+static bool tracing = false;
+
+/* Time spent finding the next command in the PATH. */
+static double pending_lookup_seconds = 0;
+
+/* Processes launched and not reaped yet. */
+static TraceProcess *processes = NULL;  // launched processes
+static int process_count = 0;           // number of entries in `processes`
+static int process_capacity = 0;        // number of entries that fit
+
+/* Writer state. The interpreter fills the active buffer while the writer
+ * thread writes the other one to the file. */
+static int trace_fd = -1;                 // trace file
+static char *buffers[2] = {NULL, NULL};  // record buffers
+static size_t lengths[2] = {0, 0};       // bytes in each buffer
+static int active = 0;                   // buffer that receives records
+static bool flushing = false;            // whether a buffer is being written
+static bool flush_requested = false;     // whether to write without waiting
+static bool stopping = false;            // whether the writer must finish
+static pthread_t writer;                 // writer thread
+static pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t wake_writer = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t flush_done = PTHREAD_COND_INITIALIZER;
+
+/**
+ * @brief Computes the seconds elapsed between two monotonic times.
+ *
+ * @param start The start time.
+ * @param end The end time.
+ * @return double The elapsed seconds.
+ */
+static double elapsedSeconds(const struct timespec *start,
+                             const struct timespec *end) {
+  return (double)(end->tv_sec - start->tv_sec) +
+         (double)(end->tv_nsec - start->tv_nsec) / 1e9;
+}
+
+/**
+ * @brief Writes a whole buffer to the trace file.
+ *
+ * @param data The data to write.
+ * @param length The number of bytes to write.
+ */
+static void writeAll(const char *data, size_t length) {
+  while (length > 0) {
+    ssize_t written = write(trace_fd, data, length);
+    if (written == -1) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return;  // The trace must never disturb the commands
+    }
+    data += written;
+    length -= written;
+  }
+}
+
+/**
+ * @brief Body of the writer thread.
+ *
+ * Writes the active buffer to the file when it fills up, when the trace is
+ * closed, or at least every `TRACE_FLUSH_INTERVAL_MS` milliseconds.
+ *
+ * @param unused Not used.
+ * @return void* Always NULL.
+ */
+static void *traceWriter(void *unused) {
+  (void)unused;
+  pthread_mutex_lock(&mutex);
+  while (true) {
+    if (!stopping && !flush_requested) {
+      struct timespec deadline;
+      clock_gettime(CLOCK_REALTIME, &deadline);
+      deadline.tv_nsec += TRACE_FLUSH_INTERVAL_MS * 1000000L;
+      deadline.tv_sec += deadline.tv_nsec / 1000000000L;
+      deadline.tv_nsec %= 1000000000L;
+      pthread_cond_timedwait(&wake_writer, &mutex, &deadline);
+    }
+    flush_requested = false;
+
+    if (lengths[active] > 0) {
+      // Let the interpreter fill the other buffer while this one is written
+      int index = active;
+      active = 1 - active;
+      flushing = true;
+      pthread_mutex_unlock(&mutex);
+
+      writeAll(buffers[index], lengths[index]);
+
+      pthread_mutex_lock(&mutex);
+      lengths[index] = 0;
+      flushing = false;
+      pthread_cond_broadcast(&flush_done);
+    } else if (stopping) {
+      break;
+    }
+  }
+  pthread_mutex_unlock(&mutex);
+  return NULL;
+}
+
+/**
+ * @brief Adds a record to the trace.
+ *
+ * Only blocks when both buffers are full.
+ *
+ * @param record The record, including its newline.
+ * @param length The length of the record.
+ */
+static void appendRecord(const char *record, size_t length) {
+  pthread_mutex_lock(&mutex);
+  while (lengths[active] > 0 &&
+         lengths[active] + length > TRACE_BUFFER_SIZE_BYTES) {
+    flush_requested = true;
+    pthread_cond_signal(&wake_writer);
+    pthread_cond_wait(&flush_done, &mutex);
+  }
+
+  if (length > TRACE_BUFFER_SIZE_BYTES) {
+    // Records larger than a buffer are written directly, in order
+    while (flushing) {
+      pthread_cond_wait(&flush_done, &mutex);
+    }
+    writeAll(record, length);
+  } else {
+    memcpy(buffers[active] + lengths[active], record, length);
+    lengths[active] += length;
+    if (lengths[active] >= TRACE_BUFFER_SIZE_BYTES / 2) {
+      flush_requested = true;
+      pthread_cond_signal(&wake_writer);
+    }
+  }
+  pthread_mutex_unlock(&mutex);
+}
+
+/**
+ * @brief Starts writing the execution trace to a file.
+ *
+ * Records are appended to the file. The trace is flushed and closed when the
+ * interpreter exits.
+ *
+ * @param path The path of the trace file.
+ * @return true on success, false on error.
+ */
+bool openTrace(const char *path) {
+  if (tracing) {
+    return true;
+  }
+
+  trace_fd = open(path, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+  if (trace_fd == -1) {
+    perror(path);
+    return false;
+  }
+
+  // The writer blocks every signal, so SIGCHLD keeps reaching the signalfd
+  // of the interpreter instead of being discarded by the thread
+  sigset_t all_signals, old_mask;
+  sigfillset(&all_signals);
+  pthread_sigmask(SIG_SETMASK, &all_signals, &old_mask);
+
+  buffers[0] = malloc(TRACE_BUFFER_SIZE_BYTES);
+  buffers[1] = malloc(TRACE_BUFFER_SIZE_BYTES);
+  bool started = buffers[0] != NULL && buffers[1] != NULL &&
+                 pthread_create(&writer, NULL, traceWriter, NULL) == 0;
+  pthread_sigmask(SIG_SETMASK, &old_mask, NULL);
+
+  if (!started) {
+    fputs("Error: Unable to start the trace writer.\n", stderr);
+    free(buffers[0]);
+    free(buffers[1]);
+    close(trace_fd);
+    trace_fd = -1;
+    return false;
+  }
+
+  tracing = true;
+  atexit(closeTrace);
+  return true;
+}
+
+/**
+ * @brief Writes the pending records and stops tracing.
+ */
+void closeTrace(void) {
+  if (!tracing) {
+    return;
+  }
+  tracing = false;
+
+  pthread_mutex_lock(&mutex);
+  stopping = true;
+  pthread_cond_signal(&wake_writer);
+  pthread_mutex_unlock(&mutex);
+  pthread_join(writer, NULL);
+
+  close(trace_fd);
+  trace_fd = -1;
+  free(buffers[0]);
+  free(buffers[1]);
+  buffers[0] = buffers[1] = NULL;
+
+  for (int i = 0; i < process_count; i++) {
+    free(processes[i].path);
+    free(processes[i].argv_json);
+  }
+  free(processes);
+  processes = NULL;
+  process_count = process_capacity = 0;
+}
+
+/**
+ * @brief Checks if the execution trace is enabled.
+ *
+ * @return true if commands are being traced, false otherwise.
+ */
+bool isTracing(void) { return tracing; }
+
+/**
+ * @brief Stops tracing in a child copy of the interpreter.
+ *
+ * The writer thread does not exist in a child created with fork(), so the
+ * child must not write records nor flush the trace when it exits.
+ */
+void disableTraceInChild(void) { tracing = false; }
+
+/**
+ * @brief Writes a string as a JSON string literal.
+ *
+ * @param stream The stream to write to.
+ * @param text The string, or NULL to write `null`.
+ */
+static void writeJsonString(FILE *stream, const char *text) {
+  if (text == NULL) {
+    fputs("null", stream);
+    return;
+  }
+
+  fputc('"', stream);
+  for (const unsigned char *c = (const unsigned char *)text; *c; c++) {
+    if (*c == '"' || *c == '\\') {
+      fprintf(stream, "\\%c", *c);
+    } else if (*c < 0x20) {
+      fprintf(stream, "\\u%04x", *c);
+    } else {
+      fputc(*c, stream);
+    }
+  }
+  fputc('"', stream);
+}
+
+/**
+ * @brief Formats the arguments of a command as a JSON array.
+ *
+ * @param args The arguments, terminated by NULL.
+ * @return char* The array, to be freed by the caller, or NULL on error.
+ */
+static char *argumentsToJson(char *args[]) {
+  char *json = NULL;
+  size_t size = 0;
+  FILE *stream = open_memstream(&json, &size);
+  if (stream == NULL) {
+    return NULL;
+  }
+
+  fputc('[', stream);
+  for (int i = 0; args[i] != NULL; i++) {
+    if (i > 0) {
+      fputc(',', stream);
+    }
+    writeJsonString(stream, args[i]);
+  }
+  fputc(']', stream);
+  fclose(stream);
+  return json;
+}
+
+/**
+ * @brief Formats a record and adds it to the trace.
+ *
+ * @param process The command the record describes.
+ * @param run_seconds The time from the launch until the command finished.
+ * @param status The exit status of the command.
+ * @param signal_number The signal that terminated the command, or 0.
+ * @param usage The resources used by the command.
+ */
+static void writeRecord(const TraceProcess *process, double run_seconds,
+                        int status, int signal_number,
+                        const CommandUsage *usage) {
+  char *record = NULL;
+  size_t size = 0;
+  FILE *stream = open_memstream(&record, &size);
+  if (stream == NULL) {
+    return;
+  }
+
+  fprintf(stream,
+          "{\"time\":%ld.%06ld,\"version\":\"%s\",\"pid\":%ld,"
+          "\"kind\":\"%s\",\"argv\":%s,\"path\":",
+          (long)process->time.tv_sec, (long)process->time.tv_usec, VERSION,
+          (long)process->pid, process->kind,
+          (process->argv_json != NULL) ? process->argv_json : "[]");
+  writeJsonString(stream, process->path);
+  fprintf(stream,
+          ",\"backend\":\"%s\",\"lookup_us\":%.1f,\"spawn_us\":%.1f,"
+          "\"run_us\":%.1f,\"status\":%d,\"signal\":%d,"
+          "\"user_us\":%.0f,\"sys_us\":%.0f,\"max_rss_kb\":%ld,"
+          "\"minor_faults\":%ld,\"major_faults\":%ld,"
+          "\"voluntary_switches\":%ld,\"involuntary_switches\":%ld}\n",
+          spawnBackendName(getSpawnBackend()), process->lookup_seconds * 1e6,
+          process->spawn_seconds * 1e6, run_seconds * 1e6, status,
+          signal_number, usage->user_seconds * 1e6,
+          usage->system_seconds * 1e6, usage->max_rss_kb, usage->minor_faults,
+          usage->major_faults, usage->voluntary_switches,
+          usage->involuntary_switches);
+  fclose(stream);
+
+  if (record != NULL) {
+    appendRecord(record, size);
+    free(record);
+  }
+}
+
+/**
+ * @brief Records the time spent finding the next command in the PATH.
+ *
+ * @param start When the search started, on the monotonic clock.
+ */
+void traceLookup(const struct timespec *start) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  pending_lookup_seconds = elapsedSeconds(start, &now);
+}
+
+/**
+ * @brief Records the launch of a process.
+ *
+ * The record is written when the process is reaped, by traceExit().
+ *
+ * @param pid The pid of the process.
+ * @param kind The kind of command.
+ * @param path The path of the executed program, or NULL.
+ * @param args The arguments of the command, terminated by NULL.
+ * @param start When the launch started, on the monotonic clock.
+ */
+void traceLaunch(pid_t pid, const char *kind, const char *path, char *args[],
+                 const struct timespec *start) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  double lookup_seconds = pending_lookup_seconds;
+  pending_lookup_seconds = 0;
+
+  if (!tracing || pid <= 0) {
+    return;
+  }
+
+  if (process_count == process_capacity) {
+    int new_capacity = process_capacity ? process_capacity * 2 : 16;
+    TraceProcess *new_processes =
+        realloc(processes, new_capacity * sizeof(TraceProcess));
+    if (new_processes == NULL) {
+      return;
+    }
+    processes = new_processes;
+    process_capacity = new_capacity;
+  }
+
+  TraceProcess *process = &processes[process_count++];
+  process->pid = pid;
+  process->kind = kind;
+  process->path = (path != NULL) ? strdup(path) : NULL;
+  process->argv_json = argumentsToJson(args);
+  process->lookup_seconds = lookup_seconds;
+  process->spawn_seconds = elapsedSeconds(start, &now);
+  process->start = *start;
+  gettimeofday(&process->time, NULL);
+}
+
+/**
+ * @brief Writes the record of a process that was reaped.
+ *
+ * Processes that were not launched while tracing are ignored.
+ *
+ * @param pid The pid of the process.
+ * @param wait_status The status returned by wait4().
+ * @param rusage The resources used by the process.
+ */
+void traceExit(pid_t pid, int wait_status, const struct rusage *rusage) {
+  if (!tracing) {
+    return;
+  }
+
+  for (int i = 0; i < process_count; i++) {
+    TraceProcess *process = &processes[i];
+    if (process->pid != pid) {
+      continue;
+    }
+
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    CommandUsage usage;
+    usageFromRusage(rusage, 0, &usage);
+    writeRecord(process, elapsedSeconds(&process->start, &now),
+                exitStatusFromWait(wait_status),
+                WIFSIGNALED(wait_status) ? WTERMSIG(wait_status) : 0, &usage);
+
+    free(process->path);
+    free(process->argv_json);
+    processes[i] = processes[--process_count];
+    return;
+  }
+}
+
+/**
+ * @brief Writes the record of a command that ran inside the interpreter.
+ *
+ * @param kind The kind of command.
+ * @param args The arguments of the command, terminated by NULL.
+ * @param status The exit status of the command.
+ * @param usage The resources used by the command.
+ */
+void traceInProcess(const char *kind, char *args[], int status,
+                    const CommandUsage *usage) {
+  if (!tracing) {
+    return;
+  }
+
+  TraceProcess process;
+  memset(&process, 0, sizeof(process));
+  process.pid = getpid();
+  process.kind = kind;
+  process.argv_json = argumentsToJson(args);
+  gettimeofday(&process.time, NULL);
+
+  // The record is written at the end, so the start is moved back
+  double seconds = usage->wall_seconds;
+  process.time.tv_sec -= (time_t)seconds;
+  process.time.tv_usec -= (suseconds_t)((seconds - (time_t)seconds) * 1e6);
+  if (process.time.tv_usec < 0) {
+    process.time.tv_sec--;
+    process.time.tv_usec += 1000000;
+  }
+
+  writeRecord(&process, usage->wall_seconds, status, 0, usage);
+  free(process.argv_json);
+}
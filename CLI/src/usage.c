@@ -0,0 +1,330 @@
+/**
+ * @file usage.c
+ * @author Enrique Rodrigues (a28602@alunos.ipca.pt)
+ * @brief Contains the resource accounting of commands.
+ * @version 0.1
+ * @date 2026-10-16
+ * @copyright Copyright (c) 2024
+ */
+#define _XOPEN_SOURCE 700
+#define _DEFAULT_SOURCE
+
+#include "usage.h"
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/time.h>
+#include <time.h>
+
+#include "constants.h"
+
+/**
+ * @brief Structure that holds the usage of the commands with the same name.
+ */
+typedef struct SessionEntry {
+  char *name;          // name of the command
+  int runs;            // number of times the command ran
+  CommandUsage total;  // usage added over every run
+} SessionEntry;
+
+/* Innermost active meter, or NULL. */
+static UsageMeter *current_meter = NULL;
+
+/* Whether a summary is printed after each command. */
+static bool usage_reporting = false;
+
+/* Session summary state. */
+static SessionEntry *session = NULL;  // one entry per command name
+static int session_count = 0;         // number of entries in `session`
+static int session_capacity = 0;      // number of entries that fit
+
+/**
+ * @brief Converts a time value to seconds.
+ *
+ * @param time The time value.
+ * @return double The time in seconds.
+ */
+static double timevalSeconds(const struct timeval *time) {
+  return (double)time->tv_sec + (double)time->tv_usec / 1e6;
+}
+
+/**
+ * @brief Converts the usage returned by the kernel.
+ *
+ * @param rusage The usage returned by getrusage() or wait4().
+ * @param wall_seconds The elapsed time.
+ * @param usage Receives the converted usage.
+ */
+void usageFromRusage(const struct rusage *rusage, double wall_seconds,
+                     CommandUsage *usage) {
+  usage->wall_seconds = wall_seconds;
+  usage->user_seconds = timevalSeconds(&rusage->ru_utime);
+  usage->system_seconds = timevalSeconds(&rusage->ru_stime);
+  usage->max_rss_kb = rusage->ru_maxrss;
+  usage->minor_faults = rusage->ru_minflt;
+  usage->major_faults = rusage->ru_majflt;
+  usage->voluntary_switches = rusage->ru_nvcsw;
+  usage->involuntary_switches = rusage->ru_nivcsw;
+}
+
+/**
+ * @brief Adds one usage to another.
+ *
+ * Times and counters are added. The resident set size is the largest of
+ * both, since processes that ran one after the other do not add up.
+ *
+ * @param total The usage that is increased.
+ * @param usage The usage to add.
+ */
+void addUsage(CommandUsage *total, const CommandUsage *usage) {
+  total->wall_seconds += usage->wall_seconds;
+  total->user_seconds += usage->user_seconds;
+  total->system_seconds += usage->system_seconds;
+  if (usage->max_rss_kb > total->max_rss_kb) {
+    total->max_rss_kb = usage->max_rss_kb;
+  }
+  total->minor_faults += usage->minor_faults;
+  total->major_faults += usage->major_faults;
+  total->voluntary_switches += usage->voluntary_switches;
+  total->involuntary_switches += usage->involuntary_switches;
+}
+
+/**
+ * @brief Starts measuring a command.
+ *
+ * @param meter The meter that holds the measurement.
+ */
+void beginUsage(UsageMeter *meter) {
+  memset(meter, 0, sizeof(UsageMeter));
+  meter->previous = current_meter;
+  current_meter = meter;
+  getrusage(RUSAGE_SELF, &meter->self_start);
+  clock_gettime(CLOCK_MONOTONIC, &meter->start);
+}
+
+/**
+ * @brief Finishes measuring a command.
+ *
+ * Must be called for the most recent meter started with beginUsage().
+ *
+ * @param meter The meter that holds the measurement.
+ * @param usage Receives the resources used since beginUsage().
+ */
+void endUsage(UsageMeter *meter, CommandUsage *usage) {
+  struct timespec end;
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  struct rusage self_end;
+  getrusage(RUSAGE_SELF, &self_end);
+  current_meter = meter->previous;
+
+  // Work done inside the interpreter is the difference of its usage
+  CommandUsage before, after;
+  usageFromRusage(&meter->self_start, 0, &before);
+  usageFromRusage(&self_end, 0, &after);
+
+  usage->wall_seconds = (double)(end.tv_sec - meter->start.tv_sec) +
+                        (double)(end.tv_nsec - meter->start.tv_nsec) / 1e9;
+  usage->user_seconds = after.user_seconds - before.user_seconds;
+  usage->system_seconds = after.system_seconds - before.system_seconds;
+  usage->minor_faults = after.minor_faults - before.minor_faults;
+  usage->major_faults = after.major_faults - before.major_faults;
+  usage->voluntary_switches =
+      after.voluntary_switches - before.voluntary_switches;
+  usage->involuntary_switches =
+      after.involuntary_switches - before.involuntary_switches;
+
+  // The peak of the interpreter only describes commands that ran inside it
+  usage->max_rss_kb = meter->waited_children ? 0 : after.max_rss_kb;
+
+  CommandUsage children = meter->children;
+  children.wall_seconds = 0;
+  addUsage(usage, &children);
+}
+
+/**
+ * @brief Adds the usage of a process that was waited for.
+ *
+ * The usage is added to every active meter.
+ *
+ * @param rusage The usage returned by wait4().
+ */
+void addChildUsage(const struct rusage *rusage) {
+  CommandUsage usage;
+  usageFromRusage(rusage, 0, &usage);
+  for (UsageMeter *meter = current_meter; meter != NULL;
+       meter = meter->previous) {
+    addUsage(&meter->children, &usage);
+    meter->waited_children = true;
+  }
+}
+
+/**
+ * @brief Prints a one-line summary of the resources used by a command.
+ *
+ * @param stream The stream to print to.
+ * @param usage The usage to print.
+ */
+void printUsage(FILE *stream, const CommandUsage *usage) {
+  fprintf(stream,
+          "real %.3fs  user %.3fs  sys %.3fs  rss %ld KB  "
+          "faults %ld/%ld  switches %ld/%ld\n",
+          usage->wall_seconds, usage->user_seconds, usage->system_seconds,
+          usage->max_rss_kb, usage->minor_faults, usage->major_faults,
+          usage->voluntary_switches, usage->involuntary_switches);
+  fflush(stream);
+}
+
+/**
+ * @brief Builds the name a command line is grouped by.
+ *
+ * The name is the first word of each pipeline stage, without the `tempo`
+ * prefix, so `tempo mostra a | conta` is grouped as `mostra | conta`.
+ *
+ * @param command_line The command line.
+ * @param name The buffer that receives the name.
+ * @param size The size of `name`.
+ */
+static void commandName(const char *command_line, char *name, size_t size) {
+  char line[BUFFER_SIZE_BYTES];
+  snprintf(line, sizeof(line), "%s", command_line);
+
+  size_t length = 0;
+  bool stage_start = true;
+  name[0] = '\0';
+  for (char *word = strtok(line, " \t"); word != NULL && length < size;
+       word = strtok(NULL, " \t")) {
+    if (strcmp(word, PIPE_OPERATOR) == 0) {
+      stage_start = true;
+    } else if (stage_start && strcmp(word, TIME_CMD) != 0) {
+      length += snprintf(name + length, size - length, "%s%s",
+                         (length > 0) ? " | " : "", word);
+      stage_start = false;
+    }
+  }
+}
+
+/**
+ * @brief Finds the session entry of a command, creating it if needed.
+ *
+ * @param name The name of the command.
+ * @return SessionEntry* The entry, or NULL on memory allocation failure.
+ */
+static SessionEntry *findSessionEntry(const char *name) {
+  for (int i = 0; i < session_count; i++) {
+    if (strcmp(session[i].name, name) == 0) {
+      return &session[i];
+    }
+  }
+
+  if (session_count == session_capacity) {
+    int new_capacity = session_capacity ? session_capacity * 2 : 16;
+    SessionEntry *entries =
+        realloc(session, new_capacity * sizeof(SessionEntry));
+    if (entries == NULL) {
+      return NULL;
+    }
+    session = entries;
+    session_capacity = new_capacity;
+  }
+
+  SessionEntry *entry = &session[session_count];
+  memset(entry, 0, sizeof(SessionEntry));
+  entry->name = strdup(name);
+  if (entry->name == NULL) {
+    return NULL;
+  }
+  session_count++;
+  return entry;
+}
+
+/**
+ * @brief Adds the usage of a command to the session summary.
+ *
+ * Commands are grouped by name. The name of a pipeline is made of the names
+ * of its stages.
+ *
+ * @param command_line The command line that ran.
+ * @param usage The resources it used.
+ */
+void recordSessionUsage(const char *command_line, const CommandUsage *usage) {
+  char name[BUFFER_SIZE_BYTES];
+  commandName(command_line, name, sizeof(name));
+  if (name[0] == '\0') {
+    return;
+  }
+
+  SessionEntry *entry = findSessionEntry(name);
+  if (entry != NULL) {
+    entry->runs++;
+    addUsage(&entry->total, usage);
+  }
+}
+
+/**
+ * @brief Compares session entries by the CPU time they used, descending.
+ *
+ * @param a The first entry.
+ * @param b The second entry.
+ * @return int A negative value if `a` used more CPU time than `b`.
+ */
+static int compareSessionEntries(const void *a, const void *b) {
+  const CommandUsage *first = &((const SessionEntry *)a)->total;
+  const CommandUsage *second = &((const SessionEntry *)b)->total;
+  double first_cpu = first->user_seconds + first->system_seconds;
+  double second_cpu = second->user_seconds + second->system_seconds;
+  return (first_cpu < second_cpu) - (first_cpu > second_cpu);
+}
+
+/**
+ * @brief Prints the resources used by each command during the session.
+ *
+ * Commands are listed from the most to the least CPU time used.
+ *
+ * @param stream The stream to print to.
+ */
+void printSessionUsage(FILE *stream) {
+  if (session_count == 0) {
+    return;
+  }
+  qsort(session, session_count, sizeof(SessionEntry), compareSessionEntries);
+
+  CommandUsage total;
+  memset(&total, 0, sizeof(total));
+  int runs = 0;
+  for (int i = 0; i < session_count; i++) {
+    addUsage(&total, &session[i].total);
+    runs += session[i].runs;
+  }
+
+  fprintf(stream, "Session: %d commands, real %.3fs, user %.3fs, sys %.3fs\n",
+          runs, total.wall_seconds, total.user_seconds, total.system_seconds);
+  fprintf(stream, "%-20s %6s %10s %10s %10s %10s %10s %10s\n", "command",
+          "runs", "real(s)", "user(s)", "sys(s)", "rss(KB)", "faults",
+          "switches");
+  for (int i = 0; i < session_count; i++) {
+    const CommandUsage *usage = &session[i].total;
+    fprintf(stream, "%-20s %6d %10.3f %10.3f %10.3f %10ld %10ld %10ld\n",
+            session[i].name, session[i].runs, usage->wall_seconds,
+            usage->user_seconds, usage->system_seconds, usage->max_rss_kb,
+            usage->minor_faults + usage->major_faults,
+            usage->voluntary_switches + usage->involuntary_switches);
+  }
+  fflush(stream);
+}
+
+/**
+ * @brief Selects whether a summary is printed after each command.
+ *
+ * @param enabled true to print the summary, false otherwise.
+ */
+void setUsageReporting(bool enabled) { usage_reporting = enabled; }
+
+/**
+ * @brief Checks if a summary is printed after each command.
+ *
+ * @return true if the summary is printed, false otherwise.
+ */
+bool getUsageReporting(void) { return usage_reporting; }
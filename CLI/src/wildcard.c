@@ -0,0 +1,831 @@
+/**
+ * @file wildcard.c
+ * @author Enrique Rodrigues (a28602@alunos.ipca.pt)
+ * @brief Contains the expansion of wildcard patterns into file names.
+ * @version 0.1
+ * @date 2026-10-16
+ * @copyright Copyright (c) 2024
+ */
+#define _XOPEN_SOURCE 700
+#define _DEFAULT_SOURCE
+
+#include "wildcard.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "arena.h"
+#include "constants.h"
+
+/* Size of the buffer directories are read into, in a few calls each. */
+#define DIRENT_BUFFER_SIZE_BYTES (256 * 1024)
+
+/* Initial capacity of the lists of names, which grow by doubling. */
+#define INITIAL_LIST_CAPACITY 64
+
+/* Groups of strings this small are sorted by insertion. */
+#define SORT_RUN_LENGTH 16
+
+/**
+ * @brief Structure of the entries returned by getdents64().
+ */
+typedef struct DirectoryEntry {
+  uint64_t inode;         // inode number
+  int64_t offset;         // offset of the next entry
+  unsigned short length;  // size of this entry
+  unsigned char type;     // file type, DT_UNKNOWN if the file system omits it
+  char name[];            // null-terminated name
+} DirectoryEntry;
+
+/**
+ * @brief Kinds of the operations of a compiled pattern.
+ */
+typedef enum MatchKind {
+  MATCH_LITERAL,  // a run of literal bytes
+  MATCH_ANY,      // `?`, any single byte
+  MATCH_CLASS,    // `[...]`, a byte of a set
+  MATCH_STAR      // `*`, any number of bytes
+} MatchKind;
+
+/**
+ * @brief Structure that holds one operation of a compiled pattern.
+ */
+typedef struct MatchOp {
+  MatchKind kind;      // kind of operation
+  const char *text;    // bytes of a literal
+  size_t length;       // bytes consumed: the literal length, 1, or 0 for `*`
+  unsigned char *set;  // bitmap of the bytes of a class
+} MatchOp;
+
+/**
+ * @brief Structure that holds a compiled path component.
+ *
+ * The operations after the last `*` consume a fixed number of bytes, so they
+ * are matched against the end of a name first, and only the operations
+ * before it need backtracking.
+ */
+typedef struct Matcher {
+  MatchOp *ops;        // operations, in order
+  int op_count;        // number of operations
+  int last_star;       // index of the last `*`, or -1
+  size_t min_length;   // bytes consumed by all operations
+  size_t tail_length;  // bytes consumed by the operations after `last_star`
+  bool match_hidden;   // whether names starting with a dot can match
+} Matcher;
+
+/**
+ * @brief Structure that holds one component of a pattern.
+ */
+typedef struct GlobComponent {
+  const char *literal;  // the name when there are no wildcards, else NULL
+  bool recursive;       // whether the component is `**`
+  Matcher matcher;      // compiled component, when it has wildcards
+} GlobComponent;
+
+/**
+ * @brief Structure that holds a list of strings allocated from an arena.
+ */
+typedef struct StringList {
+  char **items;     // strings
+  size_t count;     // number of strings
+  size_t capacity;  // capacity of `items`
+} StringList;
+
+/**
+ * @brief Structure that holds the state of an expansion.
+ */
+typedef struct Glob {
+  Arena *arena;                  // arena everything is allocated from
+  GlobComponent *components;     // components of the pattern
+  int component_count;           // number of components
+  bool only_directories;         // whether the pattern ends with `/`
+  char path[BUFFER_SIZE_BYTES];  // path of the directory being expanded
+  StringList matches;            // paths found so far
+} Glob;
+
+/* Buffer directories are read into, allocated on first use. */
+static char *dirent_buffer = NULL;
+
+/**
+ * @brief Appends a string to a list.
+ *
+ * @param arena The arena the list is allocated from.
+ * @param list The list.
+ * @param string The string.
+ * @return true on success, false on memory allocation failure.
+ */
+static bool appendString(Arena *arena, StringList *list, char *string) {
+  if (list->count == list->capacity) {
+    size_t capacity =
+        (list->capacity > 0) ? list->capacity * 2 : INITIAL_LIST_CAPACITY;
+    char **items = arenaResize(arena, list->items,
+                               list->capacity * sizeof(char *),
+                               capacity * sizeof(char *));
+    if (items == NULL) {
+      return false;
+    }
+    list->items = items;
+    list->capacity = capacity;
+  }
+
+  list->items[list->count++] = string;
+  return true;
+}
+
+/**
+ * @brief Copies a string into an arena.
+ *
+ * @param arena The arena.
+ * @param text The bytes to copy.
+ * @param length The number of bytes.
+ * @return char* The null-terminated copy, or NULL on memory allocation
+ * failure.
+ */
+static char *copyString(Arena *arena, const char *text, size_t length) {
+  char *copy = arenaAlloc(arena, length + 1);
+  if (copy != NULL) {
+    memcpy(copy, text, length);
+    copy[length] = '\0';
+  }
+  return copy;
+}
+
+/**
+ * @brief Parses a class such as `[a-z]` into a bitmap.
+ *
+ * @param text The component, with the class starting at `start`.
+ * @param start The index of the opening bracket.
+ * @param length The length of the component.
+ * @param set The bitmap of 256 bits that receives the bytes of the class.
+ * @return size_t The index after the closing bracket, or 0 if the class is
+ * not closed, in which case the bracket is a literal.
+ */
+static size_t parseClass(const char *text, size_t start, size_t length,
+                         unsigned char *set) {
+  size_t i = start + 1;
+  bool negate = (i < length && (text[i] == '!' || text[i] == '^'));
+  if (negate) {
+    i++;
+  }
+
+  memset(set, 0, 32);
+  bool first = true;  // A `]` right after the bracket is a literal
+  while (i < length && (text[i] != ']' || first)) {
+    first = false;
+    unsigned char low = text[i];
+    if (low == '\\' && i + 1 < length) {
+      low = text[++i];
+    }
+    unsigned char high = low;
+    if (i + 2 < length && text[i + 1] == '-' && text[i + 2] != ']') {
+      i += 2;
+      high = text[i];
+      if (high == '\\' && i + 1 < length) {
+        high = text[++i];
+      }
+    }
+    for (unsigned int c = low; c <= high; c++) {
+      set[c / 8] |= 1 << (c % 8);
+    }
+    i++;
+  }
+  if (i >= length) {
+    return 0;
+  }
+
+  if (negate) {
+    for (int byte = 0; byte < 32; byte++) {
+      set[byte] = ~set[byte];
+    }
+  }
+  return i + 1;
+}
+
+/**
+ * @brief Compiles a path component into a list of operations.
+ *
+ * @param arena The arena the operations are allocated from.
+ * @param text The component.
+ * @param length The length of the component.
+ * @param matcher Receives the compiled component.
+ * @return true on success, false on memory allocation failure.
+ */
+static bool compileMatcher(Arena *arena, const char *text, size_t length,
+                           Matcher *matcher) {
+  // Every operation consumes at least one byte of the component
+  MatchOp *ops = arenaAlloc(arena, length * sizeof(MatchOp));
+  char *literals = arenaAlloc(arena, length);
+  if (ops == NULL || literals == NULL) {
+    return false;
+  }
+
+  int op_count = 0;
+  size_t literal_length = 0;
+  size_t i = 0;
+  while (i < length) {
+    MatchOp op = {MATCH_LITERAL, NULL, 1, NULL};
+
+    if (text[i] == '*') {
+      while (i < length && text[i] == '*') {
+        i++;  // Consecutive stars match the same as one
+      }
+      op.kind = MATCH_STAR;
+      op.length = 0;
+    } else if (text[i] == '?') {
+      op.kind = MATCH_ANY;
+      i++;
+    } else {
+      size_t end = 0;
+      if (text[i] == '[') {
+        op.set = arenaAlloc(arena, 32);
+        if (op.set == NULL) {
+          return false;
+        }
+        end = parseClass(text, i, length, op.set);
+      }
+
+      if (end != 0) {
+        op.kind = MATCH_CLASS;
+        i = end;
+      } else {
+        // Literal byte, merged into the previous literal when possible
+        if (text[i] == '\\' && i + 1 < length) {
+          i++;
+        }
+        literals[literal_length] = text[i++];
+        if (op_count > 0 && ops[op_count - 1].kind == MATCH_LITERAL) {
+          ops[op_count - 1].length++;
+          literal_length++;
+          continue;
+        }
+        op.text = &literals[literal_length++];
+      }
+    }
+    ops[op_count++] = op;
+  }
+
+  matcher->ops = ops;
+  matcher->op_count = op_count;
+  matcher->last_star = -1;
+  matcher->min_length = 0;
+  matcher->tail_length = 0;
+  for (int op = 0; op < op_count; op++) {
+    if (ops[op].kind == MATCH_STAR) {
+      matcher->last_star = op;
+      matcher->tail_length = 0;
+    }
+    matcher->min_length += ops[op].length;
+    matcher->tail_length += ops[op].length;
+  }
+  matcher->match_hidden = (op_count > 0 && ops[0].kind == MATCH_LITERAL &&
+                           ops[0].text[0] == '.');
+  return true;
+}
+
+/**
+ * @brief Checks if an operation that is not `*` matches at a position.
+ *
+ * @param op The operation.
+ * @param text The bytes to match, at least `op->length` of them.
+ * @return true if they match, false otherwise.
+ */
+static bool matchOp(const MatchOp *op, const char *text) {
+  unsigned char c = text[0];
+  switch (op->kind) {
+    case MATCH_LITERAL:
+      return memcmp(op->text, text, op->length) == 0;
+    case MATCH_CLASS:
+      return (op->set[c / 8] >> (c % 8)) & 1;
+    default:
+      return true;
+  }
+}
+
+/**
+ * @brief Matches operations without `*` against the start of a name.
+ *
+ * @param ops The operations.
+ * @param op_count The number of operations.
+ * @param text The bytes to match, as many as the operations consume.
+ * @return true if they match, false otherwise.
+ */
+static bool matchFixed(const MatchOp *ops, int op_count, const char *text) {
+  for (int op = 0; op < op_count; op++) {
+    if (!matchOp(&ops[op], text)) {
+      return false;
+    }
+    text += ops[op].length;
+  }
+  return true;
+}
+
+/**
+ * @brief Matches operations that end with `*` against the start of a name.
+ *
+ * On a mismatch, the most recent `*` takes one more byte and matching resumes
+ * after it.
+ *
+ * @param ops The operations, the last one being `*`.
+ * @param op_count The number of operations.
+ * @param text The bytes to match.
+ * @param length The number of bytes.
+ * @return true if they match, false otherwise.
+ */
+static bool matchHead(const MatchOp *ops, int op_count, const char *text,
+                      size_t length) {
+  int op = 0;
+  int resume_op = -1;  // Operation after the most recent `*`
+  size_t position = 0;
+  size_t resume_position = 0;
+
+  while (op < op_count) {
+    const MatchOp *current = &ops[op];
+    if (current->kind == MATCH_STAR) {
+      resume_op = ++op;
+      resume_position = position;
+    } else if (position + current->length <= length &&
+               matchOp(current, text + position)) {
+      position += current->length;
+      op++;
+    } else if (resume_op == -1 || ++resume_position > length) {
+      return false;
+    } else {
+      op = resume_op;
+      position = resume_position;
+    }
+  }
+  return true;
+}
+
+/**
+ * @brief Checks if a name matches a compiled component.
+ *
+ * @param matcher The compiled component.
+ * @param name The name.
+ * @param length The length of the name.
+ * @return true if the name matches, false otherwise.
+ */
+static bool matchName(const Matcher *matcher, const char *name,
+                      size_t length) {
+  if (length < matcher->min_length ||
+      (name[0] == '.' && !matcher->match_hidden)) {
+    return false;
+  }
+  if (matcher->last_star == -1) {
+    return length == matcher->min_length &&
+           matchFixed(matcher->ops, matcher->op_count, name);
+  }
+
+  // The operations after the last star are anchored at the end of the name
+  size_t head_length = length - matcher->tail_length;
+  return matchFixed(matcher->ops + matcher->last_star + 1,
+                    matcher->op_count - matcher->last_star - 1,
+                    name + head_length) &&
+         matchHead(matcher->ops, matcher->last_star + 1, name, head_length);
+}
+
+/**
+ * @brief Checks if a component contains wildcards.
+ *
+ * @param text The component.
+ * @param length The length of the component.
+ * @return true if it has an unescaped `*`, `?` or `[`, false otherwise.
+ */
+static bool hasWildcards(const char *text, size_t length) {
+  for (size_t i = 0; i < length; i++) {
+    if (text[i] == '\\') {
+      i++;
+    } else if (text[i] == '*' || text[i] == '?' || text[i] == '[') {
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * @brief Splits a pattern into components and compiles them.
+ *
+ * @param glob The expansion, which receives the components.
+ * @param pattern The pattern, without its leading `/`.
+ * @return true on success, false on memory allocation failure.
+ */
+static bool compilePattern(Glob *glob, const char *pattern) {
+  // One more component for the `*` added after a trailing `**`
+  int capacity = 2;
+  for (const char *c = pattern; *c != '\0'; c++) {
+    capacity += (*c == '/');
+  }
+  glob->components = arenaAlloc(glob->arena, capacity * sizeof(GlobComponent));
+  if (glob->components == NULL) {
+    return false;
+  }
+
+  glob->component_count = 0;
+  const char *start = pattern;
+  while (*start != '\0') {
+    size_t length = strcspn(start, "/");
+    const char *next = start + length + (start[length] == '/');
+    if (start[length] == '/' && *next == '\0') {
+      glob->only_directories = true;
+    }
+
+    GlobComponent *component = &glob->components[glob->component_count];
+    component->literal = NULL;
+    component->recursive = (length == 2 && strncmp(start, "**", 2) == 0);
+    bool repeated = (component->recursive && glob->component_count > 0 &&
+                     component[-1].recursive);
+
+    if (length == 0 || repeated) {
+      // Empty components and repeated `**` change nothing
+    } else if (component->recursive) {
+      glob->component_count++;
+    } else if (!hasWildcards(start, length)) {
+      char *literal = copyString(glob->arena, start, length);
+      if (literal == NULL) {
+        return false;
+      }
+      unescapePattern(literal);
+      component->literal = literal;
+      glob->component_count++;
+    } else {
+      if (!compileMatcher(glob->arena, start, length, &component->matcher)) {
+        return false;
+      }
+      glob->component_count++;
+    }
+    start = next;
+  }
+
+  // A trailing `**` matches every file below the directory
+  if (glob->component_count > 0 &&
+      glob->components[glob->component_count - 1].recursive) {
+    GlobComponent *component = &glob->components[glob->component_count++];
+    component->literal = NULL;
+    component->recursive = false;
+    return compileMatcher(glob->arena, "*", 1, &component->matcher);
+  }
+  return true;
+}
+
+/**
+ * @brief Appends a name to the path being expanded.
+ *
+ * @param glob The expansion.
+ * @param path_length The length of the path.
+ * @param name The name.
+ * @param name_length The length of the name.
+ * @return size_t The new length of the path, or 0 if it is too long.
+ */
+static size_t appendToPath(Glob *glob, size_t path_length, const char *name,
+                           size_t name_length) {
+  bool separator = (path_length > 0 && glob->path[path_length - 1] != '/');
+  size_t length = path_length + separator + name_length;
+  if (length + 2 > sizeof(glob->path)) {
+    return 0;  // No room for a trailing `/` and the null terminator
+  }
+
+  if (separator) {
+    glob->path[path_length] = '/';
+  }
+  memcpy(glob->path + path_length + separator, name, name_length);
+  glob->path[length] = '\0';
+  return length;
+}
+
+/**
+ * @brief Adds the path being expanded to the matches.
+ *
+ * @param glob The expansion.
+ * @param path_length The length of the path.
+ * @return true on success, false on memory allocation failure.
+ */
+static bool addMatch(Glob *glob, size_t path_length) {
+  if (glob->only_directories) {
+    glob->path[path_length++] = '/';
+  }
+  char *match = copyString(glob->arena, glob->path, path_length);
+  return match != NULL && appendString(glob->arena, &glob->matches, match);
+}
+
+/**
+ * @brief Checks if a directory entry is a directory.
+ *
+ * The type comes from the entry, so only file systems that do not report it
+ * and symbolic links that are followed cost a stat() call.
+ *
+ * @param dir_fd The directory that holds the entry.
+ * @param entry The entry.
+ * @param follow_links Whether a link to a directory counts as a directory.
+ * @return true if the entry is a directory, false otherwise.
+ */
+static bool isDirectory(int dir_fd, const DirectoryEntry *entry,
+                        bool follow_links) {
+  if (entry->type == DT_DIR) {
+    return true;
+  }
+  if (entry->type != DT_UNKNOWN && (entry->type != DT_LNK || !follow_links)) {
+    return false;
+  }
+
+  struct stat file_stat;
+  int flags = follow_links ? 0 : AT_SYMLINK_NOFOLLOW;
+  return fstatat(dir_fd, entry->name, &file_stat, flags) == 0 &&
+         S_ISDIR(file_stat.st_mode);
+}
+
+/**
+ * @brief Reads a directory and matches its entries against a component.
+ *
+ * Matches of the last component are added to the results. Matches of any
+ * other component are directories, returned so the caller can descend into
+ * them once the directory is closed.
+ *
+ * @param glob The expansion.
+ * @param index The index of the component.
+ * @param path_length The length of the path of the directory.
+ * @param directories Receives the names of the matching directories.
+ * @return true on success, false on memory allocation failure.
+ */
+static bool scanDirectory(Glob *glob, int index, size_t path_length,
+                          StringList *directories) {
+  const GlobComponent *component = &glob->components[index];
+  bool last = (index == glob->component_count - 1);
+  bool need_directory = !last || glob->only_directories;
+
+  if (dirent_buffer == NULL) {
+    dirent_buffer = malloc(DIRENT_BUFFER_SIZE_BYTES);
+    if (dirent_buffer == NULL) {
+      return false;
+    }
+  }
+
+  // Directories that cannot be read have no matches. The path may still hold
+  // a longer path from an earlier match
+  glob->path[path_length] = '\0';
+  const char *path = (path_length > 0) ? glob->path : ".";
+  int dir_fd = open(path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if (dir_fd == -1) {
+    return true;
+  }
+
+  bool ok = true;
+  long bytes;
+  while (ok && (bytes = syscall(SYS_getdents64, dir_fd, dirent_buffer,
+                                DIRENT_BUFFER_SIZE_BYTES)) > 0) {
+    for (long offset = 0; ok && offset < bytes;) {
+      const DirectoryEntry *entry =
+          (const DirectoryEntry *)(dirent_buffer + offset);
+      offset += entry->length;
+
+      const char *name = entry->name;
+      if (name[0] == '.' &&
+          (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'))) {
+        continue;
+      }
+
+      size_t name_length = strlen(name);
+      if (component->recursive) {
+        // `**` descends into every directory that is not hidden
+        if (name[0] == '.' || !isDirectory(dir_fd, entry, false)) {
+          continue;
+        }
+      } else if (!matchName(&component->matcher, name, name_length) ||
+                 (need_directory && !isDirectory(dir_fd, entry, true))) {
+        continue;
+      }
+
+      if (last && !component->recursive) {
+        size_t length = appendToPath(glob, path_length, name, name_length);
+        ok = (length == 0) || addMatch(glob, length);
+      } else {
+        char *copy = copyString(glob->arena, name, name_length);
+        ok = copy != NULL && appendString(glob->arena, directories, copy);
+      }
+    }
+  }
+
+  close(dir_fd);
+  return ok;
+}
+
+/**
+ * @brief Expands the components of a pattern from a directory.
+ *
+ * @param glob The expansion.
+ * @param index The index of the first component to expand.
+ * @param path_length The length of the path of the directory.
+ * @return true on success, false on memory allocation failure.
+ */
+static bool expandComponent(Glob *glob, int index, size_t path_length) {
+  const GlobComponent *component = &glob->components[index];
+  bool last = (index == glob->component_count - 1);
+
+  // A component without wildcards is used as it is
+  if (component->literal != NULL) {
+    size_t length = appendToPath(glob, path_length, component->literal,
+                                 strlen(component->literal));
+    if (length == 0) {
+      return true;
+    }
+    if (!last) {
+      return expandComponent(glob, index + 1, length);
+    }
+
+    struct stat file_stat;
+    int flags = glob->only_directories ? 0 : AT_SYMLINK_NOFOLLOW;
+    if (fstatat(AT_FDCWD, glob->path, &file_stat, flags) == -1 ||
+        (glob->only_directories && !S_ISDIR(file_stat.st_mode))) {
+      return true;
+    }
+    return addMatch(glob, length);
+  }
+
+  // `**` also matches no directory at all
+  if (component->recursive && !expandComponent(glob, index + 1, path_length)) {
+    return false;
+  }
+
+  StringList directories = {NULL, 0, 0};
+  if (!scanDirectory(glob, index, path_length, &directories)) {
+    return false;
+  }
+
+  int next = component->recursive ? index : index + 1;
+  for (size_t i = 0; i < directories.count; i++) {
+    const char *name = directories.items[i];
+    size_t length = appendToPath(glob, path_length, name, strlen(name));
+    if (length != 0 && !expandComponent(glob, next, length)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * @brief Sorts strings that share their first bytes by insertion.
+ *
+ * @param items The strings.
+ * @param count The number of strings.
+ * @param depth The number of leading bytes known to be equal.
+ */
+static void insertionSort(char **items, size_t count, size_t depth) {
+  for (size_t i = 1; i < count; i++) {
+    char *item = items[i];
+    size_t j = i;
+    for (; j > 0 && strcmp(items[j - 1] + depth, item + depth) > 0; j--) {
+      items[j] = items[j - 1];
+    }
+    items[j] = item;
+  }
+}
+
+/**
+ * @brief Sorts strings that share their first bytes, one byte at a time.
+ *
+ * The strings are distributed into buckets by their byte at `depth`. Each
+ * bucket is then sorted by the next byte: the largest one in this loop and
+ * the others by recursion, so the recursion is never deeper than the
+ * logarithm of the number of strings.
+ *
+ * @param items The strings.
+ * @param scratch Array of at least `count` entries used to distribute them.
+ * @param keys Array of at least `count` bytes used to hold their bytes.
+ * @param count The number of strings.
+ * @param depth The number of leading bytes known to be equal.
+ */
+static void radixSort(char **items, char **scratch, unsigned char *keys,
+                      size_t count, size_t depth) {
+  while (count > SORT_RUN_LENGTH) {
+    size_t counts[256] = {0};
+    for (size_t i = 0; i < count; i++) {
+      keys[i] = items[i][depth];
+      counts[keys[i]]++;
+    }
+    if (counts[0] == count) {
+      return;  // Every string ends here, so they are all equal
+    }
+
+    size_t starts[256];
+    size_t next[256];
+    size_t start = 0;
+    int largest = 0;
+    for (int byte = 0; byte < 256; byte++) {
+      starts[byte] = next[byte] = start;
+      start += counts[byte];
+      if (counts[byte] > counts[largest]) {
+        largest = byte;
+      }
+    }
+    for (size_t i = 0; i < count; i++) {
+      scratch[next[keys[i]]++] = items[i];
+    }
+    memcpy(items, scratch, count * sizeof(char *));
+
+    // Strings that ended are equal and already in place
+    for (int byte = 1; byte < 256; byte++) {
+      if (byte != largest && counts[byte] > 1) {
+        radixSort(items + starts[byte], scratch, keys, counts[byte], depth + 1);
+      }
+    }
+    if (largest == 0) {
+      return;
+    }
+    items += starts[largest];
+    count = counts[largest];
+    depth++;
+  }
+
+  insertionSort(items, count, depth);
+}
+
+/**
+ * @brief Sorts strings in byte order.
+ *
+ * A most significant byte first radix sort, whose scratch arrays are taken
+ * from the arena. Names in a directory often share a prefix, and the sort
+ * reads each byte of it once instead of comparing it again for every pair.
+ *
+ * @param arena The arena the scratch arrays are allocated from.
+ * @param items The strings.
+ * @param count The number of strings.
+ * @return true on success, false on memory allocation failure.
+ */
+static bool sortStrings(Arena *arena, char **items, size_t count) {
+  if (count <= SORT_RUN_LENGTH) {
+    insertionSort(items, count, 0);
+    return true;
+  }
+
+  char **scratch = arenaAlloc(arena, count * sizeof(char *));
+  unsigned char *keys = arenaAlloc(arena, count);
+  if (scratch == NULL || keys == NULL) {
+    return false;
+  }
+  radixSort(items, scratch, keys, count, 0);
+  return true;
+}
+
+/**
+ * @brief Expands a pattern into the paths that match it.
+ *
+ * The paths are sorted in byte order. A pattern ending with `/` only matches
+ * directories, and their paths end with `/`. Directories that cannot be read
+ * are skipped.
+ *
+ * @param arena The arena the paths and their array are allocated from.
+ * @param pattern The pattern.
+ * @param matches Receives the paths.
+ * @param match_count Receives the number of paths, 0 if nothing matched.
+ * @return true on success, false on memory allocation failure.
+ */
+bool expandWildcards(Arena *arena, const char *pattern, char ***matches,
+                     size_t *match_count) {
+  // The path is large, so the state is not kept on the stack
+  Glob *glob = arenaAlloc(arena, sizeof(Glob));
+  if (glob == NULL) {
+    return false;
+  }
+  glob->arena = arena;
+  glob->only_directories = false;
+  glob->matches = (StringList){NULL, 0, 0};
+
+  size_t path_length = 0;
+  if (*pattern == '/') {
+    glob->path[path_length++] = '/';
+  }
+  glob->path[path_length] = '\0';
+
+  bool ok = compilePattern(glob, pattern + path_length);
+  if (ok && glob->component_count > 0) {
+    ok = expandComponent(glob, 0, path_length) &&
+         sortStrings(arena, glob->matches.items, glob->matches.count);
+  }
+
+  *matches = glob->matches.items;
+  *match_count = ok ? glob->matches.count : 0;
+  return ok;
+}
+
+/**
+ * @brief Removes the backslashes that make characters of a pattern literal.
+ *
+ * @param pattern The pattern, modified in place.
+ */
+void unescapePattern(char *pattern) {
+  char *out = pattern;
+  for (const char *in = pattern; *in != '\0'; in++) {
+    if (*in == '\\' && in[1] != '\0') {
+      in++;
+    }
+    *out++ = *in;
+  }
+  *out = '\0';
+}
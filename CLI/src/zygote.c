@@ -0,0 +1,428 @@
+/**
+ * @file zygote.c
+ * @author Enrique Rodrigues (a28602@alunos.ipca.pt)
+ * @brief Contains the pool of pre-forked helper processes.
+ * @version 0.1
+ * @date 2026-10-16
+ * @copyright Copyright (c) 2024
+ */
+#define _GNU_SOURCE
+
+#include "zygote.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "constants.h"
+#include "trace.h"
+
+/* Number of helpers kept ready by the zygote. */
+#define ZYGOTE_POOL_SIZE 8
+
+/* Largest command (path and arguments) that can be sent to a helper. */
+#define ZYGOTE_MESSAGE_SIZE_BYTES (64 * 1024)
+
+/*
+ * Largest number of arguments that can be sent to a helper. Longer commands
+ * are launched with posix_spawn().
+ */
+#define ZYGOTE_MAX_ARGS 1024
+
+/* Number of descriptors sent with a command: stdin, stdout and stderr. */
+#define ZYGOTE_STREAM_COUNT 3
+
+/* Size of the stack a helper starts on, which holds a whole message. */
+#define ZYGOTE_STACK_SIZE_BYTES (4 * ZYGOTE_MESSAGE_SIZE_BYTES)
+
+/**
+ * @brief Structure that holds the descriptors a new helper starts with.
+ */
+typedef struct HelperStart {
+  int socket_fd;   // socket the helper receives its command on
+  int peer_fd;     // other end of the socket, closed by the helper
+  int control_fd;  // control socket, closed by the helper
+} HelperStart;
+
+/* Environment passed to the commands. */
+extern char **environ;
+
+/* Zygote state, in the interpreter. */
+static int control_fd = -1;         // control socket of the zygote, or -1
+static pid_t zygote_pid = -1;       // pid of the zygote, or -1
+static bool zygote_failed = false;  // whether the pool stopped working
+
+/* Buffer that holds a command while it is sent. */
+static char message[ZYGOTE_MESSAGE_SIZE_BYTES];
+
+/**
+ * @brief Sends data and descriptors over a Unix socket.
+ *
+ * @param socket_fd The socket.
+ * @param data The data to send.
+ * @param length The length of `data`.
+ * @param fds The descriptors to send.
+ * @param fd_count The number of descriptors in `fds`.
+ * @return true on success, false on error.
+ */
+static bool sendWithDescriptors(int socket_fd, const void *data,
+                                size_t length, const int fds[],
+                                int fd_count) {
+  union {
+    char buffer[CMSG_SPACE(sizeof(int) * ZYGOTE_STREAM_COUNT)];
+    struct cmsghdr align;
+  } control;
+  memset(&control, 0, sizeof(control));
+
+  struct iovec iov = {(void *)data, length};
+  struct msghdr header;
+  memset(&header, 0, sizeof(header));
+  header.msg_iov = &iov;
+  header.msg_iovlen = 1;
+  header.msg_control = control.buffer;
+  header.msg_controllen = CMSG_SPACE(sizeof(int) * fd_count);
+
+  struct cmsghdr *cmsg = CMSG_FIRSTHDR(&header);
+  cmsg->cmsg_level = SOL_SOCKET;
+  cmsg->cmsg_type = SCM_RIGHTS;
+  cmsg->cmsg_len = CMSG_LEN(sizeof(int) * fd_count);
+  memcpy(CMSG_DATA(cmsg), fds, sizeof(int) * fd_count);
+
+  ssize_t sent;
+  do {
+    sent = sendmsg(socket_fd, &header, MSG_NOSIGNAL);
+  } while (sent == -1 && errno == EINTR);
+  return sent == (ssize_t)length;
+}
+
+/**
+ * @brief Receives data and descriptors from a Unix socket.
+ *
+ * The descriptors are received with the close-on-exec flag set.
+ *
+ * @param socket_fd The socket.
+ * @param data The buffer that receives the data.
+ * @param size The size of `data`.
+ * @param fds Receives the descriptors.
+ * @param fd_count The number of descriptors expected.
+ * @return ssize_t The length of the data, 0 if the peer closed the socket or
+ * -1 on error, including a message without the expected descriptors.
+ */
+static ssize_t receiveWithDescriptors(int socket_fd, void *data, size_t size,
+                                      int fds[], int fd_count) {
+  union {
+    char buffer[CMSG_SPACE(sizeof(int) * ZYGOTE_STREAM_COUNT)];
+    struct cmsghdr align;
+  } control;
+
+  struct iovec iov = {data, size};
+  struct msghdr header;
+  memset(&header, 0, sizeof(header));
+  header.msg_iov = &iov;
+  header.msg_iovlen = 1;
+  header.msg_control = control.buffer;
+  header.msg_controllen = sizeof(control.buffer);
+
+  ssize_t received;
+  do {
+    received = recvmsg(socket_fd, &header, MSG_CMSG_CLOEXEC);
+  } while (received == -1 && errno == EINTR);
+  if (received <= 0) {
+    return received;
+  }
+
+  struct cmsghdr *cmsg = CMSG_FIRSTHDR(&header);
+  if (cmsg == NULL || cmsg->cmsg_type != SCM_RIGHTS ||
+      cmsg->cmsg_len != CMSG_LEN(sizeof(int) * fd_count)) {
+    return -1;
+  }
+  memcpy(fds, CMSG_DATA(cmsg), sizeof(int) * fd_count);
+  return received;
+}
+
+/**
+ * @brief Reports an error in a helper without using stdio.
+ *
+ * @param error The error number.
+ */
+static void reportHelperError(int error) {
+  const char *prefix = "Error executing command: ";
+  char *text = strerror(error);
+  struct iovec parts[] = {{(void *)prefix, strlen(prefix)},
+                          {text, strlen(text)},
+                          {"\n", 1}};
+  writev(STDERR_FILENO, parts, sizeof(parts) / sizeof(parts[0]));
+}
+
+/**
+ * @brief Waits for a command and executes it. Runs in a helper.
+ *
+ * The command arrives as the path followed by the arguments, each
+ * null-terminated, with the standard streams as descriptors.
+ *
+ * @param argument The descriptors of the helper.
+ * @return int The exit status if the command could not be executed.
+ */
+static int runHelper(void *argument) {
+  const HelperStart *start = argument;
+  int socket_fd = start->socket_fd;
+  close(start->peer_fd);  // Otherwise the socket would never be closed
+  close(start->control_fd);
+
+  char message[ZYGOTE_MESSAGE_SIZE_BYTES];
+  int fds[ZYGOTE_STREAM_COUNT];
+  ssize_t length = receiveWithDescriptors(socket_fd, message, sizeof(message),
+                                          fds, ZYGOTE_STREAM_COUNT);
+  if (length <= 0) {
+    _exit(EXIT_FAILURE);  // The interpreter exited or gave up on the helper
+  }
+
+  // Split the message into the path and the arguments
+  char *args[ZYGOTE_MAX_ARGS + 1];
+  char *command_path = message;
+  char *next = message + strlen(message) + 1;
+  int arg_count = 0;
+  while (next < message + length && arg_count < ZYGOTE_MAX_ARGS) {
+    args[arg_count++] = next;
+    next += strlen(next) + 1;
+  }
+  args[arg_count] = NULL;
+
+  // The received descriptors are closed on exec, their copies are not
+  for (int target = 0; target < ZYGOTE_STREAM_COUNT; target++) {
+    if (dup2(fds[target], target) == -1) {
+      reportHelperError(errno);
+      _exit(EXIT_FAILURE);
+    }
+  }
+
+  execve(command_path, args, environ);
+  reportHelperError(errno);
+  _exit(EXIT_FAILURE);
+}
+
+/**
+ * @brief Creates a helper and hands it to the interpreter. Runs in the
+ * zygote.
+ *
+ * The helper gets a copy of the memory of the zygote, like with fork(), so
+ * it has its own `errno` and the zygote keeps running while the helper waits
+ * for its command. With `CLONE_PARENT` its parent is the interpreter. The
+ * interpreter receives the pid of the helper and the socket used to send it
+ * a command.
+ *
+ * @param control The control socket.
+ * @param stack The stack the helper starts on, copied with the rest of the
+ * memory and so reused for every helper.
+ * @return true on success, false if the interpreter is gone.
+ */
+static bool createHelper(int control, char *stack) {
+  int sockets[2];
+  if (socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, sockets) == -1) {
+    return false;
+  }
+
+  HelperStart start = {sockets[1], sockets[0], control};
+  pid_t pid = clone(runHelper, stack + ZYGOTE_STACK_SIZE_BYTES,
+                    CLONE_PARENT | SIGCHLD, &start);
+  close(sockets[1]);
+
+  bool sent = (pid > 0) &&
+              sendWithDescriptors(control, &pid, sizeof(pid), &sockets[0], 1);
+  close(sockets[0]);
+  return sent;
+}
+
+/**
+ * @brief Keeps the pool of helpers full. Runs in the zygote.
+ *
+ * Creates a new helper every time the interpreter takes one, and exits when
+ * the interpreter closes the control socket.
+ *
+ * @param control The control socket.
+ */
+static void runZygote(int control) {
+  // Helpers start with the state commands expect
+  sigset_t empty_mask;
+  sigemptyset(&empty_mask);
+  sigprocmask(SIG_SETMASK, &empty_mask, NULL);
+  disableTraceInChild();
+
+  // Keep only the standard streams and the control socket
+  if (control != STDERR_FILENO + 1) {
+    dup2(control, STDERR_FILENO + 1);
+    control = STDERR_FILENO + 1;
+  }
+  fcntl(control, F_SETFD, FD_CLOEXEC);
+  closefrom(STDERR_FILENO + 2);
+
+  static char stack[ZYGOTE_STACK_SIZE_BYTES];
+  int requests = ZYGOTE_POOL_SIZE;  // helpers to create
+  while (true) {
+    for (; requests > 0; requests--) {
+      if (!createHelper(control, stack)) {
+        _exit(EXIT_FAILURE);
+      }
+    }
+
+    // Wait for the interpreter to take a helper
+    char request;
+    ssize_t result = read(control, &request, 1);
+    if (result == -1 && errno == EINTR) {
+      continue;
+    }
+    if (result != 1) {
+      _exit(EXIT_SUCCESS);  // The interpreter exited
+    }
+    requests++;
+  }
+}
+
+/**
+ * @brief Stops using the pool after an error.
+ */
+static void stopZygote(void) {
+  fputs("Error: The helper pool stopped, using posix_spawn.\n", stderr);
+  close(control_fd);
+  control_fd = -1;
+  kill(zygote_pid, SIGKILL);
+  waitpid(zygote_pid, NULL, 0);
+  zygote_pid = -1;
+  zygote_failed = true;
+}
+
+/**
+ * @brief Starts the zygote and fills the pool of helpers.
+ *
+ * Does nothing if the zygote is already running.
+ *
+ * @return true if the pool is available, false otherwise.
+ */
+bool startZygote(void) {
+  if (control_fd != -1) {
+    return true;
+  }
+  if (zygote_failed) {
+    return false;
+  }
+
+  int sockets[2];
+  if (socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, sockets) == -1) {
+    perror("Error starting the helper pool");
+    zygote_failed = true;
+    return false;
+  }
+
+  fflush(stdout);
+  fflush(stderr);
+  pid_t pid = fork();
+  if (pid == -1) {
+    perror("Error starting the helper pool");
+    close(sockets[0]);
+    close(sockets[1]);
+    zygote_failed = true;
+    return false;
+  }
+  if (pid == 0) {
+    // Zygote process
+    close(sockets[0]);
+    runZygote(sockets[1]);
+  }
+
+  close(sockets[1]);
+  control_fd = sockets[0];
+  zygote_pid = pid;
+  return true;
+}
+
+/**
+ * @brief Stops using the pool in a child copy of the interpreter.
+ *
+ * Helpers are children of the interpreter, so a copy of it could not wait
+ * for them. The copy launches commands with posix_spawn() instead.
+ */
+void disableZygoteInChild(void) {
+  control_fd = -1;
+  zygote_pid = -1;
+  zygote_failed = true;
+}
+
+/**
+ * @brief Builds the message that carries a command to a helper.
+ *
+ * @param command_path The path to the command.
+ * @param args The arguments of the command, terminated by NULL.
+ * @return size_t The length of the message, or 0 if it does not fit.
+ */
+static size_t buildMessage(const char *command_path, char *args[]) {
+  size_t length = strlen(command_path) + 1;
+  if (length > sizeof(message)) {
+    return 0;
+  }
+  memcpy(message, command_path, length);
+
+  for (int i = 0; args[i] != NULL; i++) {
+    if (i == ZYGOTE_MAX_ARGS) {
+      return 0;
+    }
+    size_t arg_length = strlen(args[i]) + 1;
+    if (length + arg_length > sizeof(message)) {
+      return 0;
+    }
+    memcpy(message + length, args[i], arg_length);
+    length += arg_length;
+  }
+  return length;
+}
+
+/**
+ * @brief Launches a command in a helper from the pool.
+ *
+ * @param command_path The path to the command to be executed.
+ * @param args An array of strings containing the arguments for the command.
+ * @param io The descriptors the command uses as its standard streams.
+ * @param pid Receives the pid of the command.
+ * @return true if the command was handed to a helper, false if the pool is
+ * unavailable and the command must be launched some other way.
+ */
+bool spawnWithZygote(const char *command_path, char *args[],
+                     const CommandIO *io, pid_t *pid) {
+  size_t length = buildMessage(command_path, args);
+  if (length == 0 || !startZygote()) {
+    return false;
+  }
+
+  // Take the next ready helper and ask the zygote for a replacement
+  pid_t helper_pid;
+  int helper_fd;
+  if (receiveWithDescriptors(control_fd, &helper_pid, sizeof(helper_pid),
+                             &helper_fd, 1) != sizeof(helper_pid)) {
+    stopZygote();
+    return false;
+  }
+  char request = '+';
+  send(control_fd, &request, 1, MSG_NOSIGNAL);
+
+  const int fds[ZYGOTE_STREAM_COUNT] = {io->in_fd, io->out_fd, io->err_fd};
+  bool sent = sendWithDescriptors(helper_fd, message, length, fds,
+                                  ZYGOTE_STREAM_COUNT);
+  close(helper_fd);
+  if (!sent) {
+    kill(helper_pid, SIGKILL);
+    waitpid(helper_pid, NULL, 0);
+    return false;
+  }
+
+  *pid = helper_pid;
+  return true;
+}
@@ -0,0 +1,52 @@
+#!/bin/sh
+#
+# Measures the throughput of `copia -j` with 1, 2, 4, 8 and 16 threads, to
+# choose the number of threads for a device.
+#
+# Usage: bench/copia_threads.sh [megabytes] [directory]
+#
+# Creates a file of `megabytes` MB (default: 1024) in `directory` (default: a
+# new temporary directory), which should be on the device to measure, and
+# copies it next to itself with each number of threads, printing the best MB
+# per second of three runs. With COLD=1 the page cache is dropped before each
+# run, which needs root, so the source is read from the device. Build the
+# commands with `make` first.
+
+SIZE_MB=${1:-1024}
+COPIA=${COPIA:-build/commands/copia}
+
+if [ ! -x "$COPIA" ]; then
+  echo "Error: $COPIA not found, run make first." >&2
+  exit 1
+fi
+
+DIR=$(mktemp -d ${2:+"$2/copia_threads.XXXXXX"})
+trap 'rm -rf "$DIR"' EXIT
+
+head -c "${SIZE_MB}M" /dev/urandom >"$DIR/input"
+
+# Copies the file with a number of threads and prints the MB per second
+run() {
+  rm -f "$DIR/output"
+  sync
+  if [ "${COLD:-0}" = 1 ]; then
+    echo 3 >/proc/sys/vm/drop_caches
+  else
+    cat "$DIR/input" >/dev/null
+  fi
+  start=$(date +%s.%N)
+  "$COPIA" -j "$1" "$DIR/input" "$DIR/output" || return 1
+  sync "$DIR/output" 2>/dev/null || sync
+  end=$(date +%s.%N)
+  echo "$start $end $SIZE_MB" | awk '{ printf "%.0f\n", $3 / ($2 - $1) }'
+}
+
+printf "%-8s %10s\n" "threads" "MB/s"
+for threads in 1 2 4 8 16; do
+  best=0
+  for attempt in 1 2 3; do
+    rate=$(run "$threads") || exit 1
+    [ "$rate" -gt "$best" ] && best=$rate
+  done
+  printf "%-8s %10s\n" "$threads" "$best"
+done
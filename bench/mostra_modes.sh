@@ -0,0 +1,63 @@
+#!/bin/sh
+#
+# Measures the throughput of each mode of `mostra` (`--modo`) when writing
+# into a file, a pipe and a socket.
+#
+# Usage: bench/mostra_modes.sh [megabytes]
+#
+# Creates a file of `megabytes` MB (default: 1024) and shows it with each
+# mode into each kind of output, printing the MB per second, or "-" when the
+# mode cannot be used for that output. The file is read once first so every
+# run reads it from the page cache. Build the commands with `make` first.
+
+SIZE_MB=${1:-1024}
+MOSTRA=${MOSTRA:-build/commands/mostra}
+
+if [ ! -x "$MOSTRA" ]; then
+  echo "Error: $MOSTRA not found, run make first." >&2
+  exit 1
+fi
+
+DIR=$(mktemp -d)
+trap 'rm -rf "$DIR"' EXIT
+
+head -c "${SIZE_MB}M" /dev/zero | tr '\0' 'x' >"$DIR/input"
+cat "$DIR/input" >/dev/null
+
+# Runs `mostra` with a mode into an output and prints the MB per second
+run() {
+  start=$(date +%s.%N)
+  case $2 in
+    file) "$MOSTRA" --modo "$1" "$DIR/input" >"$DIR/output" 2>/dev/null ;;
+    pipe)
+      {
+        "$MOSTRA" --modo "$1" "$DIR/input" 2>/dev/null
+        echo $? >"$DIR/status"
+      } | cat >/dev/null
+      (exit "$(cat "$DIR/status")") ;;
+    socket)
+      python3 -c 'import socket, subprocess, sys
+a, b = socket.socketpair()
+p = subprocess.Popen(sys.argv[1:], stdout=a, stderr=subprocess.DEVNULL)
+a.close()
+while b.recv(1 << 20):
+    pass
+sys.exit(p.wait())' "$MOSTRA" --modo "$1" "$DIR/input" ;;
+  esac
+  status=$?
+  end=$(date +%s.%N)
+  if [ "$status" -ne 0 ]; then
+    printf " %10s" "-"
+  else
+    echo "$start $end $SIZE_MB" | awk '{ printf " %10.0f", $3 / ($2 - $1) }'
+  fi
+}
+
+printf "%-9s %10s %10s %10s\n" "mode" "file" "pipe" "socket"
+for mode in auto splice copy sendfile mmap buffer; do
+  printf "%-9s" "$mode"
+  for output in file pipe socket; do
+    run "$mode" "$output"
+  done
+  printf "\n"
+done
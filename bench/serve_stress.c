@@ -0,0 +1,280 @@
+/**
+ * @file serve_stress.c
+ * @author Enrique Rodrigues (a28602@alunos.ipca.pt)
+ * @brief Stress client for the server mode of the interpreter.
+ *
+ * Opens many connections to `interpretador --serve` and keeps each one busy:
+ * every connection sends a line, waits for the status that ends its output
+ * and sends the next. Prints the commands per second and the latency
+ * percentiles of the lines.
+ *
+ * Usage: build/bench/serve_stress socket [clients] [commands] [line]
+ *
+ * Defaults to 16 clients running 1000 lines of `conta /etc/passwd` in total.
+ * Build it with `make bench`.
+ *
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <poll.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+/* Usage message of the client. */
+#define USAGE_MESSAGE \
+  "Usage: serve_stress socket [clients] [commands] [line]\n"
+
+/**
+ * @brief Structure that holds a connection to the server.
+ */
+typedef struct Connection {
+  int fd;                  // socket
+  bool busy;               // whether a line is running
+  struct timespec start;   // when the running line was sent
+  bool status_next;        // whether the output ended and a status follows
+  int status;              // status of the running line, as it is read
+} Connection;
+
+/**
+ * @brief Returns the seconds elapsed between two instants.
+ *
+ * @param start The first instant.
+ * @param end The second instant.
+ * @return double The seconds from `start` to `end`.
+ */
+static double elapsedSeconds(const struct timespec *start,
+                             const struct timespec *end) {
+  return (end->tv_sec - start->tv_sec) +
+         (end->tv_nsec - start->tv_nsec) / 1e9;
+}
+
+/**
+ * @brief Compares two latencies, for qsort().
+ *
+ * @param a The first latency.
+ * @param b The second latency.
+ * @return int Negative, zero or positive as `a` is below, equal or above `b`.
+ */
+static int compareLatencies(const void *a, const void *b) {
+  double x = *(const double *)a, y = *(const double *)b;
+  return (x > y) - (x < y);
+}
+
+/**
+ * @brief Connects to the server.
+ *
+ * @param path The path of the server socket.
+ * @return int The socket, or -1 on error.
+ */
+static int connectToServer(const char *path) {
+  struct sockaddr_un address;
+  memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  strncpy(address.sun_path, path, sizeof(address.sun_path) - 1);
+
+  int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (fd == -1 ||
+      connect(fd, (struct sockaddr *)&address, sizeof(address)) == -1) {
+    perror(path);
+    if (fd != -1) {
+      close(fd);
+    }
+    return -1;
+  }
+  return fd;
+}
+
+/**
+ * @brief Sends a line on a connection.
+ *
+ * @param connection The connection.
+ * @param line The line, ending with a newline.
+ * @param length The length of the line.
+ * @return true on success, false on error.
+ */
+static bool sendLine(Connection *connection, const char *line,
+                     size_t length) {
+  clock_gettime(CLOCK_MONOTONIC, &connection->start);
+  while (length > 0) {
+    ssize_t sent = send(connection->fd, line, length, MSG_NOSIGNAL);
+    if (sent == -1) {
+      if (errno == EINTR) {
+        continue;
+      }
+      perror("Error sending line");
+      return false;
+    }
+    line += sent;
+    length -= sent;
+  }
+  connection->busy = true;
+  connection->status_next = false;
+  connection->status = 0;
+  return true;
+}
+
+/**
+ * @brief Reads the output of the running line of a connection.
+ *
+ * The output is discarded up to the NUL byte sent by the server, which is
+ * followed by the exit status of the line and a newline.
+ *
+ * @param connection The connection.
+ * @return int 1 if the line finished, 0 if it is still running, or -1 if
+ * the connection failed.
+ */
+static int readOutput(Connection *connection) {
+  char buffer[4096];
+  ssize_t received = recv(connection->fd, buffer, sizeof(buffer), 0);
+  if (received <= 0) {
+    if (received == -1 && errno == EINTR) {
+      return 0;
+    }
+    fputs("Error: The server closed a connection.\n", stderr);
+    return -1;
+  }
+
+  // The status is the last thing sent for a line
+  for (ssize_t i = 0; i < received; i++) {
+    if (!connection->status_next) {
+      connection->status_next = (buffer[i] == '\0');
+    } else if (buffer[i] >= '0' && buffer[i] <= '9') {
+      connection->status = connection->status * 10 + (buffer[i] - '0');
+    } else if (buffer[i] == '\n') {
+      connection->busy = false;
+      return 1;
+    }
+  }
+  return 0;
+}
+
+/**
+ * @brief Main entry point of the stress client.
+ *
+ * @param argc The number of command-line arguments.
+ * @param argv The socket path, and optionally the number of clients, the
+ * number of lines and the line to run.
+ * @return int Returns 0 if every line ran, or 1 in the case of error.
+ */
+int main(int argc, char *argv[]) {
+  if (argc < 2 || argc > 5) {
+    fputs(USAGE_MESSAGE, stderr);
+    return EXIT_FAILURE;
+  }
+  const char *socket_path = argv[1];
+  int client_count = (argc > 2) ? atoi(argv[2]) : 16;
+  int command_count = (argc > 3) ? atoi(argv[3]) : 1000;
+  const char *command = (argc > 4) ? argv[4] : "conta /etc/passwd";
+  if (client_count <= 0 || command_count <= 0) {
+    fputs(USAGE_MESSAGE, stderr);
+    return EXIT_FAILURE;
+  }
+  if (client_count > command_count) {
+    client_count = command_count;
+  }
+
+  size_t line_length = strlen(command) + 1;
+  char *line = malloc(line_length + 1);
+  Connection *connections = calloc(client_count, sizeof(Connection));
+  struct pollfd *fds = calloc(client_count, sizeof(struct pollfd));
+  double *latencies = malloc(command_count * sizeof(double));
+  if (line == NULL || connections == NULL || fds == NULL ||
+      latencies == NULL) {
+    fputs("Error: Memory allocation failed.\n", stderr);
+    return EXIT_FAILURE;
+  }
+  snprintf(line, line_length + 1, "%s\n", command);
+
+  for (int i = 0; i < client_count; i++) {
+    connections[i].fd = connectToServer(socket_path);
+    if (connections[i].fd == -1) {
+      return EXIT_FAILURE;
+    }
+    fds[i].fd = connections[i].fd;
+    fds[i].events = POLLIN;
+  }
+
+  struct timespec start, now;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+
+  // Each connection keeps a line running until every line was sent
+  int sent = 0, finished = 0, failures = 0;
+  for (int i = 0; i < client_count; i++) {
+    if (!sendLine(&connections[i], line, line_length)) {
+      return EXIT_FAILURE;
+    }
+    sent++;
+  }
+
+  while (finished < command_count) {
+    if (poll(fds, client_count, -1) == -1) {
+      if (errno == EINTR) {
+        continue;
+      }
+      perror("Error");
+      return EXIT_FAILURE;
+    }
+
+    for (int i = 0; i < client_count; i++) {
+      if (fds[i].revents == 0) {
+        continue;
+      }
+      Connection *connection = &connections[i];
+      int result = readOutput(connection);
+      if (result == -1) {
+        return EXIT_FAILURE;
+      } else if (result == 0) {
+        continue;
+      }
+
+      clock_gettime(CLOCK_MONOTONIC, &now);
+      latencies[finished++] = elapsedSeconds(&connection->start, &now);
+      if (connection->status != 0) {
+        failures++;
+      }
+      if (sent < command_count) {
+        if (!sendLine(connection, line, line_length)) {
+          return EXIT_FAILURE;
+        }
+        sent++;
+      }
+    }
+  }
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  double seconds = elapsedSeconds(&start, &now);
+  qsort(latencies, command_count, sizeof(double), compareLatencies);
+
+  printf("%-12s %d\n", "clients", client_count);
+  printf("%-12s %d\n", "commands", command_count);
+  printf("%-12s %d\n", "failures", failures);
+  printf("%-12s %.3f\n", "seconds", seconds);
+  printf("%-12s %.0f\n", "commands/s", command_count / seconds);
+  printf("%-12s %.3f ms\n", "p50", latencies[command_count / 2] * 1e3);
+  printf("%-12s %.3f ms\n", "p90",
+         latencies[(int)(command_count * 0.9)] * 1e3);
+  printf("%-12s %.3f ms\n", "p99",
+         latencies[(int)(command_count * 0.99)] * 1e3);
+  printf("%-12s %.3f ms\n", "max", latencies[command_count - 1] * 1e3);
+
+  for (int i = 0; i < client_count; i++) {
+    close(connections[i].fd);
+  }
+  free(latencies);
+  free(fds);
+  free(connections);
+  free(line);
+  return (failures == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,44 @@
+#!/bin/sh
+#
+# Measures how many commands per second the interpreter launches with each
+# backend (`opcao lancador`).
+#
+# Usage: bench/spawn_rate.sh [commands] [command]
+#
+# Runs `commands` copies of `command` (default: 5000 runs of /bin/true) as a
+# script, once per backend, and prints the commands per second. The command
+# is given as an absolute path so the PATH lookup is not measured. Build the
+# interpreter with `make` first.
+
+COUNT=${1:-5000}
+COMMAND=${2:-/bin/true}
+INTERPRETER=${INTERPRETER:-build/interpretador}
+
+if [ ! -x "$INTERPRETER" ]; then
+  echo "Error: $INTERPRETER not found, run make first." >&2
+  exit 1
+fi
+
+SCRIPT=$(mktemp)
+trap 'rm -f "$SCRIPT" "$SCRIPT.cmds"' EXIT
+
+i=0
+while [ "$i" -lt "$COUNT" ]; do
+  echo "$COMMAND"
+  i=$((i + 1))
+done >"$SCRIPT.cmds"
+
+printf "%-8s %10s %12s\n" "backend" "seconds" "commands/s"
+for backend in fork spawn zigoto; do
+  {
+    echo "opcao lancador $backend"
+    cat "$SCRIPT.cmds"
+  } >"$SCRIPT"
+
+  start=$(date +%s.%N)
+  "$INTERPRETER" -f "$SCRIPT" >/dev/null
+  end=$(date +%s.%N)
+
+  echo "$start $end $COUNT" | awk -v backend="$backend" \
+    '{ s = $2 - $1; printf "%-8s %10.3f %12.0f\n", backend, s, $3 / s }'
+done
@@ -0,0 +1,63 @@
+#!/bin/sh
+#
+# Measures the throughput of the io_uring engine (`--fila`) of `copia`,
+# `acrescenta` and `mostra` with 1, 4, 16 and 64 operations in flight.
+#
+# Usage: bench/uring_depth.sh [megabytes] [directory]
+#
+# Creates a file of `megabytes` MB (default: 1024) in `directory` (default: a
+# new temporary directory), which should be on the file system to measure,
+# and copies it, appends it to an empty file and displays it into /dev/null
+# with each queue depth, printing the best MB per second of three runs. With
+# COLD=1 the page cache is dropped before each run, which needs root, so the
+# file is read from the device. Build the commands with `make` first.
+
+SIZE_MB=${1:-1024}
+BIN=${BIN:-build/commands}
+
+for command in copia acrescenta mostra; do
+  if [ ! -x "$BIN/$command" ]; then
+    echo "Error: $BIN/$command not found, run make first." >&2
+    exit 1
+  fi
+done
+
+DIR=$(mktemp -d ${2:+"$2/uring_depth.XXXXXX"})
+trap 'rm -rf "$DIR"' EXIT
+
+head -c "${SIZE_MB}M" /dev/urandom >"$DIR/input"
+
+# Runs a command with a queue depth and prints the MB per second
+run() {
+  rm -f "$DIR/output"
+  : >"$DIR/output"
+  sync
+  if [ "${COLD:-0}" = 1 ]; then
+    echo 3 >/proc/sys/vm/drop_caches
+  else
+    cat "$DIR/input" >/dev/null
+  fi
+  start=$(date +%s.%N)
+  case $1 in
+    copia) "$BIN/copia" --fila "$2" "$DIR/input" "$DIR/output" ;;
+    acrescenta) "$BIN/acrescenta" --fila "$2" "$DIR/input" "$DIR/output" ;;
+    mostra) "$BIN/mostra" --fila "$2" "$DIR/input" >/dev/null ;;
+  esac || return 1
+  sync "$DIR/output" 2>/dev/null || sync
+  end=$(date +%s.%N)
+  echo "$start $end $SIZE_MB" | awk '{ printf "%.0f\n", $3 / ($2 - $1) }'
+}
+
+printf "%-6s %10s %10s %10s\n" "depth" "copia" "acrescenta" "mostra"
+for depth in 1 4 16 64; do
+  printf "%-6s" "$depth"
+  for command in copia acrescenta mostra; do
+    best=0
+    for attempt in 1 2 3; do
+      rate=$(run "$command" "$depth") || exit 1
+      [ "$rate" -gt "$best" ] && best=$rate
+    done
+    printf " %10s" "$best"
+  done
+  printf "\n"
+done
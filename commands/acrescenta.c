@@ -9,6 +9,13 @@
  *
  * @version 0.1
  * @date 2024-04-18
+ *
+ * @section Modifications
+ * - 2026-10-16: The program logic moved to acrescenta_main() so the interpreter
+ *               can run the command in-process.
+ *   Enrique George Rodrigues (a28602@alunos.ipca.pt)
+ * - 2026-10-16: Added --fila to append through the shared io_uring engine.
+ *   Enrique George Rodrigues (a28602@alunos.ipca.pt)
  */
 #define _XOPEN_SOURCE 700
 
@@ -17,8 +24,12 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/stat.h>
 #include <unistd.h>
 
+#include "commands.h"
+#include "common/uring.h"
+
 /* Name of the utility program. */
 #define PROGRAM_NAME "acrescenta"
 
@@ -27,13 +38,19 @@
 
 /* Help message explaining usage. */
 #define HELP_MESSAGE                                                        \
-  "Usage: acrescenta <file_with_contents> <destination>\n"                  \
+  "Usage: acrescenta [--fila N] <file_with_contents> <destination>\n"       \
   "Appends content of a file to another file.\n"                            \
   "Arguments:\n"                                                            \
   "  <file_with_contents>  The file with the contents to append.\n"         \
   "  <destination>         The file where the contents will be appended.\n" \
   "\n"                                                                      \
   "Options:\n"                                                              \
+  "  --fila N    Append through io_uring with N reads and writes in\n"      \
+  "              flight, up to 256. Falls back to read() and write()\n"     \
+  "              when io_uring is not available. The contents are\n"       \
+  "              written after the end the destination had when the\n"     \
+  "              append started, so it is not atomic against other\n"      \
+  "              processes appending to the same file.\n"                  \
   "  --help      Display this help message.\n"
 
 /**
@@ -51,7 +68,7 @@
  * @return false If an error occurred during cleanup (i.e., one or both file
  *               descriptors failed to close).
  */
-bool cleanup(int src_fd, int dest_fd) {
+static bool cleanup(int src_fd, int dest_fd) {
   bool success = true;  // Initialize success flag
 
   if (src_fd != -1) {
@@ -84,22 +101,34 @@ bool cleanup(int src_fd, int dest_fd) {
  * @return Returns 0 if the file is successfully copied. If an error occurs,
  * returns 1.
  */
-int main(const int argc, const char *argv[]) {
+int acrescenta_main(const int argc, const char *argv[]) {
   // Display help command
   if ((argc == 2) && (strcmp(argv[1], "--help") == 0)) {
     fputs(HELP_MESSAGE, stdout);
     return EXIT_SUCCESS;
   }
 
+  // Read the number of operations in flight through io_uring
+  unsigned ring_depth = 0;
+  int arg = 1;
+  if (argc > 2 && strcmp(argv[1], "--fila") == 0) {
+    ring_depth = parseRingDepth(argv[2]);
+    if (ring_depth == 0) {
+      fprintf(stderr, "Error: Invalid queue depth '%s'.\n", argv[2]);
+      return EXIT_FAILURE;
+    }
+    arg = 3;
+  }
+
   // Control incorrect usage
-  if (argc < 3) {
+  if (argc - arg < 2) {
     fputs("Error: Incorrect usage.\n", stderr);
     fputs(HELP_MESSAGE, stderr);
     return EXIT_FAILURE;
   }
 
-  const char *src_file = argv[1];
-  const char *dest_file = argv[2];
+  const char *src_file = argv[arg];
+  const char *dest_file = argv[arg + 1];
 
   // Open source file in read-only mode
   int src_fd = open(src_file, O_RDONLY);
@@ -116,6 +145,32 @@ int main(const int argc, const char *argv[]) {
     return EXIT_FAILURE;
   }
 
+  // Append between regular files through io_uring, which writes at explicit
+  // offsets after the end, so O_APPEND is cleared while it runs. The end is
+  // read once it is cleared, and data other processes append from then on
+  // may be overwritten, as the help message says
+  struct stat src_stat, dest_stat;
+  int dest_flags = fcntl(dest_fd, F_GETFL);
+  if (ring_depth > 0 && dest_flags != -1 && fstat(src_fd, &src_stat) == 0 &&
+      S_ISREG(src_stat.st_mode) &&
+      fcntl(dest_fd, F_SETFL, dest_flags & ~O_APPEND) == 0 &&
+      fstat(dest_fd, &dest_stat) == 0 && S_ISREG(dest_stat.st_mode)) {
+    off_t copied;
+    int result = copyWithRing(src_fd, 0, dest_fd, dest_stat.st_size,
+                              src_stat.st_size, ring_depth, &copied);
+    if (result == -1) {
+      perror("Error writing to file");
+      cleanup(src_fd, dest_fd);
+      return EXIT_FAILURE;
+    }
+    if (result == 0) {
+      return cleanup(src_fd, dest_fd) ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+  }
+  if (ring_depth > 0 && dest_flags != -1) {
+    fcntl(dest_fd, F_SETFL, dest_flags);  // Not available, append below
+  }
+
   // Read data from source file and append to destination file
   char buffer[BUFFER_SIZE_BYTES];
   ssize_t bytes_read;
@@ -142,3 +197,16 @@ int main(const int argc, const char *argv[]) {
 
   return EXIT_SUCCESS;
 }
+
+#ifndef COMMAND_LIBRARY
+/**
+ * @brief Entry point of the standalone `acrescenta` program.
+ *
+ * @param argc The number of command-line arguments passed to the program.
+ * @param argv An array of strings containing the command-line arguments.
+ * @return int The exit status returned by acrescenta_main().
+ */
+int main(const int argc, const char *argv[]) {
+  return acrescenta_main(argc, argv);
+}
+#endif
@@ -14,6 +14,10 @@
  *
  * @copyright Copyright (c) 2024
  *
+ * @section Modifications
+ * - 2026-10-16: The program logic moved to apaga_main() so the interpreter can
+ *               run the command in-process.
+ *   Enrique George Rodrigues (a28602@alunos.ipca.pt)
  */
 #define _XOPEN_SOURCE 700
 
@@ -23,6 +27,8 @@
 #include <string.h>
 #include <unistd.h>
 
+#include "commands.h"
+
 /* Name of the utility program. */
 #define PROGRAM_NAME "apaga"
 
@@ -53,7 +59,7 @@
  * because the file is in use, the program prints the error using perror (see
  * the errno.h header for more information) and returns 1.
  */
-int main(const int argc, const char *argv[]) {
+int apaga_main(const int argc, const char *argv[]) {
   // Control incorrect usage
   if (argc < 2) {
     fputs("Error: Incorrect usage.\n", stderr);
@@ -77,3 +83,14 @@ int main(const int argc, const char *argv[]) {
 
   return EXIT_SUCCESS;
 }
+
+#ifndef COMMAND_LIBRARY
+/**
+ * @brief Entry point of the standalone `apaga` program.
+ *
+ * @param argc The number of command-line arguments passed to the program.
+ * @param argv An array of strings containing the command-line arguments.
+ * @return int The exit status returned by apaga_main().
+ */
+int main(const int argc, const char *argv[]) { return apaga_main(argc, argv); }
+#endif
@@ -0,0 +1,333 @@
+/**
+ * @file uring.c
+ * @author Enrique Rodrigues (a28602@alunos.ipca.pt)
+ * @brief Contains the io_uring engine shared by the commands.
+ * @version 0.1
+ * @date 2026-10-16
+ * @copyright Copyright (c) 2024
+ */
+#define _GNU_SOURCE
+
+#include "uring.h"
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+/* Alignment of the buffers, so they also suit files opened with O_DIRECT */
+#define BUFFER_ALIGNMENT 4096
+
+/**
+ * @brief Structure that holds a buffer of copyWithRing() in flight.
+ */
+typedef struct RingSlot {
+  off_t start;           // offset of the buffer in the range
+  size_t length;         // bytes requested
+  int completions_left;  // completions not received yet, of 2
+  int read_result;       // bytes read, or minus the error number
+  int write_result;      // bytes written, or minus the error number
+  bool busy;             // whether the buffer is in flight
+} RingSlot;
+
+void freeRing(Ring *ring) {
+  if (ring->sqes != NULL && ring->sqes != MAP_FAILED) {
+    munmap(ring->sqes, ring->sqes_size);
+  }
+  if (ring->cq_ptr != NULL && ring->cq_ptr != MAP_FAILED &&
+      ring->cq_ptr != ring->sq_ptr) {
+    munmap(ring->cq_ptr, ring->cq_size);
+  }
+  if (ring->sq_ptr != NULL && ring->sq_ptr != MAP_FAILED) {
+    munmap(ring->sq_ptr, ring->sq_size);
+  }
+  close(ring->fd);
+}
+
+bool setupRing(Ring *ring, unsigned entries) {
+  struct io_uring_params params;
+  memset(&params, 0, sizeof(params));
+  memset(ring, 0, sizeof(*ring));
+  ring->fd = (int)syscall(__NR_io_uring_setup, entries, &params);
+  if (ring->fd == -1) {
+    return false;
+  }
+
+  // Kernels with a single mapping share it between both queues
+  ring->sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  ring->cq_size = params.cq_off.cqes +
+                  params.cq_entries * sizeof(struct io_uring_cqe);
+  bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+  if (single_mmap && ring->cq_size > ring->sq_size) {
+    ring->sq_size = ring->cq_size;
+  }
+  ring->sq_ptr = mmap(NULL, ring->sq_size, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQ_RING);
+  ring->cq_ptr = single_mmap ? ring->sq_ptr
+                             : mmap(NULL, ring->cq_size,
+                                    PROT_READ | PROT_WRITE,
+                                    MAP_SHARED | MAP_POPULATE, ring->fd,
+                                    IORING_OFF_CQ_RING);
+  ring->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+  ring->sqes = mmap(NULL, ring->sqes_size, PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQES);
+  if (ring->sq_ptr == MAP_FAILED || ring->cq_ptr == MAP_FAILED ||
+      ring->sqes == MAP_FAILED) {
+    freeRing(ring);
+    return false;
+  }
+
+  char *sq = ring->sq_ptr;
+  char *cq = ring->cq_ptr;
+  ring->sq_tail = (unsigned *)(sq + params.sq_off.tail);
+  ring->sq_mask = (unsigned *)(sq + params.sq_off.ring_mask);
+  ring->sq_array = (unsigned *)(sq + params.sq_off.array);
+  ring->cq_head = (unsigned *)(cq + params.cq_off.head);
+  ring->cq_tail = (unsigned *)(cq + params.cq_off.tail);
+  ring->cq_mask = (unsigned *)(cq + params.cq_off.ring_mask);
+  ring->cqes = (struct io_uring_cqe *)(cq + params.cq_off.cqes);
+  return true;
+}
+
+bool registerRingBuffers(Ring *ring, char *buffers, unsigned count,
+                         size_t size) {
+  struct iovec *vectors = malloc(count * sizeof(struct iovec));
+  if (vectors == NULL) {
+    return false;
+  }
+  for (unsigned i = 0; i < count; i++) {
+    vectors[i].iov_base = buffers + (size_t)i * size;
+    vectors[i].iov_len = size;
+  }
+  long result = syscall(__NR_io_uring_register, ring->fd,
+                        IORING_REGISTER_BUFFERS, vectors, count);
+  free(vectors);
+  if (result == -1) {
+    return false;
+  }
+  ring->buffers = buffers;
+  ring->buffer_size = size;
+  ring->buffer_count = count;
+  return true;
+}
+
+void queueTransfer(Ring *ring, bool write, int fd, char *buffer,
+                   size_t length, off_t offset, bool linked,
+                   unsigned long long user_data) {
+  unsigned tail = *ring->sq_tail;
+  unsigned index = tail & *ring->sq_mask;
+  struct io_uring_sqe *sqe = &ring->sqes[index];
+  memset(sqe, 0, sizeof(*sqe));
+  sqe->opcode = write ? IORING_OP_WRITE : IORING_OP_READ;
+  if (ring->buffers != NULL && buffer >= ring->buffers &&
+      buffer < ring->buffers + ring->buffer_count * ring->buffer_size) {
+    sqe->opcode = write ? IORING_OP_WRITE_FIXED : IORING_OP_READ_FIXED;
+    sqe->buf_index = (buffer - ring->buffers) / ring->buffer_size;
+  }
+  sqe->flags = linked ? IOSQE_IO_LINK : 0;
+  sqe->fd = fd;
+  sqe->addr = (unsigned long long)(uintptr_t)buffer;
+  sqe->len = length;
+  sqe->off = offset;
+  sqe->user_data = user_data;
+  ring->sq_array[index] = index;
+
+  // The kernel must see the entry before the new tail
+  __atomic_store_n(ring->sq_tail, tail + 1, __ATOMIC_RELEASE);
+  ring->to_submit++;
+}
+
+int submitAndWait(Ring *ring) {
+  while (1) {
+    long submitted = syscall(__NR_io_uring_enter, ring->fd, ring->to_submit,
+                             1, IORING_ENTER_GETEVENTS, NULL, 0);
+    if (submitted >= 0) {
+      ring->to_submit -= submitted;
+      return 0;
+    }
+    if (errno != EINTR) {
+      return -1;
+    }
+  }
+}
+
+bool nextCompletion(Ring *ring, struct io_uring_cqe *completion) {
+  unsigned head = *ring->cq_head;
+  if (head == __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE)) {
+    return false;
+  }
+  *completion = ring->cqes[head & *ring->cq_mask];
+  __atomic_store_n(ring->cq_head, head + 1, __ATOMIC_RELEASE);
+  return true;
+}
+
+unsigned parseRingDepth(const char *text) {
+  char *end;
+  errno = 0;
+  long depth = strtol(text, &end, 10);
+  if (errno != 0 || end == text || *end != '\0' || depth < 1 ||
+      depth > RING_MAX_DEPTH) {
+    return 0;
+  }
+  return (unsigned)depth;
+}
+
+/**
+ * @brief Finishes a buffer whose read or write came up short, with pread()
+ * and pwrite().
+ *
+ * A short read cancels the linked write, so the bytes that were read are
+ * written here, and the rest of the buffer is copied until the source
+ * ends.
+ *
+ * @param src_fd The source file.
+ * @param src_offset The offset of the buffer in the source.
+ * @param dest_fd The destination file.
+ * @param dest_offset The offset of the buffer in the destination.
+ * @param buffer The buffer, holding the bytes already read.
+ * @param slot The buffer in flight.
+ * @return off_t The bytes of the buffer copied, fewer than its length if the
+ * source ended first, or -1 on error.
+ */
+static off_t finishSlot(int src_fd, off_t src_offset, int dest_fd,
+                        off_t dest_offset, char *buffer,
+                        const RingSlot *slot) {
+  size_t done = 0;       // bytes of the buffer in the destination
+  size_t available = 0;  // bytes of the buffer read
+  if (slot->read_result == (int)slot->length && slot->write_result >= 0) {
+    done = slot->write_result;
+    available = slot->length;
+  } else if (slot->read_result >= 0 &&
+             slot->read_result < (int)slot->length) {
+    available = slot->read_result;
+  } else {
+    errno = (slot->read_result < 0) ? -slot->read_result
+                                    : -slot->write_result;
+    return -1;
+  }
+
+  while (done < slot->length) {
+    if (done == available) {
+      ssize_t bytes = pread(src_fd, buffer + available,
+                            slot->length - available,
+                            src_offset + (off_t)available);
+      if (bytes == -1) {
+        return -1;
+      } else if (bytes == 0) {
+        return done;  // The source ended
+      }
+      available += bytes;
+    }
+    ssize_t bytes = pwrite(dest_fd, buffer + done, available - done,
+                           dest_offset + (off_t)done);
+    if (bytes == -1) {
+      return -1;
+    }
+    done += bytes;
+  }
+  return done;
+}
+
+int copyWithRing(int src_fd, off_t src_offset, int dest_fd, off_t dest_offset,
+                 off_t length, unsigned depth, off_t *copied) {
+  *copied = 0;
+  off_t buffer_count = (length + RING_BUFFER_BYTES - 1) / RING_BUFFER_BYTES;
+  if (buffer_count < (off_t)depth) {
+    depth = (buffer_count > 0) ? (unsigned)buffer_count : 1;
+  }
+
+  Ring ring;
+  char *buffers;
+  RingSlot *slots = calloc(depth, sizeof(RingSlot));
+  if (slots == NULL ||
+      posix_memalign((void **)&buffers, BUFFER_ALIGNMENT,
+                     (size_t)depth * RING_BUFFER_BYTES) != 0) {
+    free(slots);
+    errno = ENOMEM;
+    return -1;
+  }
+  if (!setupRing(&ring, 2 * depth)) {
+    free(buffers);
+    free(slots);
+    return 1;
+  }
+  registerRingBuffers(&ring, buffers, depth, RING_BUFFER_BYTES);
+
+  off_t next = 0;       // offset in the range of the next buffer to queue
+  off_t end = length;   // end of the range, earlier if the source ends
+  unsigned in_flight = 0;
+  int error = 0;
+  while (1) {
+    // Queue a read and its linked write for each free buffer
+    for (unsigned i = 0; i < depth && error == 0 && next < end; i++) {
+      RingSlot *slot = &slots[i];
+      if (slot->busy) {
+        continue;
+      }
+      char *buffer = buffers + (size_t)i * RING_BUFFER_BYTES;
+      slot->start = next;
+      slot->length = (end - next < RING_BUFFER_BYTES) ? (size_t)(end - next)
+                                                      : RING_BUFFER_BYTES;
+      slot->completions_left = 2;
+      slot->busy = true;
+      queueTransfer(&ring, false, src_fd, buffer, slot->length,
+                    src_offset + next, true, 2 * i);
+      queueTransfer(&ring, true, dest_fd, buffer, slot->length,
+                    dest_offset + next, false, 2 * i + 1);
+      next += slot->length;
+      in_flight++;
+    }
+    if (in_flight == 0) {
+      break;
+    }
+
+    // The kernel keeps using the buffers, so stop only on a fatal error
+    if (submitAndWait(&ring) == -1) {
+      error = errno;
+      break;
+    }
+    struct io_uring_cqe completion;
+    while (nextCompletion(&ring, &completion)) {
+      unsigned index = completion.user_data / 2;
+      RingSlot *slot = &slots[index];
+      if (completion.user_data % 2 == 0) {
+        slot->read_result = completion.res;
+      } else {
+        slot->write_result = completion.res;
+      }
+      if (--slot->completions_left > 0) {
+        continue;
+      }
+
+      slot->busy = false;
+      in_flight--;
+      if (slot->read_result == (int)slot->length &&
+          slot->write_result == (int)slot->length) {
+        continue;
+      }
+      off_t done = finishSlot(src_fd, src_offset + slot->start, dest_fd,
+                              dest_offset + slot->start,
+                              buffers + (size_t)index * RING_BUFFER_BYTES,
+                              slot);
+      if (done == -1) {
+        error = (error == 0) ? errno : error;
+      } else if (done < (off_t)slot->length && slot->start + done < end) {
+        end = slot->start + done;
+      }
+    }
+  }
+
+  freeRing(&ring);
+  free(buffers);
+  free(slots);
+  if (error != 0) {
+    errno = error;
+    return -1;
+  }
+  *copied = end;
+  return 0;
+}
@@ -0,0 +1,159 @@
+/**
+ * @file uring.h
+ * @author Enrique Rodrigues (a28602@alunos.ipca.pt)
+ * @brief Header file for the io_uring engine shared by the commands.
+ *
+ * `copia`, `acrescenta` and `mostra` move data through an io_uring instance
+ * set up with the raw system calls, so no library is needed. The engine
+ * keeps a number of reads and writes in flight, each with a buffer
+ * registered with the kernel, and links the write of a buffer to its read.
+ *
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef URING_H
+#define URING_H
+
+#include <linux/io_uring.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <sys/types.h>
+
+/* Number of operations in flight when no other number is given */
+#define RING_DEFAULT_DEPTH 16
+
+/* Largest number of operations in flight */
+#define RING_MAX_DEPTH 256
+
+/* Size of each buffer of the engine */
+#define RING_BUFFER_BYTES (128 * 1024)  // 128KB per read or write
+
+/**
+ * @brief Structure that holds an io_uring instance and its mapped queues.
+ */
+typedef struct Ring {
+  int fd;                      // descriptor of the instance
+  void *sq_ptr;                // mapping of the submission queue
+  void *cq_ptr;                // mapping of the completion queue
+  struct io_uring_sqe *sqes;   // mapping of the submission entries
+  size_t sq_size;              // size of `sq_ptr`
+  size_t cq_size;              // size of `cq_ptr`
+  size_t sqes_size;            // size of `sqes`
+  unsigned *sq_tail;           // tail of the submission queue
+  unsigned *sq_mask;           // mask of submission queue indexes
+  unsigned *sq_array;          // indexes of the submitted entries
+  unsigned *cq_head;           // head of the completion queue
+  unsigned *cq_tail;           // tail of the completion queue
+  unsigned *cq_mask;           // mask of completion queue indexes
+  struct io_uring_cqe *cqes;   // completion entries
+  unsigned to_submit;          // entries queued and not submitted yet
+  char *buffers;               // registered buffers, or NULL
+  size_t buffer_size;          // size of each registered buffer
+  unsigned buffer_count;       // number of registered buffers
+} Ring;
+
+/**
+ * @brief Creates an io_uring instance and maps its queues.
+ *
+ * @param ring The ring to set up.
+ * @param entries The number of entries of the submission queue.
+ * @return true on success, false if io_uring is not available.
+ */
+bool setupRing(Ring *ring, unsigned entries);
+
+/**
+ * @brief Unmaps the queues of an io_uring instance and closes it.
+ *
+ * @param ring The ring.
+ */
+void freeRing(Ring *ring);
+
+/**
+ * @brief Registers contiguous buffers with the kernel, so reads and writes
+ * into them skip mapping their pages each time.
+ *
+ * Registering can fail, for example when it exceeds the limit of locked
+ * memory of older kernels, and the buffers can then still be used without
+ * being registered.
+ *
+ * @param ring The ring.
+ * @param buffers The first buffer, followed by the others.
+ * @param count The number of buffers.
+ * @param size The size of each buffer.
+ * @return true if the buffers were registered, false otherwise.
+ */
+bool registerRingBuffers(Ring *ring, char *buffers, unsigned count,
+                         size_t size);
+
+/**
+ * @brief Queues a read or a write in the submission queue.
+ *
+ * Buffers registered with registerRingBuffers() are read or written with
+ * their fixed version. The queue must have a free entry.
+ *
+ * @param ring The ring.
+ * @param write true for a write, false for a read.
+ * @param fd The descriptor to read or write.
+ * @param buffer The buffer.
+ * @param length The number of bytes.
+ * @param offset The offset in the file.
+ * @param linked true if the next entry only starts once this one completed
+ * in full, and is cancelled otherwise.
+ * @param user_data The value returned with the completion.
+ */
+void queueTransfer(Ring *ring, bool write, int fd, char *buffer,
+                   size_t length, off_t offset, bool linked,
+                   unsigned long long user_data);
+
+/**
+ * @brief Submits the queued entries and waits for at least one completion.
+ *
+ * @param ring The ring.
+ * @return int 0 on success or -1 on error.
+ */
+int submitAndWait(Ring *ring);
+
+/**
+ * @brief Takes the next completion from the completion queue.
+ *
+ * @param ring The ring.
+ * @param completion Receives the completion.
+ * @return true if there was a completion, false otherwise.
+ */
+bool nextCompletion(Ring *ring, struct io_uring_cqe *completion);
+
+/**
+ * @brief Parses a number of operations in flight.
+ *
+ * @param text The text to parse.
+ * @return unsigned The number, from 1 to RING_MAX_DEPTH, or 0 if the text is
+ * not one.
+ */
+unsigned parseRingDepth(const char *text);
+
+/**
+ * @brief Copies a range of a file into another one through io_uring.
+ *
+ * The range is split into buffers, and up to `depth` of them are in flight
+ * at once, each as a read linked to the write of the same buffer, so a
+ * buffer is written as soon as it is read without waiting for the others.
+ *
+ * @param src_fd The source file.
+ * @param src_offset The offset of the range in the source.
+ * @param dest_fd The destination file, written at explicit offsets.
+ * @param dest_offset The offset the range is written at.
+ * @param length The size of the range.
+ * @param depth The number of buffers in flight.
+ * @param copied Receives the bytes copied, which are fewer than asked if the
+ * source ended first.
+ * @return int 0 on success, -1 on error, with errno set, or 1 if io_uring
+ * is not available and nothing was copied.
+ */
+int copyWithRing(int src_fd, off_t src_offset, int dest_fd, off_t dest_offset,
+                 off_t length, unsigned depth, off_t *copied);
+
+#endif /* URING_H */
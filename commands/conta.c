@@ -16,29 +16,40 @@
  *
  * @copyright Copyright (c) 2024
  *
+ * @section Modifications
+ * - 2026-10-16: The program logic moved to conta_main() so the interpreter can
+ *               run the command in-process.
+ *   Enrique George Rodrigues (a28602@alunos.ipca.pt)
+ * - 2026-10-16: Counts stdin when no file is given. Reads in larger chunks
+ *               and finds newlines with memchr().
+ *   Enrique George Rodrigues (a28602@alunos.ipca.pt)
  */
 #define _XOPEN_SOURCE 700
 
 #include <fcntl.h>
+#include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
 
+#include "commands.h"
+
 /* Name of the utility program. */
 #define PROGRAM_NAME "conta"
 
 /* Size of buffer when reading from file */
-#define BUFFER_SIZE_BYTES 4096  // 4KB buffer size
+#define BUFFER_SIZE_BYTES (128 * 1024)  // 128KB buffer size
 
 /* Help message explaining usage. */
-#define HELP_MESSAGE                              \
-  "Usage: conta <file>\n"                         \
-  "Counts the number of lines a file contains.\n" \
-  "Arguments:\n"                                  \
-  "  <file>  The file to be counted.\n"           \
-  "\n"                                            \
-  "Options:\n"                                    \
+#define HELP_MESSAGE                                                 \
+  "Usage: conta <file>\n"                                            \
+  "Counts the number of lines a file contains.\n"                    \
+  "Arguments:\n"                                                     \
+  "  <file>  The file to be counted. If omitted or '-', stdin is\n"  \
+  "          counted when it is not a terminal.\n"                   \
+  "\n"                                                               \
+  "Options:\n"                                                       \
   "  --help      Display this help message.\n"
 
 /**
@@ -59,52 +70,64 @@
  * error occurs, prints the error using perror (see the errno.h header for more
  * information) and returns 1.
  */
-int main(const int argc, const char *argv[]) {
+int conta_main(const int argc, const char *argv[]) {
   // Control incorrect usage
-  if (argc < 2) {
+  if (argc < 2 && isatty(STDIN_FILENO)) {
     fputs("Error: Incorrect usage.\n", stderr);
     fputs(HELP_MESSAGE, stderr);
     return EXIT_FAILURE;
   }
 
   // Display help command
-  if (strcmp(argv[1], "--help") == 0) {
+  if (argc >= 2 && strcmp(argv[1], "--help") == 0) {
     fputs(HELP_MESSAGE, stdout);
     return EXIT_SUCCESS;
   }
 
-  const char *src_file = argv[1];
+  const char *src_file = (argc >= 2) ? argv[1] : "-";
+  bool from_stdin = (strcmp(src_file, "-") == 0);
   int num_lines = 0;
 
   // Open the file in read-only mode
-  int fd = open(src_file, O_RDONLY);
+  int fd = from_stdin ? STDIN_FILENO : open(src_file, O_RDONLY);
   if (fd == -1) {
     perror("Error");
     return EXIT_FAILURE;
   }
 
-  char buffer[BUFFER_SIZE_BYTES];
+  char *buffer = malloc(BUFFER_SIZE_BYTES);
+  if (buffer == NULL) {
+    fputs("Error: Memory allocation failed.\n", stderr);
+    if (!from_stdin) {
+      close(fd);
+    }
+    return EXIT_FAILURE;
+  }
   ssize_t bytes_read = 0;
 
   // Read the file in chunks
-  while ((bytes_read = read(fd, buffer, sizeof(buffer))) > 0) {
-    // Iterate through buffer and count new lines
-    for (ssize_t i = 0; i < bytes_read; i++) {
-      if (buffer[i] == '\n') {
-        num_lines++;
-      }
+  while ((bytes_read = read(fd, buffer, BUFFER_SIZE_BYTES)) > 0) {
+    // Jump from newline to newline through the buffer
+    const char *end = buffer + bytes_read;
+    const char *next = buffer;
+    while ((next = memchr(next, '\n', end - next)) != NULL) {
+      num_lines++;
+      next++;
     }
   }
+  free(buffer);
 
   // Check for read error
   if (bytes_read == -1) {
     perror("Error");
-    close(fd);
+    if (!from_stdin) {
+      close(fd);
+    }
     return EXIT_FAILURE;
   }
 
   // Close the file
-  if (close(fd) == -1) {
+  if (!from_stdin && close(fd) == -1) {
     perror("Error");
     return EXIT_FAILURE;
   }
@@ -113,3 +136,14 @@ int main(const int argc, const char *argv[]) {
 
   return EXIT_SUCCESS;
 }
+
+#ifndef COMMAND_LIBRARY
+/**
+ * @brief Entry point of the standalone `conta` program.
+ *
+ * @param argc The number of command-line arguments passed to the program.
+ * @param argv An array of strings containing the command-line arguments.
+ * @return int The exit status returned by conta_main().
+ */
+int main(const int argc, const char *argv[]) { return conta_main(argc, argv); }
+#endif
@@ -16,33 +16,1698 @@
  *   Diogo Araujo Machado (a26042@alunos.ipca.pt)
  * - 2024-04-23: Improved memory & pointer safety.
  *   Enrique George Rodrigues (a28602@alunos.ipca.pt)
+ * - 2026-10-16: The program logic moved to copia_main() so the interpreter can
+ *               run the command in-process.
+ *   Enrique George Rodrigues (a28602@alunos.ipca.pt)
+ * - 2026-10-16: Copies inside the kernel with a reflink, copy_file_range() or
+ *               sendfile(), keeps the holes of sparse files, and added -v.
+ *   Enrique George Rodrigues (a28602@alunos.ipca.pt)
+ * - 2026-10-16: Added -j to copy parts of a file with several threads.
+ *   Enrique George Rodrigues (a28602@alunos.ipca.pt)
+ * - 2026-10-16: Added -r to copy directory trees with a pool of workers.
+ *   Enrique George Rodrigues (a28602@alunos.ipca.pt)
+ * - 2026-10-16: Added --sync to rewrite only the blocks of a copy that differ.
+ *   Enrique George Rodrigues (a28602@alunos.ipca.pt)
+ * - 2026-10-16: Added --fila to copy through the shared io_uring engine.
+ *   Enrique George Rodrigues (a28602@alunos.ipca.pt)
  */
-#define _XOPEN_SOURCE 700
+#define _GNU_SOURCE
 
+#include <dirent.h>
+#include <errno.h>
 #include <fcntl.h>
+#include <limits.h>
+#include <linux/fs.h>
+#include <pthread.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/sendfile.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
 #include <unistd.h>
 
+#include "commands.h"
+#include "common/uring.h"
+
 /* Name of the utility program. */
 #define PROGRAM_NAME "copia"
 
 /* Size of buffer when reading from file */
-#define BUFFER_SIZE_BYTES 4096  // 4KB buffer size
+#define BUFFER_SIZE_BYTES (1024 * 1024)  // 1MB buffer size
+
+/* Alignment of the buffer, so it also suits files opened with O_DIRECT */
+#define BUFFER_ALIGNMENT 4096
+
+/* Maximum number of bytes copied by each copy_file_range() or sendfile() */
+#define COPY_CHUNK_BYTES (64 * 1024 * 1024)  // 64MB per call
+
+/* Size of the parts of a file copied by each thread with -j */
+#define PART_BYTES (32 * 1024 * 1024)  // 32MB per part
+
+/* Maximum number of threads of a parallel copy */
+#define MAX_JOBS 64
+
+/* Size of the buffer directories are read into, in a few calls each. */
+#define DIRENT_BUFFER_SIZE_BYTES (64 * 1024)
+
+/* Most entries copied by one task of a tree copy */
+#define BATCH_FILES 64
+
+/* Size of the names of the entries copied by one task of a tree copy */
+#define BATCH_NAME_BYTES 4096
+
+/* Size of the blocks --sync compares and rewrites */
+#define SYNC_BLOCK_BYTES (64 * 1024)
+
+/* Size of the windows of the files --sync maps at once */
+#define SYNC_WINDOW_BYTES (64 * 1024 * 1024)
 
 /* Help message explaining usage. */
-#define HELP_MESSAGE                                           \
-  "Usage: copia <filename> <destination file>\n"               \
-  "Creates a copy of a given file.\n"                          \
-  "Arguments:\n"                                               \
-  "  <file_name>  The name of the file to create a copy of.\n" \
-  "  (copy_name)  The name of the copy (optional).\n"          \
-  "\n"                                                         \
-  "Options:\n"                                                 \
+#define HELP_MESSAGE                                                 \
+  "Usage: copia [-v] [-r] [-j threads] <filename> <destination>\n"   \
+  "Creates a copy of a given file or directory tree.\n"              \
+  "Arguments:\n"                                                     \
+  "  <file_name>  The name of the file to create a copy of.\n"       \
+  "  (copy_name)  The name of the copy (optional).\n"                \
+  "\n"                                                               \
+  "Options:\n"                                                       \
+  "  -v          Print how the file was copied: reflink,\n"          \
+  "              copy_file_range, sendfile or read/write.\n"         \
+  "  -j threads  Copy parts of the file with several threads at\n"   \
+  "              once, up to 64 (default: 1), or the number of\n"    \
+  "              workers of a tree copy (default: one for each\n"    \
+  "              processor).\n"                                      \
+  "  -r          Copy a directory and everything in it, with the\n"  \
+  "              permissions and times of each entry.\n"             \
+  "  --sync      Only rewrite the blocks of an existing copy that\n" \
+  "              differ, and skip copies that have the size and\n"   \
+  "              modification time of their source.\n"               \
+  "  --fila N    Copy through io_uring with N reads and writes in\n" \
+  "              flight, up to 256, or in the kernel when it is\n"   \
+  "              not available. Only used for single files.\n"       \
   "  --help      Display this help message.\n"
 
+/**
+ * @brief Ways of copying the data, from the fastest to the slowest.
+ */
+typedef enum CopyStrategy {
+  COPY_REFLINK,     // the copy shares the blocks of the source (FICLONE)
+  COPY_FILE_RANGE,  // copy_file_range(), inside the kernel
+  COPY_SENDFILE,    // sendfile(), inside the kernel
+  COPY_URING,       // reads and writes through io_uring, with --fila
+  COPY_BUFFER       // pread() and pwrite() through a buffer
+} CopyStrategy;
+
+/* Names of the strategies printed with -v, in the order of CopyStrategy. */
+static const char *const STRATEGY_NAMES[] = {
+    "reflink", "copy_file_range", "sendfile", "io_uring", "read/write"};
+
+/**
+ * @brief Structure that holds what a copy did.
+ */
+typedef struct CopyStats {
+  CopyStrategy strategy;  // slowest strategy used
+  off_t data_bytes;       // bytes of data copied
+  off_t hole_bytes;       // bytes of holes kept as holes
+  off_t same_bytes;       // bytes --sync found already equal
+} CopyStats;
+
+/**
+ * @brief Returns whether an error means a strategy is not supported for
+ * these files, so the next one should be tried.
+ *
+ * @param error The error number.
+ * @return true if the error is a lack of support, false otherwise.
+ */
+static bool isUnsupported(int error) {
+  return (error == EXDEV || error == EINVAL || error == ENOSYS ||
+          error == EOPNOTSUPP || error == ENOTTY || error == EBADF);
+}
+
+/**
+ * @brief Parses the number of threads given to -j.
+ *
+ * @param text The text to parse.
+ * @return int The number of threads, from 1 to MAX_JOBS, or -1 if the text
+ * is not one.
+ */
+static int parseJobs(const char *text) {
+  char *end;
+  errno = 0;
+  long jobs = strtol(text, &end, 10);
+  if (errno != 0 || end == text || *end != '\0' || jobs < 1 ||
+      jobs > MAX_JOBS) {
+    return -1;
+  }
+  return (int)jobs;
+}
+
+/**
+ * @brief Copies a range of bytes through a buffer.
+ *
+ * @param src_fd The source file.
+ * @param dest_fd The destination file.
+ * @param start The offset of the first byte.
+ * @param end The offset after the last byte.
+ * @return off_t The bytes copied, which are fewer than asked if the source
+ * ended first, or -1 on error.
+ */
+static off_t copyWithBuffer(int src_fd, int dest_fd, off_t start, off_t end) {
+  char *buffer;
+  if (posix_memalign((void **)&buffer, BUFFER_ALIGNMENT,
+                     BUFFER_SIZE_BYTES) != 0) {
+    errno = ENOMEM;
+    return -1;
+  }
+
+  off_t offset = start;
+  while (offset < end) {
+    size_t length = (end - offset < BUFFER_SIZE_BYTES) ? end - offset
+                                                       : BUFFER_SIZE_BYTES;
+    ssize_t bytes_read = pread(src_fd, buffer, length, offset);
+    if (bytes_read <= 0) {
+      free(buffer);
+      return (bytes_read == 0) ? offset - start : -1;
+    }
+    for (ssize_t written = 0; written < bytes_read;) {
+      ssize_t result = pwrite(dest_fd, buffer + written, bytes_read - written,
+                              offset + written);
+      if (result == -1) {
+        free(buffer);
+        return -1;
+      }
+      written += result;
+    }
+    offset += bytes_read;
+  }
+  free(buffer);
+  return offset - start;
+}
+
+/**
+ * @brief Copies a range of bytes at the same offsets, with the fastest
+ * strategy these files support.
+ *
+ * copy_file_range() is tried first, then sendfile(), then a buffer. A
+ * strategy that turns out to be unsupported is not tried again for the
+ * rest of the copy.
+ *
+ * @param src_fd The source file.
+ * @param dest_fd The destination file.
+ * @param start The offset of the first byte.
+ * @param end The offset after the last byte.
+ * @param shared true if other threads write to the destination too, so
+ * sendfile(), which moves the offset of the destination, is skipped.
+ * @param strategy The fastest strategy to try, updated to the one used.
+ * @return off_t The bytes copied, which are fewer than asked if the source
+ * ended first, or -1 on error.
+ */
+static off_t copyRange(int src_fd, int dest_fd, off_t start, off_t end,
+                       bool shared, CopyStrategy *strategy) {
+  off_t offset = start;
+
+  while (*strategy == COPY_FILE_RANGE && offset < end) {
+    loff_t in_offset = offset, out_offset = offset;
+    size_t length = (end - offset < COPY_CHUNK_BYTES) ? end - offset
+                                                      : COPY_CHUNK_BYTES;
+    ssize_t copied = copy_file_range(src_fd, &in_offset, dest_fd, &out_offset,
+                                     length, 0);
+    if (copied == 0) {
+      return offset - start;
+    } else if (copied > 0) {
+      offset += copied;
+    } else if (isUnsupported(errno)) {
+      *strategy = COPY_SENDFILE;
+    } else {
+      return -1;
+    }
+  }
+
+  // sendfile() writes at the offset of the destination
+  if (*strategy == COPY_SENDFILE && shared) {
+    *strategy = COPY_BUFFER;
+  }
+  if (*strategy == COPY_SENDFILE && offset < end &&
+      lseek(dest_fd, offset, SEEK_SET) == -1) {
+    return -1;
+  }
+  while (*strategy == COPY_SENDFILE && offset < end) {
+    off_t in_offset = offset;
+    size_t length = (end - offset < COPY_CHUNK_BYTES) ? end - offset
+                                                      : COPY_CHUNK_BYTES;
+    ssize_t copied = sendfile(dest_fd, src_fd, &in_offset, length);
+    if (copied == 0) {
+      return offset - start;
+    } else if (copied > 0) {
+      offset += copied;
+    } else if (isUnsupported(errno)) {
+      *strategy = COPY_BUFFER;
+    } else {
+      return -1;
+    }
+  }
+
+  if (offset < end) {
+    off_t copied = copyWithBuffer(src_fd, dest_fd, offset, end);
+    return (copied == -1) ? -1 : offset - start + copied;
+  }
+  return offset - start;
+}
+
+/**
+ * @brief Copies everything a source gives until its end, for sources and
+ * destinations that are not regular files, like pipes or /proc files.
+ *
+ * @param src_fd The source.
+ * @param dest_fd The destination.
+ * @param stats Receives what the copy did.
+ * @return int 0 on success or -1 on error.
+ */
+static int copyStream(int src_fd, int dest_fd, CopyStats *stats) {
+  stats->strategy = COPY_SENDFILE;
+  while (true) {
+    ssize_t copied = sendfile(dest_fd, src_fd, NULL, COPY_CHUNK_BYTES);
+    if (copied == 0) {
+      return 0;
+    } else if (copied > 0) {
+      stats->data_bytes += copied;
+    } else if (isUnsupported(errno) && stats->data_bytes == 0) {
+      break;
+    } else {
+      return -1;
+    }
+  }
+
+  stats->strategy = COPY_BUFFER;
+  char *buffer = malloc(BUFFER_SIZE_BYTES);
+  if (buffer == NULL) {
+    return -1;
+  }
+  ssize_t bytes_read;
+  while ((bytes_read = read(src_fd, buffer, BUFFER_SIZE_BYTES)) > 0) {
+    for (ssize_t written = 0; written < bytes_read;) {
+      ssize_t result = write(dest_fd, buffer + written, bytes_read - written);
+      if (result == -1) {
+        free(buffer);
+        return -1;
+      }
+      written += result;
+    }
+    stats->data_bytes += bytes_read;
+  }
+  free(buffer);
+  return (bytes_read == -1) ? -1 : 0;
+}
+
+/**
+ * @brief Copies the data regions of part of a file at the same offsets.
+ *
+ * The regions are found with SEEK_DATA and SEEK_HOLE, so the holes between
+ * them stay holes in the copy. When the file system cannot report holes the
+ * whole part is copied.
+ *
+ * @param src_fd The source file.
+ * @param dest_fd The destination file.
+ * @param start The offset of the first byte of the part.
+ * @param end The offset after the last byte of the part.
+ * @param shared true if other threads write to the destination too.
+ * @param ring_depth The number of buffers in flight through io_uring, or 0
+ * to copy with copyRange(), which is also used when io_uring is not
+ * available.
+ * @param stats Receives the bytes copied and skipped, and the strategy used.
+ * @return int 0 on success or -1 on error.
+ */
+static int copyDataRegions(int src_fd, int dest_fd, off_t start, off_t end,
+                           bool shared, unsigned ring_depth,
+                           CopyStats *stats) {
+  off_t offset = start;
+  while (offset < end) {
+    // Find the next region of data, or copy everything if holes are unknown
+    off_t data_start = lseek(src_fd, offset, SEEK_DATA);
+    off_t data_end = (data_start == -1)
+                         ? -1
+                         : lseek(src_fd, data_start, SEEK_HOLE);
+    if (data_start == -1 && errno == ENXIO) {
+      break;  // Only a hole is left
+    } else if (data_start == -1 || data_end == -1) {
+      data_start = offset;
+      data_end = end;
+    }
+    if (data_start >= end) {
+      break;  // The next region belongs to another part
+    }
+    if (data_end > end) {
+      data_end = end;
+    }
+
+    off_t copied = -1;
+    int ring_result = (ring_depth == 0)
+                          ? 1
+                          : copyWithRing(src_fd, data_start, dest_fd,
+                                         data_start, data_end - data_start,
+                                         ring_depth, &copied);
+    if (ring_result == 1) {
+      ring_depth = 0;  // Not available, so not tried for the next regions
+      copied = copyRange(src_fd, dest_fd, data_start, data_end, shared,
+                         &stats->strategy);
+    } else if (ring_result == 0 && stats->strategy < COPY_URING) {
+      stats->strategy = COPY_URING;
+    }
+    if (ring_result == -1 || copied == -1) {
+      return -1;
+    }
+    stats->hole_bytes += data_start - offset;
+    stats->data_bytes += copied;
+    offset = data_start + copied;
+    if (copied < data_end - data_start) {
+      return 0;  // The source became shorter
+    }
+  }
+  stats->hole_bytes += end - offset;
+  return 0;
+}
+
+/**
+ * @brief Structure that holds one part of a file copied by a thread.
+ */
+typedef struct CopyPart {
+  off_t start;  // offset of the first byte
+  off_t end;    // offset after the last byte
+  int error;    // errno of the failure, or 0 if the part was copied
+} CopyPart;
+
+/**
+ * @brief Structure shared by the threads of a parallel copy.
+ */
+typedef struct ParallelCopy {
+  int src_fd;                 // source file
+  int dest_fd;                // destination file
+  CopyPart *parts;            // parts of the file, in order
+  size_t part_count;          // number of parts
+  size_t next_part;           // next part to copy, taken atomically
+  unsigned ring_depth;        // buffers in flight through io_uring, or 0
+  CopyStats stats[MAX_JOBS];  // what each thread did
+} ParallelCopy;
+
+/**
+ * @brief Structure that holds the argument of a copying thread.
+ */
+typedef struct CopyWorker {
+  ParallelCopy *copy;  // shared state
+  CopyStats *stats;    // what this thread did
+} CopyWorker;
+
+/**
+ * @brief Copies parts of a file until none are left.
+ *
+ * Each thread takes the next part when it finishes one, so a thread slowed
+ * down by the device does not hold the others back.
+ *
+ * @param arg The CopyWorker of the thread.
+ * @return void* NULL.
+ */
+static void *copyParts(void *arg) {
+  CopyWorker *worker = arg;
+  ParallelCopy *copy = worker->copy;
+  while (true) {
+    size_t index = __atomic_fetch_add(&copy->next_part, 1, __ATOMIC_RELAXED);
+    if (index >= copy->part_count) {
+      return NULL;
+    }
+    CopyPart *part = &copy->parts[index];
+    if (copyDataRegions(copy->src_fd, copy->dest_fd, part->start, part->end,
+                        true, copy->ring_depth, worker->stats) == -1) {
+      part->error = errno;
+    }
+  }
+}
+
+/**
+ * @brief Gives an empty destination the size of the source before parts of
+ * it are written in any order.
+ *
+ * The blocks are also reserved with posix_fallocate() unless the source is
+ * sparse, so the writers do not fragment the file.
+ *
+ * @param dest_fd The destination file.
+ * @param src_stat The status of the source.
+ * @return int 0 on success or -1 on error, including when the file system
+ * has no space for the copy.
+ */
+static int prepareDestination(int dest_fd, const struct stat *src_stat) {
+  if (ftruncate(dest_fd, src_stat->st_size) == -1) {
+    return -1;
+  }
+  if ((off_t)src_stat->st_blocks * 512 >= src_stat->st_size) {
+    // Other errors only mean the file system cannot reserve blocks
+    int error = posix_fallocate(dest_fd, 0, src_stat->st_size);
+    if (error == ENOSPC) {
+      errno = error;
+      return -1;
+    }
+  }
+  return 0;
+}
+
+/**
+ * @brief Copies a file with several threads, each copying parts of it with
+ * copy_file_range() or pread() and pwrite() at their own offsets.
+ *
+ * The destination gets the size of the source first, and its blocks are
+ * reserved with posix_fallocate() unless the source is sparse, so the
+ * threads do not extend the file or fragment it as they write. A failed
+ * part is reported with its offsets, and the other parts are still copied.
+ *
+ * @param src_fd The source file.
+ * @param src_stat The status of the source.
+ * @param dest_fd The destination file, which must be empty.
+ * @param jobs The number of threads.
+ * @param ring_depth The number of buffers each thread keeps in flight
+ * through io_uring, or 0.
+ * @param stats Receives what the copy did.
+ * @return int 0 on success, -1 on error, or 1 if some parts failed, which
+ * were already reported.
+ */
+static int copyInParallel(int src_fd, const struct stat *src_stat,
+                          int dest_fd, int jobs, unsigned ring_depth,
+                          CopyStats *stats) {
+  off_t size = src_stat->st_size;
+  if (prepareDestination(dest_fd, src_stat) == -1) {
+    return -1;
+  }
+
+  ParallelCopy *copy = calloc(1, sizeof(ParallelCopy));
+  if (copy == NULL) {
+    return -1;
+  }
+  copy->src_fd = src_fd;
+  copy->dest_fd = dest_fd;
+  copy->ring_depth = ring_depth;
+  copy->part_count = (size + PART_BYTES - 1) / PART_BYTES;
+  copy->parts = malloc(copy->part_count * sizeof(CopyPart));
+  if (copy->parts == NULL) {
+    free(copy);
+    return -1;
+  }
+  for (size_t i = 0; i < copy->part_count; i++) {
+    copy->parts[i].start = (off_t)i * PART_BYTES;
+    copy->parts[i].end = (size - copy->parts[i].start < PART_BYTES)
+                             ? size
+                             : copy->parts[i].start + PART_BYTES;
+    copy->parts[i].error = 0;
+  }
+
+  if ((size_t)jobs > copy->part_count) {
+    jobs = copy->part_count;
+  }
+  pthread_t threads[MAX_JOBS];
+  CopyWorker workers[MAX_JOBS];
+  int started = 0;
+  for (; started < jobs; started++) {
+    copy->stats[started].strategy = COPY_FILE_RANGE;
+    workers[started].copy = copy;
+    workers[started].stats = &copy->stats[started];
+    if (pthread_create(&threads[started], NULL, copyParts,
+                       &workers[started]) != 0) {
+      break;
+    }
+  }
+  if (started == 0) {
+    copyParts(&workers[0]);  // Copy in this thread instead
+    started = 1;
+  } else {
+    for (int i = 0; i < started; i++) {
+      pthread_join(threads[i], NULL);
+    }
+  }
+
+  stats->strategy = COPY_FILE_RANGE;
+  for (int i = 0; i < started; i++) {
+    stats->data_bytes += copy->stats[i].data_bytes;
+    stats->hole_bytes += copy->stats[i].hole_bytes;
+    if (copy->stats[i].strategy > stats->strategy) {
+      stats->strategy = copy->stats[i].strategy;
+    }
+  }
+
+  int result = 0;
+  for (size_t i = 0; i < copy->part_count; i++) {
+    if (copy->parts[i].error != 0) {
+      fprintf(stderr, "Error: Copying bytes %lld to %lld: %s\n",
+              (long long)copy->parts[i].start,
+              (long long)copy->parts[i].end - 1,
+              strerror(copy->parts[i].error));
+      result = 1;
+    }
+  }
+  free(copy->parts);
+  free(copy);
+  return result;
+}
+
+/**
+ * @brief Copies the contents of a file into an empty file.
+ *
+ * A reflink is tried first, which shares the blocks of the source on file
+ * systems like Btrfs and XFS, so nothing is copied. Otherwise only the data
+ * regions of the source are copied, by several threads when jobs is more
+ * than 1 and the file has more than one part.
+ *
+ * Sources that report no size, like /proc files, and destinations that are
+ * not regular files are copied as streams instead.
+ *
+ * @param src_fd The source file.
+ * @param src_stat The status of the source.
+ * @param dest_fd The destination file, which must be empty.
+ * @param jobs The number of threads.
+ * @param ring_depth The number of buffers kept in flight through io_uring,
+ * or 0 to copy in the kernel.
+ * @param stats Receives what the copy did.
+ * @return int 0 on success, -1 on error, or 1 if some parts of a parallel
+ * copy failed, which were already reported.
+ */
+static int copyFileContents(int src_fd, const struct stat *src_stat,
+                            int dest_fd, int jobs, unsigned ring_depth,
+                            CopyStats *stats) {
+  stats->data_bytes = 0;
+  stats->hole_bytes = 0;
+  stats->same_bytes = 0;
+
+  struct stat dest_stat;
+  if (fstat(dest_fd, &dest_stat) == -1) {
+    return -1;
+  }
+  off_t size = src_stat->st_size;
+  if (!S_ISREG(src_stat->st_mode) || !S_ISREG(dest_stat.st_mode) ||
+      size == 0) {
+    return copyStream(src_fd, dest_fd, stats);
+  }
+
+  stats->strategy = COPY_REFLINK;
+  if (ioctl(dest_fd, FICLONE, src_fd) == 0) {
+    stats->data_bytes = size;
+    return 0;
+  }
+  if (!isUnsupported(errno)) {
+    return -1;
+  }
+
+  if (jobs > 1 && size > PART_BYTES) {
+    return copyInParallel(src_fd, src_stat, dest_fd, jobs, ring_depth, stats);
+  }
+  stats->strategy = COPY_FILE_RANGE;
+  if (copyDataRegions(src_fd, dest_fd, 0, size, false, ring_depth, stats) ==
+      -1) {
+    return -1;
+  }
+
+  // A hole at the end is only kept by the size of the file
+  return ftruncate(dest_fd, size);
+}
+
+/**
+ * @brief Returns whether a copy is already up to date: it has the size and
+ * the modification time of the source, which --sync gives every copy.
+ *
+ * @param src_stat The status of the source.
+ * @param dest_stat The status of the copy.
+ * @return true if the copy is up to date, false otherwise.
+ */
+static bool isUpToDate(const struct stat *src_stat,
+                       const struct stat *dest_stat) {
+  return S_ISREG(dest_stat->st_mode) &&
+         dest_stat->st_size == src_stat->st_size &&
+         dest_stat->st_mtim.tv_sec == src_stat->st_mtim.tv_sec &&
+         dest_stat->st_mtim.tv_nsec == src_stat->st_mtim.tv_nsec;
+}
+
+/**
+ * @brief Rewrites the blocks of a window of a copy that differ from the
+ * source.
+ *
+ * Both windows are mapped and compared a block at a time with memcmp(),
+ * and each run of differing blocks is written with one pwrite() from the
+ * mapping of the source.
+ *
+ * @param src_fd The source file.
+ * @param dest_fd The copy, open for reading and writing.
+ * @param start The offset of the window, a multiple of the page size.
+ * @param length The size of the window.
+ * @param stats Receives the bytes rewritten and the bytes already equal.
+ * @return int 0 on success or -1 on error.
+ */
+static int syncWindow(int src_fd, int dest_fd, off_t start, size_t length,
+                      CopyStats *stats) {
+  char *source = mmap(NULL, length, PROT_READ, MAP_SHARED, src_fd, start);
+  if (source == MAP_FAILED) {
+    return -1;
+  }
+  char *copy = mmap(NULL, length, PROT_READ, MAP_SHARED, dest_fd, start);
+  if (copy == MAP_FAILED) {
+    int error = errno;
+    munmap(source, length);
+    errno = error;
+    return -1;
+  }
+  madvise(source, length, MADV_SEQUENTIAL);
+  madvise(copy, length, MADV_SEQUENTIAL);
+
+  int result = 0;
+  size_t offset = 0, run_start = 0, run_length = 0;
+  while (result == 0 && offset < length) {
+    size_t block = (length - offset < SYNC_BLOCK_BYTES) ? length - offset
+                                                        : SYNC_BLOCK_BYTES;
+    bool differs = memcmp(source + offset, copy + offset, block) != 0;
+    if (differs) {
+      run_start = (run_length == 0) ? offset : run_start;
+      run_length += block;
+    } else {
+      stats->same_bytes += block;
+    }
+    offset += block;
+    if (run_length == 0 || (differs && offset < length)) {
+      continue;
+    }
+
+    // Write the run of differing blocks that just ended
+    for (size_t written = 0; result == 0 && written < run_length;) {
+      ssize_t bytes = pwrite(dest_fd, source + run_start + written,
+                             run_length - written,
+                             start + (off_t)(run_start + written));
+      if (bytes == -1) {
+        result = -1;
+      } else {
+        written += bytes;
+      }
+    }
+    stats->data_bytes += run_length;
+    run_length = 0;
+  }
+
+  int error = errno;
+  munmap(source, length);
+  munmap(copy, length);
+  errno = error;
+  return result;
+}
+
+/**
+ * @brief Brings an existing copy up to date with its source, rewriting only
+ * the blocks that differ.
+ *
+ * The bytes both files have are compared in windows of SYNC_WINDOW_BYTES,
+ * the bytes the source has beyond the end of the copy are copied like a
+ * new file, and the copy is cut when the source is shorter. Copies that
+ * have the size and modification time of the source are left untouched.
+ *
+ * @param src_fd The source file.
+ * @param src_stat The status of the source.
+ * @param dest_fd The copy, open for reading and writing.
+ * @param stats Receives the bytes rewritten and the bytes already equal.
+ * @return int 0 on success or -1 on error.
+ */
+static int syncFileContents(int src_fd, const struct stat *src_stat,
+                            int dest_fd, CopyStats *stats) {
+  stats->strategy = COPY_FILE_RANGE;
+  stats->data_bytes = 0;
+  stats->hole_bytes = 0;
+  stats->same_bytes = 0;
+
+  struct stat dest_stat;
+  if (fstat(dest_fd, &dest_stat) == -1) {
+    return -1;
+  }
+  if (!S_ISREG(src_stat->st_mode) || !S_ISREG(dest_stat.st_mode)) {
+    return copyFileContents(src_fd, src_stat, dest_fd, 1, 0, stats);
+  }
+  if (isUpToDate(src_stat, &dest_stat)) {
+    stats->same_bytes = src_stat->st_size;
+    return 0;
+  }
+
+  off_t common = (dest_stat.st_size < src_stat->st_size) ? dest_stat.st_size
+                                                         : src_stat->st_size;
+  if (dest_stat.st_size != src_stat->st_size &&
+      ftruncate(dest_fd, src_stat->st_size) == -1) {
+    return -1;
+  }
+  for (off_t offset = 0; offset < common; offset += SYNC_WINDOW_BYTES) {
+    size_t length = (common - offset < SYNC_WINDOW_BYTES)
+                        ? (size_t)(common - offset)
+                        : SYNC_WINDOW_BYTES;
+    if (syncWindow(src_fd, dest_fd, offset, length, stats) == -1) {
+      return -1;
+    }
+  }
+  if (common < src_stat->st_size) {
+    return copyDataRegions(src_fd, dest_fd, common, src_stat->st_size, false,
+                           0, stats);
+  }
+  return 0;
+}
+
+/**
+ * @brief Structure of the entries returned by getdents64().
+ */
+typedef struct DirectoryEntry {
+  uint64_t inode;         // inode number
+  int64_t offset;         // offset of the next entry
+  unsigned short length;  // size of this entry
+  unsigned char type;     // file type, DT_UNKNOWN if the file system omits it
+  char name[];            // null-terminated name
+} DirectoryEntry;
+
+/**
+ * @brief Structure that holds a directory of a tree being copied.
+ *
+ * A directory stays open while tasks for its entries are pending, so they
+ * open their files relative to it. Its permissions and times are applied
+ * once the last of them finishes, since writing into it changes its times.
+ */
+typedef struct TreeDirectory {
+  struct TreeDirectory *parent;  // containing directory, NULL for the root
+  char *path;                    // path of the source, for messages
+  int src_fd;                    // source directory
+  int dest_fd;                   // destination directory
+  int references;                // this scan and pending tasks, atomic
+  struct stat status;            // status of the source
+} TreeDirectory;
+
+/**
+ * @brief Structure that holds a large file copied in parts by several tasks.
+ */
+typedef struct TreeFile {
+  TreeDirectory *directory;  // containing directory
+  char *name;                // name in the directory
+  int src_fd;                // source file
+  int dest_fd;               // destination file
+  int parts_left;            // parts not copied yet, atomic
+  bool failed;               // whether a part failed
+  struct stat status;        // status of the source
+} TreeFile;
+
+/**
+ * @brief Kinds of the tasks of a tree copy.
+ */
+typedef enum TaskKind {
+  TASK_DIRECTORY,  // create a directory and scan its entries
+  TASK_ENTRIES,    // copy a batch of files and symbolic links
+  TASK_PART        // copy a part of a large file
+} TaskKind;
+
+/**
+ * @brief Structure that holds a task of a tree copy.
+ *
+ * The names of a batch are stored one after the other, each preceded by its
+ * type from getdents64() and followed by a null byte.
+ */
+typedef struct TreeTask {
+  TaskKind kind;              // kind of task
+  TreeDirectory *directory;   // directory of the entries
+  TreeFile *file;             // file of a part
+  off_t start;                // offset of the first byte of a part
+  off_t end;                  // offset after the last byte of a part
+  size_t names_length;        // bytes used by the names
+  char names[];               // types and names of the entries
+} TreeTask;
+
+/**
+ * @brief Structure that holds the tasks of one worker, a double-ended
+ * queue in a ring buffer.
+ *
+ * The worker pushes and pops at the back, so it goes depth first and keeps
+ * few directories open, and other workers steal from the front, taking the
+ * oldest tasks, which tend to be the largest subtrees.
+ */
+typedef struct TaskQueue {
+  pthread_mutex_t lock;  // protects the queue
+  TreeTask **tasks;      // ring buffer of tasks
+  size_t capacity;       // size of the ring buffer
+  size_t head;           // index of the front task
+  size_t count;          // number of tasks
+} TaskQueue;
+
+/**
+ * @brief Structure that holds what a worker of a tree copy did.
+ */
+typedef struct TreeStats {
+  CopyStats copy;      // bytes copied and slowest strategy
+  long files;          // regular files copied
+  long directories;    // directories created
+  long links;          // symbolic links created
+  long unchanged;      // files --sync found up to date
+} TreeStats;
+
+struct TreePool;
+
+/**
+ * @brief Structure that holds a worker of a tree copy.
+ */
+typedef struct TreeWorker {
+  struct TreePool *pool;  // shared state
+  int index;              // index of the worker, and of its queue
+  char *dirent_buffer;    // buffer directories are read into
+  TreeStats stats;        // what the worker did
+} TreeWorker;
+
+/**
+ * @brief Structure shared by the workers of a tree copy.
+ */
+typedef struct TreePool {
+  TaskQueue queues[MAX_JOBS];    // tasks of each worker
+  TreeWorker workers[MAX_JOBS];  // workers
+  int worker_count;              // number of workers
+  pthread_mutex_t lock;          // protects the sleeping of workers
+  pthread_cond_t wake;           // signalled when a task is queued
+  size_t queued;                 // tasks in all queues, atomic
+  size_t pending;                // tasks queued or running, atomic
+  dev_t dest_device;             // device of the destination root
+  ino_t dest_inode;              // inode of the destination root
+  bool sync;                     // whether copies are only brought up to date
+  bool failed;                   // whether anything failed, atomic
+} TreePool;
+
+/**
+ * @brief Adds a task to the back of the queue of a worker and wakes a
+ * sleeping worker to take it.
+ *
+ * @param worker The worker.
+ * @param task The task.
+ * @return bool true on success, false on memory allocation failure.
+ */
+static bool pushTask(TreeWorker *worker, TreeTask *task) {
+  TreePool *pool = worker->pool;
+  TaskQueue *queue = &pool->queues[worker->index];
+
+  // Counted before it can be taken, so the count never drops to 0 early
+  pthread_mutex_lock(&pool->lock);
+  __atomic_add_fetch(&pool->pending, 1, __ATOMIC_SEQ_CST);
+  __atomic_add_fetch(&pool->queued, 1, __ATOMIC_SEQ_CST);
+  pthread_cond_signal(&pool->wake);
+  pthread_mutex_unlock(&pool->lock);
+
+  pthread_mutex_lock(&queue->lock);
+  if (queue->count == queue->capacity) {
+    size_t capacity = (queue->capacity == 0) ? 64 : queue->capacity * 2;
+    TreeTask **tasks = malloc(capacity * sizeof(TreeTask *));
+    if (tasks == NULL) {
+      pthread_mutex_unlock(&queue->lock);
+      __atomic_sub_fetch(&pool->queued, 1, __ATOMIC_SEQ_CST);
+      __atomic_sub_fetch(&pool->pending, 1, __ATOMIC_SEQ_CST);
+      return false;
+    }
+    for (size_t i = 0; i < queue->count; i++) {
+      tasks[i] = queue->tasks[(queue->head + i) % queue->capacity];
+    }
+    free(queue->tasks);
+    queue->tasks = tasks;
+    queue->capacity = capacity;
+    queue->head = 0;
+  }
+  queue->tasks[(queue->head + queue->count) % queue->capacity] = task;
+  queue->count++;
+  pthread_mutex_unlock(&queue->lock);
+  return true;
+}
+
+/**
+ * @brief Takes a task from a queue.
+ *
+ * @param queue The queue.
+ * @param back true to take the newest task, false to take the oldest one.
+ * @return TreeTask* The task, or NULL if the queue is empty.
+ */
+static TreeTask *takeTask(TaskQueue *queue, bool back) {
+  TreeTask *task = NULL;
+  pthread_mutex_lock(&queue->lock);
+  if (queue->count > 0) {
+    queue->count--;
+    if (back) {
+      task = queue->tasks[(queue->head + queue->count) % queue->capacity];
+    } else {
+      task = queue->tasks[queue->head];
+      queue->head = (queue->head + 1) % queue->capacity;
+    }
+  }
+  pthread_mutex_unlock(&queue->lock);
+  return task;
+}
+
+/**
+ * @brief Reports an error about an entry of a tree and marks the copy as
+ * failed.
+ *
+ * @param pool The tree copy.
+ * @param directory The directory of the entry.
+ * @param name The name of the entry, or NULL for the directory itself.
+ * @param error The error number.
+ */
+static void reportTreeError(TreePool *pool, const TreeDirectory *directory,
+                            const char *name, int error) {
+  fprintf(stderr, "Error copying '%s%s%s': %s\n", directory->path,
+          (name != NULL) ? "/" : "", (name != NULL) ? name : "",
+          strerror(error));
+  __atomic_store_n(&pool->failed, true, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief Gives a copied file or directory the permissions and times of its
+ * source.
+ *
+ * @param fd The copy.
+ * @param status The status of the source.
+ * @return int 0 on success or -1 on error.
+ */
+static int copyAttributes(int fd, const struct stat *status) {
+  struct timespec times[2] = {status->st_atim, status->st_mtim};
+  if (fchmod(fd, status->st_mode & 07777) == -1) {
+    return -1;
+  }
+  return futimens(fd, times);
+}
+
+/**
+ * @brief Drops a reference to a directory, and finishes it when it was the
+ * last one.
+ *
+ * @param pool The tree copy.
+ * @param directory The directory.
+ */
+static void releaseDirectory(TreePool *pool, TreeDirectory *directory) {
+  while (directory != NULL &&
+         __atomic_sub_fetch(&directory->references, 1, __ATOMIC_ACQ_REL) ==
+             0) {
+    if (copyAttributes(directory->dest_fd, &directory->status) == -1) {
+      reportTreeError(pool, directory, NULL, errno);
+    }
+    close(directory->src_fd);
+    close(directory->dest_fd);
+
+    TreeDirectory *parent = directory->parent;
+    free(directory->path);
+    free(directory);
+    directory = parent;
+  }
+}
+
+/**
+ * @brief Creates a task of a tree copy, holding a reference to its
+ * directory.
+ *
+ * @param kind The kind of task.
+ * @param directory The directory of the entries.
+ * @param names The types and names of the entries.
+ * @param names_length The bytes used by the names.
+ * @return TreeTask* The task, or NULL on memory allocation failure.
+ */
+static TreeTask *createTask(TaskKind kind, TreeDirectory *directory,
+                            const char *names, size_t names_length) {
+  TreeTask *task = malloc(sizeof(TreeTask) + names_length);
+  if (task == NULL) {
+    return NULL;
+  }
+  task->kind = kind;
+  task->directory = directory;
+  task->file = NULL;
+  task->names_length = names_length;
+  memcpy(task->names, names, names_length);
+  __atomic_add_fetch(&directory->references, 1, __ATOMIC_RELAXED);
+  return task;
+}
+
+/**
+ * @brief Queues a task, or reports the failure to create or queue it.
+ *
+ * @param worker The worker.
+ * @param task The task, or NULL if it could not be created.
+ * @param directory The directory of the task.
+ */
+static void queueTask(TreeWorker *worker, TreeTask *task,
+                      TreeDirectory *directory) {
+  if (task != NULL && pushTask(worker, task)) {
+    return;
+  }
+  reportTreeError(worker->pool, directory, NULL, ENOMEM);
+  if (task != NULL) {
+    releaseDirectory(worker->pool, directory);
+    free(task);
+  }
+}
+
+/**
+ * @brief Finishes a large file once its last part is copied.
+ *
+ * @param pool The tree copy.
+ * @param file The file.
+ */
+static void finishFile(TreePool *pool, TreeFile *file) {
+  if (!file->failed && copyAttributes(file->dest_fd, &file->status) == -1) {
+    reportTreeError(pool, file->directory, file->name, errno);
+  }
+  close(file->src_fd);
+  close(file->dest_fd);
+  releaseDirectory(pool, file->directory);
+  free(file->name);
+  free(file);
+}
+
+/**
+ * @brief Splits a large file into parts copied by separate tasks.
+ *
+ * @param worker The worker.
+ * @param directory The directory of the file.
+ * @param name The name of the file.
+ * @param src_fd The source file.
+ * @param dest_fd The destination file, which must be empty.
+ * @param status The status of the source.
+ * @return int 0 if the parts were queued, or -1 on error, in which case the
+ * files are still open.
+ */
+static int splitFile(TreeWorker *worker, TreeDirectory *directory,
+                     const char *name, int src_fd, int dest_fd,
+                     const struct stat *status) {
+  if (prepareDestination(dest_fd, status) == -1) {
+    return -1;
+  }
+  TreeFile *file = malloc(sizeof(TreeFile));
+  if (file == NULL || (file->name = strdup(name)) == NULL) {
+    free(file);
+    errno = ENOMEM;
+    return -1;
+  }
+  size_t part_count = (status->st_size + PART_BYTES - 1) / PART_BYTES;
+  file->directory = directory;
+  file->src_fd = src_fd;
+  file->dest_fd = dest_fd;
+  file->parts_left = part_count;
+  file->failed = false;
+  file->status = *status;
+  __atomic_add_fetch(&directory->references, 1, __ATOMIC_RELAXED);
+
+  for (size_t i = 0; i < part_count; i++) {
+    TreeTask *task = createTask(TASK_PART, directory, NULL, 0);
+    if (task != NULL) {
+      task->file = file;
+      task->start = (off_t)i * PART_BYTES;
+      task->end = (status->st_size - task->start < PART_BYTES)
+                      ? status->st_size
+                      : task->start + PART_BYTES;
+      if (pushTask(worker, task)) {
+        continue;
+      }
+      releaseDirectory(worker->pool, directory);
+      free(task);
+    }
+
+    // The parts that were not queued count as failed
+    reportTreeError(worker->pool, directory, name, ENOMEM);
+    file->failed = true;
+    if (__atomic_sub_fetch(&file->parts_left, part_count - i,
+                           __ATOMIC_ACQ_REL) == 0) {
+      finishFile(worker->pool, file);
+    }
+    break;
+  }
+  return 0;
+}
+
+/**
+ * @brief Brings the copy of a regular file of a tree up to date with
+ * syncFileContents(), and closes the source.
+ *
+ * @param worker The worker.
+ * @param directory The directory of the file.
+ * @param name The name of the file.
+ * @param src_fd The source file.
+ * @param status The status of the source.
+ * @return int 0 on success or -1 on error.
+ */
+static int syncTreeFile(TreeWorker *worker, TreeDirectory *directory,
+                        const char *name, int src_fd,
+                        const struct stat *status) {
+  worker->stats.files++;
+  struct stat dest_status;
+  if (fstatat(directory->dest_fd, name, &dest_status, AT_SYMLINK_NOFOLLOW) ==
+          0 &&
+      isUpToDate(status, &dest_status)) {
+    worker->stats.unchanged++;
+    worker->stats.copy.same_bytes += status->st_size;
+    close(src_fd);
+    return 0;
+  }
+
+  CopyStats stats;
+  int result = -1;
+  int dest_fd = openat(directory->dest_fd, name,
+                       O_CREAT | O_RDWR | O_NOFOLLOW | O_CLOEXEC,
+                       S_IRUSR | S_IWUSR);
+  if (dest_fd != -1 &&
+      syncFileContents(src_fd, status, dest_fd, &stats) == 0) {
+    worker->stats.copy.data_bytes += stats.data_bytes;
+    worker->stats.copy.hole_bytes += stats.hole_bytes;
+    worker->stats.copy.same_bytes += stats.same_bytes;
+    if (stats.strategy > worker->stats.copy.strategy) {
+      worker->stats.copy.strategy = stats.strategy;
+    }
+    result = copyAttributes(dest_fd, status);
+  }
+
+  int error = errno;
+  close(src_fd);
+  if (dest_fd != -1) {
+    close(dest_fd);
+  }
+  errno = error;
+  return result;
+}
+
+/**
+ * @brief Copies a regular file of a tree.
+ *
+ * Files larger than two parts are split into tasks, so several workers copy
+ * them at once.
+ *
+ * @param worker The worker.
+ * @param directory The directory of the file.
+ * @param name The name of the file.
+ * @return int 0 on success or if the error was already reported, -1 on
+ * error.
+ */
+static int copyTreeFile(TreeWorker *worker, TreeDirectory *directory,
+                        const char *name) {
+  int src_fd = openat(directory->src_fd, name,
+                      O_RDONLY | O_NOFOLLOW | O_CLOEXEC);
+  struct stat status;
+  if (src_fd == -1 || fstat(src_fd, &status) == -1) {
+    int error = errno;
+    if (src_fd != -1) {
+      close(src_fd);
+    }
+    errno = error;
+    return -1;
+  }
+  if (worker->pool->sync) {
+    return syncTreeFile(worker, directory, name, src_fd, &status);
+  }
+  // Truncate only after checking the copy is not the source itself, which
+  // a hard link or a bind mount can make it
+  int dest_fd = openat(directory->dest_fd, name,
+                       O_CREAT | O_WRONLY | O_NOFOLLOW | O_CLOEXEC,
+                       S_IRUSR | S_IWUSR);
+  struct stat dest_status;
+  if (dest_fd == -1 || fstat(dest_fd, &dest_status) == -1) {
+    int error = errno;
+    close(src_fd);
+    if (dest_fd != -1) {
+      close(dest_fd);
+    }
+    errno = error;
+    return -1;
+  }
+  if (dest_status.st_dev == status.st_dev &&
+      dest_status.st_ino == status.st_ino) {
+    fprintf(stderr, "Error copying '%s/%s': The source and the destination "
+            "are the same file.\n", directory->path, name);
+    __atomic_store_n(&worker->pool->failed, true, __ATOMIC_RELAXED);
+    close(src_fd);
+    close(dest_fd);
+    return 0;  // Already reported
+  }
+  if (ftruncate(dest_fd, 0) == -1) {
+    int error = errno;
+    close(src_fd);
+    close(dest_fd);
+    errno = error;
+    return -1;
+  }
+
+  worker->stats.files++;
+  CopyStats stats = {COPY_REFLINK, status.st_size, 0, 0};
+  int result = -1;
+  if (status.st_size == 0) {
+    result = copyAttributes(dest_fd, &status);  // Nothing to copy
+  } else if (status.st_size <= 2 * PART_BYTES) {
+    result = copyFileContents(src_fd, &status, dest_fd, 1, 0, &stats);
+  } else if (ioctl(dest_fd, FICLONE, src_fd) == 0) {
+    result = 0;
+  } else if (isUnsupported(errno) &&
+             splitFile(worker, directory, name, src_fd, dest_fd, &status) ==
+                 0) {
+    return 0;  // The last part closes the files
+  }
+  if (result == 0 && status.st_size > 0) {
+    worker->stats.copy.data_bytes += stats.data_bytes;
+    worker->stats.copy.hole_bytes += stats.hole_bytes;
+    if (stats.strategy > worker->stats.copy.strategy) {
+      worker->stats.copy.strategy = stats.strategy;
+    }
+    result = copyAttributes(dest_fd, &status);
+  }
+
+  int error = errno;
+  close(src_fd);
+  close(dest_fd);
+  errno = error;
+  return result;
+}
+
+/**
+ * @brief Copies an entry of a tree that is not a directory: a regular file,
+ * a symbolic link or a named pipe. Other kinds of files are skipped.
+ *
+ * @param worker The worker.
+ * @param directory The directory of the entry.
+ * @param type The type of the entry from getdents64(), or DT_UNKNOWN.
+ * @param name The name of the entry.
+ */
+static void copyTreeEntry(TreeWorker *worker, TreeDirectory *directory,
+                          unsigned char type, const char *name) {
+  struct stat status;
+  if (type != DT_REG && type != DT_LNK) {
+    if (fstatat(directory->src_fd, name, &status, AT_SYMLINK_NOFOLLOW) ==
+        -1) {
+      reportTreeError(worker->pool, directory, name, errno);
+      return;
+    }
+    type = S_ISREG(status.st_mode)    ? DT_REG
+           : S_ISLNK(status.st_mode)  ? DT_LNK
+           : S_ISFIFO(status.st_mode) ? DT_FIFO
+                                      : DT_UNKNOWN;
+  }
+
+  int result = 0;
+  if (type == DT_REG) {
+    result = copyTreeFile(worker, directory, name);
+  } else if (type == DT_LNK) {
+    char target[PATH_MAX];
+    ssize_t length =
+        readlinkat(directory->src_fd, name, target, sizeof(target) - 1);
+    if (length != -1) {
+      target[length] = '\0';
+      result = symlinkat(target, directory->dest_fd, name);
+      if (result == -1 && errno == EEXIST &&
+          unlinkat(directory->dest_fd, name, 0) == 0) {
+        result = symlinkat(target, directory->dest_fd, name);
+      }
+    }
+    if (length != -1 && result == 0 &&
+        fstatat(directory->src_fd, name, &status, AT_SYMLINK_NOFOLLOW) == 0) {
+      struct timespec times[2] = {status.st_atim, status.st_mtim};
+      utimensat(directory->dest_fd, name, times, AT_SYMLINK_NOFOLLOW);
+    }
+    result = (length == -1) ? -1 : result;
+    worker->stats.links += (result == 0);
+  } else if (type == DT_FIFO) {
+    result = mkfifoat(directory->dest_fd, name, status.st_mode & 07777);
+    result = (result == -1 && errno == EEXIST) ? 0 : result;
+  } else {
+    fprintf(stderr, "Warning: Skipping '%s/%s', which is not a file, "
+            "directory or symbolic link.\n", directory->path, name);
+  }
+  if (result == -1) {
+    reportTreeError(worker->pool, directory, name, errno);
+  }
+}
+
+/**
+ * @brief Opens a directory of a tree and creates its copy.
+ *
+ * The copy is created with only the permissions of the owner so the
+ * workers can write into it, and gets those of the source when it is
+ * finished.
+ *
+ * @param pool The tree copy.
+ * @param parent The containing directory.
+ * @param name The name of the directory.
+ * @return TreeDirectory* The directory, or NULL if it failed, which was
+ * already reported, or if it is the destination itself.
+ */
+static TreeDirectory *openTreeDirectory(TreePool *pool, TreeDirectory *parent,
+                                        const char *name) {
+  TreeDirectory *directory = calloc(1, sizeof(TreeDirectory));
+  size_t path_length = strlen(parent->path) + 1 + strlen(name);
+  if (directory == NULL ||
+      (directory->path = malloc(path_length + 1)) == NULL) {
+    free(directory);
+    reportTreeError(pool, parent, name, ENOMEM);
+    return NULL;
+  }
+  sprintf(directory->path, "%s/%s", parent->path, name);
+  directory->dest_fd = -1;
+  directory->src_fd = openat(parent->src_fd, name,
+                             O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+  int error = 0;
+  if (directory->src_fd == -1 ||
+      fstat(directory->src_fd, &directory->status) == -1) {
+    error = errno;
+  } else if (directory->status.st_dev == pool->dest_device &&
+             directory->status.st_ino == pool->dest_inode) {
+    error = -1;  // Copying the destination into itself would never end
+  } else if (mkdirat(parent->dest_fd, name, S_IRWXU) == -1 &&
+             errno != EEXIST) {
+    error = errno;
+  } else {
+    directory->dest_fd =
+        openat(parent->dest_fd, name,
+               O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+    error = (directory->dest_fd == -1) ? errno : 0;
+  }
+
+  if (error != 0) {
+    if (error != -1) {
+      reportTreeError(pool, parent, name, error);
+    }
+    if (directory->src_fd != -1) {
+      close(directory->src_fd);
+    }
+    free(directory->path);
+    free(directory);
+    return NULL;
+  }
+  directory->parent = parent;
+  directory->references = 1;
+  return directory;
+}
+
+/**
+ * @brief Reads the entries of a directory and queues tasks for them: one
+ * task for each subdirectory and one for each batch of other entries.
+ *
+ * @param worker The worker.
+ * @param directory The directory, whose reference is dropped at the end.
+ */
+static void scanTreeDirectory(TreeWorker *worker, TreeDirectory *directory) {
+  char batch[BATCH_NAME_BYTES];
+  size_t batch_length = 0;
+  int batch_count = 0;
+
+  long bytes;
+  while ((bytes = syscall(SYS_getdents64, directory->src_fd,
+                          worker->dirent_buffer,
+                          DIRENT_BUFFER_SIZE_BYTES)) > 0) {
+    for (long offset = 0; offset < bytes;) {
+      const DirectoryEntry *entry =
+          (const DirectoryEntry *)(worker->dirent_buffer + offset);
+      offset += entry->length;
+
+      const char *name = entry->name;
+      if (name[0] == '.' &&
+          (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'))) {
+        continue;
+      }
+      size_t name_length = strlen(name) + 1;
+      struct stat status;
+      bool is_directory =
+          entry->type == DT_DIR ||
+          (entry->type == DT_UNKNOWN &&
+           fstatat(directory->src_fd, name, &status, AT_SYMLINK_NOFOLLOW) ==
+               0 &&
+           S_ISDIR(status.st_mode));
+
+      if (is_directory) {
+        queueTask(worker,
+                  createTask(TASK_DIRECTORY, directory, name, name_length),
+                  directory);
+        continue;
+      }
+
+      // Small files are copied in batches, so each task is worth taking
+      if (batch_length + 1 + name_length > BATCH_NAME_BYTES) {
+        queueTask(worker,
+                  createTask(TASK_ENTRIES, directory, batch, batch_length),
+                  directory);
+        batch_length = 0;
+        batch_count = 0;
+      }
+      batch[batch_length++] = (char)entry->type;
+      memcpy(batch + batch_length, name, name_length);
+      batch_length += name_length;
+      if (++batch_count == BATCH_FILES) {
+        queueTask(worker,
+                  createTask(TASK_ENTRIES, directory, batch, batch_length),
+                  directory);
+        batch_length = 0;
+        batch_count = 0;
+      }
+    }
+  }
+  if (bytes == -1) {
+    reportTreeError(worker->pool, directory, NULL, errno);
+  }
+  if (batch_length > 0) {
+    queueTask(worker,
+              createTask(TASK_ENTRIES, directory, batch, batch_length),
+              directory);
+  }
+  releaseDirectory(worker->pool, directory);
+}
+
+/**
+ * @brief Runs a task of a tree copy.
+ *
+ * @param worker The worker.
+ * @param task The task, which is freed.
+ */
+static void runTreeTask(TreeWorker *worker, TreeTask *task) {
+  TreePool *pool = worker->pool;
+  TreeDirectory *directory = task->directory;
+
+  if (task->kind == TASK_DIRECTORY) {
+    TreeDirectory *child = openTreeDirectory(pool, directory, task->names);
+    if (child != NULL) {
+      worker->stats.directories++;
+      scanTreeDirectory(worker, child);
+      free(task);
+      return;  // The child keeps the reference of the task to its parent
+    }
+  } else if (task->kind == TASK_ENTRIES) {
+    for (size_t offset = 0; offset < task->names_length;) {
+      const char *name = task->names + offset + 1;
+      copyTreeEntry(worker, directory, (unsigned char)task->names[offset],
+                    name);
+      offset += 1 + strlen(name) + 1;
+    }
+  } else {
+    TreeFile *file = task->file;
+    CopyStats stats = {COPY_FILE_RANGE, 0, 0, 0};
+    if (copyDataRegions(file->src_fd, file->dest_fd, task->start, task->end,
+                        true, 0, &stats) == -1) {
+      fprintf(stderr, "Error copying bytes %lld to %lld of '%s/%s': %s\n",
+              (long long)task->start, (long long)task->end - 1,
+              directory->path, file->name, strerror(errno));
+      __atomic_store_n(&file->failed, true, __ATOMIC_RELAXED);
+      __atomic_store_n(&pool->failed, true, __ATOMIC_RELAXED);
+    }
+    worker->stats.copy.data_bytes += stats.data_bytes;
+    worker->stats.copy.hole_bytes += stats.hole_bytes;
+    if (stats.strategy > worker->stats.copy.strategy) {
+      worker->stats.copy.strategy = stats.strategy;
+    }
+    if (__atomic_sub_fetch(&file->parts_left, 1, __ATOMIC_ACQ_REL) == 0) {
+      finishFile(pool, file);
+    }
+  }
+  releaseDirectory(pool, directory);
+  free(task);
+}
+
+/**
+ * @brief Runs tasks until the whole tree is copied.
+ *
+ * A worker takes the newest task of its own queue, and when it is empty
+ * steals the oldest task of another queue. It sleeps while every queue is
+ * empty but other workers may still queue tasks.
+ *
+ * @param arg The TreeWorker.
+ * @return void* NULL.
+ */
+static void *runTreeWorker(void *arg) {
+  TreeWorker *worker = arg;
+  TreePool *pool = worker->pool;
+
+  while (true) {
+    TreeTask *task = takeTask(&pool->queues[worker->index], true);
+    for (int i = 1; task == NULL && i < pool->worker_count; i++) {
+      int victim = (worker->index + i) % pool->worker_count;
+      task = takeTask(&pool->queues[victim], false);
+    }
+
+    if (task == NULL) {
+      pthread_mutex_lock(&pool->lock);
+      while (__atomic_load_n(&pool->queued, __ATOMIC_SEQ_CST) == 0 &&
+             __atomic_load_n(&pool->pending, __ATOMIC_SEQ_CST) > 0) {
+        pthread_cond_wait(&pool->wake, &pool->lock);
+      }
+      bool done = __atomic_load_n(&pool->pending, __ATOMIC_SEQ_CST) == 0;
+      pthread_mutex_unlock(&pool->lock);
+      if (done) {
+        return NULL;
+      }
+      continue;
+    }
+
+    __atomic_sub_fetch(&pool->queued, 1, __ATOMIC_SEQ_CST);
+    runTreeTask(worker, task);
+    if (__atomic_sub_fetch(&pool->pending, 1, __ATOMIC_SEQ_CST) == 0) {
+      pthread_mutex_lock(&pool->lock);
+      pthread_cond_broadcast(&pool->wake);
+      pthread_mutex_unlock(&pool->lock);
+    }
+  }
+}
+
+/**
+ * @brief Copies a directory tree with a pool of workers.
+ *
+ * The tree is read with getdents64(), and every file is opened relative to
+ * the file descriptor of its directory. Directories, regular files,
+ * symbolic links and named pipes are recreated with the permissions and
+ * times of their sources. Errors are reported and the rest of the tree is
+ * still copied.
+ *
+ * @param src_path The source directory.
+ * @param dest_path The destination, created if it does not exist.
+ * @param jobs The number of workers.
+ * @param sync Whether to only bring existing copies of files up to date.
+ * @param verbose Whether to print what was copied.
+ * @return int EXIT_SUCCESS if everything was copied, EXIT_FAILURE otherwise.
+ */
+static int copyTree(const char *src_path, const char *dest_path, int jobs,
+                    bool sync, bool verbose) {
+  TreePool *pool = calloc(1, sizeof(TreePool));
+  TreeDirectory *root = calloc(1, sizeof(TreeDirectory));
+  if (pool == NULL || root == NULL || (root->path = strdup(src_path)) == NULL) {
+    fputs("Error: Memory allocation failed.\n", stderr);
+    free(pool);
+    free(root);
+    return EXIT_FAILURE;
+  }
+
+  // Open both roots, creating the destination like its subdirectories
+  struct stat dest_status;
+  root->src_fd = open(src_path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  root->dest_fd = -1;
+  const char *failed_path = src_path;
+  if (root->src_fd != -1 && fstat(root->src_fd, &root->status) == 0) {
+    failed_path = dest_path;
+    if (mkdir(dest_path, S_IRWXU) == 0 || errno == EEXIST) {
+      root->dest_fd = open(dest_path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    }
+  }
+  if (root->dest_fd == -1 || fstat(root->dest_fd, &dest_status) == -1) {
+    fprintf(stderr, "Error opening directory '%s': %s\n", failed_path,
+            strerror(errno));
+    if (root->src_fd != -1) {
+      close(root->src_fd);
+    }
+    if (root->dest_fd != -1) {
+      close(root->dest_fd);
+    }
+    free(root->path);
+    free(root);
+    free(pool);
+    return EXIT_FAILURE;
+  }
+  if (dest_status.st_dev == root->status.st_dev &&
+      dest_status.st_ino == root->status.st_ino) {
+    // Every file would be truncated before it is read
+    fputs("Error: The source and the destination are the same file.\n",
+          stderr);
+    close(root->src_fd);
+    close(root->dest_fd);
+    free(root->path);
+    free(root);
+    free(pool);
+    return EXIT_FAILURE;
+  }
+  root->references = 1;
+  pool->dest_device = dest_status.st_dev;
+  pool->dest_inode = dest_status.st_ino;
+  pool->worker_count = jobs;
+  pool->sync = sync;
+  pthread_mutex_init(&pool->lock, NULL);
+  pthread_cond_init(&pool->wake, NULL);
+
+  // The scan of the root is pending until this thread finishes it, so the
+  // other workers do not stop before it queues anything
+  pool->pending = 1;
+  pthread_t threads[MAX_JOBS];
+  int started = 1;
+  for (int i = 0; i < jobs; i++) {
+    pthread_mutex_init(&pool->queues[i].lock, NULL);
+    pool->workers[i].pool = pool;
+    pool->workers[i].index = i;
+    pool->workers[i].stats.copy.strategy = COPY_REFLINK;
+    pool->workers[i].dirent_buffer = malloc(DIRENT_BUFFER_SIZE_BYTES);
+    if (pool->workers[i].dirent_buffer == NULL) {
+      fputs("Error: Memory allocation failed.\n", stderr);
+      pool->failed = true;
+      pool->worker_count = jobs = i;
+      break;
+    }
+  }
+  if (jobs > 0) {
+    for (; started < jobs; started++) {
+      if (pthread_create(&threads[started], NULL, runTreeWorker,
+                         &pool->workers[started]) != 0) {
+        break;
+      }
+    }
+    scanTreeDirectory(&pool->workers[0], root);
+    if (__atomic_sub_fetch(&pool->pending, 1, __ATOMIC_SEQ_CST) == 0) {
+      pthread_mutex_lock(&pool->lock);
+      pthread_cond_broadcast(&pool->wake);
+      pthread_mutex_unlock(&pool->lock);
+    }
+    runTreeWorker(&pool->workers[0]);
+    for (int i = 1; i < started; i++) {
+      pthread_join(threads[i], NULL);
+    }
+  } else {
+    releaseDirectory(pool, root);
+  }
+
+  TreeStats total = {{COPY_REFLINK, 0, 0, 0}, 0, 1, 0, 0};
+  for (int i = 0; i < jobs; i++) {
+    TreeStats *stats = &pool->workers[i].stats;
+    total.files += stats->files;
+    total.directories += stats->directories;
+    total.links += stats->links;
+    total.copy.data_bytes += stats->copy.data_bytes;
+    total.copy.hole_bytes += stats->copy.hole_bytes;
+    total.copy.same_bytes += stats->copy.same_bytes;
+    total.unchanged += stats->unchanged;
+    if (stats->copy.strategy > total.copy.strategy) {
+      total.copy.strategy = stats->copy.strategy;
+    }
+    pthread_mutex_destroy(&pool->queues[i].lock);
+    free(pool->queues[i].tasks);
+    free(pool->workers[i].dirent_buffer);
+  }
+  if (verbose) {
+    printf("'%s' -> '%s': %ld files, %ld directories, %ld symbolic links, "
+           "%s, %lld bytes of data, %lld bytes of holes\n",
+           src_path, dest_path, total.files, total.directories, total.links,
+           STRATEGY_NAMES[total.copy.strategy],
+           (long long)total.copy.data_bytes, (long long)total.copy.hole_bytes);
+    if (sync) {
+      printf("%ld files were up to date, %lld bytes were already equal\n",
+             total.unchanged, (long long)total.copy.same_bytes);
+    }
+  }
+
+  bool failed = pool->failed;
+  pthread_mutex_destroy(&pool->lock);
+  pthread_cond_destroy(&pool->wake);
+  free(pool);
+  return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
 /**
  * @brief Creates a copy of the specified file.
  *
@@ -58,33 +1723,65 @@
  * error occurs, prints the error using perror (see the errno.h header for more
  * information) and returns 1.
  */
-int main(const int argc, const char *argv[]) {
+int copia_main(const int argc, const char *argv[]) {
+  // Display help command
+  if (argc >= 2 && strcmp(argv[1], "--help") == 0) {
+    fputs(HELP_MESSAGE, stdout);
+    return EXIT_SUCCESS;
+  }
+
+  // Read the options
+  bool verbose = false;
+  bool recursive = false;
+  bool sync = false;
+  unsigned ring_depth = 0;
+  int jobs = 0;
+  int arg = 1;
+  for (; arg < argc && argv[arg][0] == '-' && argv[arg][1] != '\0'; arg++) {
+    if (strcmp(argv[arg], "-v") == 0) {
+      verbose = true;
+    } else if (strcmp(argv[arg], "-r") == 0) {
+      recursive = true;
+    } else if (strcmp(argv[arg], "--sync") == 0) {
+      sync = true;
+    } else if (strcmp(argv[arg], "--fila") == 0 && arg + 1 < argc) {
+      ring_depth = parseRingDepth(argv[++arg]);
+      if (ring_depth == 0) {
+        fprintf(stderr, "Error: Invalid queue depth '%s'.\n", argv[arg]);
+        return EXIT_FAILURE;
+      }
+    } else if (strcmp(argv[arg], "-j") == 0 && arg + 1 < argc) {
+      jobs = parseJobs(argv[++arg]);
+      if (jobs == -1) {
+        fprintf(stderr, "Error: Invalid number of threads '%s'.\n",
+                argv[arg]);
+        return EXIT_FAILURE;
+      }
+    } else {
+      break;
+    }
+  }
+
   // Control incorrect usage
-  if (argc < 2) {
+  if (argc - arg < 1 || argc - arg > 2) {
     fputs("Error: Incorrect usage.\n", stderr);
     fputs(HELP_MESSAGE, stderr);
     return EXIT_FAILURE;
   }
 
-  // Display help command
-  if (strcmp(argv[1], "--help") == 0) {
-    fputs(HELP_MESSAGE, stdout);
-    return EXIT_SUCCESS;
-  }
-
-  bool custom_name = (argc != 2);
-  const char *src_file = argv[1];
+  bool custom_name = (argc - arg == 2);
+  const char *src_file = argv[arg];
   char *dest_file_name = NULL;
 
   // Update destination file name
   if (custom_name) {
-    size_t dest_len = strlen(argv[2]);
+    size_t dest_len = strlen(argv[arg + 1]);
     dest_file_name = (char *)malloc(dest_len + 1);
     if (dest_file_name == NULL) {
       fputs("Error: Memory allocation failed.\n", stderr);
       return EXIT_FAILURE;
     }
-    strcpy(dest_file_name, argv[2]);
+    strcpy(dest_file_name, argv[arg + 1]);
   } else {
     size_t source_len = strlen(src_file);
     size_t extension_len = strlen(".copia");
@@ -97,17 +1794,47 @@ int main(const int argc, const char *argv[]) {
     strcat(dest_file_name, ".copia");
   }
 
+  // Trees are copied by a worker for each processor unless told otherwise
+  struct stat src_stat, dest_stat;
+  if (recursive && stat(src_file, &src_stat) == 0 &&
+      S_ISDIR(src_stat.st_mode)) {
+    if (jobs == 0) {
+      long processors = sysconf(_SC_NPROCESSORS_ONLN);
+      jobs = (processors < 1)          ? 1
+             : (processors > MAX_JOBS) ? MAX_JOBS
+                                       : (int)processors;
+    }
+    int status = copyTree(src_file, dest_file_name, jobs, sync, verbose);
+    free(dest_file_name);
+    return status;
+  }
+  jobs = (jobs == 0) ? 1 : jobs;
+
   // Open the source file in read-only mode
   int srcfd = open(src_file, O_RDONLY);
-  if (srcfd == -1) {
+  if (srcfd == -1 || fstat(srcfd, &src_stat) == -1) {
     perror("Error");
+    if (srcfd != -1) {
+      close(srcfd);
+    }
+    free(dest_file_name);
+    return EXIT_FAILURE;
+  }
+
+  // Truncating the source itself would lose it
+  if (stat(dest_file_name, &dest_stat) == 0 &&
+      dest_stat.st_dev == src_stat.st_dev &&
+      dest_stat.st_ino == src_stat.st_ino) {
+    fputs("Error: The source and the destination are the same file.\n",
+          stderr);
+    close(srcfd);
     free(dest_file_name);
     return EXIT_FAILURE;
   }
 
   // Open and set destination file permissions to match the source file
-  int destfd =
-      open(dest_file_name, O_CREAT | O_WRONLY | O_TRUNC, S_IRUSR | S_IWUSR);
+  int dest_flags = sync ? O_CREAT | O_RDWR : O_CREAT | O_WRONLY | O_TRUNC;
+  int destfd = open(dest_file_name, dest_flags, S_IRUSR | S_IWUSR);
   if (destfd == -1) {
     perror("Error");
     close(srcfd);
@@ -115,23 +1842,22 @@ int main(const int argc, const char *argv[]) {
     return EXIT_FAILURE;
   }
 
-  // Read data from source file and write to destination file
-  char buffer[BUFFER_SIZE_BYTES];
-  ssize_t bytes_read;
-  while ((bytes_read = read(srcfd, buffer, sizeof(buffer))) > 0) {
-    ssize_t bytes_written = write(destfd, buffer, bytes_read);
-    if (bytes_written != bytes_read) {
+  // Copy the data from the source file to the destination file
+  CopyStats stats;
+  int result = sync ? syncFileContents(srcfd, &src_stat, destfd, &stats)
+                    : copyFileContents(srcfd, &src_stat, destfd, jobs,
+                                       ring_depth, &stats);
+
+  // A synced copy gets the times of the source, so the next sync skips it
+  if (result == 0 && sync && S_ISREG(src_stat.st_mode) &&
+      fstat(destfd, &dest_stat) == 0 && S_ISREG(dest_stat.st_mode)) {
+    struct timespec times[2] = {src_stat.st_atim, src_stat.st_mtim};
+    result = futimens(destfd, times);
+  }
+  if (result != 0) {
+    if (result == -1) {
       perror("Error");
-      close(srcfd);
-      close(destfd);
-      free(dest_file_name);
-      return EXIT_FAILURE;
     }
-  }
-
-  // Check for read error
-  if (bytes_read == -1) {
-    perror("Error");
     close(srcfd);
     close(destfd);
     free(dest_file_name);
@@ -145,8 +1871,28 @@ int main(const int argc, const char *argv[]) {
     return EXIT_FAILURE;
   }
 
+  if (verbose) {
+    printf("'%s' -> '%s': %s, %lld bytes of data, %lld bytes of holes\n",
+           src_file, dest_file_name, STRATEGY_NAMES[stats.strategy],
+           (long long)stats.data_bytes, (long long)stats.hole_bytes);
+    if (sync) {
+      printf("%lld bytes were already equal\n", (long long)stats.same_bytes);
+    }
+  }
+
   // Free memory
   free(dest_file_name);
 
   return EXIT_SUCCESS;
 }
+
+#ifndef COMMAND_LIBRARY
+/**
+ * @brief Entry point of the standalone `copia` program.
+ *
+ * @param argc The number of command-line arguments passed to the program.
+ * @param argv An array of strings containing the command-line arguments.
+ * @return int The exit status returned by copia_main().
+ */
+int main(const int argc, const char *argv[]) { return copia_main(argc, argv); }
+#endif
@@ -12,6 +12,10 @@
  *
  * @copyright Copyright (c) 2024
  *
+ * @section Modifications
+ * - 2026-10-16: The program logic moved to informa_main() so the interpreter
+ *               can run the command in-process.
+ *   Enrique George Rodrigues (a28602@alunos.ipca.pt)
  */
 #define _XOPEN_SOURCE 700
 
@@ -25,6 +29,8 @@
 #include <time.h>
 #include <unistd.h>
 
+#include "commands.h"
+
 /* Name of the utility program. */
 #define PROGRAM_NAME "informa"
 
@@ -198,7 +204,7 @@ static void printFileInfo(const FileInfo *info) {
  * information) and returns 1.
  *
  */
-int main(const int argc, const char *argv[]) {
+int informa_main(const int argc, const char *argv[]) {
   // Control incorrect usage
   if (argc < 2) {
     fputs("Error: Incorrect usage.\n", stderr);
@@ -227,3 +233,16 @@ int main(const int argc, const char *argv[]) {
 
   return EXIT_SUCCESS;
 }
+
+#ifndef COMMAND_LIBRARY
+/**
+ * @brief Entry point of the standalone `informa` program.
+ *
+ * @param argc The number of command-line arguments passed to the program.
+ * @param argv An array of strings containing the command-line arguments.
+ * @return int The exit status returned by informa_main().
+ */
+int main(const int argc, const char *argv[]) {
+  return informa_main(argc, argv);
+}
+#endif
@@ -13,6 +13,10 @@
  *
  * @copyright Copyright (c) 2024
  *
+ * @section Modifications
+ * - 2026-10-16: The program logic moved to lista_main() so the interpreter can
+ *               run the command in-process.
+ *   Enrique George Rodrigues (a28602@alunos.ipca.pt)
  */
 #define _XOPEN_SOURCE 700
 
@@ -25,6 +29,8 @@
 #include <sys/stat.h>
 #include <unistd.h>
 
+#include "commands.h"
+
 /* Name of the utility program. */
 #define PROGRAM_NAME "lista"
 
@@ -59,7 +65,7 @@
  * @return Returns 0 if the directory contents are successfully listed. If an
  * error occurs, prints an error message and returns 1.
  */
-int main(const int argc, const char *argv[]) {
+int lista_main(const int argc, const char *argv[]) {
   // Display help command
   if (argc > 1 && strcmp(argv[1], "--help") == 0) {
     fputs(HELP_MESSAGE, stdout);
@@ -114,3 +120,14 @@ int main(const int argc, const char *argv[]) {
 
   return EXIT_SUCCESS;
 }
+
+#ifndef COMMAND_LIBRARY
+/**
+ * @brief Entry point of the standalone `lista` program.
+ *
+ * @param argc The number of command-line arguments passed to the program.
+ * @param argv An array of strings containing the command-line arguments.
+ * @return int The exit status returned by lista_main().
+ */
+int main(const int argc, const char *argv[]) { return lista_main(argc, argv); }
+#endif
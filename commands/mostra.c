@@ -13,30 +13,1282 @@
  *
  * @version 0.1
  * @date 2024-04-18
+ *
+ * @section Modifications
+ * - 2026-10-16: The program logic moved to mostra_main() so the interpreter can
+ *               run the command in-process.
+ *   Enrique George Rodrigues (a28602@alunos.ipca.pt)
+ * - 2026-10-16: Reads stdin when no file is given and moves data into pipes
+ *               with splice().
+ *   Enrique George Rodrigues (a28602@alunos.ipca.pt)
+ * - 2026-10-16: Copies between regular files with copy_file_range() or
+ *               sendfile().
+ *   Enrique George Rodrigues (a28602@alunos.ipca.pt)
+ * - 2026-10-16: Uses sendfile() for sockets and mmap() for terminals, reads
+ *               through a larger buffer, and added --modo to force a mode.
+ *   Enrique George Rodrigues (a28602@alunos.ipca.pt)
+ * - 2026-10-16: Added -n, -t, --bytes and --lines to display part of a file.
+ *   Enrique George Rodrigues (a28602@alunos.ipca.pt)
+ * - 2026-10-16: Added --segue, which follows files with inotify.
+ *   Enrique George Rodrigues (a28602@alunos.ipca.pt)
+ * - 2026-10-16: Displays several files, reading the next ones ahead, and
+ *               added --modo uring.
+ *   Enrique George Rodrigues (a28602@alunos.ipca.pt)
+ * - 2026-10-16: The io_uring code moved to common/uring.c, reads use registered
+ *               buffers, added --fila, and --modo uring falls back to the
+ *               buffer.
+ *   Enrique George Rodrigues (a28602@alunos.ipca.pt)
+ * - 2026-10-16: --segue ends cleanly on SIGINT.
+ *   Enrique George Rodrigues (a28602@alunos.ipca.pt)
  */
-#define _XOPEN_SOURCE 700
+#define _GNU_SOURCE
 
+#include <errno.h>
 #include <fcntl.h>
+#include <limits.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/inotify.h>
+#include <sys/mman.h>
+#include <sys/sendfile.h>
+#include <sys/signalfd.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
 #include <unistd.h>
 
+#include "commands.h"
+#include "common/uring.h"
+
 /* Name of the utility program. */
 #define PROGRAM_NAME "mostra"
 
 /* Size of buffer when reading from file */
-#define BUFFER_SIZE_BYTES 4096  // 4KB buffer size
+#define BUFFER_SIZE_BYTES (256 * 1024)  // 256KB buffer size
+
+/* Maximum number of bytes moved by each splice() or copy call */
+#define SPLICE_SIZE_BYTES (1024 * 1024)  // 1MB per call
+
+/* Size of each window of the file mapped into memory */
+#define MAP_WINDOW_BYTES (64 * 1024 * 1024)  // 64MB per mapping
+
+/* Number of files opened and read ahead of the one being displayed */
+#define READAHEAD_FILES 8
+
+/* Bytes at the start of each file read ahead of its turn */
+#define READAHEAD_BYTES (2 * 1024 * 1024)  // 2MB per file
+
+/* Size of the buffer inotify events are read into */
+#define EVENT_BUFFER_BYTES (16 * 1024)  // 16KB buffer size
+
+/* Events watched on a followed file: writes, and renames or deletion. */
+#define FILE_EVENTS (IN_MODIFY | IN_MOVE_SELF | IN_DELETE_SELF)
+
+/* Events watched on the directory of a followed file: the file appearing. */
+#define DIRECTORY_EVENTS (IN_CREATE | IN_MOVED_TO)
 
 /* Help message explaining usage. */
-#define HELP_MESSAGE                                 \
-  "Usage: mostra <filename>\n"                       \
-  "Displays the contents of a file to stdout.\n"     \
-  "Arguments:\n"                                     \
-  "  <filename>  The name of the file to display.\n" \
-  "\n"                                               \
-  "Options:\n"                                       \
-  "  --help      Display this help message.\n"
+#define HELP_MESSAGE                                                 \
+  "Usage: mostra [options] <filename>...\n"                          \
+  "Displays the contents of files to stdout, one after the other.\n" \
+  "Arguments:\n"                                                     \
+  "  <filename>  The name of a file to display. If omitted or\n"     \
+  "              '-', stdin is displayed when it is not a\n"         \
+  "              terminal.\n"                                        \
+  "\n"                                                               \
+  "Options:\n"                                                       \
+  "  -n N          Display the first N lines.\n"                     \
+  "  -t N          Display the last N lines.\n"                      \
+  "  --segue       Keep displaying what is appended to the files,\n" \
+  "                following them by name when they are rotated.\n"  \
+  "                Several files can be followed at once. Ends\n"    \
+  "                on Ctrl-C.\n"                                      \
+  "  --bytes A:B   Display bytes A to B, counted from 1. Either\n"   \
+  "                end may be omitted.\n"                            \
+  "  --lines A:B   Display lines A to B, counted from 1. Either\n"   \
+  "                end may be omitted.\n"                            \
+  "  --modo mode   How the data is moved: auto (the default,\n"      \
+  "                chosen from the input and output), splice,\n"     \
+  "                copy (copy_file_range), sendfile, mmap,\n"        \
+  "                buffer or uring (io_uring reads with several\n"   \
+  "                in flight, for whole files, or the buffer\n"      \
+  "                when io_uring is not available). Lines\n"         \
+  "                selected with -n and --lines are always\n"        \
+  "                written from the buffer.\n"                       \
+  "  --fila N      Keep N reads in flight with --modo uring, up\n"   \
+  "                to 256 (default: 16). Implies --modo uring.\n"    \
+  "  --help        Display this help message.\n"
+
+/**
+ * @brief Ways of moving the contents of the file to stdout.
+ */
+typedef enum OutputMode {
+  MODE_AUTO,      // chosen from the types of the input and of stdout
+  MODE_SPLICE,    // splice(), when the input or stdout is a pipe
+  MODE_COPY,      // copy_file_range(), between regular files
+  MODE_SENDFILE,  // sendfile(), from a regular file
+  MODE_MMAP,      // write() from a mapping of a regular file
+  MODE_BUFFER,    // read() and write() through a buffer
+  MODE_URING      // reads through io_uring, several files at once
+} OutputMode;
+
+/* Names of the modes accepted by --modo, in the order of OutputMode. */
+static const char *const MODE_NAMES[] = {"auto",     "splice", "copy",
+                                         "sendfile", "mmap",   "buffer",
+                                         "uring"};
+
+/**
+ * @brief Parts of the file that can be displayed.
+ */
+typedef enum RangeKind {
+  RANGE_ALL,    // the whole file
+  RANGE_BYTES,  // bytes `first` to `last`
+  RANGE_LINES,  // lines `first` to `last`
+  RANGE_TAIL    // the last `first` lines
+} RangeKind;
+
+/**
+ * @brief Structure that holds the part of the file to display.
+ *
+ * Bytes and lines are counted from 1, and `last` is included. A `last` of
+ * -1 extends the range to the end of the file.
+ */
+typedef struct Range {
+  RangeKind kind;   // part of the file
+  long long first;  // first byte or line, or number of lines of a tail
+  long long last;   // last byte or line, or -1 for the end of the file
+} Range;
+
+/**
+ * @brief Structure that holds a file followed with --segue.
+ */
+typedef struct FollowedFile {
+  const char *path;  // path of the file
+  const char *name;  // name of the file inside its directory
+  int fd;            // descriptor of the file, or -1 while it does not exist
+  int file_watch;    // inotify watch of the file, or -1
+  int dir_watch;     // inotify watch of the directory of the file, or -1
+} FollowedFile;
+
+/**
+ * @brief Structure that holds the state of --segue.
+ */
+typedef struct Follower {
+  int inotify_fd;                  // descriptor every watch reports to
+  FollowedFile *files;             // followed files
+  int file_count;                  // number of followed files
+  OutputMode mode;                 // mode the data is moved in
+  bool headers;                    // whether output is preceded by headers
+  const FollowedFile *last_shown;  // file of the last output, or NULL
+} Follower;
+
+/**
+ * @brief Structure that holds a chunk of a file read with io_uring.
+ */
+typedef struct RingChunk {
+  int fd;            // descriptor of the file
+  const char *path;  // path of the file
+  size_t length;     // bytes requested
+  bool last;         // whether it is the last chunk of the file
+  bool done;         // whether the read completed
+  int result;        // bytes read, or minus the error number
+} RingChunk;
+
+/**
+ * @brief Writes a whole buffer to stdout.
+ *
+ * @param data The bytes to write.
+ * @param length The number of bytes.
+ * @return int 0 on success or -1 on error.
+ */
+static int writeAll(const char *data, size_t length) {
+  while (length > 0) {
+    ssize_t bytes_written = write(STDOUT_FILENO, data, length);
+    if (bytes_written == -1) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return -1;
+    }
+    data += bytes_written;
+    length -= bytes_written;
+  }
+  return 0;
+}
+
+/**
+ * @brief Returns how many bytes to move in the next call.
+ *
+ * @param limit The most bytes to move in total, or -1 for no limit.
+ * @param moved The bytes moved so far.
+ * @param chunk The most bytes to move in a call.
+ * @return size_t The bytes to move, 0 once the limit was reached.
+ */
+static size_t nextChunk(off_t limit, off_t moved, size_t chunk) {
+  if (limit >= 0 && limit - moved < (off_t)chunk) {
+    return limit - moved;
+  }
+  return chunk;
+}
+
+/**
+ * @brief Moves the contents of a file into stdout when stdout is a pipe.
+ *
+ * splice() moves the pages of the file into the pipe inside the kernel, so
+ * the data is never copied to user space.
+ *
+ * @param fd The descriptor of the file to display.
+ * @param limit The most bytes to move, or -1 to move up to the end.
+ * @return int 0 on success, -1 on error, or 1 if splice() cannot be used for
+ * this file and nothing was moved yet.
+ */
+static int spliceToStdout(int fd, off_t limit) {
+  ssize_t bytes_moved = 1;
+  off_t moved = 0;
+
+  while (bytes_moved > 0 && (limit < 0 || moved < limit)) {
+    bytes_moved = splice(fd, NULL, STDOUT_FILENO, NULL,
+                         nextChunk(limit, moved, SPLICE_SIZE_BYTES),
+                         SPLICE_F_MOVE);
+    moved += (bytes_moved > 0) ? bytes_moved : 0;
+  }
+  if (bytes_moved >= 0) {
+    return 0;
+  }
+  if (moved == 0 && (errno == EINVAL || errno == ENOSYS)) {
+    return 1;
+  }
+  return -1;
+}
+
+/**
+ * @brief Copies the contents of a file into stdout when both are files.
+ *
+ * copy_file_range() copies inside the kernel, and file systems that support
+ * it share the blocks instead of copying them. It does not work when stdout
+ * was opened for appending.
+ *
+ * @param fd The descriptor of the file to display.
+ * @param limit The most bytes to copy, or -1 to copy up to the end.
+ * @return int 0 on success, -1 on error, or 1 if copy_file_range() cannot be
+ * used for these files and nothing was copied yet.
+ */
+static int copyFileToStdout(int fd, off_t limit) {
+  ssize_t bytes_copied = 1;
+  off_t copied = 0;
+
+  while (bytes_copied > 0 && (limit < 0 || copied < limit)) {
+    bytes_copied = copy_file_range(fd, NULL, STDOUT_FILENO, NULL,
+                                   nextChunk(limit, copied,
+                                             SPLICE_SIZE_BYTES), 0);
+    copied += (bytes_copied > 0) ? bytes_copied : 0;
+  }
+  if (bytes_copied >= 0) {
+    return 0;
+  }
+  if (copied == 0 && (errno == EXDEV || errno == EINVAL || errno == ENOSYS ||
+                      errno == EOPNOTSUPP || errno == EBADF)) {
+    return 1;
+  }
+  return -1;
+}
+
+/**
+ * @brief Sends the contents of a file to stdout with sendfile().
+ *
+ * The pages of the file go to stdout inside the kernel, which works for any
+ * kind of stdout, such as a socket, but needs a regular file as input.
+ *
+ * @param fd The descriptor of the file to display.
+ * @param limit The most bytes to send, or -1 to send up to the end.
+ * @return int 0 on success, -1 on error, or 1 if sendfile() cannot be used
+ * for these descriptors and nothing was sent yet.
+ */
+static int sendFileToStdout(int fd, off_t limit) {
+  ssize_t bytes_sent = 1;
+  off_t sent = 0;
+
+  while (bytes_sent > 0 && (limit < 0 || sent < limit)) {
+    bytes_sent = sendfile(STDOUT_FILENO, fd, NULL,
+                          nextChunk(limit, sent, SPLICE_SIZE_BYTES));
+    sent += (bytes_sent > 0) ? bytes_sent : 0;
+  }
+  if (bytes_sent >= 0) {
+    return 0;
+  }
+  if (sent == 0 && (errno == EINVAL || errno == ENOSYS)) {
+    return 1;
+  }
+  return -1;
+}
+
+/**
+ * @brief Writes the contents of a file to stdout from a memory mapping.
+ *
+ * The file is mapped a window at a time from its current offset, and the
+ * kernel is told it is read sequentially so it reads ahead and drops the
+ * pages already written. This saves the copy into a read buffer when stdout
+ * does not accept data from the kernel, such as a terminal.
+ *
+ * @param fd The descriptor of the file to display.
+ * @param limit The most bytes to write, or -1 to write up to the end.
+ * @return int 0 on success, -1 on error, or 1 if the file cannot be mapped.
+ */
+static int mapToStdout(int fd, off_t limit) {
+  struct stat file_stat;
+  off_t offset = lseek(fd, 0, SEEK_CUR);
+  if (fstat(fd, &file_stat) == -1 || !S_ISREG(file_stat.st_mode) ||
+      offset == -1) {
+    return 1;
+  }
+  off_t end = file_stat.st_size;
+  if (limit >= 0 && offset + limit < end) {
+    end = offset + limit;
+  }
+
+  // Mappings start at a page boundary
+  off_t page_size = sysconf(_SC_PAGESIZE);
+  off_t start = offset;
+  while (offset < end) {
+    off_t window_start = offset - offset % page_size;
+    size_t window_length = end - window_start;
+    if (window_length > MAP_WINDOW_BYTES) {
+      window_length = MAP_WINDOW_BYTES;
+    }
+
+    char *window = mmap(NULL, window_length, PROT_READ, MAP_PRIVATE, fd,
+                        window_start);
+    if (window == MAP_FAILED) {
+      return (offset == start) ? 1 : -1;
+    }
+    madvise(window, window_length, MADV_SEQUENTIAL);
+    size_t skipped = offset - window_start;
+    int result = writeAll(window + skipped, window_length - skipped);
+    munmap(window, window_length);
+    if (result == -1) {
+      return -1;
+    }
+    offset = window_start + window_length;
+  }
+
+  // Leave the offset where read() would, for a file given as stdin
+  return (lseek(fd, offset, SEEK_SET) == -1) ? -1 : 0;
+}
+
+/**
+ * @brief Copies the contents of a file to stdout through a buffer.
+ *
+ * @param fd The descriptor of the file to display.
+ * @param limit The most bytes to copy, or -1 to copy up to the end.
+ * @return int 0 on success or -1 on error.
+ */
+static int copyToStdout(int fd, off_t limit) {
+  char *buffer = malloc(BUFFER_SIZE_BYTES);  // Buffer to store read data
+  if (buffer == NULL) {
+    errno = ENOMEM;
+    return -1;
+  }
+
+  ssize_t bytes_read = 1;
+  off_t copied = 0;
+  while (bytes_read > 0 && (limit < 0 || copied < limit)) {
+    bytes_read = read(fd, buffer, nextChunk(limit, copied,
+                                            BUFFER_SIZE_BYTES));
+    if (bytes_read > 0 && writeAll(buffer, bytes_read) == -1) {
+      free(buffer);
+      return -1;
+    }
+    copied += (bytes_read > 0) ? bytes_read : 0;
+  }
+  free(buffer);
+  return (bytes_read == -1) ? -1 : 0;
+}
+
+/**
+ * @brief Moves the contents of a file to stdout in the given mode.
+ *
+ * @param fd The descriptor of the file to display.
+ * @param mode The mode to use, other than MODE_AUTO.
+ * @param limit The most bytes to move, or -1 to move up to the end.
+ * @return int 0 on success, -1 on error, or 1 if the mode cannot be used for
+ * this input and output and nothing was moved yet.
+ */
+static int showInMode(int fd, OutputMode mode, off_t limit) {
+  switch (mode) {
+    case MODE_SPLICE:
+      return spliceToStdout(fd, limit);
+    case MODE_COPY:
+      return copyFileToStdout(fd, limit);
+    case MODE_SENDFILE:
+      return sendFileToStdout(fd, limit);
+    case MODE_MMAP:
+      return mapToStdout(fd, limit);
+    default:
+      return copyToStdout(fd, limit);
+  }
+}
+
+/**
+ * @brief Moves the contents of a file to stdout in the fastest mode for the
+ * types of the input and of stdout.
+ *
+ * - A pipe on either side is spliced.
+ * - Between regular files the data is copied with copy_file_range(), or with
+ *   sendfile() when the file system does not support it.
+ * - From a regular file to a socket the data is sent with sendfile().
+ * - From a regular file to anything else, like a terminal, it is written
+ *   from a mapping of the file.
+ *
+ * Every mode falls back to the buffer when it turns out not to be usable.
+ *
+ * @param fd The descriptor of the file to display.
+ * @param limit The most bytes to move, or -1 to move up to the end.
+ * @param in_stat The status of the file.
+ * @param out_stat The status of stdout.
+ * @return int 0 on success or -1 on error.
+ */
+static int showAuto(int fd, off_t limit, const struct stat *in_stat,
+                    const struct stat *out_stat) {
+  OutputMode modes[3] = {MODE_BUFFER, MODE_BUFFER, MODE_BUFFER};
+  if (S_ISFIFO(out_stat->st_mode) || S_ISFIFO(in_stat->st_mode)) {
+    modes[0] = MODE_SPLICE;
+  } else if (S_ISREG(in_stat->st_mode) && S_ISREG(out_stat->st_mode)) {
+    modes[0] = MODE_COPY;
+    modes[1] = MODE_SENDFILE;
+  } else if (S_ISREG(in_stat->st_mode) && S_ISSOCK(out_stat->st_mode)) {
+    modes[0] = MODE_SENDFILE;
+  } else if (S_ISREG(in_stat->st_mode)) {
+    modes[0] = MODE_MMAP;
+  }
+
+  int result = 1;
+  for (int i = 0; i < 3 && result == 1; i++) {
+    result = showInMode(fd, modes[i], limit);
+  }
+  return result;
+}
+
+/**
+ * @brief Displays a range of lines of a file.
+ *
+ * The file is read forward only up to the last line of the range, and each
+ * block is searched for newlines with memchr().
+ *
+ * @param fd The descriptor of the file to display.
+ * @param first The first line to display, counted from 1.
+ * @param last The last line to display, or -1 for the end of the file.
+ * @return int 0 on success or -1 on error.
+ */
+static int showLines(int fd, long long first, long long last) {
+  if (last != -1 && last < first) {
+    return 0;
+  }
+  char *buffer = malloc(BUFFER_SIZE_BYTES);
+  if (buffer == NULL) {
+    errno = ENOMEM;
+    return -1;
+  }
+
+  long long line = 1;  // Line the next byte belongs to
+  bool done = false;
+  ssize_t bytes_read = 0;
+  while (!done && (bytes_read = read(fd, buffer, BUFFER_SIZE_BYTES)) > 0) {
+    const char *end = buffer + bytes_read;
+    const char *start = (line >= first) ? buffer : NULL;
+    const char *next = buffer;
+    const char *newline;
+    while (!done && (newline = memchr(next, '\n', end - next)) != NULL) {
+      next = newline + 1;
+      done = (line == last);
+      line++;
+      if (line == first) {
+        start = next;
+      }
+    }
+
+    // Write the part of the block inside the range
+    const char *stop = done ? next : end;
+    if (start != NULL && stop > start && writeAll(start, stop - start) == -1) {
+      free(buffer);
+      return -1;
+    }
+  }
+  free(buffer);
+  return (bytes_read == -1) ? -1 : 0;
+}
+
+/**
+ * @brief Finds where the last lines of a block of data start.
+ *
+ * A newline at the end of the data ends its last line, and the data before
+ * the first newline counts as a line.
+ *
+ * @param data The data.
+ * @param length The number of bytes of data.
+ * @param count The number of lines.
+ * @return size_t The offset of the first of the last `count` lines, or 0 if
+ * the data has fewer lines.
+ */
+static size_t findTailStart(const char *data, size_t length,
+                            long long count) {
+  if (count == 0) {
+    return length;
+  }
+  size_t scan = (length > 0 && data[length - 1] == '\n') ? length - 1
+                                                          : length;
+  const char *newline;
+  while ((newline = memrchr(data, '\n', scan)) != NULL) {
+    scan = newline - data;
+    if (--count == 0) {
+      return scan + 1;
+    }
+  }
+  return 0;
+}
+
+/**
+ * @brief Moves the offset of a regular file to the start of its last lines.
+ *
+ * The file is searched backwards from its end in large blocks with
+ * memrchr(), so only the blocks that hold the last lines are read, however
+ * large the file is.
+ *
+ * @param fd The descriptor of the file.
+ * @param size The size of the file.
+ * @param count The number of lines.
+ * @return int 0 on success or -1 on error.
+ */
+static int seekToTail(int fd, off_t size, long long count) {
+  off_t base = lseek(fd, 0, SEEK_CUR);
+  char *buffer = malloc(BUFFER_SIZE_BYTES);
+  if (base == -1 || buffer == NULL) {
+    free(buffer);
+    return -1;
+  }
+
+  // Without enough lines the whole file is displayed
+  off_t start = (count == 0) ? size : base;
+  off_t position = size;
+  bool last_block = true;
+  while (count > 0 && position > base) {
+    size_t length = BUFFER_SIZE_BYTES;
+    if (position - base < (off_t)length) {
+      length = position - base;
+    }
+    off_t block = position - length;
+    ssize_t bytes_read = pread(fd, buffer, length, block);
+    if (bytes_read == -1) {
+      free(buffer);
+      return -1;
+    }
+
+    // The newline that ends the file ends its last line
+    size_t scan = bytes_read;
+    if (last_block && scan > 0 && buffer[scan - 1] == '\n') {
+      scan--;
+    }
+    last_block = false;
+
+    const char *newline;
+    while (count > 0 && (newline = memrchr(buffer, '\n', scan)) != NULL) {
+      scan = newline - buffer;
+      if (--count == 0) {
+        start = block + scan + 1;
+      }
+    }
+    position = block;
+  }
+  free(buffer);
+  return (lseek(fd, start, SEEK_SET) == -1) ? -1 : 0;
+}
+
+/**
+ * @brief Displays the last lines of a stream that cannot be searched from
+ * its end, like a pipe.
+ *
+ * The stream is read to its end, but only its last lines are kept: the data
+ * before them is dropped as the buffer grows.
+ *
+ * @param fd The descriptor of the stream.
+ * @param count The number of lines.
+ * @return int 0 on success or -1 on error.
+ */
+static int showTailOfStream(int fd, long long count) {
+  char *data = NULL;
+  size_t length = 0;
+  size_t capacity = 0;
+  ssize_t bytes_read;
+
+  do {
+    if (length > 0 && capacity - length < BUFFER_SIZE_BYTES) {
+      // Drop the lines before the last ones before growing
+      size_t start = findTailStart(data, length, count);
+      memmove(data, data + start, length - start);
+      length -= start;
+    }
+    if (capacity - length < BUFFER_SIZE_BYTES) {
+      char *new_data = realloc(data, capacity * 2 + BUFFER_SIZE_BYTES);
+      if (new_data == NULL) {
+        free(data);
+        errno = ENOMEM;
+        return -1;
+      }
+      data = new_data;
+      capacity = capacity * 2 + BUFFER_SIZE_BYTES;
+    }
+    bytes_read = read(fd, data + length, capacity - length);
+    length += (bytes_read > 0) ? bytes_read : 0;
+  } while (bytes_read > 0);
+
+  size_t start = findTailStart(data, length, count);
+  int result = (bytes_read == -1) ? -1
+                                  : writeAll(data + start, length - start);
+  free(data);
+  return result;
+}
+
+/**
+ * @brief Skips the first bytes of a file.
+ *
+ * @param fd The descriptor of the file.
+ * @param count The number of bytes to skip.
+ * @param seekable Whether the offset of the file can be moved.
+ * @return int 0 on success or -1 on error.
+ */
+static int skipBytes(int fd, off_t count, bool seekable) {
+  if (seekable) {
+    return (lseek(fd, count, SEEK_CUR) == -1) ? -1 : 0;
+  }
+
+  char *buffer = malloc(BUFFER_SIZE_BYTES);
+  if (buffer == NULL) {
+    errno = ENOMEM;
+    return -1;
+  }
+  ssize_t bytes_read = 1;
+  off_t skipped = 0;
+  while (bytes_read > 0 && skipped < count) {
+    bytes_read = read(fd, buffer, nextChunk(count, skipped,
+                                            BUFFER_SIZE_BYTES));
+    skipped += (bytes_read > 0) ? bytes_read : 0;
+  }
+  free(buffer);
+  return (bytes_read == -1) ? -1 : 0;
+}
+
+/**
+ * @brief Displays a range of a file.
+ *
+ * Lines selected from the start are written from the buffer they are found
+ * in. The tail of a regular file and ranges of bytes are located first and
+ * then moved in the given mode.
+ *
+ * @param fd The descriptor of the file to display.
+ * @param range The part of the file to display.
+ * @param mode The mode to move the data in.
+ * @param in_stat The status of the file.
+ * @param out_stat The status of stdout.
+ * @return int 0 on success, -1 on error, or 1 if a forced mode cannot be
+ * used for this input and output.
+ */
+static int showRange(int fd, const Range *range, OutputMode mode,
+                     const struct stat *in_stat,
+                     const struct stat *out_stat) {
+  bool seekable = S_ISREG(in_stat->st_mode);
+  off_t limit = -1;
+
+  if (range->kind == RANGE_LINES) {
+    return showLines(fd, range->first, range->last);
+  } else if (range->kind == RANGE_TAIL && !seekable) {
+    return showTailOfStream(fd, range->first);
+  } else if (range->kind == RANGE_TAIL &&
+             seekToTail(fd, in_stat->st_size, range->first) == -1) {
+    return -1;
+  } else if (range->kind == RANGE_BYTES) {
+    if (skipBytes(fd, range->first - 1, seekable) == -1) {
+      return -1;
+    }
+    limit = (range->last == -1) ? -1 : range->last - range->first + 1;
+  }
+
+  // A forced mode is used as is, to compare the modes
+  if (mode == MODE_AUTO) {
+    return showAuto(fd, limit, in_stat, out_stat);
+  }
+  return showInMode(fd, mode, limit);
+}
+
+/**
+ * @brief Reads a count of lines.
+ *
+ * @param text The text of the count.
+ * @param count Receives the count.
+ * @return true if the text is a count, false otherwise.
+ */
+static bool parseCount(const char *text, long long *count) {
+  char *end;
+  errno = 0;
+  *count = strtoll(text, &end, 10);
+  return (errno == 0 && end != text && *end == '\0' && *count >= 0);
+}
+
+/**
+ * @brief Reads a range in the form `A:B`, where either end may be omitted.
+ *
+ * @param text The text of the range.
+ * @param kind The kind of range.
+ * @param range Receives the range.
+ * @return true if the text is a range, false otherwise.
+ */
+static bool parseRange(const char *text, RangeKind kind, Range *range) {
+  const char *colon = strchr(text, ':');
+  if (colon == NULL) {
+    return false;
+  }
+
+  char *end;
+  errno = 0;
+  range->kind = kind;
+  range->first = (colon == text) ? 1 : strtoll(text, &end, 10);
+  if (colon != text && end != colon) {
+    return false;
+  }
+  range->last = (colon[1] == '\0') ? -1 : strtoll(colon + 1, &end, 10);
+  if (colon[1] != '\0' && *end != '\0') {
+    return false;
+  }
+  return (errno == 0 && range->first >= 1 &&
+          (range->last == -1 || range->last >= range->first));
+}
+
+/**
+ * @brief Displays a part of an open file.
+ *
+ * Errors are printed.
+ *
+ * @param fd The descriptor of the file to display.
+ * @param range The part of the file to display.
+ * @param mode The mode to move the data in.
+ * @return true on success, false on error.
+ */
+static bool showFile(int fd, const Range *range, OutputMode mode) {
+  struct stat out_stat = {0};
+  struct stat in_stat = {0};
+  fstat(STDOUT_FILENO, &out_stat);
+  fstat(fd, &in_stat);
+
+  // Appending a file to itself would never reach its end
+  if (S_ISREG(in_stat.st_mode) && S_ISREG(out_stat.st_mode) &&
+      in_stat.st_dev == out_stat.st_dev &&
+      in_stat.st_ino == out_stat.st_ino && in_stat.st_size > 0) {
+    fputs("Error: The input file is the output file.\n", stderr);
+    return false;
+  }
+
+  int result = showRange(fd, range, mode, &in_stat, &out_stat);
+  if (result == 1) {
+    fprintf(stderr, "Error: The %s mode cannot be used for this input and "
+            "output.\n", MODE_NAMES[mode]);
+    return false;
+  }
+  if (result == -1) {
+    perror("Error");
+    return false;
+  }
+  return true;
+}
+
+/**
+ * @brief Writes the header that names a file, when several are displayed.
+ *
+ * @param path The path of the file.
+ * @param first Whether it is the first header written.
+ * @return int 0 on success or -1 on error.
+ */
+static int writeHeader(const char *path, bool first) {
+  char header[PATH_MAX + 16];
+  int length = snprintf(header, sizeof(header), "%s==> %s <==\n",
+                        first ? "" : "\n", path);
+  if (length >= (int)sizeof(header)) {
+    length = sizeof(header) - 1;
+  }
+  return writeAll(header, length);
+}
+
+/**
+ * @brief Writes the bytes appended to a followed file since it was last
+ * displayed.
+ *
+ * A file that became shorter than what was displayed was truncated, and is
+ * displayed again from its start.
+ *
+ * @param follower The follower.
+ * @param file The file.
+ * @return int 0 on success or -1 on error.
+ */
+static int forwardAppended(Follower *follower, FollowedFile *file) {
+  struct stat in_stat;
+  struct stat out_stat = {0};
+  off_t offset = lseek(file->fd, 0, SEEK_CUR);
+  if (offset == -1 || fstat(file->fd, &in_stat) == -1) {
+    return -1;
+  }
+  if (in_stat.st_size < offset) {
+    fprintf(stderr, "Warning: '%s' was truncated, displaying it from the "
+            "start.\n", file->path);
+    offset = lseek(file->fd, 0, SEEK_SET);
+  }
+  if (in_stat.st_size <= offset) {
+    return 0;
+  }
+
+  if (follower->headers && follower->last_shown != file) {
+    if (writeHeader(file->path, follower->last_shown == NULL) == -1) {
+      return -1;
+    }
+    follower->last_shown = file;
+  }
+
+  // Only what was written up to now, the rest comes with the next event
+  fstat(STDOUT_FILENO, &out_stat);
+  off_t limit = in_stat.st_size - offset;
+  int result = (follower->mode == MODE_AUTO)
+                   ? showAuto(file->fd, limit, &in_stat, &out_stat)
+                   : showInMode(file->fd, follower->mode, limit);
+  return (result == 0) ? 0 : -1;
+}
+
+/**
+ * @brief Opens the file at the path of a followed file again.
+ *
+ * When the path names a new file, because the old one was rotated or
+ * deleted and created again, the rest of the old file is written and the
+ * new one is followed from its start.
+ *
+ * @param follower The follower.
+ * @param file The file.
+ * @return int 0 on success, including when the path does not exist now, or
+ * -1 on error.
+ */
+static int reopenFile(Follower *follower, FollowedFile *file) {
+  int fd = open(file->path, O_RDONLY | O_CLOEXEC);
+  struct stat new_stat, old_stat;
+  if (fd == -1 || fstat(fd, &new_stat) == -1) {
+    if (fd != -1) {
+      close(fd);
+    }
+    return 0;  // Waits for the file to appear in its directory
+  }
+  if (file->fd != -1 && fstat(file->fd, &old_stat) == 0 &&
+      old_stat.st_dev == new_stat.st_dev &&
+      old_stat.st_ino == new_stat.st_ino) {
+    close(fd);
+    return 0;
+  }
+
+  if (file->fd != -1) {
+    int result = forwardAppended(follower, file);
+    close(file->fd);
+    if (result == -1) {
+      close(fd);
+      return -1;
+    }
+    fprintf(stderr, "Warning: '%s' was replaced, following the new file.\n",
+            file->path);
+  }
+  if (file->file_watch != -1) {
+    inotify_rm_watch(follower->inotify_fd, file->file_watch);
+  }
+  file->fd = fd;
+  file->file_watch = inotify_add_watch(follower->inotify_fd, file->path,
+                                       FILE_EVENTS);
+  return forwardAppended(follower, file);
+}
+
+/**
+ * @brief Handles an inotify event for the followed files it concerns.
+ *
+ * @param follower The follower.
+ * @param event The event.
+ * @return int 0 on success or -1 on error.
+ */
+static int handleFollowEvent(Follower *follower,
+                             const struct inotify_event *event) {
+  for (int i = 0; i < follower->file_count; i++) {
+    FollowedFile *file = &follower->files[i];
+    int result = 0;
+    if (event->wd == file->file_watch) {
+      if ((event->mask & IN_MODIFY) && file->fd != -1) {
+        result = forwardAppended(follower, file);
+      }
+      if (result == 0 && (event->mask & (IN_MOVE_SELF | IN_DELETE_SELF))) {
+        result = reopenFile(follower, file);
+      }
+      if (event->mask & IN_IGNORED) {
+        file->file_watch = -1;
+      }
+    } else if (event->wd == file->dir_watch && event->len > 0 &&
+               strcmp(event->name, file->name) == 0) {
+      result = reopenFile(follower, file);
+    }
+    if (result == -1) {
+      return -1;
+    }
+  }
+  return 0;
+}
+
+/**
+ * @brief Displays files and then follows them, writing what is appended to
+ * them as it is written.
+ *
+ * A single inotify descriptor watches every file and the directory that
+ * holds it, so the process sleeps until one of them changes. Files that are
+ * rotated, deleted or truncated are followed by name. When several files
+ * are followed, a header names the file each part of the output comes from.
+ *
+ * SIGINT is read from a signalfd next to the inotify descriptor, so Ctrl-C
+ * ends the loop and the files are closed before returning.
+ *
+ * @param paths The paths of the files.
+ * @param count The number of files.
+ * @param range The part of each file to display before following it.
+ * @param mode The mode to move the data in.
+ * @return int 0 when interrupted by SIGINT, 1 on error.
+ */
+static int followFiles(const char *paths[], int count, const Range *range,
+                       OutputMode mode) {
+  Follower follower = {inotify_init1(IN_CLOEXEC), NULL, count, mode,
+                       count > 1, NULL};
+  follower.files = calloc(count, sizeof(FollowedFile));
+  if (follower.inotify_fd == -1 || follower.files == NULL) {
+    perror("Error");
+    free(follower.files);
+    return EXIT_FAILURE;
+  }
+
+  int status = EXIT_SUCCESS;
+  for (int i = 0; i < count && status == EXIT_SUCCESS; i++) {
+    FollowedFile *file = &follower.files[i];
+    file->path = paths[i];
+    const char *slash = strrchr(paths[i], '/');
+    file->name = (slash != NULL) ? slash + 1 : paths[i];
+    file->fd = open(paths[i], O_RDONLY | O_CLOEXEC);
+    file->file_watch = -1;
+
+    // The directory reports the file being created again after a rotation
+    char directory[PATH_MAX];
+    snprintf(directory, sizeof(directory), "%.*s",
+             (slash != NULL) ? (int)(slash - paths[i] + 1) : 1,
+             (slash != NULL) ? paths[i] : ".");
+    file->dir_watch = inotify_add_watch(follower.inotify_fd, directory,
+                                        DIRECTORY_EVENTS | IN_ONLYDIR);
+
+    if (file->fd == -1) {
+      fprintf(stderr, "Error opening file '%s': %s\n", paths[i],
+              strerror(errno));
+      continue;
+    }
+    file->file_watch = inotify_add_watch(follower.inotify_fd, paths[i],
+                                         FILE_EVENTS);
+    if (follower.headers &&
+        writeHeader(paths[i], follower.last_shown == NULL) == -1) {
+      perror("Error");
+      status = EXIT_FAILURE;
+    } else if (!showFile(file->fd, range, mode)) {
+      status = EXIT_FAILURE;
+    }
+    follower.last_shown = file;
+  }
+
+  // Receive SIGINT as an event instead of being killed by it
+  sigset_t interrupt_mask, previous_mask;
+  sigemptyset(&interrupt_mask);
+  sigaddset(&interrupt_mask, SIGINT);
+  sigprocmask(SIG_BLOCK, &interrupt_mask, &previous_mask);
+  int signal_fd = signalfd(-1, &interrupt_mask, SFD_CLOEXEC | SFD_NONBLOCK);
+  if (signal_fd == -1 && status == EXIT_SUCCESS) {
+    perror("Error");
+    status = EXIT_FAILURE;
+  }
+
+  // Sleep until a watched file changes or SIGINT arrives
+  long long storage[EVENT_BUFFER_BYTES / sizeof(long long)];
+  char *events = (char *)storage;
+  while (status == EXIT_SUCCESS) {
+    struct pollfd fds[] = {{follower.inotify_fd, POLLIN, 0},
+                           {signal_fd, POLLIN, 0}};
+    if (poll(fds, 2, -1) == -1) {
+      if (errno == EINTR) {
+        continue;
+      }
+      perror("Error");
+      status = EXIT_FAILURE;
+      break;
+    }
+    if (fds[1].revents != 0) {
+      break;  // Interrupted, which is how following ends
+    }
+    ssize_t length = read(follower.inotify_fd, events, sizeof(storage));
+    if (length == -1 && errno == EINTR) {
+      continue;
+    }
+    if (length <= 0) {
+      perror("Error");
+      status = EXIT_FAILURE;
+    }
+
+    for (ssize_t offset = 0; status == EXIT_SUCCESS && offset < length;) {
+      const struct inotify_event *event =
+          (const struct inotify_event *)(events + offset);
+      if (handleFollowEvent(&follower, event) == -1) {
+        perror("Error");
+        status = EXIT_FAILURE;
+      }
+      offset += sizeof(struct inotify_event) + event->len;
+    }
+  }
+
+  // Drop the SIGINT that ended the loop before unblocking it
+  if (signal_fd != -1) {
+    struct signalfd_siginfo info;
+    ssize_t drained = read(signal_fd, &info, sizeof(info));
+    (void)drained;  // Nothing to drop when the loop ended on an error
+    close(signal_fd);
+  }
+  sigprocmask(SIG_SETMASK, &previous_mask, NULL);
+
+  for (int i = 0; i < count; i++) {
+    if (follower.files[i].fd != -1) {
+      close(follower.files[i].fd);
+    }
+  }
+  close(follower.inotify_fd);
+  free(follower.files);
+  return status;
+}
+
+/**
+ * @brief Opens a file to display and asks the kernel to start reading it.
+ *
+ * The start of the file is read ahead in the background while the files
+ * before it are written out, and the rest is read ahead as a sequential
+ * stream.
+ *
+ * @param path The path of the file, or "-" for stdin.
+ * @return int The descriptor of the file, or -1 with errno set on error.
+ */
+static int openInput(const char *path) {
+  if (strcmp(path, "-") == 0) {
+    return STDIN_FILENO;
+  }
+  int fd = open(path, O_RDONLY | O_CLOEXEC);
+  struct stat file_stat;
+  if (fd != -1 && fstat(fd, &file_stat) == 0 && S_ISREG(file_stat.st_mode)) {
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    posix_fadvise(fd, 0, READAHEAD_BYTES, POSIX_FADV_WILLNEED);
+  }
+  return fd;
+}
+
+/**
+ * @brief Displays files one after the other.
+ *
+ * The next files are opened ahead of the one being written, so the device
+ * reads them at the same time. A file that cannot be displayed is reported
+ * and the others are still displayed.
+ *
+ * @param paths The paths of the files, where "-" is stdin.
+ * @param count The number of files.
+ * @param range The part of each file to display.
+ * @param mode The mode to move the data in.
+ * @return true if every file was displayed, false otherwise.
+ */
+static bool showFiles(const char *paths[], int count, const Range *range,
+                      OutputMode mode) {
+  int fds[READAHEAD_FILES];
+  int errors[READAHEAD_FILES];
+  int opened = 0;
+  bool success = true;
+
+  for (int i = 0; i < count; i++) {
+    while (opened < count && opened < i + READAHEAD_FILES) {
+      fds[opened % READAHEAD_FILES] = openInput(paths[opened]);
+      errors[opened % READAHEAD_FILES] = errno;
+      opened++;
+    }
+
+    int fd = fds[i % READAHEAD_FILES];
+    if (fd == -1) {
+      fprintf(stderr, "Error opening file '%s': %s\n", paths[i],
+              strerror(errors[i % READAHEAD_FILES]));
+      success = false;
+      continue;
+    }
+    if (!showFile(fd, range, mode)) {
+      success = false;
+    }
+    if (fd != STDIN_FILENO && close(fd) == -1) {
+      perror("Error");
+      success = false;
+    }
+  }
+  return success;
+}
+
+/**
+ * @brief Displays whole files one after the other, reading them with
+ * io_uring.
+ *
+ * The files are split into chunks that are read into a ring of buffers,
+ * with up to a buffer per entry of the queue in flight, across the end of
+ * one file and the start of the next. Chunks are written in order as they
+ * complete, so reading a file never waits for the write of the one before
+ * it, and many small files keep the device busy. Inputs that are not
+ * regular files are displayed in order without the ring.
+ *
+ * @param paths The paths of the files, where "-" is stdin.
+ * @param count The number of files.
+ * @param depth The number of reads in flight.
+ * @return int 0 if every file was displayed, -1 if a file could not be
+ * displayed, after printing the error, or 1 if io_uring is not available.
+ */
+static int showFilesWithRing(const char *paths[], int count,
+                             unsigned depth) {
+  Ring ring;
+  RingChunk *chunks = calloc(depth, sizeof(RingChunk));
+  char *buffers = malloc((size_t)depth * RING_BUFFER_BYTES);
+  if (chunks == NULL || buffers == NULL || !setupRing(&ring, depth)) {
+    free(chunks);
+    free(buffers);
+    return 1;
+  }
+  registerRingBuffers(&ring, buffers, depth, RING_BUFFER_BYTES);
+
+  const Range whole = {RANGE_ALL, 1, -1};
+  struct stat out_stat = {0};
+  fstat(STDOUT_FILENO, &out_stat);
+
+  int next_path = 0;           // next file to open
+  int fd = -1;                 // file being queued, or -1
+  off_t size = 0, offset = 0;  // size of the file and next offset to queue
+  unsigned long long queued = 0, written = 0;  // chunks queued and written
+  int failed_fd = -1;          // file whose chunks are dropped after an error
+  bool success = true;
+  bool writing = true;         // false once stdout failed
+
+  while (1) {
+    // Queue chunks while there are free buffers
+    while (writing && queued - written < depth &&
+           (fd != -1 || next_path < count)) {
+      if (fd == -1) {
+        const char *path = paths[next_path];
+        struct stat in_stat;
+        int new_fd = openInput(path);
+        if (new_fd == -1) {
+          fprintf(stderr, "Error opening file '%s': %s\n", path,
+                  strerror(errno));
+          success = false;
+          next_path++;
+          continue;
+        }
+        fstat(new_fd, &in_stat);
+        bool same_file = (in_stat.st_dev == out_stat.st_dev &&
+                          in_stat.st_ino == out_stat.st_ino);
+        if (!S_ISREG(in_stat.st_mode) || same_file) {
+          // Displayed without the ring, once the queued chunks are written
+          if (queued != written) {
+            if (new_fd != STDIN_FILENO) {
+              close(new_fd);
+            }
+            break;
+          }
+          if (!showFile(new_fd, &whole, MODE_AUTO)) {
+            success = false;
+          }
+          if (new_fd != STDIN_FILENO) {
+            close(new_fd);
+          }
+          next_path++;
+          continue;
+        }
+        if (in_stat.st_size == 0) {
+          close(new_fd);
+          next_path++;
+          continue;
+        }
+        fd = new_fd;
+        size = in_stat.st_size;
+        offset = 0;
+      }
+
+      RingChunk *chunk = &chunks[queued % depth];
+      chunk->fd = fd;
+      chunk->path = paths[next_path];
+      chunk->length = nextChunk(size, offset, RING_BUFFER_BYTES);
+      chunk->last = (offset + (off_t)chunk->length == size);
+      chunk->done = false;
+      queueTransfer(&ring, false, fd,
+                    buffers + (queued % depth) * (size_t)RING_BUFFER_BYTES,
+                    chunk->length, offset, false, queued);
+      queued++;
+      offset += chunk->length;
+      if (chunk->last) {
+        fd = -1;  // Closed once its last chunk is written
+        next_path++;
+      }
+    }
+    if (queued == written) {
+      break;
+    }
+
+    // Wait for chunks and write those that are next in order
+    if (submitAndWait(&ring) == -1) {
+      perror("Error");
+      success = false;
+      break;
+    }
+    struct io_uring_cqe completion;
+    while (nextCompletion(&ring, &completion)) {
+      RingChunk *chunk = &chunks[completion.user_data % depth];
+      chunk->done = true;
+      chunk->result = completion.res;
+    }
+    while (written < queued && chunks[written % depth].done) {
+      RingChunk *chunk = &chunks[written % depth];
+      char *buffer = buffers + (written % depth) *
+                                   (size_t)RING_BUFFER_BYTES;
+      if (chunk->result < 0 && chunk->fd != failed_fd) {
+        fprintf(stderr, "Error reading file '%s': %s\n", chunk->path,
+                strerror(-chunk->result));
+        success = false;
+        failed_fd = chunk->fd;
+      } else if (writing && chunk->fd != failed_fd &&
+                 writeAll(buffer, chunk->result) == -1) {
+        perror("Error");
+        success = false;
+        writing = false;
+      }
+      if (chunk->last) {
+        failed_fd = (failed_fd == chunk->fd) ? -1 : failed_fd;
+        close(chunk->fd);
+      }
+      written++;
+    }
+  }
+
+  if (fd != -1) {
+    close(fd);
+  }
+  freeRing(&ring);
+  free(buffers);
+  free(chunks);
+  return success ? 0 : -1;
+}
 
 /**
  * @brief Displays the contents of a file to stdout.
@@ -56,54 +1308,100 @@
  * error occurs, prints the error using perror (see the errno.h header for more
  * information) and returns 1.
  */
-int main(const int argc, const char* argv[]) {
-  // Control incorrect usage
-  if (argc < 2) {
-    fputs("Error: Incorrect usage.\n", stderr);
-    fputs(HELP_MESSAGE, stderr);
-    return EXIT_FAILURE;
-  }
-
+int mostra_main(const int argc, const char *argv[]) {
   // Display help command
-  if (strcmp(argv[1], "--help") == 0) {
+  if (argc >= 2 && strcmp(argv[1], "--help") == 0) {
     fputs(HELP_MESSAGE, stdout);
     return EXIT_SUCCESS;
   }
 
-  // Set filename to given name
-  const char* src_file = argv[1];
-
-  // Open the file in read-only mode
-  int fd = open(src_file, O_RDONLY);
-  if (fd == -1) {
-    perror("Error");
-    return EXIT_FAILURE;
+  // Read the options, each followed by its value except --segue
+  OutputMode mode = MODE_AUTO;
+  Range range = {RANGE_ALL, 1, -1};
+  bool follow = false;
+  unsigned depth = RING_DEFAULT_DEPTH;
+  int arg = 1;
+  bool valid = true;
+  while (valid && arg < argc && argv[arg][0] == '-' &&
+         argv[arg][1] != '\0') {
+    const char *option = argv[arg];
+    const char *value = (arg + 1 < argc) ? argv[arg + 1] : "";
+    int used = 2;  // Arguments used by the option
+    if (strcmp(option, "--segue") == 0) {
+      follow = true;
+      used = 1;
+    } else if (strcmp(option, "--modo") == 0) {
+      valid = false;
+      for (int i = 0; i <= MODE_URING; i++) {
+        if (strcmp(value, MODE_NAMES[i]) == 0) {
+          mode = (OutputMode)i;
+          valid = true;
+        }
+      }
+    } else if (strcmp(option, "--fila") == 0) {
+      mode = MODE_URING;
+      depth = parseRingDepth(value);
+      valid = depth != 0;
+    } else if (strcmp(option, "-n") == 0) {
+      range.kind = RANGE_LINES;
+      range.first = 1;
+      valid = parseCount(value, &range.last);
+    } else if (strcmp(option, "-t") == 0) {
+      range.kind = RANGE_TAIL;
+      range.last = -1;
+      valid = parseCount(value, &range.first);
+    } else if (strcmp(option, "--bytes") == 0) {
+      valid = parseRange(value, RANGE_BYTES, &range);
+    } else if (strcmp(option, "--lines") == 0) {
+      valid = parseRange(value, RANGE_LINES, &range);
+    } else {
+      valid = false;
+    }
+    arg += used;
   }
 
-  // Read and output the contents of the file
-  char buffer[BUFFER_SIZE_BYTES];  // Buffer to store read data
-  ssize_t bytes_read;
-  while ((bytes_read = read(fd, buffer, sizeof(buffer))) > 0) {
-    if (write(STDOUT_FILENO, buffer, bytes_read) != bytes_read) {
-      // If there is an error writing to stdout, close the file and exit
-      close(fd);
-      perror("Error");
-      return EXIT_FAILURE;
-    }
+  // Only named files can be followed
+  int file_count = argc - arg;
+  for (int i = arg; follow && i < argc; i++) {
+    valid = valid && strcmp(argv[i], "-") != 0;
   }
 
-  // Check for read error
-  if (bytes_read == -1) {
-    close(fd);
-    perror("Error");
+  // Control incorrect usage
+  if (!valid || (follow && file_count <= 0) ||
+      (!follow && file_count == 0 && isatty(STDIN_FILENO))) {
+    fputs("Error: Incorrect usage.\n", stderr);
+    fputs(HELP_MESSAGE, stderr);
     return EXIT_FAILURE;
   }
 
-  // Close the file
-  if (close(fd) == -1) {
-    perror("Error");
-    return EXIT_FAILURE;
+  if (follow) {
+    return followFiles(argv + arg, file_count, &range, mode);
   }
 
-  return EXIT_SUCCESS;
+  // Display the files in order, or stdin
+  const char *stdin_path[] = {"-"};
+  const char **paths = (file_count > 0) ? argv + arg : stdin_path;
+  int path_count = (file_count > 0) ? file_count : 1;
+
+  // The ring reads whole files, and ranges are displayed from the buffer,
+  // like everything when io_uring is not available
+  if (mode == MODE_URING && range.kind == RANGE_ALL) {
+    int result = showFilesWithRing(paths, path_count, depth);
+    if (result != 1) {
+      return (result == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+  }
+  return showFiles(paths, path_count, &range, mode) ? EXIT_SUCCESS
+                                                    : EXIT_FAILURE;
 }
+
+#ifndef COMMAND_LIBRARY
+/**
+ * @brief Entry point of the standalone `mostra` program.
+ *
+ * @param argc The number of command-line arguments passed to the program.
+ * @param argv An array of strings containing the command-line arguments.
+ * @return int The exit status returned by mostra_main().
+ */
+int main(const int argc, const char *argv[]) { return mostra_main(argc, argv); }
+#endif